@@ -10,6 +10,10 @@ pushd build
     REM 64-bit build release build with statically linked c-runtime library
     cl %CompilerFlags% ../code/examples/framework_2d_shapes_and_colors.cpp -link %LinkerFlags%
     cl %CompilerFlags% ../code/examples/framework_3d_shapes.cpp -link %LinkerFlags%
+    cl %CompilerFlags% ../code/examples/framework_instancing.cpp -link %LinkerFlags%
+    cl %CompilerFlags% ../code/examples/framework_particles.cpp -link %LinkerFlags%
+    cl %CompilerFlags% ../code/examples/framework_quaternions.cpp -link %LinkerFlags%
+    cl %CompilerFlags% ../code/examples/framework_benchmark.cpp -link %LinkerFlags%
     cl %CompilerFlags% ../code/examples/framework_image_3d_model.cpp -link %LinkerFlags%
     cl %CompilerFlags% ../code/examples/framework_vectors.cpp -link %LinkerFlags%
     cl %CompilerFlags% ../code/examples/framework_random.cpp -link %LinkerFlags%
@@ -8,12 +8,11 @@
 #pragma comment(lib, "gdi32.lib")
 #pragma comment(lib, "Xinput9_1_0.lib")
 #pragma comment(lib, "opengl32.lib")
-#pragma comment(lib, "glu32.lib")
 
 #define _CRT_SECURE_NO_WARNINGS
 #define _CRT_SECURE_NO_DEPRECATE
 
-#pragma warning( disable : 4100; disable : 4201; disable: 4996 )
+#pragma warning( disable : 4100; disable : 4201; disable: 4996; disable: 4324 )
 
 #ifdef NOCRT
 #define _NO_CRT_STDIO_INLINE
@@ -25,9 +24,10 @@ extern "C" int _fltused = 0; // for floating point
 #include <stdio.h> // for vsprintf_s
 #include <xinput.h>
 #include <gl/gl.h>
-#include <gl/glu.h> // gluOrtho2D
 #include <math.h>
+#include <intrin.h> // SSE2, AVX and cpuid
 #include <malloc.h> 
+#include <new> // placement new for Array
 
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
@@ -106,80 +106,148 @@ quitError(const char *errorMessage, ...)
 // Data Structures
 // 
 
-// dynamic array
+// dynamic array, the items are stored one after the other so a loop over them is a linear scan.
+// growth doubles the capacity and moves the items, plain structs are copied with memcpy. the array
+// owns its items but not what they point to, freeMem() destroys the items and frees the storage
+template <typename T, bool trivial = __is_trivially_copyable(T)>
+struct ArrayMove {
+    static void move(T *to, T *from, i32 count)
+    {
+        for (i32 i = 0; i < count; i++) {
+            new (to + i) T(static_cast<T &&>(from[i]));
+            from[i].~T();
+        }
+    }
+};
+
+template <typename T>
+struct ArrayMove<T, true> {
+    static void move(T *to, T *from, i32 count)
+    {
+        if (count > 0)
+            memcpy(to, from, sizeof(T) * count);
+    }
+};
+
+template <typename T>
 struct Array {
-    i32 length;
-    i32 size;
-    void **data;
+    T *data = 0;
+    i32 length = 0;
+    i32 capacity = 0;
 
-    void reserve(i32 initSize)
+    static T *allocate(i32 count)
     {
-        length = 0;
-        size = initSize;
-        data = (void **)malloc(sizeof(void *) * size);
+        sizeT alignment = alignof(T) > 16 ? alignof(T) : 16;
+        return (T *)_aligned_malloc(sizeof(T) * count, alignment);
     }
 
-    void resize(i32 newSize)
+    // room for capacity items without reallocating
+    void reserve(i32 newCapacity)
     {
+        if (newCapacity <= capacity)
+            return;
+        T *grown = allocate(newCapacity);
+        ArrayMove<T>::move(grown, data, length);
+        _aligned_free(data);
+        data = grown;
+        capacity = newCapacity;
+    }
 
-#if defined(_DEBUG) || defined(DEVELOPER)
-        printf("Realloc the Array: %d to %d\n", size, newSize);
-#endif
-        void **newArray = (void **)realloc(data, sizeof(void *) * newSize);
-        if (newArray)
-        {
-            data = newArray;
-            size = newSize;
+    // constructs an item at the end from the arguments and returns it. the arguments can be items of this
+    // array, when it grows the new item is made before the old storage is freed
+    template <typename... Args>
+    T *emplace(Args &&... args)
+    {
+        if (length == capacity) {
+            i32 newCapacity = capacity ? capacity * 2 : 16;
+            T *grown = allocate(newCapacity);
+            new (grown + length) T(static_cast<Args &&>(args)...);
+            ArrayMove<T>::move(grown, data, length);
+            _aligned_free(data);
+            data = grown;
+            capacity = newCapacity;
+            return data + length++;
         }
+        return new (data + length++) T(static_cast<Args &&>(args)...);
+    }
+
+    void push(const T &value)
+    {
+        emplace(value);
     }
 
-    void push(void *value)
+    void push(T &&value)
     {
-        if (size == length)
-            resize(size * 2);
-        data[length++] = value;
+        emplace(static_cast<T &&>(value));
     }
 
+    // removes the item at index, the ones after it move down
     void splice(i32 index)
     {
         if (index < 0 || index >= length)
             return;
+        for (i32 i = index; i < length - 1; i++)
+            data[i] = static_cast<T &&>(data[i + 1]);
+        data[--length].~T();
+    }
 
-        free(data[index]);
-        data[index] = 0;
-
-        for (int i = index; i < length - 1; i++) {
-            data[i] = data[i + 1];
-            data[i + 1] = 0;
-        }
-
-        length--;
-
-        if (length > 0 && length == size / 4)
-            resize(size / 2);
+    // removes the item at index and puts the last one in its place, for when the order doesn't matter
+    void swapRemove(i32 index)
+    {
+        if (index < 0 || index >= length)
+            return;
+        if (index != length - 1)
+            data[index] = static_cast<T &&>(data[length - 1]);
+        data[--length].~T();
     }
 
-    void set(int index, void *value)
+    void set(i32 index, const T &value)
     {
         if (index >= 0 && index < length)
             data[index] = value;
     }
 
-    void *get(int index)
+    // 0 when index is out of range
+    T *get(i32 index)
     {
         if (index >= 0 && index < length)
-            return data[index];
+            return data + index;
         return 0;
     }
 
-    void freeMem()
+    // unchecked, except in developer builds
+    T &operator[](i32 index)
     {
-        for (i32 i = 0; i < length; i++)
-            free(data[i]);
+        Assert(index >= 0 && index < length);
+        return data[index];
+    }
+
+    const T &operator[](i32 index) const
+    {
+        Assert(index >= 0 && index < length);
+        return data[index];
+    }
 
-        free(data);
+    T *begin() { return data; }
+    T *end() { return data + length; }
+    const T *begin() const { return data; }
+    const T *end() const { return data + length; }
+
+    // destroys the items and keeps the storage
+    void clear()
+    {
+        for (i32 i = 0; i < length; i++)
+            data[i].~T();
+        length = 0;
     }
 
+    void freeMem()
+    {
+        clear();
+        _aligned_free(data);
+        data = 0;
+        capacity = 0;
+    }
 };
 
 // Sean Barrets stretchy buffer
@@ -191,7 +259,8 @@ struct Array {
 #define stb_sb_add(a,n)        (stb__sbmaybegrow(a,n), stb__sbn(a)+=(n), &(a)[stb__sbn(a)-(n)])
 #define stb_sb_last(a)         ((a)[stb__sbn(a)-1])
 
-#define stb__sbraw(a) ((int *) (a) - 2)
+// the header is padded to 16 bytes so the items keep the alignment of malloc, m4 needs 16
+#define stb__sbraw(a) ((int *) (a) - 4)
 #define stb__sbm(a)   stb__sbraw(a)[0]
 #define stb__sbn(a)   stb__sbraw(a)[1]
 
@@ -204,14 +273,14 @@ static void *stb__raw_sbgrowf(void *arr, int increment, int itemsize)
     int dbl_cur = arr ? 2 * stb__sbm(arr) : 0;
     int min_needed = countArray(arr) + increment;
     int m = dbl_cur > min_needed ? dbl_cur : min_needed;
-    int *p = (int *)realloc(arr ? stb__sbraw(arr) : 0, itemsize * m + sizeof(int) * 2);
+    int *p = (int *)realloc(arr ? stb__sbraw(arr) : 0, itemsize * m + sizeof(int) * 4);
     if (p) {
         if (!arr)
             p[1] = 0;
         p[0] = m;
-        return p + 2;
+        return p + 4;
     } else {
-        return (void *)(2 * sizeof(int));
+        return (void *)(4 * sizeof(int));
     }
 }
 
@@ -224,7 +293,6 @@ static T *stb__sbgrowf(T *arr, int increment, int itemsize) {
 //
 // Math
 //
-#include <random>
 
 #define PI 3.14159265358979323846f
 #define TWO_PI 6.28318530717958647693f
@@ -294,51 +362,86 @@ inline f32 squareRoot(f32 value)
     return result;
 }
 
+// the SSE estimate is inf for denormals and the Newton step can flush to 0 for huge values, outside of
+// this range inverseSquareRoot() and inverseSquareRoot4() divide by sqrtf() instead
+#define INVERSE_SQUARE_ROOT_MIN FLT_MIN
+#define INVERSE_SQUARE_ROOT_MAX (1.f / FLT_MIN)
+
+// returns 1 / squareRoot(value) for value > 0, the SSE estimate refined with one Newton-Raphson step.
+// the relative error is below 3e-7, a multiply by this replaces a square root and a divide
+inline f32 inverseSquareRoot(f32 value)
+{
+    if (!(value >= INVERSE_SQUARE_ROOT_MIN && value <= INVERSE_SQUARE_ROOT_MAX))
+        return 1.f / sqrtf(value);
+
+    f32 estimate = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(value)));
+    f32 result = estimate * (1.5f - 0.5f * value * estimate * estimate);
+    return result;
+}
+
+// four at a time. the Newton step multiplies in the order of the scalar version, ((0.5 * value) * estimate)
+// * estimate, so the lanes round like inverseSquareRoot() when the compiler keeps the order, -fp:fast doesn't
+// promise that so the two only share the 3e-7 error bound
+inline __m128 inverseSquareRoot4(__m128 value)
+{
+    __m128 estimate = _mm_rsqrt_ps(value);
+    __m128 correction = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), value), estimate), estimate);
+    __m128 result = _mm_mul_ps(estimate, _mm_sub_ps(_mm_set1_ps(1.5f), correction));
+
+    __m128 inRange = _mm_and_ps(_mm_cmpge_ps(value, _mm_set1_ps(INVERSE_SQUARE_ROOT_MIN)),
+                                _mm_cmple_ps(value, _mm_set1_ps(INVERSE_SQUARE_ROOT_MAX)));
+    if (_mm_movemask_ps(inRange) != 0xf) {
+        __m128 exact = _mm_div_ps(_mm_set1_ps(1.f), _mm_sqrt_ps(value));
+        result = _mm_or_ps(_mm_and_ps(inRange, result), _mm_andnot_ps(inRange, exact));
+    }
+    return result;
+}
+
 // returns value squared (value^2), the result is always positive
-inline f32 square(f32 a)
+constexpr f32 square(f32 a)
 {
     f32 result = a*a;
     return result;
 }
 
 // raise base to n-th power, n must: n >= 0
-f32 powerOf(f32 base, f32 n)
+constexpr f32 powerOf(f32 base, f32 n)
 {
-    f32 result;
-    for (result = 1; n > 0; --n)
+    f32 result = 1.f;
+    for (; n > 0; --n)
         result = result * base;
     return result;
 }
 
 // an absolute value is defined as the distance from zero, absoluteValue(-5) will return 5
-inline f32 absoluteValue(f32 value)
+constexpr f32 absoluteValue(f32 value)
 {
-    f32 result = (f32)fabs(value);
+    f32 result = (value < 0.f) ? -value : value;
     return result;
 }
 
 // returns 1 if the value is positive and -1 if the value is negative
-inline i32 signOf(i32 value)
+constexpr i32 signOf(i32 value)
 {
     i32 result = (value >= 0) ? 1 : -1;
     return result;
 }
 
 // constrains a value to be within a range
-inline i32 constrain(i32 value, i32 min, i32 max)
+constexpr i32 constrain(i32 value, i32 min, i32 max)
 {
     return (value < min) ? min : ((value > max) ? max : value);
 }
 
-inline f32 constrainf(f32 value, f32 min, f32 max)
+constexpr f32 constrainf(f32 value, f32 min, f32 max)
 {
     return (value < min) ? min : ((value > max) ? max : value);
 }
 
 // re-maps a value from one range to another
-inline f32 map(f32 value, f32 inMin, f32 inMax, f32 outMin, f32 outMax)
+constexpr f32 map(f32 value, f32 inMin, f32 inMax, f32 outMin, f32 outMax)
 {
-    if (fabs(inMin - inMax) < FLT_EPSILON)
+    if (absoluteValue(inMin - inMax) < FLT_EPSILON)
     {
         return outMin;
     }
@@ -366,7 +469,7 @@ inline f32 map(f32 value, f32 inMin, f32 inMax, f32 outMin, f32 outMax)
 }
 
 // returns a interpolated value between two numbers, the amount parameter is the amount to interpolate between the two values. 
-inline f32 lerp(f32 min, f32 max, f32 amount)
+constexpr f32 lerp(f32 min, f32 max, f32 amount)
 {
     /* 
        Linear blend
@@ -391,46 +494,461 @@ inline f32 lerp(f32 min, f32 max, f32 amount)
     return result;
 }
 
+// CPU features, the SIMD kernels are picked from these at startup
+struct CpuFeatures
+{
+    b32 avx;
+    b32 fma;
+    b32 avx2;
+};
+
+internal CpuFeatures
+detectCpuFeatures()
+{
+    CpuFeatures result = {};
+    i32 info[4];
+    __cpuid(info, 0);
+    i32 maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    b32 osxsave = (info[2] & (1 << 27)) != 0;
+    b32 avx = (info[2] & (1 << 28)) != 0;
+    b32 fma = (info[2] & (1 << 12)) != 0;
+
+    // the OS has to save the ymm registers on context switches
+    if (osxsave && avx && (_xgetbv(0) & 6) == 6) {
+        result.avx = true;
+        result.fma = fma;
+        if (maxLeaf >= 7) {
+            __cpuidex(info, 7, 0);
+            result.avx2 = (info[1] & (1 << 5)) != 0;
+        }
+    }
+    return result;
+}
+
+global CpuFeatures cpuFeatures = detectCpuFeatures();
+
+//
+// Parallel work
+//
+
+// parallelFor splits [0, count) in one contiguous range per thread and runs them on worker threads plus
+// the calling thread, it returns when all ranges are done. grain is the smallest range worth a thread of
+// its own and jobs with less than two grains run on the calling thread. work must only write to its own
+// range. there is no thread pool: every call creates and joins its threads, which costs tens of
+// microseconds. it pays off for work in the millisecond range, like a noise image per frame, but a loop
+// that calls it for small jobs many times a frame spends more on the threads than on the work.
+// maxThreads limits the threads, 0 uses one per processor
+typedef void ParallelWork(void *data, i32 first, i32 last);
+
+#define PARALLEL_MAX_THREADS 32
+
+struct ParallelRange
+{
+    ParallelWork *work;
+    void *data;
+    i32 first, last;
+};
+
+internal i32
+countProcessors()
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (i32)info.dwNumberOfProcessors : 1;
+}
+
+global i32 processorCount = countProcessors();
+
+internal DWORD WINAPI
+parallelThread(LPVOID parameter)
+{
+    ParallelRange *range = (ParallelRange *)parameter;
+    range->work(range->data, range->first, range->last);
+    return 0;
+}
+
+void parallelFor(i32 count, i32 grain, ParallelWork *work, void *data, i32 maxThreads = 0)
+{
+    i32 limit = maxThreads > 0 && maxThreads < processorCount ? maxThreads : processorCount;
+    i32 threads = count / (grain > 0 ? grain : 1);
+    threads = threads < limit ? threads : limit;
+    threads = threads < PARALLEL_MAX_THREADS ? threads : PARALLEL_MAX_THREADS;
+    if (threads < 2) {
+        if (count > 0)
+            work(data, 0, count);
+        return;
+    }
+
+    ParallelRange ranges[PARALLEL_MAX_THREADS];
+    HANDLE handles[PARALLEL_MAX_THREADS];
+    for (i32 t = 0; t < threads; t++) {
+        ranges[t].work = work;
+        ranges[t].data = data;
+        ranges[t].first = (i32)((i64)count * t / threads);
+        ranges[t].last = (i32)((i64)count * (t + 1) / threads);
+    }
+
+    // the first range runs on the calling thread, a range that gets no thread runs here too
+    i32 started = 0;
+    for (i32 t = 1; t < threads; t++) {
+        handles[started] = CreateThread(0, 0, parallelThread, ranges + t, 0, 0);
+        if (handles[started])
+            started++;
+        else
+            parallelThread(ranges + t);
+    }
+    parallelThread(ranges);
+
+    if (started > 0)
+        WaitForMultipleObjects((DWORD)started, handles, TRUE, INFINITE);
+    for (i32 t = 0; t < started; t++)
+        CloseHandle(handles[t]);
+}
+
 //
 // Trigonometry
 //
 
+// fast sine, cosine and arc tangent with minimax polynomials (the cephes single precision coefficients).
+// the angle is reduced to [-pi/4, pi/4] around the nearest multiple of pi/2, pi/2 is split in three
+// parts so the reduction stays exact. max errors against the double precision libm functions:
+//   fastSin(), fastCos(), fastSinCos()   1e-7 for |angle| < 8192, beyond that it grows with the angle
+//   fastAtan2()                          3e-7 radians
+//   fastArcCosine()                      3e-7 radians
+// the 4 and 8 lane versions use the same polynomials and have the same error bounds, -fp:fast lets the
+// compiler contract and reorder the scalar ones so the last bit can differ. fastSin(), fastCos() and
+// fastSinCos() are constexpr, tables of them can be built at compile time (see sineTable() and circleTable())
+
+#define TRIG_PIO2_1 1.5703125f
+#define TRIG_PIO2_2 4.837512969970703125e-4f
+#define TRIG_PIO2_3 7.54978995489188216e-8f
+#define TRIG_TAN_PI_8 0.4142135623730950f
+
+#define TRIG_SIN_1 -1.6666654611e-1f
+#define TRIG_SIN_2 8.3321608736e-3f
+#define TRIG_SIN_3 -1.9515295891e-4f
+#define TRIG_COS_1 4.166664568298827e-2f
+#define TRIG_COS_2 -1.388731625493765e-3f
+#define TRIG_COS_3 2.443315711809948e-5f
+#define TRIG_ATAN_1 8.05374449538e-2f
+#define TRIG_ATAN_2 -1.38776856032e-1f
+#define TRIG_ATAN_3 1.99777106478e-1f
+#define TRIG_ATAN_4 -3.33329491539e-1f
+
+constexpr void fastSinCos(f32 angle, f32 *sine, f32 *cosine)
+{
+    // nearest multiple of pi/2, half away from zero and truncated like the SIMD versions
+    f32 x = angle * (2.f / PI);
+    i32 q = (i32)(x + (x < 0.f ? -0.5f : 0.5f));
+    f32 fq = (f32)q;
+    f32 r = ((angle - fq * TRIG_PIO2_1) - fq * TRIG_PIO2_2) - fq * TRIG_PIO2_3;
+    f32 r2 = r * r;
+    f32 s = r + r * r2 * (TRIG_SIN_1 + r2 * (TRIG_SIN_2 + r2 * TRIG_SIN_3));
+    f32 c = (1.f - 0.5f * r2) + r2 * r2 * (TRIG_COS_1 + r2 * (TRIG_COS_2 + r2 * TRIG_COS_3));
+
+    // sin(q * pi/2 + r) and cos(q * pi/2 + r) for the four quadrants
+    f32 sq = (q & 1) ? c : s;
+    f32 cq = (q & 1) ? s : c;
+    *sine = (q & 2) ? -sq : sq;
+    *cosine = ((q + 1) & 2) ? -cq : cq;
+}
+
+constexpr f32 fastSin(f32 angle)
+{
+    f32 s = 0.f, c = 0.f;
+    fastSinCos(angle, &s, &c);
+    return s;
+}
+
+constexpr f32 fastCos(f32 angle)
+{
+    f32 s = 0.f, c = 0.f;
+    fastSinCos(angle, &s, &c);
+    return c;
+}
+
+inline f32 fastAtan2(f32 y, f32 x)
+{
+    f32 ax = fabsf(x);
+    f32 ay = fabsf(y);
+    f32 largest = ax > ay ? ax : ay;
+    f32 smallest = ax > ay ? ay : ax;
+    f32 a = largest > 0.f ? smallest / largest : 0.f;
+
+    // atan(a) = pi/4 + atan((a - 1) / (a + 1)) keeps the polynomial in [-tan(pi/8), tan(pi/8)]
+    f32 offset = 0.f;
+    if (a > TRIG_TAN_PI_8) {
+        a = (a - 1.f) / (a + 1.f);
+        offset = PI / 4.f;
+    }
+    f32 z = a * a;
+    f32 result = offset + ((((TRIG_ATAN_1 * z + TRIG_ATAN_2) * z + TRIG_ATAN_3) * z + TRIG_ATAN_4) * z * a + a);
+
+    if (ay > ax)
+        result = PI / 2.f - result;
+    // the sign bit so atan2(0, -0) is pi like in libm
+    if (copysignf(1.f, x) < 0.f)
+        result = PI - result;
+    return copysignf(result, y);
+}
+
+inline f32 fastArcCosine(f32 value)
+{
+    return fastAtan2(sqrtf((1.f - value) * (1.f + value)), value);
+}
+
+// four angles at a time
+inline void fastSinCos4(__m128 angle, __m128 *sine, __m128 *cosine)
+{
+    __m128 x = _mm_mul_ps(angle, _mm_set1_ps(2.f / PI));
+    __m128 half = _mm_or_ps(_mm_and_ps(x, _mm_set1_ps(-0.f)), _mm_set1_ps(0.5f));
+    __m128i q = _mm_cvttps_epi32(_mm_add_ps(x, half));
+    __m128 fq = _mm_cvtepi32_ps(q);
+    __m128 r = _mm_sub_ps(angle, _mm_mul_ps(fq, _mm_set1_ps(TRIG_PIO2_1)));
+    r = _mm_sub_ps(r, _mm_mul_ps(fq, _mm_set1_ps(TRIG_PIO2_2)));
+    r = _mm_sub_ps(r, _mm_mul_ps(fq, _mm_set1_ps(TRIG_PIO2_3)));
+    __m128 r2 = _mm_mul_ps(r, r);
+
+    __m128 s = _mm_add_ps(_mm_set1_ps(TRIG_SIN_2), _mm_mul_ps(r2, _mm_set1_ps(TRIG_SIN_3)));
+    s = _mm_add_ps(_mm_set1_ps(TRIG_SIN_1), _mm_mul_ps(r2, s));
+    s = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2), s));
+    __m128 c = _mm_add_ps(_mm_set1_ps(TRIG_COS_2), _mm_mul_ps(r2, _mm_set1_ps(TRIG_COS_3)));
+    c = _mm_add_ps(_mm_set1_ps(TRIG_COS_1), _mm_mul_ps(r2, c));
+    c = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.f), _mm_mul_ps(_mm_set1_ps(0.5f), r2)), _mm_mul_ps(_mm_mul_ps(r2, r2), c));
+
+    __m128i one = _mm_set1_epi32(1);
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, one), one));
+    __m128 sq = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+    __m128 cq = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+    // bit 1 of the quadrant moved to the sign bit
+    __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, _mm_set1_epi32(2)), 30));
+    __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, one), _mm_set1_epi32(2)), 30));
+    *sine = _mm_xor_ps(sq, sinSign);
+    *cosine = _mm_xor_ps(cq, cosSign);
+}
+
+inline __m128 fastAtan2_4(__m128 y, __m128 x)
+{
+    __m128 signMask = _mm_set1_ps(-0.f);
+    __m128 ax = _mm_andnot_ps(signMask, x);
+    __m128 ay = _mm_andnot_ps(signMask, y);
+    __m128 largest = _mm_max_ps(ax, ay);
+    __m128 smallest = _mm_min_ps(ax, ay);
+    __m128 nonZero = _mm_cmpgt_ps(largest, _mm_setzero_ps());
+    __m128 a = _mm_and_ps(nonZero, _mm_div_ps(smallest, largest));
+
+    __m128 one = _mm_set1_ps(1.f);
+    __m128 reduce = _mm_cmpgt_ps(a, _mm_set1_ps(TRIG_TAN_PI_8));
+    __m128 reduced = _mm_div_ps(_mm_sub_ps(a, one), _mm_add_ps(a, one));
+    a = _mm_or_ps(_mm_and_ps(reduce, reduced), _mm_andnot_ps(reduce, a));
+    __m128 offset = _mm_and_ps(reduce, _mm_set1_ps(PI / 4.f));
+
+    __m128 z = _mm_mul_ps(a, a);
+    __m128 p = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(TRIG_ATAN_1), z), _mm_set1_ps(TRIG_ATAN_2));
+    p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(TRIG_ATAN_3));
+    p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(TRIG_ATAN_4));
+    __m128 result = _mm_add_ps(offset, _mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, z), a), a));
+
+    __m128 steep = _mm_cmpgt_ps(ay, ax);
+    result = _mm_or_ps(_mm_and_ps(steep, _mm_sub_ps(_mm_set1_ps(PI / 2.f), result)), _mm_andnot_ps(steep, result));
+    __m128 left = _mm_castsi128_ps(_mm_srai_epi32(_mm_castps_si128(x), 31));
+    result = _mm_or_ps(_mm_and_ps(left, _mm_sub_ps(_mm_set1_ps(PI), result)), _mm_andnot_ps(left, result));
+    return _mm_or_ps(result, _mm_and_ps(signMask, y));
+}
+
+// eight angles at a time, needs AVX2
+inline void fastSinCos8(__m256 angle, __m256 *sine, __m256 *cosine)
+{
+    __m256 x = _mm256_mul_ps(angle, _mm256_set1_ps(2.f / PI));
+    __m256 half = _mm256_or_ps(_mm256_and_ps(x, _mm256_set1_ps(-0.f)), _mm256_set1_ps(0.5f));
+    __m256i q = _mm256_cvttps_epi32(_mm256_add_ps(x, half));
+    __m256 fq = _mm256_cvtepi32_ps(q);
+    __m256 r = _mm256_sub_ps(angle, _mm256_mul_ps(fq, _mm256_set1_ps(TRIG_PIO2_1)));
+    r = _mm256_sub_ps(r, _mm256_mul_ps(fq, _mm256_set1_ps(TRIG_PIO2_2)));
+    r = _mm256_sub_ps(r, _mm256_mul_ps(fq, _mm256_set1_ps(TRIG_PIO2_3)));
+    __m256 r2 = _mm256_mul_ps(r, r);
+
+    __m256 s = _mm256_add_ps(_mm256_set1_ps(TRIG_SIN_2), _mm256_mul_ps(r2, _mm256_set1_ps(TRIG_SIN_3)));
+    s = _mm256_add_ps(_mm256_set1_ps(TRIG_SIN_1), _mm256_mul_ps(r2, s));
+    s = _mm256_add_ps(r, _mm256_mul_ps(_mm256_mul_ps(r, r2), s));
+    __m256 c = _mm256_add_ps(_mm256_set1_ps(TRIG_COS_2), _mm256_mul_ps(r2, _mm256_set1_ps(TRIG_COS_3)));
+    c = _mm256_add_ps(_mm256_set1_ps(TRIG_COS_1), _mm256_mul_ps(r2, c));
+    c = _mm256_add_ps(_mm256_sub_ps(_mm256_set1_ps(1.f), _mm256_mul_ps(_mm256_set1_ps(0.5f), r2)), _mm256_mul_ps(_mm256_mul_ps(r2, r2), c));
+
+    __m256i one = _mm256_set1_epi32(1);
+    __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(q, one), one));
+    __m256 sq = _mm256_blendv_ps(s, c, swap);
+    __m256 cq = _mm256_blendv_ps(c, s, swap);
+    __m256 sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(q, _mm256_set1_epi32(2)), 30));
+    __m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(q, one), _mm256_set1_epi32(2)), 30));
+    *sine = _mm256_xor_ps(sq, sinSign);
+    *cosine = _mm256_xor_ps(cq, cosSign);
+}
+
+inline __m256 fastAtan2_8(__m256 y, __m256 x)
+{
+    __m256 signMask = _mm256_set1_ps(-0.f);
+    __m256 ax = _mm256_andnot_ps(signMask, x);
+    __m256 ay = _mm256_andnot_ps(signMask, y);
+    __m256 largest = _mm256_max_ps(ax, ay);
+    __m256 smallest = _mm256_min_ps(ax, ay);
+    __m256 nonZero = _mm256_cmp_ps(largest, _mm256_setzero_ps(), _CMP_GT_OQ);
+    __m256 a = _mm256_and_ps(nonZero, _mm256_div_ps(smallest, largest));
+
+    __m256 one = _mm256_set1_ps(1.f);
+    __m256 reduce = _mm256_cmp_ps(a, _mm256_set1_ps(TRIG_TAN_PI_8), _CMP_GT_OQ);
+    a = _mm256_blendv_ps(a, _mm256_div_ps(_mm256_sub_ps(a, one), _mm256_add_ps(a, one)), reduce);
+    __m256 offset = _mm256_and_ps(reduce, _mm256_set1_ps(PI / 4.f));
+
+    __m256 z = _mm256_mul_ps(a, a);
+    __m256 p = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(TRIG_ATAN_1), z), _mm256_set1_ps(TRIG_ATAN_2));
+    p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(TRIG_ATAN_3));
+    p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(TRIG_ATAN_4));
+    __m256 result = _mm256_add_ps(offset, _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(p, z), a), a));
+
+    result = _mm256_blendv_ps(result, _mm256_sub_ps(_mm256_set1_ps(PI / 2.f), result), _mm256_cmp_ps(ay, ax, _CMP_GT_OQ));
+    result = _mm256_blendv_ps(result, _mm256_sub_ps(_mm256_set1_ps(PI), result), _mm256_castsi256_ps(_mm256_srai_epi32(_mm256_castps_si256(x), 31)));
+    return _mm256_or_ps(result, _mm256_and_ps(signMask, y));
+}
+
+internal void
+fastSinCosArraySSE(const f32 *angles, f32 *sines, f32 *cosines, i32 count)
+{
+    i32 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 s, c;
+        fastSinCos4(_mm_loadu_ps(angles + i), &s, &c);
+        _mm_storeu_ps(sines + i, s);
+        _mm_storeu_ps(cosines + i, c);
+    }
+    for (; i < count; i++)
+        fastSinCos(angles[i], sines + i, cosines + i);
+}
+
+internal void
+fastSinCosArrayAVX(const f32 *angles, f32 *sines, f32 *cosines, i32 count)
+{
+    i32 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 s, c;
+        fastSinCos8(_mm256_loadu_ps(angles + i), &s, &c);
+        _mm256_storeu_ps(sines + i, s);
+        _mm256_storeu_ps(cosines + i, c);
+    }
+    fastSinCosArraySSE(angles + i, sines + i, cosines + i, count - i);
+}
+
+internal void
+fastAtan2ArraySSE(const f32 *y, const f32 *x, f32 *out, i32 count)
+{
+    i32 i = 0;
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(out + i, fastAtan2_4(_mm_loadu_ps(y + i), _mm_loadu_ps(x + i)));
+    for (; i < count; i++)
+        out[i] = fastAtan2(y[i], x[i]);
+}
+
+internal void
+fastAtan2ArrayAVX(const f32 *y, const f32 *x, f32 *out, i32 count)
+{
+    i32 i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(out + i, fastAtan2_8(_mm256_loadu_ps(y + i), _mm256_loadu_ps(x + i)));
+    fastAtan2ArraySSE(y + i, x + i, out + i, count - i);
+}
+
+// the array versions pick the widest kernel the CPU supports
+struct TrigKernels
+{
+    void (*sinCos)(const f32 *angles, f32 *sines, f32 *cosines, i32 count);
+    void (*atan2)(const f32 *y, const f32 *x, f32 *out, i32 count);
+};
+
+internal TrigKernels
+selectTrigKernels()
+{
+    TrigKernels result = { fastSinCosArraySSE, fastAtan2ArraySSE };
+    if (cpuFeatures.avx2) {
+        result.sinCos = fastSinCosArrayAVX;
+        result.atan2 = fastAtan2ArrayAVX;
+    }
+    return result;
+}
+
+global TrigKernels trigKernels = selectTrigKernels();
+
+// sines[i] and cosines[i] of angles[i]
+inline void fastSinCosArray(const f32 *angles, f32 *sines, f32 *cosines, i32 count)
+{
+    trigKernels.sinCos(angles, sines, cosines, count);
+}
+
+// out[i] = atan2(y[i], x[i])
+inline void fastAtan2Array(const f32 *y, const f32 *x, f32 *out, i32 count)
+{
+    trigKernels.atan2(y, x, out, count);
+}
+
+// define FAST_TRIG as 1 before including the framework to make sinus(), cosinus(), arcTangent2() and
+// arcCosine() use the fast versions above everywhere, or call the fast versions directly where it matters
+#ifndef FAST_TRIG
+#define FAST_TRIG 0
+#endif
+
 // sinus(), cosinus() takes radians as input and returns a number between -1 and 1
 inline f32 sinus(f32 angle)
 {
+#if FAST_TRIG
+    f32 result = fastSin(angle);
+#else
     f32 result = sinf(angle);
+#endif
     return result;
 }
 
 inline f32 cosinus(f32 angle)
 {
+#if FAST_TRIG
+    f32 result = fastCos(angle);
+#else
     f32 result = cosf(angle);
+#endif
     return result;
 }
 
 // used for calculating an angle
 inline f32 arcTangent2(f32 y, f32 x)
 {
+#if FAST_TRIG
+    f32 result = fastAtan2(y, x);
+#else
     f32 result = atan2f(y, x);
+#endif
     return result;
 }
 
 // returns the arc cosine (inverse cosine, cos-1) of a number in radians
 inline f32 arcCosine(f32 angle)
 {
+#if FAST_TRIG
+    f32 result = fastArcCosine(angle);
+#else
     f32 result = acosf(angle);
+#endif
     return result;
 }
 
 // convert radians to degrees
-inline f32 degrees(f32 radians)
+constexpr f32 degrees(f32 radians)
 {
     f32 degrees = (radians / TWO_PI) * 360;
     return degrees;
 }
 
 // convert degrees to radians
-inline f32 radians(f32 degrees)
+constexpr f32 radians(f32 degrees)
 {
     f32 radians = (degrees / 360) * TWO_PI;
     return radians;
@@ -441,31 +959,216 @@ inline f32 radians(f32 degrees)
 // Random numbers
 //
 
+// xoshiro256** by Blackman and Vigna, 256 bits of state and 64 bits out per step. it replaces rand(), which
+// gives 15 bits on MSVC, and std::default_random_engine, so random() and randomGaussian() share one generator.
+// every thread has its own state so worker threads can call random() without locks. randomSeed() seeds the
+// calling thread, other threads are seeded from the same seed and the order they draw their first number in.
+// for numbers that don't depend on the threads use streams, see randomStreams() and parallelForRandom()
+struct RandomState
+{
+    u64 s[4];
+};
+
+inline u64 rotateLeft64(u64 value, i32 shift)
+{
+    return (value << shift) | (value >> (64 - shift));
+}
+
+// splitmix64, spreads a 64 bit seed over the state so seeds close together give unrelated sequences
+inline u64 splitMix64(u64 *x)
+{
+    u64 z = (*x += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+inline void randomStateSeed(RandomState *state, u64 seed)
+{
+    u64 x = seed;
+    for (i32 i = 0; i < 4; i++)
+        state->s[i] = splitMix64(&x);
+}
+
+inline u64 randomNext(RandomState *state)
+{
+    u64 *s = state->s;
+    u64 result = rotateLeft64(s[1] * 5, 7) * 9;
+    u64 t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotateLeft64(s[3], 45);
+    return result;
+}
+
+// uniform in [0, range), range 0 means all 2^32 values. Lemire's multiply and shift, the few products
+// that would make some results more likely than others are rejected instead of taking a biased modulo
+inline u32 randomBounded(RandomState *state, u32 range)
+{
+    u32 x = (u32)(randomNext(state) >> 32);
+    if (range == 0)
+        return x;
+    u64 m = (u64)x * range;
+    u32 low = (u32)m;
+    if (low < range) {
+        u32 threshold = (0u - range) % range;
+        while (low < threshold) {
+            x = (u32)(randomNext(state) >> 32);
+            m = (u64)x * range;
+            low = (u32)m;
+        }
+    }
+    return (u32)(m >> 32);
+}
+
+// [0, 1) from the top 24 bits, every result is a multiple of 2^-24 so all of them are exact floats
+inline f32 randomUnitFloat(RandomState *state)
+{
+    return (f32)(randomNext(state) >> 40) * (1.f / 16777216.f);
+}
+
+// jump-ahead, the jump polynomials of the xoshiro reference code. the state moves as far as 2^128 calls
+// of randomNext(), so the states between two jumps never overlap. the long jump is 2^192 calls, for
+// streams of streams
+internal void
+randomJumpBy(RandomState *state, const u64 *polynomial)
+{
+    u64 s[4] = {};
+    for (i32 i = 0; i < 4; i++) {
+        for (i32 b = 0; b < 64; b++) {
+            if (polynomial[i] & (1ull << b)) {
+                s[0] ^= state->s[0];
+                s[1] ^= state->s[1];
+                s[2] ^= state->s[2];
+                s[3] ^= state->s[3];
+            }
+            randomNext(state);
+        }
+    }
+    for (i32 i = 0; i < 4; i++)
+        state->s[i] = s[i];
+}
+
+void randomJump(RandomState *state)
+{
+    static const u64 jump[4] = { 0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull, 0xa9582618e03fc9aaull, 0x39abdc4529b1661cull };
+    randomJumpBy(state, jump);
+}
+
+void randomLongJump(RandomState *state)
+{
+    static const u64 jump[4] = { 0x76e15d3efefdcbbfull, 0xc5004e441c522fb3ull, 0x77710069854ee241ull, 0x39109bb02acbe635ull };
+    randomJumpBy(state, jump);
+}
+
+// count streams from one seed, stream i is the seeded state jumped i times. give every block of work
+// its own stream and the numbers it gets are the same whichever thread runs it
+void randomStreams(RandomState *streams, i32 count, u64 seed)
+{
+    if (count <= 0)
+        return;
+    randomStateSeed(streams, seed);
+    for (i32 i = 1; i < count; i++) {
+        streams[i] = streams[i - 1];
+        randomJump(streams + i);
+    }
+}
+
+// stream index alone, index jumps so use randomStreams() for many of them
+RandomState randomStream(u64 seed, i32 index)
+{
+    RandomState result;
+    randomStateSeed(&result, seed);
+    for (i32 i = 0; i < index; i++)
+        randomJump(&result);
+    return result;
+}
+
+// parallelFor() with a stream per block of blockSize items. the blocks don't change with the number of
+// threads, so neither do the numbers every item gets. keep results per block and combine them in block
+// order afterwards, float sums in another order round differently. maxThreads is passed on to parallelFor()
+typedef void RandomWork(void *data, RandomState *stream, i32 first, i32 last);
+
+struct RandomJob
+{
+    RandomWork *work;
+    void *data;
+    RandomState *streams;
+    i32 count;
+    i32 blockSize;
+};
+
+internal void
+randomJobBlocks(void *data, i32 first, i32 last)
+{
+    RandomJob *job = (RandomJob *)data;
+    for (i32 b = first; b < last; b++) {
+        i32 end = (i32)minimum((i64)(b + 1) * job->blockSize, (i64)job->count);
+        job->work(job->data, job->streams + b, b * job->blockSize, end);
+    }
+}
+
+void parallelForRandom(i32 count, i32 blockSize, u64 seed, RandomWork *work, void *data, i32 maxThreads = 0)
+{
+    if (count <= 0)
+        return;
+    if (blockSize < 1)
+        blockSize = 1;
+    i32 blocks = (i32)(((i64)count + blockSize - 1) / blockSize);
+    RandomJob job = { work, data, (RandomState *)malloc(sizeof(RandomState) * blocks), count, blockSize };
+    randomStreams(job.streams, blocks, seed);
+    parallelFor(blocks, 1, randomJobBlocks, &job, maxThreads);
+    free(job.streams);
+}
+
+global u64 randomBaseSeed = 1;
+global volatile LONG randomThreadCount;
+global thread_local RandomState randomState;
+global thread_local b32 randomStateSeeded;
+
+// the state of the calling thread, seeded on first use
+inline RandomState *threadRandomState()
+{
+    if (!randomStateSeeded) {
+        u64 thread = (u64)InterlockedIncrement(&randomThreadCount);
+        randomStateSeed(&randomState, randomBaseSeed + thread * 0x9e3779b97f4a7c15ull);
+        randomStateSeeded = true;
+    }
+    return &randomState;
+}
+
 // pseudo-random uniform distribution of numbers
 // set the random seed to constant value to return the same pseudo random numbers every time
+// the CRT generator is seeded too, stars2d, stars3d and snow still use rand()
 inline void randomSeed(u32 value)
 {
     srand(value);
+    randomBaseSeed = value;
+    randomStateSeed(&randomState, value);
+    randomStateSeeded = true;
 }
 
 // returns random integer between min and max
 inline i32 random(i32 min, i32 max)
 {
     /* ex:  Random(-10,20) -> will give -10 to, and including, 20. */
-    return i32(rand() % (max - min + 1)) + min;
+    return (i32)((u32)min + randomBounded(threadRandomState(), (u32)max - (u32)min + 1));
 }
 
 // returns random integer between 0 and max
 inline i32 random(i32 max)
 {
-    return i32(rand() % (max - 0 + 1)) + 0;
+    return random(0, max);
 }
 
 // returns a random float between 0 max
 // if no argument is given, returns a random number from 0 up to 1
 inline f32 random(f32 max = 1.f)
 {
-    return ((f32)rand() / (RAND_MAX) * max);
+    return randomUnitFloat(threadRandomState()) * max;
 }
 
 // returns random float between min and max
@@ -474,2714 +1177,6974 @@ inline f32 random(f32 min, f32 max)
     return min + random() * (max - min);
 }
 
-// the likelihood that a random value will be picked is equal to the the first random number (r1)
-// returns a random value between 0 and 1
+// the same from a stream instead of the thread's own state
+inline i32 random(RandomState *state, i32 min, i32 max)
+{
+    return (i32)((u32)min + randomBounded(state, (u32)max - (u32)min + 1));
+}
+
+inline f32 random(RandomState *state, f32 min, f32 max)
+{
+    return min + randomUnitFloat(state) * (max - min);
+}
+
+// returns a random value between 0 and 1 where small values are more likely, value x is picked with a
+// probability proportional to (1 - x)^8. this used to pick a random number and keep it with that
+// probability until one was kept, the inverse of the distribution function 1 - (1 - x)^9 gives the
+// same distribution with one random number. use a Distribution for other curves
 inline f32 montecarlo()
 {
-    // loop until we find a qualifying random number
-    while (true)
-    {
-        f32 r1 = random();
-        f32 probability = powerOf(1.f - r1, 8.f);
+    return 1.f - powf(1.f - random(), 1.f / 9.f);
+}
+
+// the ziggurat method of Marsaglia and Tsang: the density is covered by 128 (normal) or 256 (exponential)
+// layers of equal area. a random layer and a random point in it are picked and about 99% of the time the
+// point is under the curve without any exp() or log(). the layer index and the value come from different
+// bits of one 64 bit number, using the same bits for both biases the tails
+struct ZigguratTables
+{
+    u32 kn[128];    // |value| below this is accepted right away
+    f32 wn[128];    // value scale of the layer
+    f32 fn[128];    // density at the edge of the layer
+    u32 ke[256];
+    f32 we[256];
+    f32 fe[256];
+};
 
-        f32 r2 = random();
+internal ZigguratTables
+buildZigguratTables()
+{
+    ZigguratTables t = {};
+
+    // normal, r is where the tail starts and v the area of every layer
+    f64 m1 = 2147483648.0;
+    f64 dn = 3.442619855899, tn = dn, vn = 9.91256303526217e-3;
+    f64 q = vn / exp(-0.5 * dn * dn);
+    t.kn[0] = (u32)((dn / q) * m1);
+    t.kn[1] = 0;
+    t.wn[0] = (f32)(q / m1);
+    t.wn[127] = (f32)(dn / m1);
+    t.fn[0] = 1.f;
+    t.fn[127] = (f32)exp(-0.5 * dn * dn);
+    for (i32 i = 126; i >= 1; i--) {
+        dn = sqrt(-2.0 * log(vn / dn + exp(-0.5 * dn * dn)));
+        t.kn[i + 1] = (u32)((dn / tn) * m1);
+        tn = dn;
+        t.fn[i] = (f32)exp(-0.5 * dn * dn);
+        t.wn[i] = (f32)(dn / m1);
+    }
 
-        if (r2 < probability)
-            return r1;
+    // exponential
+    f64 m2 = 4294967296.0;
+    f64 de = 7.697117470131487, te = de, ve = 3.949659822581572e-3;
+    q = ve / exp(-de);
+    t.ke[0] = (u32)((de / q) * m2);
+    t.ke[1] = 0;
+    t.we[0] = (f32)(q / m2);
+    t.we[255] = (f32)(de / m2);
+    t.fe[0] = 1.f;
+    t.fe[255] = (f32)exp(-de);
+    for (i32 i = 254; i >= 1; i--) {
+        de = -log(ve / de + exp(-de));
+        t.ke[i + 1] = (u32)((de / te) * m2);
+        te = de;
+        t.fe[i] = (f32)exp(-de);
+        t.we[i] = (f32)(de / m2);
     }
+    return t;
 }
 
-std::default_random_engine randomGenerator;
+global ZigguratTables zigguratTables = buildZigguratTables();
+
+internal f32
+zigguratNormal(RandomState *state)
+{
+    const ZigguratTables *t = &zigguratTables;
+    for (;;) {
+        u64 r = randomNext(state);
+        u32 layer = (u32)r & 127;
+        i32 hz = (i32)(r >> 32);
+        u32 magnitude = hz < 0 ? 0u - (u32)hz : (u32)hz;
+        f32 x = (f32)hz * t->wn[layer];
+        if (magnitude < t->kn[layer])
+            return x;
+
+        if (layer == 0) {
+            // the tail beyond r, Marsaglia's exponential rejection
+            f32 tx, ty;
+            do {
+                tx = -logf(1.f - randomUnitFloat(state)) * (1.f / 3.442619855899f);
+                ty = -logf(1.f - randomUnitFloat(state));
+            } while (ty + ty < tx * tx);
+            return hz > 0 ? 3.442619855899f + tx : -3.442619855899f - tx;
+        }
+
+        // between the layer's rectangle and the curve, compare with the density
+        if (t->fn[layer] + randomUnitFloat(state) * (t->fn[layer - 1] - t->fn[layer]) < expf(-0.5f * x * x))
+            return x;
+    }
+}
 
 // returns a Gaussian(normal) distribution of random numbers around the mean with a specific standard deviation.
 // the probability of getting values far from the mean is low, the probability of getting numbers near the mean is high.
 inline f32 randomGaussian()
 {
-    //std::default_random_engine randomGenerator;
-    //gaussian random numbers with a mean of 0 and standard deviation of 1.0
-    std::normal_distribution<f32> gaussianDistribution(0.0f, 1.0f);
-    return gaussianDistribution(randomGenerator);
+    return zigguratNormal(threadRandomState());
 }
 
 inline f32 randomGaussian(f32 mean)
 {
-    //std::default_random_engine randomGenerator;
-    std::normal_distribution<f32> gaussianDistribution(mean, 1.0f);
-    return gaussianDistribution(randomGenerator);
+    return mean + randomGaussian();
 }
 
 inline f32 randomGaussian(f32 mean, f32 sd)
 {
-    //std::default_random_engine randomGenerator;
-    std::normal_distribution<f32> gaussianDistribution(mean, sd);
-    return gaussianDistribution(randomGenerator);
+    return mean + sd * randomGaussian();
 }
 
-//
-// Noise
-//
-
-#include "ext/include/slang_library_noise.cpp"
-//1D Perlin noise, returns noise value at specified coordinate, the value is always between 0 and 1.
-inline f32 noise(f32 x)
+inline f32 randomGaussian(RandomState *state, f32 mean, f32 sd)
 {
-    return _slang_library_noise1(x) * 0.5f + 0.5f;
+    return mean + sd * zigguratNormal(state);
 }
 
-//2D Perlin noise
-inline f32 noise(f32 x, f32 y)
+// exponential distribution, the time between events that happen rate times per unit on average
+inline f32 randomExponential(RandomState *state, f32 rate)
 {
-    return _slang_library_noise2(x, y) * 0.5f + 0.5f;
+    const ZigguratTables *t = &zigguratTables;
+    for (;;) {
+        u64 r = randomNext(state);
+        u32 layer = (u32)r & 255;
+        u32 jz = (u32)(r >> 32);
+        f32 x = (f32)jz * t->we[layer];
+        if (jz < t->ke[layer])
+            return x / rate;
+
+        // the tail is the same distribution shifted, no rejection needed
+        if (layer == 0)
+            return (7.697117470131487f - logf(1.f - randomUnitFloat(state))) / rate;
+
+        if (t->fe[layer] + randomUnitFloat(state) * (t->fe[layer - 1] - t->fe[layer]) < expf(-x))
+            return x / rate;
+    }
 }
 
-//3D Perlin noise
-inline f32 noise(f32 x, f32 y, f32 z)
+inline f32 randomExponential(f32 rate = 1.f)
 {
-    return _slang_library_noise3(x, y, z) * 0.5f + 0.5f;
+    return randomExponential(threadRandomState(), rate);
 }
 
+// Poisson distribution, the number of events in a unit when mean of them happen on average
+inline i32 randomPoisson(RandomState *state, f32 mean)
+{
+    if (mean <= 0.f)
+        return 0;
 
-//
-// Vectors 
-//
-
-union v2 {
-    
-    struct {
-        f32 x, y;
-    };
-    struct {
-        f32 w, h;
-    };
-    
-    v2() { };
-    v2(f32 X, f32 Y) : x(X), y(Y) {}
-    
-    // calculate length (magnitude) of the vector, square root of x^2 + y^2 -> same as sqrt(dotProduct(*this))
-    // The Pythagorean Theorem
-    f32 length() 
-    {
-        f32 result = sqrt(x * x + y * y);
-        return result;
-    }
-    
-    // returns the angle of rotation, the heading (direction), of the vector.
-    f32 heading() 
-    { 
-        f32 result = arcTangent2(y, x);
+    // small means, multiply uniform numbers until the product drops below exp(-mean)
+    if (mean < 10.f) {
+        f32 limit = expf(-mean);
+        f32 product = 1.f - randomUnitFloat(state);
+        i32 result = 0;
+        while (product > limit) {
+            product *= 1.f - randomUnitFloat(state);
+            result++;
+        }
         return result;
     }
-    
-    // calculate the dot(inner) product, returns a scalar
-    // dot product of a * b = lenght of a * length of b * cos(angle between them)
-    // The dot product consists of multiplying each element of the A vector with its counterpart from vector B and taking the sum of each product.
-    f32 dotProduct(v2 a)
-    {
-        f32 result = x * a.x + y * a.y;
-        return result;
+
+    // Hormann's transformed rejection (PTRS), constant time for large means. the final test compares two
+    // sides that grow with the mean and nearly cancel, it is done in double precision like the reference
+    f32 slam = squareRoot(mean);
+    f64 logMean = log((f64)mean);
+    f32 b = 0.931f + 2.53f * slam;
+    f32 a = -0.059f + 0.02483f * b;
+    f32 invAlpha = 1.1239f + 1.1328f / (b - 3.4f);
+    f32 vr = 0.9277f - 3.6224f / (b - 2.f);
+    for (;;) {
+        f32 u = randomUnitFloat(state) - 0.5f;
+        f32 v = randomUnitFloat(state);
+        f32 us = 0.5f - absoluteValue(u);
+        i32 k = floorFloatToInt((2.f * a / us + b) * u + mean + 0.43f);
+        if (us >= 0.07f && v <= vr)
+            return k;
+        if (k < 0 || (us < 0.013f && v > us))
+            continue;
+        if (log((f64)v * invAlpha / (a / (us * us) + b)) <= -(f64)mean + (f64)k * logMean - lgamma((f64)k + 1.0))
+            return k;
     }
-    
-    // calculates and returns the angle (in radians) between two vectors
-    // dot product of a * b = lenght of a * length of b * cos(angle between them)
-    f32 angleBetween(v2 a)
-    {
-        f32 d = a.dotProduct(*this);
-        f32 result = acos(d / (a.length() * (*this).length()));
-        return result;
+}
+
+inline i32 randomPoisson(f32 mean)
+{
+    return randomPoisson(threadRandomState(), mean);
+}
+
+// bulk generation: 8 xoshiro128** generators side by side in SIMD lanes, 4 lanes per SSE instruction and
+// 8 with AVX2. the lanes are a thread_local state of their own, seeded from the generator above, so
+// randomSeed() also decides what the fill functions return, and SSE and AVX2 give the same numbers
+#define RANDOM_LANES 8
+#define RANDOM_BLOCK 256
+
+struct RandomLanes
+{
+    u32 s[4][RANDOM_LANES];
+};
+
+global thread_local RandomLanes randomLanes;
+global thread_local b32 randomLanesSeeded;
+
+inline RandomLanes *threadRandomLanes()
+{
+    if (!randomLanesSeeded) {
+        RandomState *state = threadRandomState();
+        for (i32 lane = 0; lane < RANDOM_LANES; lane++) {
+            u64 a = randomNext(state);
+            u64 b = randomNext(state);
+            // an all zero state would only give zeros
+            randomLanes.s[0][lane] = (u32)a | 1;
+            randomLanes.s[1][lane] = (u32)(a >> 32);
+            randomLanes.s[2][lane] = (u32)b;
+            randomLanes.s[3][lane] = (u32)(b >> 32);
+        }
+        randomLanesSeeded = true;
     }
-    
-    // set length of vector
-    void setLength(f32 length)
-    {
-        f32 a = heading();
-        x = cos(a) * length;
-        y = sin(a) * length;
+    return &randomLanes;
+}
+
+// one xoshiro128** step of 4 lanes, the multiplies by 5 and 9 are shifts and adds
+inline __m128i randomLanesStep4(__m128i *s)
+{
+    __m128i x5 = _mm_add_epi32(_mm_slli_epi32(s[1], 2), s[1]);
+    __m128i r = _mm_or_si128(_mm_slli_epi32(x5, 7), _mm_srli_epi32(x5, 25));
+    r = _mm_add_epi32(_mm_slli_epi32(r, 3), r);
+    __m128i t = _mm_slli_epi32(s[1], 9);
+    s[2] = _mm_xor_si128(s[2], s[0]);
+    s[3] = _mm_xor_si128(s[3], s[1]);
+    s[1] = _mm_xor_si128(s[1], s[2]);
+    s[0] = _mm_xor_si128(s[0], s[3]);
+    s[2] = _mm_xor_si128(s[2], t);
+    s[3] = _mm_or_si128(_mm_slli_epi32(s[3], 11), _mm_srli_epi32(s[3], 21));
+    return r;
+}
+
+inline __m256i randomLanesStep8(__m256i *s)
+{
+    __m256i x5 = _mm256_add_epi32(_mm256_slli_epi32(s[1], 2), s[1]);
+    __m256i r = _mm256_or_si256(_mm256_slli_epi32(x5, 7), _mm256_srli_epi32(x5, 25));
+    r = _mm256_add_epi32(_mm256_slli_epi32(r, 3), r);
+    __m256i t = _mm256_slli_epi32(s[1], 9);
+    s[2] = _mm256_xor_si256(s[2], s[0]);
+    s[3] = _mm256_xor_si256(s[3], s[1]);
+    s[1] = _mm256_xor_si256(s[1], s[2]);
+    s[0] = _mm256_xor_si256(s[0], s[3]);
+    s[2] = _mm256_xor_si256(s[2], t);
+    s[3] = _mm256_or_si256(_mm256_slli_epi32(s[3], 11), _mm256_srli_epi32(s[3], 21));
+    return r;
+}
+
+// count / 8 steps of all lanes, count is a multiple of 8
+internal void
+randomBitsSSE(RandomLanes *lanes, u32 *out, i32 count)
+{
+    __m128i lo[4], hi[4];
+    for (i32 i = 0; i < 4; i++) {
+        lo[i] = _mm_loadu_si128((__m128i *)lanes->s[i]);
+        hi[i] = _mm_loadu_si128((__m128i *)(lanes->s[i] + 4));
     }
-    
-    // set the angle of the vector
-    void setAngle(f32 angle)
-    {
-        f32 l = length();
-        x = cos(angle) * l;
-        y = sin(angle) * l;
+    for (i32 i = 0; i < count; i += RANDOM_LANES) {
+        _mm_storeu_si128((__m128i *)(out + i), randomLanesStep4(lo));
+        _mm_storeu_si128((__m128i *)(out + i + 4), randomLanesStep4(hi));
     }
-    
-    // limit the magnitude of the vector
-    void limit(f32 max)
-    {
-        if (length() > max)
-            setLength(max);
+    for (i32 i = 0; i < 4; i++) {
+        _mm_storeu_si128((__m128i *)lanes->s[i], lo[i]);
+        _mm_storeu_si128((__m128i *)(lanes->s[i] + 4), hi[i]);
     }
-    
-    // calculate a unit vector. normalizing a vector makes its length equal to 1.
-    // to normalize a vector - multiply it by the inverse of its length
-    // or divide each component by its length
-    void normalize()
-    {
-        f32 l = length();
-        // avoid divide by 0
-        if (l > 0) { 
-            x *= 1 / l;
-            y *= 1 / l;
-            //x /= l;
-            //y /= l;
+}
+
+internal void
+randomBitsAVX(RandomLanes *lanes, u32 *out, i32 count)
+{
+    __m256i s[4];
+    for (i32 i = 0; i < 4; i++)
+        s[i] = _mm256_loadu_si256((__m256i *)lanes->s[i]);
+    for (i32 i = 0; i < count; i += RANDOM_LANES)
+        _mm256_storeu_si256((__m256i *)(out + i), randomLanesStep8(s));
+    for (i32 i = 0; i < 4; i++)
+        _mm256_storeu_si256((__m256i *)lanes->s[i], s[i]);
+}
+
+global void (*randomBitsKernel)(RandomLanes *lanes, u32 *out, i32 count) = cpuFeatures.avx2 ? randomBitsAVX : randomBitsSSE;
+
+// count random 32 bit values, the last step is thrown away if count isn't a multiple of 8
+void randomFillBits(u32 *out, i32 count)
+{
+    RandomLanes *lanes = threadRandomLanes();
+    i32 whole = count & ~(RANDOM_LANES - 1);
+    randomBitsKernel(lanes, out, whole);
+    if (whole < count) {
+        u32 tail[RANDOM_LANES];
+        randomBitsKernel(lanes, tail, RANDOM_LANES);
+        memcpy(out + whole, tail, (count - whole) * sizeof(u32));
+    }
+}
+
+// natural logarithm of 4 positive normal floats, the cephes logf polynomial, max relative error 2e-7
+inline __m128 randomLog4(__m128 x)
+{
+    // x = m * 2^e with m in [sqrt(0.5), sqrt(2))
+    __m128i bits = _mm_castps_si128(x);
+    __m128i e = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127));
+    __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+    __m128 big = _mm_cmpgt_ps(m, _mm_set1_ps(1.41421356f));
+    m = _mm_sub_ps(_mm_or_ps(_mm_and_ps(big, _mm_mul_ps(m, _mm_set1_ps(0.5f))), _mm_andnot_ps(big, m)), _mm_set1_ps(1.f));
+    __m128 fe = _mm_add_ps(_mm_cvtepi32_ps(e), _mm_and_ps(big, _mm_set1_ps(1.f)));
+
+    __m128 z = _mm_mul_ps(m, m);
+    __m128 p = _mm_set1_ps(7.0376836292e-2f);
+    p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(-1.1514610310e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(1.1676998740e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(-1.2420140846e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(1.4249322787e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(-1.6668057665e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(2.0000714765e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(-2.4999993993e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(3.3333331174e-1f));
+    p = _mm_mul_ps(_mm_mul_ps(p, m), z);
+    p = _mm_sub_ps(p, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+    __m128 result = _mm_add_ps(m, p);
+    return _mm_add_ps(result, _mm_mul_ps(fe, _mm_set1_ps(0.693147180559945f)));
+}
+
+// out[i] uniform in [min, max)
+void randomFill(f32 *out, i32 count, f32 min = 0.f, f32 max = 1.f)
+{
+    u32 bits[RANDOM_BLOCK];
+    __m128 scale = _mm_set1_ps((max - min) * (1.f / 16777216.f));
+    __m128 offset = _mm_set1_ps(min);
+    for (i32 first = 0; first < count; first += RANDOM_BLOCK) {
+        i32 n = minimum(RANDOM_BLOCK, count - first);
+        randomFillBits(bits, (n + 3) & ~3);
+        i32 i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128i top = _mm_srli_epi32(_mm_loadu_si128((__m128i *)(bits + i)), 8);
+            _mm_storeu_ps(out + first + i, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(top), scale), offset));
+        }
+        for (; i < n; i++)
+            out[first + i] = (f32)(bits[i] >> 8) * (1.f / 16777216.f) * (max - min) + min;
+    }
+}
+
+// out[i] uniform in [min, max] like random(min, max), with the same rejection so no value is favoured
+void randomFillInt(i32 *out, i32 count, i32 min, i32 max)
+{
+    u32 range = (u32)max - (u32)min + 1;
+    if (range == 0) {
+        randomFillBits((u32 *)out, count);
+        return;
+    }
+    u32 threshold = (0u - range) % range;
+    u32 bits[RANDOM_BLOCK];
+    __m128i r = _mm_set1_epi32((i32)range);
+    __m128i base = _mm_set1_epi32(min);
+    __m128i flip = _mm_set1_epi32((i32)0x80000000);
+    __m128i limit = _mm_xor_si128(_mm_set1_epi32((i32)threshold), flip);
+    for (i32 first = 0; first < count; first += RANDOM_BLOCK) {
+        i32 n = minimum(RANDOM_BLOCK, count - first);
+        randomFillBits(bits, (n + 3) & ~3);
+        i32 i = 0;
+        for (; i + 4 <= n; i += 4) {
+            // 32 x 32 -> 64 bit products of the even and the odd lanes
+            __m128i x = _mm_loadu_si128((__m128i *)(bits + i));
+            __m128i even = _mm_mul_epu32(x, r);
+            __m128i odd = _mm_mul_epu32(_mm_srli_epi64(x, 32), r);
+            __m128i high = _mm_unpacklo_epi64(_mm_unpacklo_epi32(_mm_srli_epi64(even, 32), _mm_srli_epi64(odd, 32)),
+                _mm_unpackhi_epi32(_mm_srli_epi64(even, 32), _mm_srli_epi64(odd, 32)));
+            __m128i low = _mm_unpacklo_epi64(_mm_unpacklo_epi32(even, odd), _mm_unpackhi_epi32(even, odd));
+            _mm_storeu_si128((__m128i *)(out + first + i), _mm_add_epi32(high, base));
+
+            // the rare lanes Lemire's method rejects get a new value from the scalar generator
+            i32 rejected = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(_mm_xor_si128(low, flip), limit)));
+            for (i32 lane = 0; rejected; lane++, rejected >>= 1) {
+                if (rejected & 1)
+                    out[first + i + lane] = (i32)((u32)min + randomBounded(threadRandomState(), range));
+            }
+        }
+        for (; i < n; i++) {
+            u64 m = (u64)bits[i] * range;
+            out[first + i] = (u32)m < threshold ? (i32)((u32)min + randomBounded(threadRandomState(), range)) :
+                (i32)((u32)min + (u32)(m >> 32));
+        }
+    }
+}
+
+// normal distribution with the Box-Muller transform, every pair of uniform numbers gives two normal ones.
+// with the 4 lane logarithm and fastSinCos4 this is faster than a loop of the ziggurat randomGaussian()
+void randomGaussianFill(f32 *out, i32 count, f32 mean = 0.f, f32 sd = 1.f)
+{
+    u32 bits[RANDOM_BLOCK];
+    f32 values[RANDOM_BLOCK];
+    __m128 unit = _mm_set1_ps(1.f / 16777216.f);
+    for (i32 first = 0; first < count; first += RANDOM_BLOCK) {
+        i32 n = minimum(RANDOM_BLOCK, count - first);
+        randomFillBits(bits, RANDOM_BLOCK);
+        for (i32 i = 0; i < RANDOM_BLOCK; i += 8) {
+            // u in (0, 1] so the logarithm is finite
+            __m128 u = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_srli_epi32(_mm_loadu_si128((__m128i *)(bits + i)), 8), _mm_set1_epi32(1))), unit);
+            __m128 v = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(_mm_loadu_si128((__m128i *)(bits + i + 4)), 8)), unit);
+            __m128 radius = _mm_mul_ps(_mm_sqrt_ps(_mm_mul_ps(_mm_set1_ps(-2.f), randomLog4(u))), _mm_set1_ps(sd));
+            __m128 s, c;
+            fastSinCos4(_mm_mul_ps(v, _mm_set1_ps(TWO_PI)), &s, &c);
+            _mm_storeu_ps(values + i, _mm_add_ps(_mm_mul_ps(radius, c), _mm_set1_ps(mean)));
+            _mm_storeu_ps(values + i + 4, _mm_add_ps(_mm_mul_ps(radius, s), _mm_set1_ps(mean)));
+        }
+        memcpy(out + first, values, n * sizeof(f32));
+    }
+}
+
+// exponential distribution, -log(u) / rate with u in (0, 1]
+void randomExponentialFill(f32 *out, i32 count, f32 rate = 1.f)
+{
+    u32 bits[RANDOM_BLOCK];
+    __m128 unit = _mm_set1_ps(1.f / 16777216.f);
+    __m128 scale = _mm_set1_ps(-1.f / rate);
+    for (i32 first = 0; first < count; first += RANDOM_BLOCK) {
+        i32 n = minimum(RANDOM_BLOCK, count - first);
+        randomFillBits(bits, (n + 3) & ~3);
+        i32 i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128 u = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_srli_epi32(_mm_loadu_si128((__m128i *)(bits + i)), 8), _mm_set1_epi32(1))), unit);
+            _mm_storeu_ps(out + first + i, _mm_mul_ps(randomLog4(u), scale));
         }
+        for (; i < n; i++)
+            out[first + i] = -logf((f32)((bits[i] >> 8) + 1) * (1.f / 16777216.f)) / rate;
     }
+}
+
+// Poisson distribution, one randomPoisson() per value
+void randomPoissonFill(i32 *out, i32 count, f32 mean)
+{
+    for (i32 i = 0; i < count; i++)
+        out[i] = randomPoisson(mean);
+}
+
+// a distribution of your own, built once from a probability density or a list of weights and then
+// sampled in constant time with Walker's alias method: every bin keeps its own index with some
+// probability and otherwise gives its alias. the range min to max is split in count bins and the
+// value is uniform inside the picked bin. distributionSampleIndex() only picks the bin, for weighted choices
+struct Distribution
+{
+    i32 count;
+    f32 min, max;
+    f32 *probability;   // chance to keep the bin instead of taking the alias
+    i32 *alias;
 };
 
-// overloaded operators
-// vector addition: newVector = v1 + v2;
-inline v2 operator+(v2 a, v2 b)
+// the weights don't have to sum to 1, negative weights count as 0 and all 0 gives a uniform distribution
+Distribution distributionCreate(const f32 *weights, i32 count, f32 min = 0.f, f32 max = 1.f)
+{
+    Assert(count > 0);
+    Distribution d = {};
+    d.count = count;
+    d.min = min;
+    d.max = max;
+    d.probability = (f32 *)malloc(count * sizeof(f32));
+    d.alias = (i32 *)malloc(count * sizeof(i32));
+
+    f64 total = 0.0;
+    for (i32 i = 0; i < count; i++)
+        total += maximum(weights[i], 0.f);
+
+    // Vose's version: weights scaled so the average is 1, bins below 1 are filled up from bins above 1.
+    // the bins below 1 are a stack at the start of work and the ones above at the end
+    f64 *scaled = (f64 *)malloc(count * sizeof(f64));
+    i32 *work = (i32 *)malloc(count * sizeof(i32));
+    i32 lightCount = 0, heavyCount = 0;
+    for (i32 i = 0; i < count; i++) {
+        scaled[i] = total > 0.0 ? maximum(weights[i], 0.f) * count / total : 1.0;
+        if (scaled[i] < 1.0)
+            work[lightCount++] = i;
+        else
+            work[count - ++heavyCount] = i;
+    }
+
+    while (lightCount > 0 && heavyCount > 0) {
+        i32 light = work[--lightCount];
+        i32 heavy = work[count - heavyCount];
+        d.probability[light] = (f32)scaled[light];
+        d.alias[light] = heavy;
+        scaled[heavy] = (scaled[heavy] + scaled[light]) - 1.0;
+        if (scaled[heavy] < 1.0) {
+            heavyCount--;
+            work[lightCount++] = heavy;
+        }
+    }
+
+    // what is left is 1 up to rounding errors
+    while (heavyCount > 0) {
+        i32 i = work[count - heavyCount--];
+        d.probability[i] = 1.f;
+        d.alias[i] = i;
+    }
+    while (lightCount > 0) {
+        i32 i = work[--lightCount];
+        d.probability[i] = 1.f;
+        d.alias[i] = i;
+    }
+
+    free(scaled);
+    free(work);
+    return d;
+}
+
+// samples the density in the middle of every bin, pdf doesn't have to integrate to 1
+Distribution distributionCreate(f32 (*pdf)(f32 x), i32 count, f32 min, f32 max)
 {
-    v2 result;
-    result.x = a.x + b.x;
-    result.y = a.y + b.y;
-    return result;
+    f32 *weights = (f32 *)malloc(count * sizeof(f32));
+    f32 binWidth = (max - min) / (f32)count;
+    for (i32 i = 0; i < count; i++)
+        weights[i] = pdf(min + ((f32)i + 0.5f) * binWidth);
+    Distribution d = distributionCreate(weights, count, min, max);
+    free(weights);
+    return d;
 }
 
-// v1 += v2;
-inline v2 &operator+=(v2 &a, v2 b)
+void distributionFree(Distribution *d)
 {
-    a = a + b;
-    return a;
+    free(d->probability);
+    free(d->alias);
+    *d = {};
 }
 
-// vector subtraction
-inline v2 operator-(v2 a, v2 b)
+// one 64 bit number is enough for a draw: the high half times count gives the bin in the top 32 bits of
+// the product and a uniform position inside the bin in the low 32 bits, the low half decides between the
+// bin and its alias. the bin is off by at most count / 2^32 from uniform, far below what can be measured
+inline i32 distributionBin(const Distribution *d, u64 r, f32 *position)
 {
-    v2 result;
-    result.x = a.x - b.x;
-    result.y = a.y - b.y;
-    return result;
+    u64 m = (r >> 32) * (u64)d->count;
+    i32 bin = (i32)(m >> 32);
+    *position = (f32)((u32)m >> 8) * (1.f / 16777216.f);
+    if ((f32)((u32)r >> 8) * (1.f / 16777216.f) >= d->probability[bin])
+        bin = d->alias[bin];
+    return bin;
 }
 
-inline v2 operator-=(v2 &a, v2 b)
+// a bin index from 0 to count - 1, picked with the probability of its weight
+inline i32 distributionSampleIndex(const Distribution *d)
 {
-    a = a - b;
-    return a;
+    f32 position;
+    return distributionBin(d, randomNext(threadRandomState()), &position);
 }
 
-// vector multiplication with a scalar number (vector scaling)
-inline v2 operator*(f32 scalar, v2 a)
+// a value between min and max
+inline f32 distributionSample(RandomState *state, const Distribution *d)
 {
-    v2 result;
-    result.x = scalar * a.x;
-    result.y = scalar * a.y;
-    return result;
+    f32 position;
+    i32 bin = distributionBin(d, randomNext(state), &position);
+    return d->min + ((f32)bin + position) * ((d->max - d->min) / (f32)d->count);
 }
 
-inline v2 operator*(v2 a, f32 scalar)
+inline f32 distributionSample(const Distribution *d)
 {
-    v2 result = scalar * a;
-    return result;
+    return distributionSample(threadRandomState(), d);
 }
 
-inline v2 &operator*=(v2 &a, f32 scalar)
+// count values, the random numbers come from the SIMD lanes like randomFill()
+void distributionFill(const Distribution *d, f32 *out, i32 count)
 {
-    a = scalar * a;
-    return a;
+    u32 bits[RANDOM_BLOCK];
+    f32 binWidth = (d->max - d->min) / (f32)d->count;
+    for (i32 first = 0; first < count; first += RANDOM_BLOCK / 2) {
+        i32 n = minimum(RANDOM_BLOCK / 2, count - first);
+        randomFillBits(bits, n * 2);
+        for (i32 i = 0; i < n; i++) {
+            f32 position;
+            i32 bin = distributionBin(d, ((u64)bits[2 * i] << 32) | bits[2 * i + 1], &position);
+            out[first + i] = d->min + ((f32)bin + position) * binWidth;
+        }
+    }
 }
 
-// divide by a scalar number
-inline v2 operator/(f32 scalar, v2 a)
+// count bin indices
+void distributionFillIndex(const Distribution *d, i32 *out, i32 count)
 {
-    v2 result;
-    result.x = scalar / a.x;
-    result.y = scalar / a.y;
-    return result;
+    u32 bits[RANDOM_BLOCK];
+    for (i32 first = 0; first < count; first += RANDOM_BLOCK / 2) {
+        i32 n = minimum(RANDOM_BLOCK / 2, count - first);
+        randomFillBits(bits, n * 2);
+        for (i32 i = 0; i < n; i++) {
+            f32 position;
+            out[first + i] = distributionBin(d, ((u64)bits[2 * i] << 32) | bits[2 * i + 1], &position);
+        }
+    }
 }
 
-inline v2 operator/(v2 a, f32 scalar)
+//
+// Noise
+//
+
+#include "ext/include/slang_library_noise.cpp"
+
+// noise is a sum of octaves of simplex noise, every octave has twice the frequency of the one before and
+// falloff times its amplitude. the sum is divided by the total amplitude so the value stays between 0 and
+// 1. the default is a single octave, noiseDetail(4, 0.5f) gives the look of noise() in Processing
+enum { NOISE_FBM, NOISE_RIDGED, NOISE_TURBULENCE };
+
+#define NOISE_MAX_OCTAVES 16
+
+// two copies of the 256 shuffled values, the rest pads the 32 bit gathers of the grid kernels and makes
+// an instance a whole number of cache lines
+#define NOISE_PERM_SIZE 568
+
+// a noise instance, its own permutation table and octaves. the functions without an instance use
+// noiseDefault, which noiseSeed() and noiseDetail() change. instances share nothing, so layers of noise
+// can be made on separate threads
+struct __declspec(align(64)) Noise
 {
-    v2 result;
-    result.x = a.x / scalar;
-    result.y = a.y / scalar;
-    return result;
+    u8 perm[NOISE_PERM_SIZE];
+    i32 octaves;
+    f32 falloff;
+};
+
+static_assert(sizeof(Noise) % 64 == 0, "Noise should fill whole cache lines");
+
+// a Fisher-Yates shuffle of 0..255 from the seed
+void noiseSeed(Noise *n, u32 seed)
+{
+    RandomState state;
+    randomStateSeed(&state, seed);
+    for (i32 i = 0; i < 256; i++)
+        n->perm[i] = (u8)i;
+    for (i32 i = 255; i > 0; i--) {
+        u32 j = randomBounded(&state, (u32)i + 1);
+        u8 swap = n->perm[i];
+        n->perm[i] = n->perm[j];
+        n->perm[j] = swap;
+    }
+    for (i32 i = 256; i < NOISE_PERM_SIZE; i++)
+        n->perm[i] = i < 512 ? n->perm[i - 256] : 0;
 }
 
-inline v2 &operator/=(v2 &a, f32 scalar)
+// falloff is kept between 0 and 1, a negative one can make the amplitudes sum to 0 and the noise NaN
+void noiseDetail(Noise *n, i32 octaves, f32 falloff = 0.5f)
 {
-    a.x /= scalar;
-    a.y /= scalar;
-    return a;
+    n->octaves = constrain(octaves, 1, NOISE_MAX_OCTAVES);
+    n->falloff = falloff > 0.f ? minimum(falloff, 1.f) : 0.f;
 }
 
-// vector negation, vector equals it's negative
-inline v2 operator-(v2 a)
+Noise noiseCreate(u32 seed)
 {
-    v2 result;
-    
-    result.x = -a.x;
-    result.y = -a.y;
-    
+    Noise result;
+    noiseSeed(&result, seed);
+    noiseDetail(&result, 1);
     return result;
 }
 
-// the hadamard product - element-wise product of two vectors which return a new vector
-inline v2 v2Hadamard(v2 a, v2 b)
+// the table of the simplex noise library, so noise() is the same as always until noiseSeed() is called
+internal Noise
+createDefaultNoise()
 {
-    v2 result = { a.x * b.x, a.y * b.y };
+    Noise result = {};
+    for (i32 i = 0; i < 512; i++)
+        result.perm[i] = perm[i];
+    noiseDetail(&result, 1);
     return result;
 }
 
-// calculate the dot(inner) product which gives us the angle between two vectors, returns a scalar
-// The dot product tells you what amount of one vector goes in the direction of another.
-// dot product of a * b = lenght of a * length of b * cos(angle between them)
-// The dot product consists of multiplying each element of the A vector with its counterpart from vector B and taking the sum of each product.
-inline f32 v2DotProduct(v2 a, v2 b)
+global Noise noiseDefault = createDefaultNoise();
+
+void noiseSeed(u32 seed)
 {
-    f32 result = a.x * b.x + a.y * b.y;
-    return result;
+    noiseSeed(&noiseDefault, seed);
 }
 
-// using the Pythagorean Theorem to calculate the distance between 2 points
-// same as calculating a vectors length
-inline f32 dist(v2 a, v2 b)
+void noiseDetail(i32 octaves, f32 falloff = 0.5f)
 {
-    return squareRoot((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y));
+    noiseDetail(&noiseDefault, octaves, falloff);
 }
 
-// random 2d direction
-inline v2 random2d()
+// an octave as the fractal adds it up. ridged noise folds every octave into sharp crests where the noise
+// crosses 0.5, turbulence into creases at the same places
+inline f32 noiseFractalOctave(f32 n, i32 fractal)
 {
-    v2 vec = v2(1.0, 1.0);
-    //vec.normalize();
-    vec.setAngle(random() * TWO_PI);
-    return vec;
+    if (fractal == NOISE_FBM)
+        return n;
+    f32 folded = absoluteValue(2.f * n - 1.f);
+    if (fractal == NOISE_TURBULENCE)
+        return folded;
+    return (1.f - folded) * (1.f - folded);
 }
 
-inline void v2Swap(v2 *a, v2 *b)
+internal f32
+noiseFractal(const Noise *noise, i32 dimensions, f32 x, f32 y, f32 z, f32 w, i32 fractal)
+{
+    f32 sum = 0.f;
+    f32 total = 0.f;
+    f32 amplitude = 1.f;
+    f32 frequency = 1.f;
+    for (i32 octave = 0; octave < noise->octaves; octave++) {
+        f32 n;
+        if (dimensions == 1)
+            n = _slang_library_noise1(x * frequency, noise->perm);
+        else if (dimensions == 2)
+            n = _slang_library_noise2(x * frequency, y * frequency, noise->perm);
+        else if (dimensions == 3)
+            n = _slang_library_noise3(x * frequency, y * frequency, z * frequency, noise->perm);
+        else
+            n = _slang_library_noise4(x * frequency, y * frequency, z * frequency, w * frequency, noise->perm);
+        sum += amplitude * noiseFractalOctave(n * 0.5f + 0.5f, fractal);
+        total += amplitude;
+        amplitude *= noise->falloff;
+        frequency *= 2.f;
+    }
+    return sum / total;
+}
+
+//1D Perlin noise, returns noise value at specified coordinate, the value is always between 0 and 1.
+inline f32 noise(f32 x)
 {
-    v2 temp;
-    temp.x = a->x;
-    a->x = b->x;
-    b->x = temp.x;
-    temp.y = a->y;
-    a->y = b->y;
-    b->y = temp.y;
+    return noiseFractal(&noiseDefault, 1, x, 0.f, 0.f, 0.f, NOISE_FBM);
 }
 
-typedef struct {
-    i32 x;
-    i32 y;
-} v2i;
+//2D Perlin noise
+inline f32 noise(f32 x, f32 y)
+{
+    return noiseFractal(&noiseDefault, 2, x, y, 0.f, 0.f, NOISE_FBM);
+}
 
-// overloaded operators
-// vector addition: newVector = v1 + v2;
-inline v2i operator+(v2i a, v2i b)
+//3D Perlin noise
+inline f32 noise(f32 x, f32 y, f32 z)
 {
-    v2i result;
-    result.x = a.x + b.x;
-    result.y = a.y + b.y;
-    return result;
+    return noiseFractal(&noiseDefault, 3, x, y, z, 0.f, NOISE_FBM);
 }
 
-// v1 += v2;
-inline v2i &operator+=(v2i &a, v2i b)
+//4D Perlin noise, for noise that loops or tiles by going around circles in the extra dimensions
+inline f32 noise(f32 x, f32 y, f32 z, f32 w)
 {
-    a = a + b;
-    return a;
+    return noiseFractal(&noiseDefault, 4, x, y, z, w, NOISE_FBM);
 }
 
-// vector subtraction
-inline v2i operator-(v2i a, v2i b)
+// ridged noise, 1 on the crests and falling off quadratically, with the octaves of noiseDetail
+inline f32 noiseRidged(f32 x)
 {
-    v2i result;
-    result.x = a.x - b.x;
-    result.y = a.y - b.y;
-    return result;
+    return noiseFractal(&noiseDefault, 1, x, 0.f, 0.f, 0.f, NOISE_RIDGED);
 }
 
-inline v2i operator-=(v2i &a, v2i b)
+inline f32 noiseRidged(f32 x, f32 y)
 {
-    a = a - b;
-    return a;
+    return noiseFractal(&noiseDefault, 2, x, y, 0.f, 0.f, NOISE_RIDGED);
 }
 
-// vector multiplication with a scalar number (vector scaling)
-inline v2i operator*(i32 scalar, v2i a)
+inline f32 noiseRidged(f32 x, f32 y, f32 z)
 {
-    v2i result;
-    result.x = scalar * a.x;
-    result.y = scalar * a.y;
-    return result;
+    return noiseFractal(&noiseDefault, 3, x, y, z, 0.f, NOISE_RIDGED);
 }
 
-inline v2i operator*(v2i a, i32 scalar)
+// turbulence, the sum of the absolute octaves, 0 in the creases
+inline f32 noiseTurbulence(f32 x)
 {
-    v2i result = scalar * a;
-    return result;
+    return noiseFractal(&noiseDefault, 1, x, 0.f, 0.f, 0.f, NOISE_TURBULENCE);
 }
 
-inline v2i &operator*=(v2i &a, i32 scalar)
+inline f32 noiseTurbulence(f32 x, f32 y)
 {
-    a = scalar * a;
-    return a;
+    return noiseFractal(&noiseDefault, 2, x, y, 0.f, 0.f, NOISE_TURBULENCE);
 }
 
-//divide by a scalar number
-inline v2i operator/(i32 scalar, v2i a)
+inline f32 noiseTurbulence(f32 x, f32 y, f32 z)
 {
-    v2i result;
-    result.x = scalar / a.x;
-    result.y = scalar / a.y;
-    return result;
+    return noiseFractal(&noiseDefault, 3, x, y, z, 0.f, NOISE_TURBULENCE);
 }
 
-inline v2i operator/(v2i a, i32 scalar)
+// the same functions on an instance
+inline f32 noise(const Noise *n, f32 x)
 {
-    v2i result;
-    result.x = a.x / scalar;
-    result.y = a.y / scalar;
-    return result;
+    return noiseFractal(n, 1, x, 0.f, 0.f, 0.f, NOISE_FBM);
 }
 
-inline v2i &operator/=(v2i &a, i32 scalar)
+inline f32 noise(const Noise *n, f32 x, f32 y)
 {
-    a.x /= scalar;
-    a.y /= scalar;
-    return a;
+    return noiseFractal(n, 2, x, y, 0.f, 0.f, NOISE_FBM);
 }
 
-// Vector3
+inline f32 noise(const Noise *n, f32 x, f32 y, f32 z)
+{
+    return noiseFractal(n, 3, x, y, z, 0.f, NOISE_FBM);
+}
 
-union v3 {
-    
-    struct {
-        f32 x, y, z;
-    };
-    struct {
-        f32 r, g, b;
-    };
-    struct {
-        f32 u, v, w;
-    };
-    
-    // swizzle
-    struct
-    {
-        v2 xy;
-        f32 _ignored0;
-    };
-    
-    struct
-    {
-        f32 _ignored1;
-        v2 yz;
-    };
-    
-    f32 e[3];
-    
-    v3() { };
-    v3(f32 X, f32 Y, f32 Z) : x(X), y(Y), z(Z) {}
-    // overloaded operator for vector addition: v3 = v1 + v2;
-    v3 operator+(const v3& v2) const
-    {
-        return v3{ x + v2.x, y + v2.y, z + v2.z };
-    }
-    
-    // v1 += v2;
-    friend v3& operator+=(v3& v1, const v3& v2)
-    {
-        v1.x += v2.x;
-        v1.y += v2.y;
-        v1.z += v2.z;
-        return v1;
-    }
-    
-    // subtracting two vectors
-    v3 operator-(const v3& v2) const
-    {
-        return v3{ x - v2.x, y - v2.y, z - v2.z };
-    }
-    
-    friend v3& operator-=(v3& v1, const v3& v2)
-    {
-        v1.x -= v2.x;
-        v1.y -= v2.y;
-        v1.z -= v2.z;
-        return v1;
-    }
-    
-    //multiply by a scalar number
-    v3 operator*(f32 scalar)
-    {
-        return v3{ x * scalar, y * scalar, z * scalar };
-    }
-    
-    v3& operator*=(f32 scalar)
-    {
-        x *= scalar;
-        y *= scalar;
-        z *= scalar;
-        return *this;
-    }
-    
-    //divide by a scalar number
-    v3 operator/(f32 scalar)
-    {
-        return v3{ x / scalar, y / scalar, z / scalar };
-    }
-    
-    v3& operator/=(f32 scalar)
-    {
-        x /= scalar;
-        y /= scalar;
-        z /= scalar;
-        
-        return *this;
-    }
-    
-    
-    //calculate length (magnitude) of the vector, square root of x^2 + y^2 + z^2
-    f32 length() { return sqrt(x * x + y * y + z * z); }
-    
-    //normalizing a vector makes its length equal to 1.
-    //to normalize a vector - multiply it by the inverse of its length
-    void normalize()
-    {
-        f32 l = length();
-        if (l > 0) //avoid divide by 0
-        {
-            (*this) *= 1 / l;
-        }
-    }
-};
-
-// vector negation, vector equals it's negative
-inline v3 operator-(v3 a)
+inline f32 noise(const Noise *n, f32 x, f32 y, f32 z, f32 w)
 {
-    v3 result;
-    
-    result.x = -a.x;
-    result.y = -a.y;
-    result.z = -a.z;
-    
-    return result;
+    return noiseFractal(n, 4, x, y, z, w, NOISE_FBM);
 }
 
-typedef union v4 {
-    struct {
-        f32 r, g, b, a;
-    };
-    struct {
-        f32 h, s, b, a;
-    };
-    struct {
-        f32 h, s, l, a;
-    };
-    struct {
-        f32 x, y, z, w;
-    };
-    f32 e[4];
-} v4;
-
-#define v2i(x, y) v2iInit(x, y)
-v2i v2iInit(i32 x, i32 y)
+inline f32 noiseRidged(const Noise *n, f32 x, f32 y)
 {
-    v2i result = { x, y };
-    return result;
+    return noiseFractal(n, 2, x, y, 0.f, 0.f, NOISE_RIDGED);
 }
 
-#define v2(x, y) v2Init(x, y)
-v2 v2Init(f32 x, f32 y)
+inline f32 noiseRidged(const Noise *n, f32 x, f32 y, f32 z)
 {
-    v2 result = { x, y };
-    return result;
+    return noiseFractal(n, 3, x, y, z, 0.f, NOISE_RIDGED);
 }
 
-#define v3(x, y, z) v3Init(x, y, z)
-v3 v3Init(f32 x, f32 y, f32 z)
+inline f32 noiseTurbulence(const Noise *n, f32 x, f32 y)
 {
-    v3 result = { x, y, z };
-    return result;
+    return noiseFractal(n, 2, x, y, 0.f, 0.f, NOISE_TURBULENCE);
 }
 
-#define v4(x, y, z, w) v4Init(x, y, z, w)
-v4 v4Init(f32 x, f32 y, f32 z, f32 w)
+inline f32 noiseTurbulence(const Noise *n, f32 x, f32 y, f32 z)
 {
-    v4 result = { x, y, z, w };
-    return result;
+    return noiseFractal(n, 3, x, y, z, 0.f, NOISE_TURBULENCE);
 }
 
-// vector addition
-inline v2
-v2Add(v2 a, v2 b)
+// noise that repeats every 1 of t, from a circle through 2D noise. the radius is in noise units, a bigger
+// circle passes more features on the way around
+inline f32 loopNoise(const Noise *n, f32 t, f32 radius = 1.f)
 {
-    v2 result = v2(a.x + b.x, a.y + b.y);
-    return result;
+    f32 s, c;
+    fastSinCos((t - floorf(t)) * TWO_PI, &s, &c);
+    return noise(n, radius * c, radius * s);
 }
 
-// vector subtraction
-inline v2
-v2Sub(v2 a, v2 b)
+inline f32 loopNoise(f32 t, f32 radius = 1.f)
 {
-    v2 result = v2(a.x - b.x, a.y - b.y);
-    return result;
+    return loopNoise(&noiseDefault, t, radius);
 }
 
-// multiplication with a scalar
-inline v2
-v2Mul(v2 a, f32 s)
+// a 2D field that moves with t and comes back to the start every 1 of t, the loop goes around a circle in
+// the third and fourth dimension
+inline f32 loopNoise(const Noise *n, f32 x, f32 y, f32 t, f32 radius = 1.f)
 {
-    v2 result = v2(a.x * s, a.y * s);
-    return result;
+    f32 s, c;
+    fastSinCos((t - floorf(t)) * TWO_PI, &s, &c);
+    return noise(n, x, y, radius * c, radius * s);
 }
 
-// calculate length (magnitude) of the vector, square root of x^2 + y^2 + z^2
-f32 v3Length(v3 inVec)
+inline f32 loopNoise(f32 x, f32 y, f32 t, f32 radius = 1.f)
 {
-    f32 result = sqrt(inVec.x * inVec.x + inVec.y * inVec.y + inVec.z * inVec.z);
-    return result;
+    return loopNoise(&noiseDefault, x, y, t, radius);
 }
 
-// normalizing a vector makes its length equal to 1.
-// to normalize a vector - multiply it by the inverse of its length
-v3 v3Normalize(v3 inVec)
+struct TileableNoise
 {
-    f32 l = v3Length(inVec);
-    //avoid divide by 0
-    if (l > 0) {
-        inVec.x *= 1 / l;
-        inVec.y *= 1 / l;
-        inVec.z *= 1 / l;
+    const Noise *noise;
+    f32 *out;
+    i32 width;
+    f32 *columns; // radius * cos and radius * sin of the angle of every column, then every row
+};
+
+internal void
+tileableNoiseRows(void *data, i32 first, i32 last)
+{
+    TileableNoise *tile = (TileableNoise *)data;
+    const f32 *columns = tile->columns;
+    const f32 *rows = tile->columns + 2 * tile->width;
+    for (i32 y = first; y < last; y++) {
+        f32 *row = tile->out + (i64)y * tile->width;
+        for (i32 x = 0; x < tile->width; x++)
+            row[x] = noise(tile->noise, columns[2 * x], columns[2 * x + 1], rows[2 * y], rows[2 * y + 1]);
     }
-    return inVec;
 }
 
-inline f32 v3DotProduct(v3 a, v3 b)
+// a w by h texture that wraps around at the edges, period is the size in noise units. every axis is an
+// angle around a circle in 4D noise, the circles are period long so the features keep their size. the
+// rows are split over the processors
+void tileableNoise2(const Noise *n, f32 *out, i32 w, i32 h, f32 period)
 {
-    return a.x * b.x + a.y * b.y + a.z * b.z;
+    if (w <= 0 || h <= 0)
+        return;
+    f32 radius = period / TWO_PI;
+    f32 *circles = (f32 *)malloc(sizeof(f32) * 2 * (w + h));
+    for (i32 x = 0; x < w; x++)
+        fastSinCos((f32)x / (f32)w * TWO_PI, circles + 2 * x + 1, circles + 2 * x);
+    for (i32 y = 0; y < h; y++)
+        fastSinCos((f32)y / (f32)h * TWO_PI, circles + 2 * (w + y) + 1, circles + 2 * (w + y));
+    for (i32 i = 0; i < 2 * (w + h); i++)
+        circles[i] *= radius;
+
+    TileableNoise tile = { n, out, w, circles };
+    parallelFor(h, maximum(1, 16384 / w), tileableNoiseRows, &tile);
+    free(circles);
 }
 
-// calculate the cross product of two vectors
-inline v3 v3CrossProduct(v3 v1, v3 v2)
+inline void tileableNoise2(f32 *out, i32 w, i32 h, f32 period)
 {
-    v3 vResult;
-    vResult.x = v1.y * v2.z - v2.y * v1.z;
-    vResult.y = -v1.x * v2.z + v2.x * v1.z;
-    vResult.z = v1.x * v2.y - v2.x * v1.y;
-    return vResult;
+    tileableNoise2(&noiseDefault, out, w, h, period);
 }
 
-// calculate the unit normal from 3 points on a plane in CCW-order
-v3 v3GetNormalVector(v3 vP1, v3 vP2, v3 vP3)
+// noise over grids, 4 (SSE) or 8 (AVX2) samples at a time. the kernels are the simplex noise above with
+// the branches turned into masks and the permutation lookups into gathers. AVX2 gathers 32 bits at byte
+// offsets of the u8 table and keeps the low byte, which is why the table is padded. cells are wrapped
+// with & 255 like the scalar code. the results are the same as noise()
+
+// FASTFLOOR, truncation minus one for everything <= 0
+inline __m128i noiseFloor4(__m128 x)
 {
-    v3 vV1, vV2;
-    v3 vNormal;
-    vV1 = vP2 - vP1;
-    vV2 = vP3 - vP1;
+    return _mm_add_epi32(_mm_cvttps_epi32(x), _mm_castps_si128(_mm_cmple_ps(x, _mm_setzero_ps())));
+}
 
-    vNormal = v3CrossProduct(vV1, vV2);
-    vNormal.normalize();
-    return vNormal;
+inline __m128i noiseGather4(const u8 *table, __m128i index)
+{
+    i32 i[4];
+    _mm_storeu_si128((__m128i *)i, index);
+    return _mm_setr_epi32(table[i[0]], table[i[1]], table[i[2]], table[i[3]]);
 }
 
-// gets the three coefficients of a plane equation given three points on the plane
-void v3GetPlaneEquation(v3 vPoint1, v3 vPoint2, v3 vPoint3, f32 vPlane[4])
+inline __m128 noiseSelect4(__m128 mask, __m128 a, __m128 b)
 {
-    // get normal vector from three points
-    // the normal vector is the first three coefficients to the plane equation
-    v3 vP = v3GetNormalVector(vPoint1, vPoint2, vPoint3);
-    vPlane[0] = vP.x;
-    vPlane[1] = vP.y;
-    vPlane[2] = vP.z;
-    // final coefficient found by back substitution
-    vPlane[3] = -(vPlane[0] * vPoint3.x + vPlane[1] * vPoint3.y + vPlane[2] * vPoint3.z);
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
 }
 
-typedef union
+// bit `bit` of hash moved to the sign bit
+inline __m128 noiseSign4(__m128i hash, i32 bit)
 {
-    //struct {
-    //v2 min, max;
-    //};
-    
-    struct {
-        f32 x, y, w, h;
-    };
-} Rect;
+    return _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(hash, _mm_set1_epi32(1 << bit)), 31 - bit));
+}
 
+inline __m128 noiseGrad2_4(__m128i hash, __m128 x, __m128 y)
+{
+    __m128i h = _mm_and_si128(hash, _mm_set1_epi32(7));
+    __m128 swap = _mm_castsi128_ps(_mm_cmpgt_epi32(h, _mm_set1_epi32(3)));
+    __m128 u = _mm_xor_ps(noiseSelect4(swap, y, x), noiseSign4(h, 0));
+    __m128 v = _mm_xor_ps(_mm_mul_ps(_mm_set1_ps(2.f), noiseSelect4(swap, x, y)), noiseSign4(h, 1));
+    return _mm_add_ps(u, v);
+}
+
+inline __m128 noiseGrad3_4(__m128i hash, __m128 x, __m128 y, __m128 z)
+{
+    __m128i h = _mm_and_si128(hash, _mm_set1_epi32(15));
+    __m128 below8 = _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(8)));
+    __m128 below4 = _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(4)));
+    // h == 12 or h == 14
+    __m128 useX = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(h, _mm_set1_epi32(13)), _mm_set1_epi32(12)));
+    __m128 u = _mm_xor_ps(noiseSelect4(below8, x, y), noiseSign4(h, 0));
+    __m128 v = _mm_xor_ps(noiseSelect4(below4, y, noiseSelect4(useX, x, z)), noiseSign4(h, 1));
+    return _mm_add_ps(u, v);
+}
+
+// t^4 * gradient for t >= 0, 0 outside the corner's radius
+inline __m128 noiseCorner4(__m128 t, __m128 gradient)
+{
+    __m128 inside = _mm_cmpge_ps(t, _mm_setzero_ps());
+    t = _mm_mul_ps(t, t);
+    return _mm_and_ps(inside, _mm_mul_ps(_mm_mul_ps(t, t), gradient));
+}
+
+// noise(x, y) of four points
+inline __m128 noise2_4(const u8 *table, __m128 x, __m128 y)
+{
+    __m128 g2 = _mm_set1_ps(G2);
+    __m128 s = _mm_mul_ps(_mm_add_ps(x, y), _mm_set1_ps(F2));
+    __m128i i = noiseFloor4(_mm_add_ps(x, s));
+    __m128i j = noiseFloor4(_mm_add_ps(y, s));
+    __m128 t = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(i, j)), g2);
+    __m128 x0 = _mm_sub_ps(x, _mm_sub_ps(_mm_cvtepi32_ps(i), t));
+    __m128 y0 = _mm_sub_ps(y, _mm_sub_ps(_mm_cvtepi32_ps(j), t));
 
-//
-// Matrices
-//
+    // lower triangle when x0 > y0
+    __m128i i1 = _mm_srli_epi32(_mm_castps_si128(_mm_cmpgt_ps(x0, y0)), 31);
+    __m128i j1 = _mm_xor_si128(i1, _mm_set1_epi32(1));
+    __m128 x1 = _mm_add_ps(_mm_sub_ps(x0, _mm_cvtepi32_ps(i1)), g2);
+    __m128 y1 = _mm_add_ps(_mm_sub_ps(y0, _mm_cvtepi32_ps(j1)), g2);
+    __m128 x2 = _mm_add_ps(_mm_sub_ps(x0, _mm_set1_ps(1.f)), _mm_set1_ps(2.f * G2));
+    __m128 y2 = _mm_add_ps(_mm_sub_ps(y0, _mm_set1_ps(1.f)), _mm_set1_ps(2.f * G2));
 
-struct m4 {
-	f32 e[4][4] = { 0 };
-};
+    __m128i mask = _mm_set1_epi32(255);
+    __m128i one = _mm_set1_epi32(1);
+    __m128i ii = _mm_and_si128(i, mask);
+    __m128i jj = _mm_and_si128(j, mask);
+    __m128i h0 = noiseGather4(table, _mm_add_epi32(ii, noiseGather4(table, jj)));
+    __m128i h1 = noiseGather4(table, _mm_add_epi32(_mm_add_epi32(ii, i1), noiseGather4(table, _mm_add_epi32(jj, j1))));
+    __m128i h2 = noiseGather4(table, _mm_add_epi32(_mm_add_epi32(ii, one), noiseGather4(table, _mm_add_epi32(jj, one))));
+
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 n0 = noiseCorner4(_mm_sub_ps(_mm_sub_ps(half, _mm_mul_ps(x0, x0)), _mm_mul_ps(y0, y0)), noiseGrad2_4(h0, x0, y0));
+    __m128 n1 = noiseCorner4(_mm_sub_ps(_mm_sub_ps(half, _mm_mul_ps(x1, x1)), _mm_mul_ps(y1, y1)), noiseGrad2_4(h1, x1, y1));
+    __m128 n2 = noiseCorner4(_mm_sub_ps(_mm_sub_ps(half, _mm_mul_ps(x2, x2)), _mm_mul_ps(y2, y2)), noiseGrad2_4(h2, x2, y2));
+    __m128 n = _mm_mul_ps(_mm_set1_ps(40.f), _mm_add_ps(_mm_add_ps(n0, n1), n2));
+    return _mm_add_ps(_mm_mul_ps(n, half), half);
+}
 
-m4 m4LoadIdentity()
+// noise(x, y, z) of four points
+inline __m128 noise3_4(const u8 *table, __m128 x, __m128 y, __m128 z)
 {
-    m4 m =
-    {
-        1.0f, 0.0f, 0.0f, 0.0f,
-        0.f,  1.0f, 0.0f, 0.0f,
-        0.f,  0.f,  1.0f, 0.0f,
-        0.f,  0.f,  0.f,  1.0f
-    };
-    return m;
-#if 0
-    m4 identity = {
-        {
-            {1, 0, 0, 0},
-            {0, 1, 0, 0},
-            {0, 0, 1, 0},
-            {0, 0, 0, 1},
+    __m128 g3 = _mm_set1_ps(G3);
+    __m128 s = _mm_mul_ps(_mm_add_ps(_mm_add_ps(x, y), z), _mm_set1_ps(F3));
+    __m128i i = noiseFloor4(_mm_add_ps(x, s));
+    __m128i j = noiseFloor4(_mm_add_ps(y, s));
+    __m128i k = noiseFloor4(_mm_add_ps(z, s));
+    __m128 t = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_add_epi32(i, j), k)), g3);
+    __m128 x0 = _mm_sub_ps(x, _mm_sub_ps(_mm_cvtepi32_ps(i), t));
+    __m128 y0 = _mm_sub_ps(y, _mm_sub_ps(_mm_cvtepi32_ps(j), t));
+    __m128 z0 = _mm_sub_ps(z, _mm_sub_ps(_mm_cvtepi32_ps(k), t));
+
+    // the six orderings of x0, y0 and z0 from three comparisons
+    __m128i xy = _mm_castps_si128(_mm_cmpge_ps(x0, y0));
+    __m128i yz = _mm_castps_si128(_mm_cmpge_ps(y0, z0));
+    __m128i xz = _mm_castps_si128(_mm_cmpge_ps(x0, z0));
+    __m128i i1 = _mm_srli_epi32(_mm_and_si128(xy, xz), 31);
+    __m128i j1 = _mm_srli_epi32(_mm_andnot_si128(xy, yz), 31);
+    __m128i k1 = _mm_srli_epi32(_mm_andnot_si128(_mm_or_si128(xz, yz), _mm_set1_epi32(-1)), 31);
+    __m128i i2 = _mm_srli_epi32(_mm_or_si128(xy, xz), 31);
+    __m128i j2 = _mm_srli_epi32(_mm_or_si128(_mm_andnot_si128(xy, _mm_set1_epi32(-1)), yz), 31);
+    __m128i k2 = _mm_srli_epi32(_mm_andnot_si128(_mm_and_si128(xz, yz), _mm_set1_epi32(-1)), 31);
+
+    __m128 x1 = _mm_add_ps(_mm_sub_ps(x0, _mm_cvtepi32_ps(i1)), g3);
+    __m128 y1 = _mm_add_ps(_mm_sub_ps(y0, _mm_cvtepi32_ps(j1)), g3);
+    __m128 z1 = _mm_add_ps(_mm_sub_ps(z0, _mm_cvtepi32_ps(k1)), g3);
+    __m128 g3x2 = _mm_set1_ps(2.f * G3);
+    __m128 x2 = _mm_add_ps(_mm_sub_ps(x0, _mm_cvtepi32_ps(i2)), g3x2);
+    __m128 y2 = _mm_add_ps(_mm_sub_ps(y0, _mm_cvtepi32_ps(j2)), g3x2);
+    __m128 z2 = _mm_add_ps(_mm_sub_ps(z0, _mm_cvtepi32_ps(k2)), g3x2);
+    __m128 oneF = _mm_set1_ps(1.f);
+    __m128 g3x3 = _mm_set1_ps(3.f * G3);
+    __m128 x3 = _mm_add_ps(_mm_sub_ps(x0, oneF), g3x3);
+    __m128 y3 = _mm_add_ps(_mm_sub_ps(y0, oneF), g3x3);
+    __m128 z3 = _mm_add_ps(_mm_sub_ps(z0, oneF), g3x3);
+
+    __m128i mask = _mm_set1_epi32(255);
+    __m128i one = _mm_set1_epi32(1);
+    __m128i ii = _mm_and_si128(i, mask);
+    __m128i jj = _mm_and_si128(j, mask);
+    __m128i kk = _mm_and_si128(k, mask);
+    __m128i h0 = noiseGather4(table, _mm_add_epi32(ii, noiseGather4(table, _mm_add_epi32(jj, noiseGather4(table, kk)))));
+    __m128i h1 = noiseGather4(table, _mm_add_epi32(_mm_add_epi32(ii, i1), noiseGather4(table,
+        _mm_add_epi32(_mm_add_epi32(jj, j1), noiseGather4(table, _mm_add_epi32(kk, k1))))));
+    __m128i h2 = noiseGather4(table, _mm_add_epi32(_mm_add_epi32(ii, i2), noiseGather4(table,
+        _mm_add_epi32(_mm_add_epi32(jj, j2), noiseGather4(table, _mm_add_epi32(kk, k2))))));
+    __m128i h3 = noiseGather4(table, _mm_add_epi32(_mm_add_epi32(ii, one), noiseGather4(table,
+        _mm_add_epi32(_mm_add_epi32(jj, one), noiseGather4(table, _mm_add_epi32(kk, one))))));
+
+    __m128 radius = _mm_set1_ps(0.6f);
+    __m128 t0 = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(radius, _mm_mul_ps(x0, x0)), _mm_mul_ps(y0, y0)), _mm_mul_ps(z0, z0));
+    __m128 t1 = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(radius, _mm_mul_ps(x1, x1)), _mm_mul_ps(y1, y1)), _mm_mul_ps(z1, z1));
+    __m128 t2 = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(radius, _mm_mul_ps(x2, x2)), _mm_mul_ps(y2, y2)), _mm_mul_ps(z2, z2));
+    __m128 t3 = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(radius, _mm_mul_ps(x3, x3)), _mm_mul_ps(y3, y3)), _mm_mul_ps(z3, z3));
+    __m128 n0 = noiseCorner4(t0, noiseGrad3_4(h0, x0, y0, z0));
+    __m128 n1 = noiseCorner4(t1, noiseGrad3_4(h1, x1, y1, z1));
+    __m128 n2 = noiseCorner4(t2, noiseGrad3_4(h2, x2, y2, z2));
+    __m128 n3 = noiseCorner4(t3, noiseGrad3_4(h3, x3, y3, z3));
+    __m128 n = _mm_mul_ps(_mm_set1_ps(32.f), _mm_add_ps(_mm_add_ps(_mm_add_ps(n0, n1), n2), n3));
+    __m128 half = _mm_set1_ps(0.5f);
+    return _mm_add_ps(_mm_mul_ps(n, half), half);
+}
+
+// eight points at a time, needs AVX2
+inline __m256i noiseFloor8(__m256 x)
+{
+    return _mm256_add_epi32(_mm256_cvttps_epi32(x), _mm256_castps_si256(_mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LE_OQ)));
+}
+
+inline __m256i noiseGather8(const u8 *table, __m256i index)
+{
+    return _mm256_and_si256(_mm256_i32gather_epi32((const i32 *)table, index, 1), _mm256_set1_epi32(255));
+}
+
+inline __m256 noiseSign8(__m256i hash, i32 bit)
+{
+    return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(hash, _mm256_set1_epi32(1 << bit)), 31 - bit));
+}
+
+inline __m256 noiseGrad2_8(__m256i hash, __m256 x, __m256 y)
+{
+    __m256i h = _mm256_and_si256(hash, _mm256_set1_epi32(7));
+    __m256 swap = _mm256_castsi256_ps(_mm256_cmpgt_epi32(h, _mm256_set1_epi32(3)));
+    __m256 u = _mm256_xor_ps(_mm256_blendv_ps(x, y, swap), noiseSign8(h, 0));
+    __m256 v = _mm256_xor_ps(_mm256_mul_ps(_mm256_set1_ps(2.f), _mm256_blendv_ps(y, x, swap)), noiseSign8(h, 1));
+    return _mm256_add_ps(u, v);
+}
+
+inline __m256 noiseGrad3_8(__m256i hash, __m256 x, __m256 y, __m256 z)
+{
+    __m256i h = _mm256_and_si256(hash, _mm256_set1_epi32(15));
+    __m256 below8 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(8), h));
+    __m256 below4 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(4), h));
+    __m256 useX = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(h, _mm256_set1_epi32(13)), _mm256_set1_epi32(12)));
+    __m256 u = _mm256_xor_ps(_mm256_blendv_ps(y, x, below8), noiseSign8(h, 0));
+    __m256 v = _mm256_xor_ps(_mm256_blendv_ps(_mm256_blendv_ps(z, x, useX), y, below4), noiseSign8(h, 1));
+    return _mm256_add_ps(u, v);
+}
+
+inline __m256 noiseCorner8(__m256 t, __m256 gradient)
+{
+    __m256 inside = _mm256_cmp_ps(t, _mm256_setzero_ps(), _CMP_GE_OQ);
+    t = _mm256_mul_ps(t, t);
+    return _mm256_and_ps(inside, _mm256_mul_ps(_mm256_mul_ps(t, t), gradient));
+}
+
+inline __m256 noise2_8(const u8 *table, __m256 x, __m256 y)
+{
+    __m256 g2 = _mm256_set1_ps(G2);
+    __m256 s = _mm256_mul_ps(_mm256_add_ps(x, y), _mm256_set1_ps(F2));
+    __m256i i = noiseFloor8(_mm256_add_ps(x, s));
+    __m256i j = noiseFloor8(_mm256_add_ps(y, s));
+    __m256 t = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(i, j)), g2);
+    __m256 x0 = _mm256_sub_ps(x, _mm256_sub_ps(_mm256_cvtepi32_ps(i), t));
+    __m256 y0 = _mm256_sub_ps(y, _mm256_sub_ps(_mm256_cvtepi32_ps(j), t));
+
+    __m256i i1 = _mm256_srli_epi32(_mm256_castps_si256(_mm256_cmp_ps(x0, y0, _CMP_GT_OQ)), 31);
+    __m256i j1 = _mm256_xor_si256(i1, _mm256_set1_epi32(1));
+    __m256 x1 = _mm256_add_ps(_mm256_sub_ps(x0, _mm256_cvtepi32_ps(i1)), g2);
+    __m256 y1 = _mm256_add_ps(_mm256_sub_ps(y0, _mm256_cvtepi32_ps(j1)), g2);
+    __m256 x2 = _mm256_add_ps(_mm256_sub_ps(x0, _mm256_set1_ps(1.f)), _mm256_set1_ps(2.f * G2));
+    __m256 y2 = _mm256_add_ps(_mm256_sub_ps(y0, _mm256_set1_ps(1.f)), _mm256_set1_ps(2.f * G2));
+
+    __m256i mask = _mm256_set1_epi32(255);
+    __m256i one = _mm256_set1_epi32(1);
+    __m256i ii = _mm256_and_si256(i, mask);
+    __m256i jj = _mm256_and_si256(j, mask);
+    __m256i h0 = noiseGather8(table, _mm256_add_epi32(ii, noiseGather8(table, jj)));
+    __m256i h1 = noiseGather8(table, _mm256_add_epi32(_mm256_add_epi32(ii, i1),
+        noiseGather8(table, _mm256_add_epi32(jj, j1))));
+    __m256i h2 = noiseGather8(table, _mm256_add_epi32(_mm256_add_epi32(ii, one),
+        noiseGather8(table, _mm256_add_epi32(jj, one))));
+
+    __m256 half = _mm256_set1_ps(0.5f);
+    __m256 n0 = noiseCorner8(_mm256_sub_ps(_mm256_sub_ps(half, _mm256_mul_ps(x0, x0)), _mm256_mul_ps(y0, y0)), noiseGrad2_8(h0, x0, y0));
+    __m256 n1 = noiseCorner8(_mm256_sub_ps(_mm256_sub_ps(half, _mm256_mul_ps(x1, x1)), _mm256_mul_ps(y1, y1)), noiseGrad2_8(h1, x1, y1));
+    __m256 n2 = noiseCorner8(_mm256_sub_ps(_mm256_sub_ps(half, _mm256_mul_ps(x2, x2)), _mm256_mul_ps(y2, y2)), noiseGrad2_8(h2, x2, y2));
+    __m256 n = _mm256_mul_ps(_mm256_set1_ps(40.f), _mm256_add_ps(_mm256_add_ps(n0, n1), n2));
+    return _mm256_add_ps(_mm256_mul_ps(n, half), half);
+}
+
+inline __m256 noise3_8(const u8 *table, __m256 x, __m256 y, __m256 z)
+{
+    __m256 g3 = _mm256_set1_ps(G3);
+    __m256 s = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(x, y), z), _mm256_set1_ps(F3));
+    __m256i i = noiseFloor8(_mm256_add_ps(x, s));
+    __m256i j = noiseFloor8(_mm256_add_ps(y, s));
+    __m256i k = noiseFloor8(_mm256_add_ps(z, s));
+    __m256 t = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_add_epi32(i, j), k)), g3);
+    __m256 x0 = _mm256_sub_ps(x, _mm256_sub_ps(_mm256_cvtepi32_ps(i), t));
+    __m256 y0 = _mm256_sub_ps(y, _mm256_sub_ps(_mm256_cvtepi32_ps(j), t));
+    __m256 z0 = _mm256_sub_ps(z, _mm256_sub_ps(_mm256_cvtepi32_ps(k), t));
+
+    __m256i all = _mm256_set1_epi32(-1);
+    __m256i xy = _mm256_castps_si256(_mm256_cmp_ps(x0, y0, _CMP_GE_OQ));
+    __m256i yz = _mm256_castps_si256(_mm256_cmp_ps(y0, z0, _CMP_GE_OQ));
+    __m256i xz = _mm256_castps_si256(_mm256_cmp_ps(x0, z0, _CMP_GE_OQ));
+    __m256i i1 = _mm256_srli_epi32(_mm256_and_si256(xy, xz), 31);
+    __m256i j1 = _mm256_srli_epi32(_mm256_andnot_si256(xy, yz), 31);
+    __m256i k1 = _mm256_srli_epi32(_mm256_andnot_si256(_mm256_or_si256(xz, yz), all), 31);
+    __m256i i2 = _mm256_srli_epi32(_mm256_or_si256(xy, xz), 31);
+    __m256i j2 = _mm256_srli_epi32(_mm256_or_si256(_mm256_andnot_si256(xy, all), yz), 31);
+    __m256i k2 = _mm256_srli_epi32(_mm256_andnot_si256(_mm256_and_si256(xz, yz), all), 31);
+
+    __m256 x1 = _mm256_add_ps(_mm256_sub_ps(x0, _mm256_cvtepi32_ps(i1)), g3);
+    __m256 y1 = _mm256_add_ps(_mm256_sub_ps(y0, _mm256_cvtepi32_ps(j1)), g3);
+    __m256 z1 = _mm256_add_ps(_mm256_sub_ps(z0, _mm256_cvtepi32_ps(k1)), g3);
+    __m256 g3x2 = _mm256_set1_ps(2.f * G3);
+    __m256 x2 = _mm256_add_ps(_mm256_sub_ps(x0, _mm256_cvtepi32_ps(i2)), g3x2);
+    __m256 y2 = _mm256_add_ps(_mm256_sub_ps(y0, _mm256_cvtepi32_ps(j2)), g3x2);
+    __m256 z2 = _mm256_add_ps(_mm256_sub_ps(z0, _mm256_cvtepi32_ps(k2)), g3x2);
+    __m256 oneF = _mm256_set1_ps(1.f);
+    __m256 g3x3 = _mm256_set1_ps(3.f * G3);
+    __m256 x3 = _mm256_add_ps(_mm256_sub_ps(x0, oneF), g3x3);
+    __m256 y3 = _mm256_add_ps(_mm256_sub_ps(y0, oneF), g3x3);
+    __m256 z3 = _mm256_add_ps(_mm256_sub_ps(z0, oneF), g3x3);
+
+    __m256i mask = _mm256_set1_epi32(255);
+    __m256i one = _mm256_set1_epi32(1);
+    __m256i ii = _mm256_and_si256(i, mask);
+    __m256i jj = _mm256_and_si256(j, mask);
+    __m256i kk = _mm256_and_si256(k, mask);
+    __m256i h0 = noiseGather8(table, _mm256_add_epi32(ii, noiseGather8(table,
+        _mm256_add_epi32(jj, noiseGather8(table, kk)))));
+    __m256i h1 = noiseGather8(table, _mm256_add_epi32(_mm256_add_epi32(ii, i1), noiseGather8(table,
+        _mm256_add_epi32(_mm256_add_epi32(jj, j1), noiseGather8(table, _mm256_add_epi32(kk, k1))))));
+    __m256i h2 = noiseGather8(table, _mm256_add_epi32(_mm256_add_epi32(ii, i2), noiseGather8(table,
+        _mm256_add_epi32(_mm256_add_epi32(jj, j2), noiseGather8(table, _mm256_add_epi32(kk, k2))))));
+    __m256i h3 = noiseGather8(table, _mm256_add_epi32(_mm256_add_epi32(ii, one), noiseGather8(table,
+        _mm256_add_epi32(_mm256_add_epi32(jj, one), noiseGather8(table, _mm256_add_epi32(kk, one))))));
+
+    __m256 radius = _mm256_set1_ps(0.6f);
+    __m256 t0 = _mm256_sub_ps(_mm256_sub_ps(_mm256_sub_ps(radius, _mm256_mul_ps(x0, x0)), _mm256_mul_ps(y0, y0)), _mm256_mul_ps(z0, z0));
+    __m256 t1 = _mm256_sub_ps(_mm256_sub_ps(_mm256_sub_ps(radius, _mm256_mul_ps(x1, x1)), _mm256_mul_ps(y1, y1)), _mm256_mul_ps(z1, z1));
+    __m256 t2 = _mm256_sub_ps(_mm256_sub_ps(_mm256_sub_ps(radius, _mm256_mul_ps(x2, x2)), _mm256_mul_ps(y2, y2)), _mm256_mul_ps(z2, z2));
+    __m256 t3 = _mm256_sub_ps(_mm256_sub_ps(_mm256_sub_ps(radius, _mm256_mul_ps(x3, x3)), _mm256_mul_ps(y3, y3)), _mm256_mul_ps(z3, z3));
+    __m256 n0 = noiseCorner8(t0, noiseGrad3_8(h0, x0, y0, z0));
+    __m256 n1 = noiseCorner8(t1, noiseGrad3_8(h1, x1, y1, z1));
+    __m256 n2 = noiseCorner8(t2, noiseGrad3_8(h2, x2, y2, z2));
+    __m256 n3 = noiseCorner8(t3, noiseGrad3_8(h3, x3, y3, z3));
+    __m256 n = _mm256_mul_ps(_mm256_set1_ps(32.f), _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(n0, n1), n2), n3));
+    __m256 half = _mm256_set1_ps(0.5f);
+    return _mm256_add_ps(_mm256_mul_ps(n, half), half);
+}
+
+// samples first to count - 1 of a row, sample i is at (x + i * dx, y + i * dy, z + i * dz). the tail is
+// computed in a full vector and only the samples inside the row are kept
+internal void
+noiseRow2SSE(const u8 *table, f32 *out, i32 first, i32 count, f32 x, f32 y, f32 dx, f32 dy)
+{
+    __m128 lane = _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+    for (i32 i = first; i < count; i += 4) {
+        __m128 index = _mm_add_ps(_mm_set1_ps((f32)i), lane);
+        __m128 n = noise2_4(table, _mm_add_ps(_mm_set1_ps(x), _mm_mul_ps(index, _mm_set1_ps(dx))),
+            _mm_add_ps(_mm_set1_ps(y), _mm_mul_ps(index, _mm_set1_ps(dy))));
+        if (i + 4 <= count) {
+            _mm_storeu_ps(out + i, n);
+        } else {
+            f32 tail[4];
+            _mm_storeu_ps(tail, n);
+            for (i32 j = i; j < count; j++)
+                out[j] = tail[j - i];
         }
-    };
-#endif
+    }
 }
 
-m4 vecToMatrix(v4 v)
-{
-    m4 m = {0};;
-    m.e[0][0] = v.x;
-    m.e[1][0] = v.y;
-    m.e[2][0] = v.z;
-    m.e[3][0] = v.w;
-    return m;
+internal void
+noiseRow2AVX(const u8 *table, f32 *out, i32 first, i32 count, f32 x, f32 y, f32 dx, f32 dy)
+{
+    __m256 lane = _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f);
+    i32 i = first;
+    for (; i + 8 <= count; i += 8) {
+        __m256 index = _mm256_add_ps(_mm256_set1_ps((f32)i), lane);
+        _mm256_storeu_ps(out + i, noise2_8(table, _mm256_add_ps(_mm256_set1_ps(x), _mm256_mul_ps(index, _mm256_set1_ps(dx))),
+            _mm256_add_ps(_mm256_set1_ps(y), _mm256_mul_ps(index, _mm256_set1_ps(dy)))));
+    }
+    noiseRow2SSE(table, out, i, count, x, y, dx, dy);
 }
 
+internal void
+noiseRow3SSE(const u8 *table, f32 *out, i32 first, i32 count, f32 x, f32 y, f32 z, f32 dx, f32 dy, f32 dz)
+{
+    __m128 lane = _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+    for (i32 i = first; i < count; i += 4) {
+        __m128 index = _mm_add_ps(_mm_set1_ps((f32)i), lane);
+        __m128 n = noise3_4(table, _mm_add_ps(_mm_set1_ps(x), _mm_mul_ps(index, _mm_set1_ps(dx))),
+            _mm_add_ps(_mm_set1_ps(y), _mm_mul_ps(index, _mm_set1_ps(dy))),
+            _mm_add_ps(_mm_set1_ps(z), _mm_mul_ps(index, _mm_set1_ps(dz))));
+        if (i + 4 <= count) {
+            _mm_storeu_ps(out + i, n);
+        } else {
+            f32 tail[4];
+            _mm_storeu_ps(tail, n);
+            for (i32 j = i; j < count; j++)
+                out[j] = tail[j - i];
+        }
+    }
+}
 
-m4 vecToMatrix(v3 v)
-{
-    m4 m = {0};;
-    m.e[0][0] = v.x;
-    m.e[1][0] = v.y;
-    m.e[2][0] = v.z;
-    m.e[3][0] = 0;
-    return m;
+internal void
+noiseRow3AVX(const u8 *table, f32 *out, i32 first, i32 count, f32 x, f32 y, f32 z, f32 dx, f32 dy, f32 dz)
+{
+    __m256 lane = _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f);
+    i32 i = first;
+    for (; i + 8 <= count; i += 8) {
+        __m256 index = _mm256_add_ps(_mm256_set1_ps((f32)i), lane);
+        _mm256_storeu_ps(out + i, noise3_8(table, _mm256_add_ps(_mm256_set1_ps(x), _mm256_mul_ps(index, _mm256_set1_ps(dx))),
+            _mm256_add_ps(_mm256_set1_ps(y), _mm256_mul_ps(index, _mm256_set1_ps(dy))),
+            _mm256_add_ps(_mm256_set1_ps(z), _mm256_mul_ps(index, _mm256_set1_ps(dz)))));
+    }
+    noiseRow3SSE(table, out, i, count, x, y, z, dx, dy, dz);
 }
 
+struct NoiseKernels
+{
+    void (*row2)(const u8 *table, f32 *out, i32 first, i32 count, f32 x, f32 y, f32 dx, f32 dy);
+    void (*row3)(const u8 *table, f32 *out, i32 first, i32 count, f32 x, f32 y, f32 z, f32 dx, f32 dy, f32 dz);
+};
 
-v4 matrixToVec(m4 m)
+internal NoiseKernels
+selectNoiseKernels()
 {
-    v4 result;
-    result.x = m.e[0][0];
-    result.y = m.e[1][0];
-    result.z = m.e[2][0];
-    result.w = m.e[3][0];
+    NoiseKernels result = { noiseRow2SSE, noiseRow3SSE };
+    if (cpuFeatures.avx2) {
+        result.row2 = noiseRow2AVX;
+        result.row3 = noiseRow3AVX;
+    }
     return result;
 }
 
-// b multiplys with a, my stuff
-m4 m4Multiply(m4 m1, m4 m2)
+global NoiseKernels noiseKernels = selectNoiseKernels();
+
+// grids with at least this many samples are split in bands of rows over the processors
+#define NOISE_PARALLEL_SAMPLES 65536
+
+// a grid is a plane through noise space, sample (x, y) is at origin + x * stepX + y * stepY
+struct NoiseGrid
 {
-	m4 result;
-    
-	result.e[0][0] = m2.e[0][0] * m1.e[0][0] + m2.e[1][0] * m1.e[0][1] + m2.e[2][0] * m1.e[0][2] + m2.e[3][0] * m1.e[0][3];
-	result.e[1][0] = m2.e[0][0] * m1.e[1][0] + m2.e[1][0] * m1.e[1][1] + m2.e[2][0] * m1.e[1][2] + m2.e[3][0] * m1.e[1][3];
-	result.e[2][0] = m2.e[0][0] * m1.e[2][0] + m2.e[1][0] * m1.e[2][1] + m2.e[2][0] * m1.e[2][2] + m2.e[3][0] * m1.e[2][3];
-	result.e[3][0] = m2.e[0][0] * m1.e[3][0] + m2.e[1][0] * m1.e[3][1] + m2.e[2][0] * m1.e[3][2] + m2.e[3][0] * m1.e[3][3];
-    
-    result.e[0][1] = m2.e[0][1] * m1.e[0][0] + m2.e[1][1] * m1.e[0][1] + m2.e[2][1] * m1.e[0][2] + m2.e[3][1] * m1.e[0][3];
-	result.e[1][1] = m2.e[0][1] * m1.e[1][0] + m2.e[1][1] * m1.e[1][1] + m2.e[2][1] * m1.e[1][2] + m2.e[3][1] * m1.e[1][3];
-	result.e[2][1] = m2.e[0][1] * m1.e[2][0] + m2.e[1][1] * m1.e[2][1] + m2.e[2][1] * m1.e[2][2] + m2.e[3][1] * m1.e[2][3];
-	result.e[3][1] = m2.e[0][1] * m1.e[3][0] + m2.e[1][1] * m1.e[3][1] + m2.e[2][1] * m1.e[3][2] + m2.e[3][1] * m1.e[3][3];
-    
-    result.e[0][2] = m2.e[0][2] * m1.e[0][0] + m2.e[1][2] * m1.e[0][1] + m2.e[2][2] * m1.e[0][2] + m2.e[3][2] * m1.e[0][3];
-	result.e[1][2] = m2.e[0][2] * m1.e[1][0] + m2.e[1][2] * m1.e[1][1] + m2.e[2][2] * m1.e[1][2] + m2.e[3][2] * m1.e[1][3];
-	result.e[2][2] = m2.e[0][2] * m1.e[2][0] + m2.e[1][2] * m1.e[2][1] + m2.e[2][2] * m1.e[2][2] + m2.e[3][2] * m1.e[2][3];
-	result.e[3][2] = m2.e[0][2] * m1.e[3][0] + m2.e[1][2] * m1.e[3][1] + m2.e[2][2] * m1.e[3][2] + m2.e[3][2] * m1.e[3][3];
-    
-    result.e[0][3] = m2.e[0][3] * m1.e[0][0] + m2.e[1][3] * m1.e[0][1] + m2.e[2][3] * m1.e[0][2] + m2.e[3][3] * m1.e[0][3];
-	result.e[1][3] = m2.e[0][3] * m1.e[1][0] + m2.e[1][3] * m1.e[1][1] + m2.e[2][3] * m1.e[1][2] + m2.e[3][3] * m1.e[1][3];
-	result.e[2][3] = m2.e[0][3] * m1.e[2][0] + m2.e[1][3] * m1.e[2][1] + m2.e[2][3] * m1.e[2][2] + m2.e[3][3] * m1.e[2][3];
-	result.e[3][3] = m2.e[0][3] * m1.e[3][0] + m2.e[1][3] * m1.e[3][1] + m2.e[2][3] * m1.e[3][2] + m2.e[3][3] * m1.e[3][3];
-    
-    
-	return result;
-}
+    const u8 *table;
+    f32 *out;
+    i32 width;
+    i32 dimensions;
+    i32 octaves;
+    f32 falloff;
+    i32 fractal;
+    f32 origin[3], stepX[3], stepY[3];
+};
 
-v4 m4MultiplyV4(m4 m, v4 v)
+// one octave of row y, the coordinates are scaled by a power of two so the samples are exactly the ones
+// noise() evaluates for the same octave
+internal void
+noiseGridOctave(NoiseGrid *grid, f32 *row, i32 y, f32 frequency)
 {
-    v4 result = {0};
-    
-    result.x = v.e[0]*m.e[0][0] + v.e[1]*m.e[0][1] + v.e[2]*m.e[0][2] + v.e[3]*m.e[0][3];
-    result.y = v.e[0]*m.e[1][0] + v.e[1]*m.e[1][1] + v.e[2]*m.e[1][2] + v.e[3]*m.e[1][3];
-    result.z = v.e[0]*m.e[2][0] + v.e[1]*m.e[2][1] + v.e[2]*m.e[2][2] + v.e[3]*m.e[2][3];
-    result.w = v.e[0]*m.e[3][0] + v.e[1]*m.e[3][1] + v.e[2]*m.e[3][2] + v.e[3]*m.e[3][3];
-    
-    return result;
+    f32 x0 = (grid->origin[0] + (f32)y * grid->stepY[0]) * frequency;
+    f32 y0 = (grid->origin[1] + (f32)y * grid->stepY[1]) * frequency;
+    if (grid->dimensions == 2) {
+        noiseKernels.row2(grid->table, row, 0, grid->width, x0, y0, grid->stepX[0] * frequency, grid->stepX[1] * frequency);
+    } else {
+        f32 z0 = (grid->origin[2] + (f32)y * grid->stepY[2]) * frequency;
+        noiseKernels.row3(grid->table, row, 0, grid->width, x0, y0, z0,
+            grid->stepX[0] * frequency, grid->stepX[1] * frequency, grid->stepX[2] * frequency);
+    }
 }
 
-v3 m4MultiplyV3(m4 m, v3 v)
+internal void
+noiseGridRows(void *data, i32 first, i32 last)
 {
-    v3 result;
-    
-    result.x = v.e[0]*m.e[0][0] + v.e[1]*m.e[0][1] + v.e[2]*m.e[0][2];
-    result.y = v.e[0]*m.e[1][0] + v.e[1]*m.e[1][1] + v.e[2]*m.e[1][2];
-    result.z = v.e[0]*m.e[2][0] + v.e[1]*m.e[2][1] + v.e[2]*m.e[2][2];
-    
-    return result;
+    NoiseGrid *grid = (NoiseGrid *)data;
+    if (grid->octaves <= 1 && grid->fractal == NOISE_FBM) {
+        for (i32 y = first; y < last; y++)
+            noiseGridOctave(grid, grid->out + (i64)y * grid->width, y, 1.f);
+        return;
+    }
+
+    // more octaves are added up row by row, in the same order as noiseFractal
+    f32 *octave = (f32 *)malloc(sizeof(f32) * grid->width);
+    for (i32 y = first; y < last; y++) {
+        f32 *row = grid->out + (i64)y * grid->width;
+        f32 total = 0.f;
+        f32 amplitude = 1.f;
+        f32 frequency = 1.f;
+        for (i32 o = 0; o < grid->octaves; o++) {
+            noiseGridOctave(grid, octave, y, frequency);
+            for (i32 x = 0; x < grid->width; x++)
+                row[x] = (o == 0 ? 0.f : row[x]) + amplitude * noiseFractalOctave(octave[x], grid->fractal);
+            total += amplitude;
+            amplitude *= grid->falloff;
+            frequency *= 2.f;
+        }
+        for (i32 x = 0; x < grid->width; x++)
+            row[x] /= total;
+    }
+    free(octave);
 }
 
-// OpenGL friendly contigous array matrix
-typedef f32 Matrix[16];      //column major 4x4 matrix
-Matrix transformationMatrix;
-Matrix rotationMatrix, translationMatrix, scalingMatrix;
+internal void
+noiseGridRun(NoiseGrid *grid, i32 height)
+{
+    if (grid->width <= 0 || height <= 0)
+        return;
+    i64 samples = (i64)grid->width * height;
+    i32 grain = samples >= NOISE_PARALLEL_SAMPLES ? maximum(1, (NOISE_PARALLEL_SAMPLES / 4) / grid->width) : height;
+    parallelFor(height, grain, noiseGridRows, grid);
+}
 
+// out[y * w + x] = noise(n, x0 + x * dx, y0 + y * dy), or noiseRidged or noiseTurbulence with fractal
+void noiseGrid2(const Noise *n, f32 *out, i32 w, i32 h, f32 x0, f32 y0, f32 dx, f32 dy, i32 fractal = NOISE_FBM)
+{
+    NoiseGrid grid = { n->perm, out, w, 2, n->octaves, n->falloff, fractal,
+        { x0, y0, 0.f }, { dx, 0.f, 0.f }, { 0.f, dy, 0.f } };
+    noiseGridRun(&grid, h);
+}
 
-// rotates a vector using a 4x4 matrix, translation column is ignored
-void rotateVector(v3 vSrc, Matrix mMatrix, v3 *vOut)
+// out[y * w + x] = noise(n, x0 + x * dx, y0 + y * dy, z), a slice of 3D noise at depth z
+void noiseGrid3(const Noise *n, f32 *out, i32 w, i32 h, f32 x0, f32 y0, f32 z, f32 dx, f32 dy, i32 fractal = NOISE_FBM)
 {
-	vOut->x = mMatrix[0] * vSrc.x + mMatrix[4] * vSrc.y + mMatrix[8] * vSrc.z;
-	vOut->y = mMatrix[1] * vSrc.x + mMatrix[5] * vSrc.y + mMatrix[9] * vSrc.z;
-	vOut->z = mMatrix[2] * vSrc.x + mMatrix[6] * vSrc.y + mMatrix[10] * vSrc.z;
+    NoiseGrid grid = { n->perm, out, w, 3, n->octaves, n->falloff, fractal,
+        { x0, y0, z }, { dx, 0.f, 0.f }, { 0.f, dy, 0.f } };
+    noiseGridRun(&grid, h);
 }
 
-// load a matrix with the identity matrix
-void loadIdentityMatrix(Matrix m)
+inline void noiseGrid2(f32 *out, i32 w, i32 h, f32 x0, f32 y0, f32 dx, f32 dy, i32 fractal = NOISE_FBM)
 {
-	static Matrix identity = {
-		1.0f, 0.0f, 0.0f, 0.0f, // x column
-		0.0f, 1.0f, 0.0f, 0.0f, // y column
-		0.0f, 0.0f, 1.0f, 0.0f, // z column
-		0.0f, 0.0f, 0.0f, 1.0f  // translation
-	};
-    
-	memcpy(m, identity, sizeof(Matrix));
-	//glMatrixMode(GL_MODELVIEW);
-	//glLoadMatrixf(identity);
+    noiseGrid2(&noiseDefault, out, w, h, x0, y0, dx, dy, fractal);
 }
 
-// reset the transformation matrix
-void loadIdentityMatrix()
+inline void noiseGrid3(f32 *out, i32 w, i32 h, f32 x0, f32 y0, f32 z, f32 dx, f32 dy, i32 fractal = NOISE_FBM)
 {
-	static Matrix identity = {
-		1.0f, 0.0f, 0.0f, 0.0f,
-		0.0f, 1.0f, 0.0f, 0.0f,
-		0.0f, 0.0f, 1.0f, 0.0f,
-		0.0f, 0.0f, 0.0f, 1.0f
-	};
-    
-	memcpy(transformationMatrix, identity, sizeof(Matrix));
+    noiseGrid3(&noiseDefault, out, w, h, x0, y0, z, dx, dy, fractal);
 }
 
-// multiply two 4x4 matricies
-void multiplyMatrix(const Matrix m1, const Matrix m2, Matrix mProduct)
+// noise fields cache a fixed 2D region of noise for terrain and flow fields that look up the same values
+// every frame. the region is sampled every spacing units and kept in tiles of NOISE_TILE intervals plus an
+// extra row and column, so the four samples of a bilinear fetch are always in one tile. level l of the
+// pyramid has 2^l times the spacing and l octaves less, the detail it can't represent is left out.
+// tiles are computed the first time a lookup touches them, noiseFieldFill computes all of them up front
+// over the processors. after that lookups only read, so they can be made from any thread
+#define NOISE_TILE 32
+#define NOISE_FIELD_MAX_LEVELS 8
+
+struct NoiseFieldLevel
 {
-	mProduct[0] = m1[0] * m2[0] + m1[4] * m2[1] + m1[8] * m2[2] + m1[12] * m2[3];
-	mProduct[4] = m1[0] * m2[4] + m1[4] * m2[5] + m1[8] * m2[6] + m1[12] * m2[7];
-	mProduct[8] = m1[0] * m2[8] + m1[4] * m2[9] + m1[8] * m2[10] + m1[12] * m2[11];
-	mProduct[12] = m1[0] * m2[12] + m1[4] * m2[13] + m1[8] * m2[14] + m1[12] * m2[15];
-    
-	mProduct[1] = m1[1] * m2[0] + m1[5] * m2[1] + m1[9] * m2[2] + m1[13] * m2[3];
-	mProduct[5] = m1[1] * m2[4] + m1[5] * m2[5] + m1[9] * m2[6] + m1[13] * m2[7];
-	mProduct[9] = m1[1] * m2[8] + m1[5] * m2[9] + m1[9] * m2[10] + m1[13] * m2[11];
-	mProduct[13] = m1[1] * m2[12] + m1[5] * m2[13] + m1[9] * m2[14] + m1[13] * m2[15];
-    
-	mProduct[2] = m1[2] * m2[0] + m1[6] * m2[1] + m1[10] * m2[2] + m1[14] * m2[3];
-	mProduct[6] = m1[2] * m2[4] + m1[6] * m2[5] + m1[10] * m2[6] + m1[14] * m2[7];
-	mProduct[10] = m1[2] * m2[8] + m1[6] * m2[9] + m1[10] * m2[10] + m1[14] * m2[11];
-	mProduct[14] = m1[2] * m2[12] + m1[6] * m2[13] + m1[10] * m2[14] + m1[14] * m2[15];
-    
-	mProduct[3] = m1[3] * m2[0] + m1[7] * m2[1] + m1[11] * m2[2] + m1[15] * m2[3];
-	mProduct[7] = m1[3] * m2[4] + m1[7] * m2[5] + m1[11] * m2[6] + m1[15] * m2[7];
-	mProduct[11] = m1[3] * m2[8] + m1[7] * m2[9] + m1[11] * m2[10] + m1[15] * m2[11];
-	mProduct[15] = m1[3] * m2[12] + m1[7] * m2[13] + m1[11] * m2[14] + m1[15] * m2[15];
+    f32 spacing;
+    i32 intervalsX, intervalsY; // sample intervals over the region
+    i32 tilesX, tilesY;
+    f32 **tiles; // (NOISE_TILE + 1)^2 samples each, 0 until used
+};
+
+struct NoiseField
+{
+    Noise noise; // a copy, the field doesn't change when the instance does
+    f32 x, y, width, height;
+    i32 fractal;
+    i32 levelCount;
+    NoiseFieldLevel levels[NOISE_FIELD_MAX_LEVELS];
+};
+
+// the w by h region at (x, y) of noise instance n
+NoiseField noiseFieldCreate(const Noise *n, f32 x, f32 y, f32 w, f32 h, f32 spacing, i32 levels = 1, i32 fractal = NOISE_FBM)
+{
+    Assert(w > 0.f && h > 0.f && spacing > 0.f);
+    NoiseField result = {};
+    result.noise = *n;
+    result.x = x;
+    result.y = y;
+    result.width = w;
+    result.height = h;
+    result.fractal = fractal;
+    result.levelCount = constrain(levels, 1, NOISE_FIELD_MAX_LEVELS);
+    for (i32 l = 0; l < result.levelCount; l++) {
+        NoiseFieldLevel *level = result.levels + l;
+        level->spacing = spacing * (f32)(1 << l);
+        level->intervalsX = maximum(1, (i32)ceilf(w / level->spacing));
+        level->intervalsY = maximum(1, (i32)ceilf(h / level->spacing));
+        level->tilesX = (level->intervalsX + NOISE_TILE - 1) / NOISE_TILE;
+        level->tilesY = (level->intervalsY + NOISE_TILE - 1) / NOISE_TILE;
+        level->tiles = (f32 **)calloc(level->tilesX * level->tilesY, sizeof(f32 *));
+    }
+    return result;
 }
 
-// create a translation matrix
-void translateMatrix(f32 x, f32 y, f32 z)
+// the region of noise() with the current noiseSeed and noiseDetail
+inline NoiseField noiseFieldCreate(f32 x, f32 y, f32 w, f32 h, f32 spacing, i32 levels = 1, i32 fractal = NOISE_FBM)
 {
-	loadIdentityMatrix(translationMatrix);
-	translationMatrix[12] = x;
-	translationMatrix[13] = y;
-	translationMatrix[14] = z;
-    //	glMultMatrixf(translationMatrix);
-	multiplyMatrix(translationMatrix, transformationMatrix, transformationMatrix);
-    
+    return noiseFieldCreate(&noiseDefault, x, y, w, h, spacing, levels, fractal);
 }
 
-void translateMatrix(Matrix m, v3 pos)
+void noiseFieldFree(NoiseField *field)
+{
+    for (i32 l = 0; l < field->levelCount; l++) {
+        NoiseFieldLevel *level = field->levels + l;
+        for (i32 i = 0; i < level->tilesX * level->tilesY; i++)
+            free(level->tiles[i]);
+        free(level->tiles);
+        level->tiles = 0;
+    }
+    field->levelCount = 0;
+}
+
+internal f32 *
+noiseFieldTile(NoiseField *field, i32 l, i32 tileX, i32 tileY)
 {
-	loadIdentityMatrix(translationMatrix);
-	translationMatrix[12] = pos.x;
-	translationMatrix[13] = pos.y;
-	translationMatrix[14] = pos.z;
-    //	glMultMatrixf(translationMatrix);
-	multiplyMatrix(translationMatrix, transformationMatrix, m);
-    //return m;
-    m[0] = 99;
+    NoiseFieldLevel *level = field->levels + l;
+    f32 **tile = level->tiles + tileY * level->tilesX + tileX;
+    if (*tile == 0) {
+        f32 *samples = (f32 *)malloc(sizeof(f32) * (NOISE_TILE + 1) * (NOISE_TILE + 1));
+        NoiseGrid grid = { field->noise.perm, samples, NOISE_TILE + 1, 2, maximum(1, field->noise.octaves - l), field->noise.falloff, field->fractal,
+            { field->x + (f32)(tileX * NOISE_TILE) * level->spacing, field->y + (f32)(tileY * NOISE_TILE) * level->spacing, 0.f },
+            { level->spacing, 0.f, 0.f }, { 0.f, level->spacing, 0.f } };
+        noiseGridRows(&grid, 0, NOISE_TILE + 1);
+        *tile = samples;
+    }
+    return *tile;
 }
 
+internal void
+noiseFieldTiles(void *data, i32 first, i32 last)
+{
+    NoiseField *field = (NoiseField *)data;
+    i32 l = 0;
+    i32 levelFirst = 0;
+    for (i32 i = first; i < last; i++) {
+        while (i - levelFirst >= field->levels[l].tilesX * field->levels[l].tilesY) {
+            levelFirst += field->levels[l].tilesX * field->levels[l].tilesY;
+            l++;
+        }
+        i32 tile = i - levelFirst;
+        noiseFieldTile(field, l, tile % field->levels[l].tilesX, tile / field->levels[l].tilesX);
+    }
+}
 
-// create a scaling matrix
-void scale(f32 x, f32 y, f32 z)
+// computes every tile of every level
+void noiseFieldFill(NoiseField *field)
 {
-	loadIdentityMatrix(scalingMatrix);
-	scalingMatrix[0] = x;
-	scalingMatrix[5] = y;
-	scalingMatrix[10] = z;
-	//glMultMatrixf(scalingMatrix);
-	multiplyMatrix(transformationMatrix, scalingMatrix, transformationMatrix);
+    i32 count = 0;
+    for (i32 l = 0; l < field->levelCount; l++)
+        count += field->levels[l].tilesX * field->levels[l].tilesY;
+    parallelFor(count, 4, noiseFieldTiles, field);
 }
 
-//creates a 4x4 rotation matrix, takes radians
-void rotate(f32 angle, v3 pos)
+// bilinear lookup in the given level, positions outside the region are clamped to its edges
+f32 noiseFieldSample(NoiseField *field, f32 x, f32 y, i32 level = 0)
 {
-	f32 sinSave, cosSave, oneMinusCos;
-	f32 xx, yy, zz, xy, yz, zx, xs, ys, zs;
+    level = constrain(level, 0, field->levelCount - 1);
+    NoiseFieldLevel *l = field->levels + level;
+    f32 u = constrainf((x - field->x) / l->spacing, 0.f, (f32)l->intervalsX);
+    f32 v = constrainf((y - field->y) / l->spacing, 0.f, (f32)l->intervalsY);
+    i32 i = minimum((i32)u, l->intervalsX - 1);
+    i32 j = minimum((i32)v, l->intervalsY - 1);
+    f32 fu = u - (f32)i;
+    f32 fv = v - (f32)j;
+
+    i32 tileX = i / NOISE_TILE;
+    i32 tileY = j / NOISE_TILE;
+    const f32 *s = noiseFieldTile(field, level, tileX, tileY) +
+        (j - tileY * NOISE_TILE) * (NOISE_TILE + 1) + (i - tileX * NOISE_TILE);
+    f32 top = lerp(s[0], s[1], fu);
+    f32 bottom = lerp(s[NOISE_TILE + 1], s[NOISE_TILE + 2], fu);
+    return lerp(top, bottom, fv);
+}
+
+
+//
+// Vectors 
+//
+
+union v2 {
+    
+    struct {
+        f32 x, y;
+    };
+    struct {
+        f32 w, h;
+    };
+    
+    v2() = default;
+    constexpr v2(f32 X, f32 Y) : x(X), y(Y) {}
     
-	if (pos.x == 0.0f && pos.y == 0.0f && pos.z == 0.0f) {
-		loadIdentityMatrix(rotationMatrix);
-		return;
-	}
+    // calculate length (magnitude) of the vector, square root of x^2 + y^2 -> same as sqrt(dotProduct(*this))
+    // The Pythagorean Theorem
+    f32 length() 
+    {
+        f32 result = squareRoot(x * x + y * y);
+        return result;
+    }
     
-	// normalize rotation matrix
-	pos.normalize();
+    // the squared length, compare against this to avoid the square root
+    constexpr f32 lengthSquared() const
+    {
+        return x * x + y * y;
+    }
     
-	sinSave = sin(angle);
-	cosSave = cos(angle);
-	oneMinusCos = 1.0f - cosSave;
+    // returns the angle of rotation, the heading (direction), of the vector.
+    f32 heading() 
+    { 
+        f32 result = arcTangent2(y, x);
+        return result;
+    }
     
-	xx = pos.x * pos.x;
-	yy = pos.y * pos.y;
-	zz = pos.z * pos.z;
-	xy = pos.x * pos.y;
-	yz = pos.y * pos.z;
-	zx = pos.z * pos.x;
-	xs = pos.x * sinSave;
-	ys = pos.y * sinSave;
-	zs = pos.z * sinSave;
+    // calculate the dot(inner) product, returns a scalar
+    // dot product of a * b = lenght of a * length of b * cos(angle between them)
+    // The dot product consists of multiplying each element of the A vector with its counterpart from vector B and taking the sum of each product.
+    constexpr f32 dotProduct(v2 a) const
+    {
+        return x * a.x + y * a.y;
+    }
     
-	rotationMatrix[0] = (oneMinusCos * xx) + cosSave;
-	rotationMatrix[4] = (oneMinusCos * xy) - zs;
-	rotationMatrix[8] = (oneMinusCos * zx) + ys;
-	rotationMatrix[12] = 0.0f;
+    // calculates and returns the angle (in radians) between two vectors
+    // dot product of a * b = lenght of a * length of b * cos(angle between them)
+    f32 angleBetween(v2 a)
+    {
+        f32 d = a.dotProduct(*this);
+        // one exact square root, acos is too steep near 0 and pi for the inverse square root estimate
+        f32 c = d / squareRoot(a.lengthSquared() * lengthSquared());
+        f32 result = arcCosine(constrainf(c, -1.f, 1.f));
+        return result;
+    }
     
-	rotationMatrix[1] = (oneMinusCos * xy) + zs;
-	rotationMatrix[5] = (oneMinusCos * yy) + cosSave;
-	rotationMatrix[9] = (oneMinusCos * yz) - xs;
-	rotationMatrix[13] = 0.0f;
+    // set length of vector, scales the vector instead of going through the angle
+    // a vector of length 0 has heading 0 and becomes (length, 0)
+    void setLength(f32 length)
+    {
+        f32 l = lengthSquared();
+        if (l > 0) {
+            f32 scale = length * inverseSquareRoot(l);
+            x *= scale;
+            y *= scale;
+        } else {
+            x = length;
+            y = 0;
+        }
+    }
     
-	rotationMatrix[2] = (oneMinusCos * zx) - ys;
-	rotationMatrix[6] = (oneMinusCos * yz) + xs;
-	rotationMatrix[10] = (oneMinusCos * zz) + cosSave;
-	rotationMatrix[14] = 0.0f;
+    // set the angle of the vector
+    void setAngle(f32 angle)
+    {
+        f32 l = length();
+        x = cosinus(angle) * l;
+        y = sinus(angle) * l;
+    }
     
-	rotationMatrix[3] = 0.0f;
-	rotationMatrix[7] = 0.0f;
-	rotationMatrix[11] = 0.0f;
-	rotationMatrix[15] = 1.0f;
+    // limit the magnitude of the vector
+    void limit(f32 max)
+    {
+        f32 l = lengthSquared();
+        if (l > max * max) {
+            f32 scale = max * inverseSquareRoot(l);
+            x *= scale;
+            y *= scale;
+        }
+    }
     
-	multiplyMatrix(transformationMatrix, rotationMatrix, transformationMatrix);
+    // calculate a unit vector. normalizing a vector makes its length equal to 1.
+    // to normalize a vector - multiply it by the inverse of its length
+    void normalize()
+    {
+        f32 l = lengthSquared();
+        // avoid divide by 0
+        if (l > 0) { 
+            f32 scale = inverseSquareRoot(l);
+            x *= scale;
+            y *= scale;
+        }
+    }
+};
+
+// overloaded operators, constexpr so they also work on constants
+// vector addition: newVector = v1 + v2;
+constexpr v2 operator+(v2 a, v2 b)
+{
+    return v2{ a.x + b.x, a.y + b.y };
 }
 
-// create a translation matrix
-void createTranslationMatrix(f32 x, f32 y, f32 z, Matrix mTranslate)
+// v1 += v2;
+constexpr v2 &operator+=(v2 &a, v2 b)
 {
-    loadIdentityMatrix(mTranslate);
-    mTranslate[12] = x;
-    mTranslate[13] = y;
-    mTranslate[14] = z;
+    a = a + b;
+    return a;
 }
 
-// create a scaling matrix
-void createScalingMatrix(f32 x, f32 y, f32 z, Matrix mScale)
+// vector subtraction
+constexpr v2 operator-(v2 a, v2 b)
 {
-    loadIdentityMatrix(mScale);
-    mScale[0] = x;
-    mScale[5] = y;
-    mScale[10] = z;
+    return v2{ a.x - b.x, a.y - b.y };
 }
 
-// creates a 4x4 rotation matrix, takes radians
-void createRotationMatrix(f32 angle, v3 pos, Matrix mMatrix)
+constexpr v2 operator-=(v2 &a, v2 b)
 {
-    f32 sinSave, cosSave, oneMinusCos;
-    f32 xx, yy, zz, xy, yz, zx, xs, ys, zs;
-    
-    if (pos.x == 0.0f && pos.y == 0.0f && pos.z == 0.0f)
-    {
-        loadIdentityMatrix(mMatrix);
-        return;
-    }
-    
-    // normalize rotation matrix
-    pos.normalize();
-    
-    sinSave = (f32)sin(angle);
-    cosSave = (f32)cos(angle);
-    oneMinusCos = 1.0f - cosSave;
-    
-    xx = pos.x * pos.x;
-    yy = pos.y * pos.y;
-    zz = pos.z * pos.z;
-    xy = pos.x * pos.y;
-    yz = pos.y * pos.z;
-    zx = pos.z * pos.x;
-    xs = pos.x * sinSave;
-    ys = pos.y * sinSave;
-    zs = pos.z * sinSave;
-    
-    mMatrix[0] = (oneMinusCos * xx) + cosSave;
-    mMatrix[4] = (oneMinusCos * xy) - zs;
-    mMatrix[8] = (oneMinusCos * zx) + ys;
-    mMatrix[12] = 0.0f;
-    
-    mMatrix[1] = (oneMinusCos * xy) + zs;
-    mMatrix[5] = (oneMinusCos * yy) + cosSave;
-    mMatrix[9] = (oneMinusCos * yz) - xs;
-    mMatrix[13] = 0.0f;
-    
-    mMatrix[2] = (oneMinusCos * zx) - ys;
-    mMatrix[6] = (oneMinusCos * yz) + xs;
-    mMatrix[10] = (oneMinusCos * zz) + cosSave;
-    mMatrix[14] = 0.0f;
-    
-    mMatrix[3] = 0.0f;
-    mMatrix[7] = 0.0f;
-    mMatrix[11] = 0.0f;
-    mMatrix[15] = 1.0f;
+    a = a - b;
+    return a;
 }
 
-// creates a shadow matrix out of the plane equation coefficients and the position of the light
-void createShadowMatrix(v3 vPoints[3], f32 vLightPos[4], Matrix destMat)
+// vector multiplication with a scalar number (vector scaling)
+constexpr v2 operator*(f32 scalar, v2 a)
 {
-    f32 vPlaneEquation[4];
-    f32 dot;
-    //Matrix destMat;
-    
-    v3GetPlaneEquation(vPoints[0], vPoints[1], vPoints[2], vPlaneEquation);
-    
-    // dot product of plane and light position
-    dot = vPlaneEquation[0] * vLightPos[0] +
-        vPlaneEquation[1] * vLightPos[1] +
-        vPlaneEquation[2] * vLightPos[2] +
-        vPlaneEquation[3] * vLightPos[3];
-    
-    // calculate shadow projection
-    // 1st column
-    destMat[0] = dot - vLightPos[0] * vPlaneEquation[0];
-    destMat[4] = 0.0f - vLightPos[0] * vPlaneEquation[1];
-    destMat[8] = 0.0f - vLightPos[0] * vPlaneEquation[2];
-    destMat[12] = 0.0f - vLightPos[0] * vPlaneEquation[3];
-    
-    // 2nd column
-    destMat[1] = 0.0f - vLightPos[1] * vPlaneEquation[0];
-    destMat[5] = dot - vLightPos[1] * vPlaneEquation[1];
-    destMat[9] = 0.0f - vLightPos[1] * vPlaneEquation[2];
-    destMat[13] = 0.0f - vLightPos[1] * vPlaneEquation[3];
-    
-    // 3rd Column
-    destMat[2] = 0.0f - vLightPos[2] * vPlaneEquation[0];
-    destMat[6] = 0.0f - vLightPos[2] * vPlaneEquation[1];
-    destMat[10] = dot - vLightPos[2] * vPlaneEquation[2];
-    destMat[14] = 0.0f - vLightPos[2] * vPlaneEquation[3];
-    
-    // 4th Column
-    destMat[3] = 0.0f - vLightPos[3] * vPlaneEquation[0];
-    destMat[7] = 0.0f - vLightPos[3] * vPlaneEquation[1];
-    destMat[11] = 0.0f - vLightPos[3] * vPlaneEquation[2];
-    destMat[15] = dot - vLightPos[3] * vPlaneEquation[3];
+    return v2{ scalar * a.x, scalar * a.y };
 }
 
-//
-// Colors
-//
+constexpr v2 operator*(v2 a, f32 scalar)
+{
+    return scalar * a;
+}
 
-union Color
+constexpr v2 &operator*=(v2 &a, f32 scalar)
 {
-    struct {
-        i32 r, g, b, a;
-    };
-    struct {
-        i32 h, s, b, a;
-    };
-    struct {
-        i32 h, s, l, a;
-    };
-    struct {
-        f32 fR, fG, fB, fA;
-    };
-};
+    a = scalar * a;
+    return a;
+}
 
-typedef struct {
-    f32 r, g, b, a;
-} Colorf;
+// divide by a scalar number
+constexpr v2 operator/(f32 scalar, v2 a)
+{
+    return v2{ scalar / a.x, scalar / a.y };
+}
 
-enum ColorModes {
-    RGB,
-    HSB,
-    HSL
-};
+// one divide and two multiplies
+constexpr v2 operator/(v2 a, f32 scalar)
+{
+    return a * (1.f / scalar);
+}
 
-Color black = { 0,0,0, 255 };
-Color white = { 255,255,255, 255 };
-Color c64red = { 104, 55, 43, 255 };
-Color c64cyan = { 112, 164, 178, 255 };
-Color c64purple = { 111, 61, 134, 255 };
-Color c64green = { 88, 141, 67, 255 };;
-Color c64blue = { 53, 40, 121, 255 };
-Color c64yellow = { 184, 199, 111, 255 };
-Color c64orange = { 111, 79, 37, 255 };;
-Color c64brown = { 67, 57, 0, 255 };
-Color c64lightred = { 154, 103, 89, 255 };
-Color c64darkgrey = { 68, 68, 68, 255 };
-Color c64grey = { 108, 108, 108, 255 };
-Color c64lightgreen = { 154, 210, 132, 255 };
-Color c64lightblue = { 108, 94, 181, 255 };
-Color c64lightgrey = { 149, 149, 149, 255 };
-Color red = { 255,0,0, 255 };
-Color green = { 0,255,0, 255 };;
-Color blue = { 0,0,255, 255 };
-Color yellow = { 255,255,0, 255 };
-Color cyan = { 0,255,255, 255 };
-Color magenta = { 255,0,255, 255 };
-Color purple = { 128, 0, 128, 255 };
-Color gray = { 128, 128, 128, 255 };
-Color grey = { 192, 192, 192, 255 };
-Color maroon = { 128, 0, 0, 255 };
-Color darkgreen = { 0, 128, 0, 255 };
-Color navy = { 0, 0, 128, 255 };
-Color teal = { 0, 128, 128, 255 };
-Color olive = { 128, 128, 0, 255 };
-Color orange = { 255,127,50, 255 };
-Color cornflowerblue = { 101, 156, 239, 255 };
-Color azure = { 0, 127, 255, 255 };
-Color turquoise = { 48, 213, 200, 255 };
-Color gold = { 255, 215, 0, 255 };
-Color silver = { 192, 192, 192, 255 };
-Color pink = { 255, 192, 203, 255 };
-Color brown = { 0xa5,0x2a,0x2a, 0xff };
+constexpr v2 &operator/=(v2 &a, f32 scalar)
+{
+    a = a / scalar;
+    return a;
+}
 
-//
-// Input
-//
+// vector negation, vector equals it's negative
+constexpr v2 operator-(v2 a)
+{
+    return v2{ -a.x, -a.y };
+}
+
+// the hadamard product - element-wise product of two vectors which return a new vector
+constexpr v2 v2Hadamard(v2 a, v2 b)
+{
+    return v2{ a.x * b.x, a.y * b.y };
+}
+
+// calculate the dot(inner) product which gives us the angle between two vectors, returns a scalar
+// The dot product tells you what amount of one vector goes in the direction of another.
+// dot product of a * b = lenght of a * length of b * cos(angle between them)
+// The dot product consists of multiplying each element of the A vector with its counterpart from vector B and taking the sum of each product.
+constexpr f32 v2DotProduct(v2 a, v2 b)
+{
+    return a.x * b.x + a.y * b.y;
+}
+
+// using the Pythagorean Theorem to calculate the distance between 2 points
+// same as calculating a vectors length
+inline f32 dist(v2 a, v2 b)
+{
+    return squareRoot((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y));
+}
+
+// random 2d direction
+inline v2 random2d()
+{
+    v2 vec = v2(1.0, 1.0);
+    //vec.normalize();
+    vec.setAngle(random() * TWO_PI);
+    return vec;
+}
+
+// count random 2d directions, the batch form of random2d()
+void randomFill2d(v2 *out, i32 count)
+{
+    u32 bits[RANDOM_BLOCK];
+    __m128 toAngle = _mm_set1_ps(TWO_PI / 16777216.f);
+    for (i32 first = 0; first < count; first += RANDOM_BLOCK) {
+        i32 n = minimum(RANDOM_BLOCK, count - first);
+        randomFillBits(bits, (n + 3) & ~3);
+        i32 i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128 angle = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(_mm_loadu_si128((__m128i *)(bits + i)), 8)), toAngle);
+            __m128 s, c;
+            fastSinCos4(angle, &s, &c);
+            _mm_storeu_ps(&out[first + i].x, _mm_unpacklo_ps(c, s));
+            _mm_storeu_ps(&out[first + i + 2].x, _mm_unpackhi_ps(c, s));
+        }
+        for (; i < n; i++) {
+            f32 s, c;
+            fastSinCos((f32)(bits[i] >> 8) * (TWO_PI / 16777216.f), &s, &c);
+            out[first + i] = v2(c, s);
+        }
+    }
+}
+
+inline void v2Swap(v2 *a, v2 *b)
+{
+    v2 temp;
+    temp.x = a->x;
+    a->x = b->x;
+    b->x = temp.x;
+    temp.y = a->y;
+    a->y = b->y;
+    b->y = temp.y;
+}
 
 typedef struct {
-    b32 isDown;
-    b32 changed;
-} ButtonState;
+    i32 x;
+    i32 y;
+} v2i;
 
-enum {
-    KEY_0 = 0x30,
-    KEY_1 = 0x31,
-    KEY_2 = 0x32,
-    KEY_3 = 0x33,
-    KEY_4 = 0x34,
-    KEY_5 = 0x35,
-    KEY_6 = 0x36,
-    KEY_7 = 0x37,
-    KEY_8 = 0x38,
-    KEY_9 = 0x39,
-    KEY_A = 0x41,
-    KEY_B = 0x42,
-    KEY_C = 0x43,
-    KEY_D = 0x44,
-    KEY_E = 0x45,
-    KEY_F = 0x46,
-    KEY_G = 0x47,
-    KEY_H = 0x48,
-    KEY_I = 0x49,
-    KEY_J = 0x4a,
-    KEY_K = 0x4b,
-    KEY_L = 0x4c,
-    KEY_M = 0x4d,
-    KEY_N = 0x4e,
-    KEY_O = 0x4f,
-    KEY_P = 0x50,
-    KEY_Q = 0x51,
-    KEY_R = 0x52,
-    KEY_S = 0x53,
-    KEY_T = 0x54,
-    KEY_U = 0x55,
-    KEY_V = 0x56,
-    KEY_W = 0x57,
-    KEY_X = 0x58,
-    KEY_Y = 0x59,
-    KEY_Z = 0x5a,
-    KEY_CTRL = VK_CONTROL,
-    KEY_ALT = VK_MENU,
-    KEY_SHIFT = VK_SHIFT,
-    KEY_ENTER = VK_RETURN,
-    KEY_ESCAPE = VK_ESCAPE,
-    KEY_SPACE = VK_SPACE,
-    KEY_BACK = VK_BACK,
-    KEY_TAB = VK_TAB,
-    KEY_PAUSE = VK_PAUSE,
-    KEY_SCROLL = VK_SCROLL,
-    KEY_INSERT = VK_INSERT,
-    KEY_HOME = VK_HOME,
-    KEY_END = VK_END,
-    KEY_DELETE = VK_DELETE,
-    KEY_PGUP = VK_PRIOR,
-    KEY_PGDOWN = VK_NEXT,
-    KEY_UP = VK_UP,
-    KEY_DOWN = VK_DOWN,
-    KEY_LEFT = VK_LEFT,
-    KEY_RIGHT = VK_RIGHT,
-    KEY_F1 = VK_F1,
-    KEY_F2 = VK_F2,
-    KEY_F3 = VK_F3,
-    KEY_F4 = VK_F4,
-    KEY_F5 = VK_F5,
-    KEY_F6 = VK_F6,
-    KEY_F7 = VK_F7,
-    KEY_F8 = VK_F8,
-    KEY_F9 = VK_F9,
-    KEY_F10 = VK_F10,
-    KEY_F11 = VK_F11,
-    KEY_F12 = VK_F12,
+// overloaded operators
+// vector addition: newVector = v1 + v2;
+inline v2i operator+(v2i a, v2i b)
+{
+    v2i result;
+    result.x = a.x + b.x;
+    result.y = a.y + b.y;
+    return result;
+}
+
+// v1 += v2;
+inline v2i &operator+=(v2i &a, v2i b)
+{
+    a = a + b;
+    return a;
+}
+
+// vector subtraction
+inline v2i operator-(v2i a, v2i b)
+{
+    v2i result;
+    result.x = a.x - b.x;
+    result.y = a.y - b.y;
+    return result;
+}
+
+inline v2i operator-=(v2i &a, v2i b)
+{
+    a = a - b;
+    return a;
+}
+
+// vector multiplication with a scalar number (vector scaling)
+inline v2i operator*(i32 scalar, v2i a)
+{
+    v2i result;
+    result.x = scalar * a.x;
+    result.y = scalar * a.y;
+    return result;
+}
+
+inline v2i operator*(v2i a, i32 scalar)
+{
+    v2i result = scalar * a;
+    return result;
+}
+
+inline v2i &operator*=(v2i &a, i32 scalar)
+{
+    a = scalar * a;
+    return a;
+}
+
+//divide by a scalar number
+inline v2i operator/(i32 scalar, v2i a)
+{
+    v2i result;
+    result.x = scalar / a.x;
+    result.y = scalar / a.y;
+    return result;
+}
+
+inline v2i operator/(v2i a, i32 scalar)
+{
+    v2i result;
+    result.x = a.x / scalar;
+    result.y = a.y / scalar;
+    return result;
+}
+
+inline v2i &operator/=(v2i &a, i32 scalar)
+{
+    a.x /= scalar;
+    a.y /= scalar;
+    return a;
+}
+
+// Vector3
+
+union v3 {
+    
+    struct {
+        f32 x, y, z;
+    };
+    struct {
+        f32 r, g, b;
+    };
+    struct {
+        f32 u, v, w;
+    };
+    
+    // swizzle
+    struct
+    {
+        v2 xy;
+        f32 _ignored0;
+    };
+    
+    struct
+    {
+        f32 _ignored1;
+        v2 yz;
+    };
+    
+    f32 e[3];
+    
+    v3() = default;
+    constexpr v3(f32 X, f32 Y, f32 Z) : x(X), y(Y), z(Z) {}
+    // overloaded operator for vector addition: v3 = v1 + v2;
+    constexpr v3 operator+(const v3& v2) const
+    {
+        return v3{ x + v2.x, y + v2.y, z + v2.z };
+    }
+    
+    // v1 += v2;
+    friend constexpr v3& operator+=(v3& v1, const v3& v2)
+    {
+        v1.x += v2.x;
+        v1.y += v2.y;
+        v1.z += v2.z;
+        return v1;
+    }
+    
+    // subtracting two vectors
+    constexpr v3 operator-(const v3& v2) const
+    {
+        return v3{ x - v2.x, y - v2.y, z - v2.z };
+    }
+    
+    friend constexpr v3& operator-=(v3& v1, const v3& v2)
+    {
+        v1.x -= v2.x;
+        v1.y -= v2.y;
+        v1.z -= v2.z;
+        return v1;
+    }
+    
+    //multiply by a scalar number
+    constexpr v3 operator*(f32 scalar) const
+    {
+        return v3{ x * scalar, y * scalar, z * scalar };
+    }
+    
+    constexpr v3& operator*=(f32 scalar)
+    {
+        x *= scalar;
+        y *= scalar;
+        z *= scalar;
+        return *this;
+    }
+    
+    //divide by a scalar number, one divide and three multiplies
+    constexpr v3 operator/(f32 scalar) const
+    {
+        return (*this) * (1.f / scalar);
+    }
+    
+    constexpr v3& operator/=(f32 scalar)
+    {
+        return (*this) *= 1.f / scalar;
+    }
+    
+    
+    //calculate length (magnitude) of the vector, square root of x^2 + y^2 + z^2
+    f32 length() { return squareRoot(x * x + y * y + z * z); }
+    
+    // the squared length, compare against this to avoid the square root
+    constexpr f32 lengthSquared() const { return x * x + y * y + z * z; }
+    
+    //normalizing a vector makes its length equal to 1.
+    //to normalize a vector - multiply it by the inverse of its length
+    void normalize()
+    {
+        f32 l = lengthSquared();
+        if (l > 0) //avoid divide by 0
+        {
+            (*this) *= inverseSquareRoot(l);
+        }
+    }
+};
+
+// vector negation, vector equals it's negative
+constexpr v3 operator-(v3 a)
+{
+    return v3{ -a.x, -a.y, -a.z };
+}
+
+typedef union v4 {
+    struct {
+        f32 r, g, b, a;
+    };
+    struct {
+        f32 h, s, b, a;
+    };
+    struct {
+        f32 h, s, l, a;
+    };
+    struct {
+        f32 x, y, z, w;
+    };
+    f32 e[4];
+} v4;
+
+#define v2i(x, y) v2iInit(x, y)
+constexpr v2i v2iInit(i32 x, i32 y)
+{
+    v2i result = { x, y };
+    return result;
+}
+
+#define v2(x, y) v2Init(x, y)
+constexpr v2 v2Init(f32 x, f32 y)
+{
+    return v2{ x, y };
+}
+
+#define v3(x, y, z) v3Init(x, y, z)
+constexpr v3 v3Init(f32 x, f32 y, f32 z)
+{
+    return v3{ x, y, z };
+}
+
+#define v4(x, y, z, w) v4Init(x, y, z, w)
+constexpr v4 v4Init(f32 x, f32 y, f32 z, f32 w)
+{
+    return v4{ x, y, z, w };
+}
+
+// vector addition
+constexpr v2
+v2Add(v2 a, v2 b)
+{
+    return v2(a.x + b.x, a.y + b.y);
+}
+
+// vector subtraction
+constexpr v2
+v2Sub(v2 a, v2 b)
+{
+    return v2(a.x - b.x, a.y - b.y);
+}
+
+// multiplication with a scalar
+constexpr v2
+v2Mul(v2 a, f32 s)
+{
+    return v2(a.x * s, a.y * s);
+}
+
+// calculate length (magnitude) of the vector, square root of x^2 + y^2 + z^2
+f32 v3Length(v3 inVec)
+{
+    f32 result = squareRoot(inVec.x * inVec.x + inVec.y * inVec.y + inVec.z * inVec.z);
+    return result;
+}
+
+// normalizing a vector makes its length equal to 1.
+// to normalize a vector - multiply it by the inverse of its length
+v3 v3Normalize(v3 inVec)
+{
+    f32 l = inVec.lengthSquared();
+    //avoid divide by 0
+    if (l > 0)
+        inVec *= inverseSquareRoot(l);
+    return inVec;
+}
+
+constexpr f32 v3DotProduct(v3 a, v3 b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+// calculate the cross product of two vectors
+constexpr v3 v3CrossProduct(v3 v1, v3 v2)
+{
+    return v3{ v1.y * v2.z - v2.y * v1.z, -v1.x * v2.z + v2.x * v1.z, v1.x * v2.y - v2.x * v1.y };
+}
+
+// calculate the unit normal from 3 points on a plane in CCW-order
+v3 v3GetNormalVector(v3 vP1, v3 vP2, v3 vP3)
+{
+    v3 vV1, vV2;
+    v3 vNormal;
+    vV1 = vP2 - vP1;
+    vV2 = vP3 - vP1;
+
+    vNormal = v3CrossProduct(vV1, vV2);
+    vNormal.normalize();
+    return vNormal;
+}
+
+// gets the three coefficients of a plane equation given three points on the plane
+void v3GetPlaneEquation(v3 vPoint1, v3 vPoint2, v3 vPoint3, f32 vPlane[4])
+{
+    // get normal vector from three points
+    // the normal vector is the first three coefficients to the plane equation
+    v3 vP = v3GetNormalVector(vPoint1, vPoint2, vPoint3);
+    vPlane[0] = vP.x;
+    vPlane[1] = vP.y;
+    vPlane[2] = vP.z;
+    // final coefficient found by back substitution
+    vPlane[3] = -(vPlane[0] * vPoint3.x + vPlane[1] * vPoint3.y + vPlane[2] * vPoint3.z);
+}
+
+// 3D noise on any plane, out[y * w + x] = noise((origin + y * stepY) + x * stepX)
+void noiseGrid3(const Noise *n, f32 *out, i32 w, i32 h, v3 origin, v3 stepX, v3 stepY, i32 fractal = NOISE_FBM)
+{
+    NoiseGrid grid = { n->perm, out, w, 3, n->octaves, n->falloff, fractal,
+        { origin.x, origin.y, origin.z }, { stepX.x, stepX.y, stepX.z }, { stepY.x, stepY.y, stepY.z } };
+    noiseGridRun(&grid, h);
+}
+
+inline void noiseGrid3(f32 *out, i32 w, i32 h, v3 origin, v3 stepX, v3 stepY, i32 fractal = NOISE_FBM)
+{
+    noiseGrid3(&noiseDefault, out, w, h, origin, stepX, stepY, fractal);
+}
+
+//
+// Vector arrays
+//
+// structure of arrays for large numbers of vectors, like particle systems. the components are kept in
+// separate arrays so the kernels below can work on four vectors at a time with SSE. the arrays are
+// 32-byte aligned and padded to a multiple of 8, out can be the same array as a or b in all kernels
+
+struct v2Array {
+    f32 *x, *y;
+    i32 count;
+};
+
+struct v3Array {
+    f32 *x, *y, *z;
+    i32 count;
+};
+
+// one extra cache line between the components, with power of two counts the x and y of the same vector
+// would otherwise be a multiple of 4KB apart and the CPU stalls on false load-store conflicts
+internal i32
+vectorArrayStride(i32 count)
+{
+    return ((count + 7) & ~7) + 16;
+}
+
+v2Array v2ArrayCreate(i32 count)
+{
+    v2Array result;
+    i32 stride = vectorArrayStride(count);
+    result.x = (f32 *)_aligned_malloc(sizeof(f32) * stride * 2, 32);
+    result.y = result.x + stride;
+    result.count = count;
+    clearMemory(result.x, sizeof(f32) * stride * 2);
+    return result;
+}
+
+v3Array v3ArrayCreate(i32 count)
+{
+    v3Array result;
+    i32 stride = vectorArrayStride(count);
+    result.x = (f32 *)_aligned_malloc(sizeof(f32) * stride * 3, 32);
+    result.y = result.x + stride;
+    result.z = result.y + stride;
+    result.count = count;
+    clearMemory(result.x, sizeof(f32) * stride * 3);
+    return result;
+}
+
+void v2ArrayFree(v2Array *a)
+{
+    _aligned_free(a->x);
+    a->x = a->y = 0;
+    a->count = 0;
+}
+
+void v3ArrayFree(v3Array *a)
+{
+    _aligned_free(a->x);
+    a->x = a->y = a->z = 0;
+    a->count = 0;
+}
+
+inline v2 v2ArrayGet(const v2Array *a, i32 i)
+{
+    return v2(a->x[i], a->y[i]);
+}
+
+inline void v2ArraySet(v2Array *a, i32 i, v2 v)
+{
+    a->x[i] = v.x;
+    a->y[i] = v.y;
+}
+
+inline v3 v3ArrayGet(const v3Array *a, i32 i)
+{
+    return v3(a->x[i], a->y[i], a->z[i]);
+}
+
+inline void v3ArraySet(v3Array *a, i32 i, v3 v)
+{
+    a->x[i] = v.x;
+    a->y[i] = v.y;
+    a->z[i] = v.z;
+}
+
+// the padding belongs to the arrays, so the kernels run over whole groups of four without a scalar tail
+internal i32
+vectorArrayGroups(i32 count)
+{
+    return (count + 3) >> 2;
+}
+
+// out = a + b
+void v2ArrayAdd(v2Array *out, const v2Array *a, const v2Array *b)
+{
+    Assert(out->count >= a->count && b->count >= a->count);
+    i32 count = vectorArrayGroups(a->count) * 4;
+    for (i32 i = 0; i < count; i += 4) {
+        _mm_store_ps(out->x + i, _mm_add_ps(_mm_load_ps(a->x + i), _mm_load_ps(b->x + i)));
+        _mm_store_ps(out->y + i, _mm_add_ps(_mm_load_ps(a->y + i), _mm_load_ps(b->y + i)));
+    }
+}
+
+// out = a + v, adds the same vector to every element
+void v2ArrayAdd(v2Array *out, const v2Array *a, v2 v)
+{
+    Assert(out->count >= a->count);
+    __m128 vx = _mm_set1_ps(v.x);
+    __m128 vy = _mm_set1_ps(v.y);
+    i32 count = vectorArrayGroups(a->count) * 4;
+    for (i32 i = 0; i < count; i += 4) {
+        _mm_store_ps(out->x + i, _mm_add_ps(_mm_load_ps(a->x + i), vx));
+        _mm_store_ps(out->y + i, _mm_add_ps(_mm_load_ps(a->y + i), vy));
+    }
+}
+
+// out = a * s
+void v2ArrayScale(v2Array *out, const v2Array *a, f32 s)
+{
+    Assert(out->count >= a->count);
+    __m128 scale = _mm_set1_ps(s);
+    i32 count = vectorArrayGroups(a->count) * 4;
+    for (i32 i = 0; i < count; i += 4) {
+        _mm_store_ps(out->x + i, _mm_mul_ps(_mm_load_ps(a->x + i), scale));
+        _mm_store_ps(out->y + i, _mm_mul_ps(_mm_load_ps(a->y + i), scale));
+    }
+}
+
+// out = a + b * s, position += velocity * time
+void v2ArrayMultiplyAdd(v2Array *out, const v2Array *a, const v2Array *b, f32 s)
+{
+    Assert(out->count >= a->count && b->count >= a->count);
+    __m128 scale = _mm_set1_ps(s);
+    i32 count = vectorArrayGroups(a->count) * 4;
+    for (i32 i = 0; i < count; i += 4) {
+        _mm_store_ps(out->x + i, _mm_add_ps(_mm_load_ps(a->x + i), _mm_mul_ps(_mm_load_ps(b->x + i), scale)));
+        _mm_store_ps(out->y + i, _mm_add_ps(_mm_load_ps(a->y + i), _mm_mul_ps(_mm_load_ps(b->y + i), scale)));
+    }
+}
+
+// out[i] = length of a[i], out is a plain array so the last few are done one at a time
+void v2ArrayLength(f32 *out, const v2Array *a)
+{
+    i32 i = 0;
+    for (; i + 4 <= a->count; i += 4) {
+        __m128 x = _mm_load_ps(a->x + i);
+        __m128 y = _mm_load_ps(a->y + i);
+        _mm_storeu_ps(out + i, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y))));
+    }
+    for (; i < a->count; i++)
+        out[i] = squareRoot(a->x[i] * a->x[i] + a->y[i] * a->y[i]);
+}
+
+// out[i] = distance from a[i] to point
+void v2ArrayDistance(f32 *out, const v2Array *a, v2 point)
+{
+    __m128 px = _mm_set1_ps(point.x);
+    __m128 py = _mm_set1_ps(point.y);
+    i32 i = 0;
+    for (; i + 4 <= a->count; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_load_ps(a->x + i), px);
+        __m128 dy = _mm_sub_ps(_mm_load_ps(a->y + i), py);
+        _mm_storeu_ps(out + i, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy))));
+    }
+    for (; i < a->count; i++)
+        out[i] = squareRoot((a->x[i] - point.x) * (a->x[i] - point.x) + (a->y[i] - point.y) * (a->y[i] - point.y));
+}
+
+// normalizes every vector, vectors with length 0 are left as they are
+void v2ArrayNormalize(v2Array *out, const v2Array *a)
+{
+    Assert(out->count >= a->count);
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.f);
+    i32 count = vectorArrayGroups(a->count) * 4;
+    for (i32 i = 0; i < count; i += 4) {
+        __m128 x = _mm_load_ps(a->x + i);
+        __m128 y = _mm_load_ps(a->y + i);
+        __m128 lengthSquared = _mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y));
+        __m128 nonZero = _mm_cmpgt_ps(lengthSquared, zero);
+        __m128 scale = inverseSquareRoot4(lengthSquared);
+        scale = _mm_or_ps(_mm_and_ps(nonZero, scale), _mm_andnot_ps(nonZero, one));
+        _mm_store_ps(out->x + i, _mm_mul_ps(x, scale));
+        _mm_store_ps(out->y + i, _mm_mul_ps(y, scale));
+    }
+}
+
+// limits the length of every vector to max
+void v2ArrayLimit(v2Array *out, const v2Array *a, f32 max)
+{
+    Assert(out->count >= a->count);
+    __m128 maxLength = _mm_set1_ps(max);
+    __m128 maxSquared = _mm_set1_ps(max * max);
+    __m128 one = _mm_set1_ps(1.f);
+    i32 count = vectorArrayGroups(a->count) * 4;
+    for (i32 i = 0; i < count; i += 4) {
+        __m128 x = _mm_load_ps(a->x + i);
+        __m128 y = _mm_load_ps(a->y + i);
+        __m128 lengthSquared = _mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y));
+        __m128 tooLong = _mm_cmpgt_ps(lengthSquared, maxSquared);
+        __m128 scale = _mm_mul_ps(maxLength, inverseSquareRoot4(lengthSquared));
+        scale = _mm_or_ps(_mm_and_ps(tooLong, scale), _mm_andnot_ps(tooLong, one));
+        _mm_store_ps(out->x + i, _mm_mul_ps(x, scale));
+        _mm_store_ps(out->y + i, _mm_mul_ps(y, scale));
+    }
+}
+
+// out = a + b
+void v3ArrayAdd(v3Array *out, const v3Array *a, const v3Array *b)
+{
+    Assert(out->count >= a->count && b->count >= a->count);
+    i32 count = vectorArrayGroups(a->count) * 4;
+    for (i32 i = 0; i < count; i += 4) {
+        _mm_store_ps(out->x + i, _mm_add_ps(_mm_load_ps(a->x + i), _mm_load_ps(b->x + i)));
+        _mm_store_ps(out->y + i, _mm_add_ps(_mm_load_ps(a->y + i), _mm_load_ps(b->y + i)));
+        _mm_store_ps(out->z + i, _mm_add_ps(_mm_load_ps(a->z + i), _mm_load_ps(b->z + i)));
+    }
+}
+
+// out = a + v, adds the same vector to every element
+void v3ArrayAdd(v3Array *out, const v3Array *a, v3 v)
+{
+    Assert(out->count >= a->count);
+    __m128 vx = _mm_set1_ps(v.x);
+    __m128 vy = _mm_set1_ps(v.y);
+    __m128 vz = _mm_set1_ps(v.z);
+    i32 count = vectorArrayGroups(a->count) * 4;
+    for (i32 i = 0; i < count; i += 4) {
+        _mm_store_ps(out->x + i, _mm_add_ps(_mm_load_ps(a->x + i), vx));
+        _mm_store_ps(out->y + i, _mm_add_ps(_mm_load_ps(a->y + i), vy));
+        _mm_store_ps(out->z + i, _mm_add_ps(_mm_load_ps(a->z + i), vz));
+    }
+}
+
+// out = a * s
+void v3ArrayScale(v3Array *out, const v3Array *a, f32 s)
+{
+    Assert(out->count >= a->count);
+    __m128 scale = _mm_set1_ps(s);
+    i32 count = vectorArrayGroups(a->count) * 4;
+    for (i32 i = 0; i < count; i += 4) {
+        _mm_store_ps(out->x + i, _mm_mul_ps(_mm_load_ps(a->x + i), scale));
+        _mm_store_ps(out->y + i, _mm_mul_ps(_mm_load_ps(a->y + i), scale));
+        _mm_store_ps(out->z + i, _mm_mul_ps(_mm_load_ps(a->z + i), scale));
+    }
+}
+
+// out = a + b * s
+void v3ArrayMultiplyAdd(v3Array *out, const v3Array *a, const v3Array *b, f32 s)
+{
+    Assert(out->count >= a->count && b->count >= a->count);
+    __m128 scale = _mm_set1_ps(s);
+    i32 count = vectorArrayGroups(a->count) * 4;
+    for (i32 i = 0; i < count; i += 4) {
+        _mm_store_ps(out->x + i, _mm_add_ps(_mm_load_ps(a->x + i), _mm_mul_ps(_mm_load_ps(b->x + i), scale)));
+        _mm_store_ps(out->y + i, _mm_add_ps(_mm_load_ps(a->y + i), _mm_mul_ps(_mm_load_ps(b->y + i), scale)));
+        _mm_store_ps(out->z + i, _mm_add_ps(_mm_load_ps(a->z + i), _mm_mul_ps(_mm_load_ps(b->z + i), scale)));
+    }
+}
+
+// out[i] = length of a[i]
+void v3ArrayLength(f32 *out, const v3Array *a)
+{
+    i32 i = 0;
+    for (; i + 4 <= a->count; i += 4) {
+        __m128 x = _mm_load_ps(a->x + i);
+        __m128 y = _mm_load_ps(a->y + i);
+        __m128 z = _mm_load_ps(a->z + i);
+        _mm_storeu_ps(out + i, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z))));
+    }
+    for (; i < a->count; i++)
+        out[i] = squareRoot(a->x[i] * a->x[i] + a->y[i] * a->y[i] + a->z[i] * a->z[i]);
+}
+
+// out[i] = distance from a[i] to point
+void v3ArrayDistance(f32 *out, const v3Array *a, v3 point)
+{
+    __m128 px = _mm_set1_ps(point.x);
+    __m128 py = _mm_set1_ps(point.y);
+    __m128 pz = _mm_set1_ps(point.z);
+    i32 i = 0;
+    for (; i + 4 <= a->count; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_load_ps(a->x + i), px);
+        __m128 dy = _mm_sub_ps(_mm_load_ps(a->y + i), py);
+        __m128 dz = _mm_sub_ps(_mm_load_ps(a->z + i), pz);
+        _mm_storeu_ps(out + i, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz))));
+    }
+    for (; i < a->count; i++) {
+        v3 d = v3(a->x[i] - point.x, a->y[i] - point.y, a->z[i] - point.z);
+        out[i] = squareRoot(d.x * d.x + d.y * d.y + d.z * d.z);
+    }
+}
+
+// normalizes every vector, vectors with length 0 are left as they are
+void v3ArrayNormalize(v3Array *out, const v3Array *a)
+{
+    Assert(out->count >= a->count);
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.f);
+    i32 count = vectorArrayGroups(a->count) * 4;
+    for (i32 i = 0; i < count; i += 4) {
+        __m128 x = _mm_load_ps(a->x + i);
+        __m128 y = _mm_load_ps(a->y + i);
+        __m128 z = _mm_load_ps(a->z + i);
+        __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        __m128 nonZero = _mm_cmpgt_ps(lengthSquared, zero);
+        __m128 scale = inverseSquareRoot4(lengthSquared);
+        scale = _mm_or_ps(_mm_and_ps(nonZero, scale), _mm_andnot_ps(nonZero, one));
+        _mm_store_ps(out->x + i, _mm_mul_ps(x, scale));
+        _mm_store_ps(out->y + i, _mm_mul_ps(y, scale));
+        _mm_store_ps(out->z + i, _mm_mul_ps(z, scale));
+    }
+}
+
+// limits the length of every vector to max
+void v3ArrayLimit(v3Array *out, const v3Array *a, f32 max)
+{
+    Assert(out->count >= a->count);
+    __m128 maxLength = _mm_set1_ps(max);
+    __m128 maxSquared = _mm_set1_ps(max * max);
+    __m128 one = _mm_set1_ps(1.f);
+    i32 count = vectorArrayGroups(a->count) * 4;
+    for (i32 i = 0; i < count; i += 4) {
+        __m128 x = _mm_load_ps(a->x + i);
+        __m128 y = _mm_load_ps(a->y + i);
+        __m128 z = _mm_load_ps(a->z + i);
+        __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        __m128 tooLong = _mm_cmpgt_ps(lengthSquared, maxSquared);
+        __m128 scale = _mm_mul_ps(maxLength, inverseSquareRoot4(lengthSquared));
+        scale = _mm_or_ps(_mm_and_ps(tooLong, scale), _mm_andnot_ps(tooLong, one));
+        _mm_store_ps(out->x + i, _mm_mul_ps(x, scale));
+        _mm_store_ps(out->y + i, _mm_mul_ps(y, scale));
+        _mm_store_ps(out->z + i, _mm_mul_ps(z, scale));
+    }
+}
+
+typedef union
+{
+    //struct {
+    //v2 min, max;
+    //};
+    
+    struct {
+        f32 x, y, w, h;
+    };
+} Rect;
+
+
+//
+// Matrices
+//
+
+// 16-byte aligned so the rows can be loaded straight into SSE registers
+struct __declspec(align(16)) m4 {
+	f32 e[4][4] = { 0 };
+};
+
+constexpr m4 m4LoadIdentity()
+{
+    m4 m =
+    {
+        1.0f, 0.0f, 0.0f, 0.0f,
+        0.f,  1.0f, 0.0f, 0.0f,
+        0.f,  0.f,  1.0f, 0.0f,
+        0.f,  0.f,  0.f,  1.0f
+    };
+    return m;
+#if 0
+    m4 identity = {
+        {
+            {1, 0, 0, 0},
+            {0, 1, 0, 0},
+            {0, 0, 1, 0},
+            {0, 0, 0, 1},
+        }
+    };
+#endif
+}
+
+m4 vecToMatrix(v4 v)
+{
+    m4 m = {0};;
+    m.e[0][0] = v.x;
+    m.e[1][0] = v.y;
+    m.e[2][0] = v.z;
+    m.e[3][0] = v.w;
+    return m;
+}
+
+
+m4 vecToMatrix(v3 v)
+{
+    m4 m = {0};;
+    m.e[0][0] = v.x;
+    m.e[1][0] = v.y;
+    m.e[2][0] = v.z;
+    m.e[3][0] = 0;
+    return m;
+}
+
+
+v4 matrixToVec(m4 m)
+{
+    v4 result;
+    result.x = m.e[0][0];
+    result.y = m.e[1][0];
+    result.z = m.e[2][0];
+    result.w = m.e[3][0];
+    return result;
+}
+
+// the scalar versions are kept as the reference for the SIMD kernels below, they are constexpr so
+// transform presets can be built at compile time together with m4Translation(), m4Scaling() and friends
+constexpr m4 m4MultiplyScalar(m4 m1, m4 m2)
+{
+	m4 result;
+    
+	result.e[0][0] = m2.e[0][0] * m1.e[0][0] + m2.e[1][0] * m1.e[0][1] + m2.e[2][0] * m1.e[0][2] + m2.e[3][0] * m1.e[0][3];
+	result.e[1][0] = m2.e[0][0] * m1.e[1][0] + m2.e[1][0] * m1.e[1][1] + m2.e[2][0] * m1.e[1][2] + m2.e[3][0] * m1.e[1][3];
+	result.e[2][0] = m2.e[0][0] * m1.e[2][0] + m2.e[1][0] * m1.e[2][1] + m2.e[2][0] * m1.e[2][2] + m2.e[3][0] * m1.e[2][3];
+	result.e[3][0] = m2.e[0][0] * m1.e[3][0] + m2.e[1][0] * m1.e[3][1] + m2.e[2][0] * m1.e[3][2] + m2.e[3][0] * m1.e[3][3];
+    
+    result.e[0][1] = m2.e[0][1] * m1.e[0][0] + m2.e[1][1] * m1.e[0][1] + m2.e[2][1] * m1.e[0][2] + m2.e[3][1] * m1.e[0][3];
+	result.e[1][1] = m2.e[0][1] * m1.e[1][0] + m2.e[1][1] * m1.e[1][1] + m2.e[2][1] * m1.e[1][2] + m2.e[3][1] * m1.e[1][3];
+	result.e[2][1] = m2.e[0][1] * m1.e[2][0] + m2.e[1][1] * m1.e[2][1] + m2.e[2][1] * m1.e[2][2] + m2.e[3][1] * m1.e[2][3];
+	result.e[3][1] = m2.e[0][1] * m1.e[3][0] + m2.e[1][1] * m1.e[3][1] + m2.e[2][1] * m1.e[3][2] + m2.e[3][1] * m1.e[3][3];
+    
+    result.e[0][2] = m2.e[0][2] * m1.e[0][0] + m2.e[1][2] * m1.e[0][1] + m2.e[2][2] * m1.e[0][2] + m2.e[3][2] * m1.e[0][3];
+	result.e[1][2] = m2.e[0][2] * m1.e[1][0] + m2.e[1][2] * m1.e[1][1] + m2.e[2][2] * m1.e[1][2] + m2.e[3][2] * m1.e[1][3];
+	result.e[2][2] = m2.e[0][2] * m1.e[2][0] + m2.e[1][2] * m1.e[2][1] + m2.e[2][2] * m1.e[2][2] + m2.e[3][2] * m1.e[2][3];
+	result.e[3][2] = m2.e[0][2] * m1.e[3][0] + m2.e[1][2] * m1.e[3][1] + m2.e[2][2] * m1.e[3][2] + m2.e[3][2] * m1.e[3][3];
+    
+    result.e[0][3] = m2.e[0][3] * m1.e[0][0] + m2.e[1][3] * m1.e[0][1] + m2.e[2][3] * m1.e[0][2] + m2.e[3][3] * m1.e[0][3];
+	result.e[1][3] = m2.e[0][3] * m1.e[1][0] + m2.e[1][3] * m1.e[1][1] + m2.e[2][3] * m1.e[1][2] + m2.e[3][3] * m1.e[1][3];
+	result.e[2][3] = m2.e[0][3] * m1.e[2][0] + m2.e[1][3] * m1.e[2][1] + m2.e[2][3] * m1.e[2][2] + m2.e[3][3] * m1.e[2][3];
+	result.e[3][3] = m2.e[0][3] * m1.e[3][0] + m2.e[1][3] * m1.e[3][1] + m2.e[2][3] * m1.e[3][2] + m2.e[3][3] * m1.e[3][3];
+    
+    
+	return result;
+}
+
+v4 m4MultiplyV4Scalar(m4 m, v4 v)
+{
+    v4 result = {0};
+    
+    result.x = v.e[0]*m.e[0][0] + v.e[1]*m.e[0][1] + v.e[2]*m.e[0][2] + v.e[3]*m.e[0][3];
+    result.y = v.e[0]*m.e[1][0] + v.e[1]*m.e[1][1] + v.e[2]*m.e[1][2] + v.e[3]*m.e[1][3];
+    result.z = v.e[0]*m.e[2][0] + v.e[1]*m.e[2][1] + v.e[2]*m.e[2][2] + v.e[3]*m.e[2][3];
+    result.w = v.e[0]*m.e[3][0] + v.e[1]*m.e[3][1] + v.e[2]*m.e[3][2] + v.e[3]*m.e[3][3];
+    
+    return result;
+}
+
+constexpr m4 m4TransposeScalar(m4 m)
+{
+    m4 result;
+    for (i32 row = 0; row < 4; row++) {
+        for (i32 col = 0; col < 4; col++)
+            result.e[row][col] = m.e[col][row];
+    }
+    return result;
+}
+
+// inverse by cofactor expansion, returns false and leaves out untouched if the matrix can't be inverted
+b32 m4InverseScalar(const m4 *m, m4 *out)
+{
+    const f32 *a = &m->e[0][0];
+    f32 inv[16];
+
+    inv[0] = a[5] * a[10] * a[15] - a[5] * a[11] * a[14] - a[9] * a[6] * a[15] + a[9] * a[7] * a[14] + a[13] * a[6] * a[11] - a[13] * a[7] * a[10];
+    inv[4] = -a[4] * a[10] * a[15] + a[4] * a[11] * a[14] + a[8] * a[6] * a[15] - a[8] * a[7] * a[14] - a[12] * a[6] * a[11] + a[12] * a[7] * a[10];
+    inv[8] = a[4] * a[9] * a[15] - a[4] * a[11] * a[13] - a[8] * a[5] * a[15] + a[8] * a[7] * a[13] + a[12] * a[5] * a[11] - a[12] * a[7] * a[9];
+    inv[12] = -a[4] * a[9] * a[14] + a[4] * a[10] * a[13] + a[8] * a[5] * a[14] - a[8] * a[6] * a[13] - a[12] * a[5] * a[10] + a[12] * a[6] * a[9];
+    inv[1] = -a[1] * a[10] * a[15] + a[1] * a[11] * a[14] + a[9] * a[2] * a[15] - a[9] * a[3] * a[14] - a[13] * a[2] * a[11] + a[13] * a[3] * a[10];
+    inv[5] = a[0] * a[10] * a[15] - a[0] * a[11] * a[14] - a[8] * a[2] * a[15] + a[8] * a[3] * a[14] + a[12] * a[2] * a[11] - a[12] * a[3] * a[10];
+    inv[9] = -a[0] * a[9] * a[15] + a[0] * a[11] * a[13] + a[8] * a[1] * a[15] - a[8] * a[3] * a[13] - a[12] * a[1] * a[11] + a[12] * a[3] * a[9];
+    inv[13] = a[0] * a[9] * a[14] - a[0] * a[10] * a[13] - a[8] * a[1] * a[14] + a[8] * a[2] * a[13] + a[12] * a[1] * a[10] - a[12] * a[2] * a[9];
+    inv[2] = a[1] * a[6] * a[15] - a[1] * a[7] * a[14] - a[5] * a[2] * a[15] + a[5] * a[3] * a[14] + a[13] * a[2] * a[7] - a[13] * a[3] * a[6];
+    inv[6] = -a[0] * a[6] * a[15] + a[0] * a[7] * a[14] + a[4] * a[2] * a[15] - a[4] * a[3] * a[14] - a[12] * a[2] * a[7] + a[12] * a[3] * a[6];
+    inv[10] = a[0] * a[5] * a[15] - a[0] * a[7] * a[13] - a[4] * a[1] * a[15] + a[4] * a[3] * a[13] + a[12] * a[1] * a[7] - a[12] * a[3] * a[5];
+    inv[14] = -a[0] * a[5] * a[14] + a[0] * a[6] * a[13] + a[4] * a[1] * a[14] - a[4] * a[2] * a[13] - a[12] * a[1] * a[6] + a[12] * a[2] * a[5];
+    inv[3] = -a[1] * a[6] * a[11] + a[1] * a[7] * a[10] + a[5] * a[2] * a[11] - a[5] * a[3] * a[10] - a[9] * a[2] * a[7] + a[9] * a[3] * a[6];
+    inv[7] = a[0] * a[6] * a[11] - a[0] * a[7] * a[10] - a[4] * a[2] * a[11] + a[4] * a[3] * a[10] + a[8] * a[2] * a[7] - a[8] * a[3] * a[6];
+    inv[11] = -a[0] * a[5] * a[11] + a[0] * a[7] * a[9] + a[4] * a[1] * a[11] - a[4] * a[3] * a[9] - a[8] * a[1] * a[7] + a[8] * a[3] * a[5];
+    inv[15] = a[0] * a[5] * a[10] - a[0] * a[6] * a[9] - a[4] * a[1] * a[10] + a[4] * a[2] * a[9] + a[8] * a[1] * a[6] - a[8] * a[2] * a[5];
+
+    f32 det = a[0] * inv[0] + a[1] * inv[4] + a[2] * inv[8] + a[3] * inv[12];
+    if (det == 0.f)
+        return false;
+
+    det = 1.f / det;
+    f32 *r = &out->e[0][0];
+    for (i32 i = 0; i < 16; i++)
+        r[i] = inv[i] * det;
+    return true;
+}
+
+// SIMD matrix kernels. SSE2 is always there on x64, the AVX and FMA versions are picked at startup when
+// the CPU and OS support them. the loads are unaligned so the kernels also work on vectors packed into
+// other structs. without FMA they do the same operations in the same order as the scalar versions, FMA rounds
+// once per multiply-add. -fp:fast lets the compiler reassociate any of them, so the paths are only held to the
+// error bound given at M4Kernels, not to equal bits.
+
+// out = a * b, out can be the same matrix as a or b
+internal void
+m4MultiplySSE(const m4 *a, const m4 *b, m4 *out)
+{
+    __m128 b0 = _mm_loadu_ps(b->e[0]);
+    __m128 b1 = _mm_loadu_ps(b->e[1]);
+    __m128 b2 = _mm_loadu_ps(b->e[2]);
+    __m128 b3 = _mm_loadu_ps(b->e[3]);
+
+    // every row of the result is the rows of b weighted by the same row of a
+    for (i32 i = 0; i < 4; i++) {
+        __m128 row = _mm_mul_ps(_mm_set1_ps(a->e[i][0]), b0);
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a->e[i][1]), b1));
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a->e[i][2]), b2));
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a->e[i][3]), b3));
+        _mm_storeu_ps(out->e[i], row);
+    }
+}
+
+// two rows at a time, the rows of b are repeated in both halves of the 256-bit registers
+internal void
+m4MultiplyAVX(const m4 *a, const m4 *b, m4 *out)
+{
+    __m256 b0 = _mm256_broadcast_ps((const __m128 *)b->e[0]);
+    __m256 b1 = _mm256_broadcast_ps((const __m128 *)b->e[1]);
+    __m256 b2 = _mm256_broadcast_ps((const __m128 *)b->e[2]);
+    __m256 b3 = _mm256_broadcast_ps((const __m128 *)b->e[3]);
+
+    for (i32 i = 0; i < 4; i += 2) {
+        __m256 rows = _mm256_loadu_ps(a->e[i]);
+        __m256 result = _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0x00), b0);
+        result = _mm256_fmadd_ps(_mm256_shuffle_ps(rows, rows, 0x55), b1, result);
+        result = _mm256_fmadd_ps(_mm256_shuffle_ps(rows, rows, 0xaa), b2, result);
+        result = _mm256_fmadd_ps(_mm256_shuffle_ps(rows, rows, 0xff), b3, result);
+        _mm256_storeu_ps(out->e[i], result);
+    }
+}
+
+// out[i] = m * in[i], in and out can be the same array
+internal void
+m4TransformSSE(const m4 *m, const v4 *in, v4 *out, i32 count)
+{
+    // the columns of m, so every vector is a weighted sum of them
+    __m128 c0 = _mm_loadu_ps(m->e[0]);
+    __m128 c1 = _mm_loadu_ps(m->e[1]);
+    __m128 c2 = _mm_loadu_ps(m->e[2]);
+    __m128 c3 = _mm_loadu_ps(m->e[3]);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+    for (i32 i = 0; i < count; i++) {
+        __m128 v = _mm_loadu_ps(in[i].e);
+        __m128 result = _mm_mul_ps(_mm_shuffle_ps(v, v, 0x00), c0);
+        result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(v, v, 0x55), c1));
+        result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(v, v, 0xaa), c2));
+        result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(v, v, 0xff), c3));
+        _mm_storeu_ps(out[i].e, result);
+    }
+}
+
+// two vectors at a time
+internal void
+m4TransformAVX(const m4 *m, const v4 *in, v4 *out, i32 count)
+{
+    __m128 c0 = _mm_loadu_ps(m->e[0]);
+    __m128 c1 = _mm_loadu_ps(m->e[1]);
+    __m128 c2 = _mm_loadu_ps(m->e[2]);
+    __m128 c3 = _mm_loadu_ps(m->e[3]);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    __m256 cc0 = _mm256_set_m128(c0, c0);
+    __m256 cc1 = _mm256_set_m128(c1, c1);
+    __m256 cc2 = _mm256_set_m128(c2, c2);
+    __m256 cc3 = _mm256_set_m128(c3, c3);
+
+    i32 i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m256 v = _mm256_loadu_ps(in[i].e);
+        __m256 result = _mm256_mul_ps(_mm256_shuffle_ps(v, v, 0x00), cc0);
+        result = _mm256_fmadd_ps(_mm256_shuffle_ps(v, v, 0x55), cc1, result);
+        result = _mm256_fmadd_ps(_mm256_shuffle_ps(v, v, 0xaa), cc2, result);
+        result = _mm256_fmadd_ps(_mm256_shuffle_ps(v, v, 0xff), cc3, result);
+        _mm256_storeu_ps(out[i].e, result);
+    }
+    if (i < count)
+        m4TransformSSE(m, in + i, out + i, count - i);
+}
+
+// point clouds: the points are transposed to x, y and z registers so every lane is one point and
+// the matrix elements are broadcast. unlike m4TransformArray() the input is v3 with an implied w of 1
+
+// 4 points from in into x, y and z
+inline void loadPoints4(const v3 *in, __m128 *x, __m128 *y, __m128 *z)
+{
+    const f32 *f = &in->x;
+    __m128 m0 = _mm_loadu_ps(f);        // x0 y0 z0 x1
+    __m128 m1 = _mm_loadu_ps(f + 4);    // y1 z1 x2 y2
+    __m128 m2 = _mm_loadu_ps(f + 8);    // z2 x3 y3 z3
+    __m128 xy = _mm_shuffle_ps(m1, m2, _MM_SHUFFLE(2, 1, 3, 2));
+    __m128 yz = _mm_shuffle_ps(m0, m1, _MM_SHUFFLE(1, 0, 2, 1));
+    *x = _mm_shuffle_ps(m0, xy, _MM_SHUFFLE(2, 0, 3, 0));
+    *y = _mm_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+    *z = _mm_shuffle_ps(yz, m2, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+// 8 points, the same shuffles on points 0-3 in the low half and 4-7 in the high half
+inline void loadPoints8(const v3 *in, __m256 *x, __m256 *y, __m256 *z)
+{
+    const f32 *f = &in->x;
+    __m256 m0 = _mm256_set_m128(_mm_loadu_ps(f + 12), _mm_loadu_ps(f));
+    __m256 m1 = _mm256_set_m128(_mm_loadu_ps(f + 16), _mm_loadu_ps(f + 4));
+    __m256 m2 = _mm256_set_m128(_mm_loadu_ps(f + 20), _mm_loadu_ps(f + 8));
+    __m256 xy = _mm256_shuffle_ps(m1, m2, _MM_SHUFFLE(2, 1, 3, 2));
+    __m256 yz = _mm256_shuffle_ps(m0, m1, _MM_SHUFFLE(1, 0, 2, 1));
+    *x = _mm256_shuffle_ps(m0, xy, _MM_SHUFFLE(2, 0, 3, 0));
+    *y = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+    *z = _mm256_shuffle_ps(yz, m2, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+// clip coordinates of 4 points, c is the matrix with every element broadcast
+inline void clipPoints4(const __m128 *c, const v3 *in, __m128 *clip)
+{
+    __m128 x, y, z;
+    loadPoints4(in, &x, &y, &z);
+    for (i32 row = 0; row < 4; row++) {
+        __m128 r = _mm_add_ps(_mm_mul_ps(x, c[row * 4 + 0]), _mm_mul_ps(y, c[row * 4 + 1]));
+        r = _mm_add_ps(r, _mm_mul_ps(z, c[row * 4 + 2]));
+        clip[row] = _mm_add_ps(r, c[row * 4 + 3]);
+    }
+}
+
+inline void clipPoints8(const __m256 *c, const v3 *in, __m256 *clip)
+{
+    __m256 x, y, z;
+    loadPoints8(in, &x, &y, &z);
+    for (i32 row = 0; row < 4; row++) {
+        __m256 r = _mm256_fmadd_ps(x, c[row * 4 + 0], c[row * 4 + 3]);
+        r = _mm256_fmadd_ps(y, c[row * 4 + 1], r);
+        clip[row] = _mm256_fmadd_ps(z, c[row * 4 + 2], r);
+    }
+}
+
+inline void transformPoints4(const __m128 *c, const v3 *in, v4 *out)
+{
+    __m128 clip[4];
+    clipPoints4(c, in, clip);
+    _MM_TRANSPOSE4_PS(clip[0], clip[1], clip[2], clip[3]);
+    for (i32 i = 0; i < 4; i++)
+        _mm_storeu_ps(out[i].e, clip[i]);
+}
+
+inline void transformPoints8(const __m256 *c, const v3 *in, v4 *out)
+{
+    __m256 clip[4];
+    clipPoints8(c, in, clip);
+    __m256 t0 = _mm256_unpacklo_ps(clip[0], clip[1]);
+    __m256 t1 = _mm256_unpackhi_ps(clip[0], clip[1]);
+    __m256 t2 = _mm256_unpacklo_ps(clip[2], clip[3]);
+    __m256 t3 = _mm256_unpackhi_ps(clip[2], clip[3]);
+    __m256 r[4] = {
+        _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)),
+        _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)),
+        _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)),
+        _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2))
+    };
+    for (i32 i = 0; i < 4; i++) {
+        _mm_storeu_ps(out[i].e, _mm256_castps256_ps128(r[i]));
+        _mm_storeu_ps(out[i + 4].e, _mm256_extractf128_ps(r[i], 1));
+    }
+}
+
+// screen positions of 4 points, returns a bit for every point inside the clip volume
+inline i32 projectPoints4(const __m128 *c, const v3 *in, v2 *out, __m128 halfWidth, __m128 halfHeight)
+{
+    __m128 clip[4];
+    clipPoints4(c, in, clip);
+    __m128 w = clip[3];
+    __m128 rw = _mm_div_ps(_mm_set1_ps(1.f), w);
+    __m128 sx = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(clip[0], rw), halfWidth), halfWidth);
+    __m128 sy = _mm_sub_ps(halfHeight, _mm_mul_ps(_mm_mul_ps(clip[1], rw), halfHeight));
+    _mm_storeu_ps(&out[0].x, _mm_unpacklo_ps(sx, sy));
+    _mm_storeu_ps(&out[2].x, _mm_unpackhi_ps(sx, sy));
+
+    // in front of the camera and -w <= x, y, z <= w
+    __m128 signMask = _mm_set1_ps(-0.f);
+    __m128 inside = _mm_cmpgt_ps(w, _mm_setzero_ps());
+    inside = _mm_and_ps(inside, _mm_cmple_ps(_mm_andnot_ps(signMask, clip[0]), w));
+    inside = _mm_and_ps(inside, _mm_cmple_ps(_mm_andnot_ps(signMask, clip[1]), w));
+    inside = _mm_and_ps(inside, _mm_cmple_ps(_mm_andnot_ps(signMask, clip[2]), w));
+    return _mm_movemask_ps(inside);
+}
+
+inline i32 projectPoints8(const __m256 *c, const v3 *in, v2 *out, __m256 halfWidth, __m256 halfHeight)
+{
+    __m256 clip[4];
+    clipPoints8(c, in, clip);
+    __m256 w = clip[3];
+    __m256 rw = _mm256_div_ps(_mm256_set1_ps(1.f), w);
+    __m256 sx = _mm256_fmadd_ps(_mm256_mul_ps(clip[0], rw), halfWidth, halfWidth);
+    __m256 sy = _mm256_fnmadd_ps(_mm256_mul_ps(clip[1], rw), halfHeight, halfHeight);
+    __m256 lo = _mm256_unpacklo_ps(sx, sy);
+    __m256 hi = _mm256_unpackhi_ps(sx, sy);
+    _mm256_storeu_ps(&out[0].x, _mm256_permute2f128_ps(lo, hi, 0x20));
+    _mm256_storeu_ps(&out[4].x, _mm256_permute2f128_ps(lo, hi, 0x31));
+
+    __m256 signMask = _mm256_set1_ps(-0.f);
+    __m256 inside = _mm256_cmp_ps(w, _mm256_setzero_ps(), _CMP_GT_OQ);
+    inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_andnot_ps(signMask, clip[0]), w, _CMP_LE_OQ));
+    inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_andnot_ps(signMask, clip[1]), w, _CMP_LE_OQ));
+    inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_andnot_ps(signMask, clip[2]), w, _CMP_LE_OQ));
+    return _mm256_movemask_ps(inside);
+}
+
+internal void
+m4TransformPointsSSE(const m4 *m, const v3 *in, v4 *out, i32 count)
+{
+    __m128 c[16];
+    for (i32 i = 0; i < 16; i++)
+        c[i] = _mm_set1_ps(m->e[i / 4][i % 4]);
+
+    i32 i = 0;
+    for (; i + 4 <= count; i += 4)
+        transformPoints4(c, in + i, out + i);
+
+    // the last points through a padded block, reading past the end of in isn't safe
+    if (i < count) {
+        v3 tailIn[4] = {};
+        v4 tailOut[4];
+        memcpy(tailIn, in + i, (count - i) * sizeof(v3));
+        transformPoints4(c, tailIn, tailOut);
+        memcpy(out + i, tailOut, (count - i) * sizeof(v4));
+    }
+}
+
+internal void
+m4TransformPointsAVX(const m4 *m, const v3 *in, v4 *out, i32 count)
+{
+    __m256 c[16];
+    for (i32 i = 0; i < 16; i++)
+        c[i] = _mm256_set1_ps(m->e[i / 4][i % 4]);
+
+    i32 i = 0;
+    for (; i + 8 <= count; i += 8)
+        transformPoints8(c, in + i, out + i);
+
+    if (i < count) {
+        v3 tailIn[8] = {};
+        v4 tailOut[8];
+        memcpy(tailIn, in + i, (count - i) * sizeof(v3));
+        transformPoints8(c, tailIn, tailOut);
+        memcpy(out + i, tailOut, (count - i) * sizeof(v4));
+    }
+}
+
+// number of set bits
+inline i32 bitCount(u32 value)
+{
+    value = value - ((value >> 1) & 0x55555555);
+    value = (value & 0x33333333) + ((value >> 2) & 0x33333333);
+    return (i32)((((value + (value >> 4)) & 0x0f0f0f0f) * 0x01010101) >> 24);
+}
+
+// visible has one bit per point, the words are cleared first
+internal i32
+m4ProjectPointsSSE(const m4 *m, const v3 *in, v2 *out, u32 *visible, i32 count, f32 width, f32 height)
+{
+    __m128 c[16];
+    for (i32 i = 0; i < 16; i++)
+        c[i] = _mm_set1_ps(m->e[i / 4][i % 4]);
+    __m128 halfWidth = _mm_set1_ps(width * 0.5f);
+    __m128 halfHeight = _mm_set1_ps(height * 0.5f);
+    i32 words = (count + 31) / 32;
+    memset(visible, 0, words * sizeof(u32));
+
+    i32 i = 0;
+    for (; i + 4 <= count; i += 4)
+        visible[i >> 5] |= (u32)projectPoints4(c, in + i, out + i, halfWidth, halfHeight) << (i & 31);
+
+    if (i < count) {
+        v3 tailIn[4] = {};
+        v2 tailOut[4];
+        memcpy(tailIn, in + i, (count - i) * sizeof(v3));
+        u32 bits = (u32)projectPoints4(c, tailIn, tailOut, halfWidth, halfHeight) & ((1u << (count - i)) - 1);
+        memcpy(out + i, tailOut, (count - i) * sizeof(v2));
+        visible[i >> 5] |= bits << (i & 31);
+    }
+
+    i32 result = 0;
+    for (i32 w = 0; w < words; w++)
+        result += bitCount(visible[w]);
+    return result;
+}
+
+internal i32
+m4ProjectPointsAVX(const m4 *m, const v3 *in, v2 *out, u32 *visible, i32 count, f32 width, f32 height)
+{
+    __m256 c[16];
+    for (i32 i = 0; i < 16; i++)
+        c[i] = _mm256_set1_ps(m->e[i / 4][i % 4]);
+    __m256 halfWidth = _mm256_set1_ps(width * 0.5f);
+    __m256 halfHeight = _mm256_set1_ps(height * 0.5f);
+    i32 words = (count + 31) / 32;
+    memset(visible, 0, words * sizeof(u32));
+
+    i32 i = 0;
+    for (; i + 8 <= count; i += 8)
+        visible[i >> 5] |= (u32)projectPoints8(c, in + i, out + i, halfWidth, halfHeight) << (i & 31);
+
+    if (i < count) {
+        v3 tailIn[8] = {};
+        v2 tailOut[8];
+        memcpy(tailIn, in + i, (count - i) * sizeof(v3));
+        u32 bits = (u32)projectPoints8(c, tailIn, tailOut, halfWidth, halfHeight) & ((1u << (count - i)) - 1);
+        memcpy(out + i, tailOut, (count - i) * sizeof(v2));
+        visible[i >> 5] |= bits << (i & 31);
+    }
+
+    i32 result = 0;
+    for (i32 w = 0; w < words; w++)
+        result += bitCount(visible[w]);
+    return result;
+}
+
+internal void
+m4TransposeSSE(const m4 *m, m4 *out)
+{
+    __m128 r0 = _mm_loadu_ps(m->e[0]);
+    __m128 r1 = _mm_loadu_ps(m->e[1]);
+    __m128 r2 = _mm_loadu_ps(m->e[2]);
+    __m128 r3 = _mm_loadu_ps(m->e[3]);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_storeu_ps(out->e[0], r0);
+    _mm_storeu_ps(out->e[1], r1);
+    _mm_storeu_ps(out->e[2], r2);
+    _mm_storeu_ps(out->e[3], r3);
+}
+
+// 2x2 matrices stored as (m00, m01, m10, m11) in one register
+#define m4Swizzle(v, x, y, z, w) _mm_shuffle_ps(v, v, _MM_SHUFFLE(w, z, y, x))
+
+// a * b
+inline __m128 m2Multiply(__m128 a, __m128 b)
+{
+    return _mm_add_ps(_mm_mul_ps(a, m4Swizzle(b, 0, 3, 0, 3)), _mm_mul_ps(m4Swizzle(a, 1, 0, 3, 2), m4Swizzle(b, 2, 1, 2, 1)));
+}
+
+// adjugate(a) * b
+inline __m128 m2AdjugateMultiply(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(m4Swizzle(a, 3, 3, 0, 0), b), _mm_mul_ps(m4Swizzle(a, 1, 1, 2, 2), m4Swizzle(b, 2, 3, 0, 1)));
+}
+
+// a * adjugate(b)
+inline __m128 m2MultiplyAdjugate(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(a, m4Swizzle(b, 3, 0, 3, 0)), _mm_mul_ps(m4Swizzle(a, 1, 0, 3, 2), m4Swizzle(b, 2, 1, 2, 1)));
+}
+
+// inverse with the 2x2 block method, returns false and leaves out untouched if the matrix can't be inverted
+internal b32
+m4InverseSSE(const m4 *m, m4 *out)
+{
+    __m128 r0 = _mm_loadu_ps(m->e[0]);
+    __m128 r1 = _mm_loadu_ps(m->e[1]);
+    __m128 r2 = _mm_loadu_ps(m->e[2]);
+    __m128 r3 = _mm_loadu_ps(m->e[3]);
+
+    // the four 2x2 blocks | A B |
+    //                     | C D |
+    __m128 a = _mm_movelh_ps(r0, r1);
+    __m128 b = _mm_movehl_ps(r1, r0);
+    __m128 c = _mm_movelh_ps(r2, r3);
+    __m128 d = _mm_movehl_ps(r3, r2);
+
+    // determinants of the blocks as (|A|, |B|, |C|, |D|)
+    __m128 detBlocks = _mm_sub_ps(
+        _mm_mul_ps(_mm_shuffle_ps(r0, r2, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(3, 1, 3, 1))),
+        _mm_mul_ps(_mm_shuffle_ps(r0, r2, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(2, 0, 2, 0))));
+    __m128 detA = m4Swizzle(detBlocks, 0, 0, 0, 0);
+    __m128 detB = m4Swizzle(detBlocks, 1, 1, 1, 1);
+    __m128 detC = m4Swizzle(detBlocks, 2, 2, 2, 2);
+    __m128 detD = m4Swizzle(detBlocks, 3, 3, 3, 3);
+
+    __m128 dc = m2AdjugateMultiply(d, c);
+    __m128 ab = m2AdjugateMultiply(a, b);
+    __m128 x = _mm_sub_ps(_mm_mul_ps(detD, a), m2Multiply(b, dc));
+    __m128 w = _mm_sub_ps(_mm_mul_ps(detA, d), m2Multiply(c, ab));
+    __m128 y = _mm_sub_ps(_mm_mul_ps(detB, c), m2MultiplyAdjugate(d, ab));
+    __m128 z = _mm_sub_ps(_mm_mul_ps(detC, b), m2MultiplyAdjugate(a, dc));
+
+    // |M| = |A||D| + |B||C| - trace(adj(A)B adj(D)C)
+    __m128 trace = _mm_mul_ps(ab, m4Swizzle(dc, 0, 2, 1, 3));
+    trace = _mm_add_ps(trace, m4Swizzle(trace, 1, 0, 3, 2));
+    trace = _mm_add_ps(trace, m4Swizzle(trace, 2, 3, 0, 1));
+    __m128 det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), trace);
+    if (_mm_cvtss_f32(det) == 0.f)
+        return false;
+
+    __m128 invDet = _mm_div_ps(_mm_setr_ps(1.f, -1.f, -1.f, 1.f), det);
+    x = _mm_mul_ps(x, invDet);
+    y = _mm_mul_ps(y, invDet);
+    z = _mm_mul_ps(z, invDet);
+    w = _mm_mul_ps(w, invDet);
+
+    // the adjugate shuffle of every block is combined with the store
+    _mm_storeu_ps(out->e[0], _mm_shuffle_ps(x, y, _MM_SHUFFLE(1, 3, 1, 3)));
+    _mm_storeu_ps(out->e[1], _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 2, 0, 2)));
+    _mm_storeu_ps(out->e[2], _mm_shuffle_ps(z, w, _MM_SHUFFLE(1, 3, 1, 3)));
+    _mm_storeu_ps(out->e[3], _mm_shuffle_ps(z, w, _MM_SHUFFLE(0, 2, 0, 2)));
+    return true;
+}
+
+// the matrix kernels used by m4Multiply(), m4TransformArray(), transformPoints(), projectPoints() and the matrix stack.
+// every path, scalar, SSE and AVX/FMA, keeps an element of a product within 4 * 2^-24 * sum |a[i][k] * b[k][j]|
+// of the exact result, the usual bound for a dot product of 4 terms. m4Inverse() keeps m * inverse within 1e-6
+// of the identity for rotation, scale and translation matrices with scales from 1 to 3. the benchmark
+// example shows the max error of every path against double precision
+struct M4Kernels
+{
+    void (*multiply)(const m4 *a, const m4 *b, m4 *out);
+    void (*transform)(const m4 *m, const v4 *in, v4 *out, i32 count);
+    void (*transformPoints)(const m4 *m, const v3 *in, v4 *out, i32 count);
+    i32 (*projectPoints)(const m4 *m, const v3 *in, v2 *out, u32 *visible, i32 count, f32 width, f32 height);
+};
+
+internal M4Kernels
+selectM4Kernels()
+{
+    M4Kernels result = { m4MultiplySSE, m4TransformSSE, m4TransformPointsSSE, m4ProjectPointsSSE };
+    if (cpuFeatures.avx && cpuFeatures.fma) {
+        result.multiply = m4MultiplyAVX;
+        result.transform = m4TransformAVX;
+        result.transformPoints = m4TransformPointsAVX;
+        result.projectPoints = m4ProjectPointsAVX;
+    }
+    return result;
+}
+
+global M4Kernels m4Kernels = selectM4Kernels();
+
+// b multiplys with a, my stuff
+m4 m4Multiply(m4 m1, m4 m2)
+{
+    m4 result;
+    m4Kernels.multiply(&m1, &m2, &result);
+    return result;
+}
+
+v4 m4MultiplyV4(m4 m, v4 v)
+{
+    v4 result;
+    m4TransformSSE(&m, &v, &result, 1);
+    return result;
+}
+
+// the translation is ignored
+v3 m4MultiplyV3(m4 m, v3 v)
+{
+    v4 in = v4(v.x, v.y, v.z, 0.f);
+    v4 out;
+    m4TransformSSE(&m, &in, &out, 1);
+    v3 result = { out.x, out.y, out.z };
+    return result;
+}
+
+// transforms count vectors with m
+void m4TransformArray(const m4 *m, const v4 *in, v4 *out, i32 count)
+{
+    m4Kernels.transform(m, in, out, count);
+}
+
+// out[i] = m * (in[i], 1), the clip coordinates when m is a projection times a modelview matrix
+void transformPoints(const m4 *m, const v3 *in, v4 *out, i32 count)
+{
+    m4Kernels.transformPoints(m, in, out, count);
+}
+
+// projects count points with m to screen positions in a width x height view with the origin at the top
+// left, the same coordinates the 2d drawing functions use. bit i % 32 of visible[i / 32] is set when point
+// i is in front of the camera and inside the view, visible needs room for (count + 31) / 32 words.
+// returns the number of visible points, the positions of the others are undefined
+i32 projectPoints(const m4 *m, const v3 *in, v2 *out, u32 *visible, i32 count, f32 width, f32 height)
+{
+    return m4Kernels.projectPoints(m, in, out, visible, count, width, height);
+}
+
+// true if point i was visible in the last projectPoints()
+inline b32 pointVisible(const u32 *visible, i32 i)
+{
+    return (visible[i >> 5] >> (i & 31)) & 1;
+}
+
+m4 m4Transpose(m4 m)
+{
+    m4 result;
+    m4TransposeSSE(&m, &result);
+    return result;
+}
+
+// returns false and leaves out untouched if the matrix can't be inverted
+b32 m4Inverse(const m4 *m, m4 *out)
+{
+    return m4InverseSSE(m, out);
+}
+
+constexpr m4 m4Translation(f32 x, f32 y, f32 z)
+{
+    m4 m = m4LoadIdentity();
+    m.e[0][3] = x;
+    m.e[1][3] = y;
+    m.e[2][3] = z;
+    return m;
+}
+
+constexpr m4 m4Scaling(f32 x, f32 y, f32 z)
+{
+    m4 m = m4LoadIdentity();
+    m.e[0][0] = x;
+    m.e[1][1] = y;
+    m.e[2][2] = z;
+    return m;
+}
+
+// rotation matrices around the x, y and z-axis, takes radians
+m4 m4RotationX(f32 angle)
+{
+    f32 c = cosinus(angle);
+    f32 s = sinus(angle);
+    m4 m = m4LoadIdentity();
+    m.e[1][1] = c;
+    m.e[1][2] = -s;
+    m.e[2][1] = s;
+    m.e[2][2] = c;
+    return m;
+}
+
+m4 m4RotationY(f32 angle)
+{
+    f32 c = cosinus(angle);
+    f32 s = sinus(angle);
+    m4 m = m4LoadIdentity();
+    m.e[0][0] = c;
+    m.e[0][2] = s;
+    m.e[2][0] = -s;
+    m.e[2][2] = c;
+    return m;
+}
+
+m4 m4RotationZ(f32 angle)
+{
+    f32 c = cosinus(angle);
+    f32 s = sinus(angle);
+    m4 m = m4LoadIdentity();
+    m.e[0][0] = c;
+    m.e[0][1] = -s;
+    m.e[1][0] = s;
+    m.e[1][1] = c;
+    return m;
+}
+
+// rotation of angle radians around axis, the axis doesn't have to be normalized
+m4 m4Rotation(f32 angle, v3 axis)
+{
+    f32 l = axis.lengthSquared();
+    if (l == 0.f)
+        return m4LoadIdentity();
+    axis *= inverseSquareRoot(l);
+
+    f32 c = cosinus(angle);
+    f32 s = sinus(angle);
+    f32 t = 1.f - c;
+    f32 x = axis.x, y = axis.y, z = axis.z;
+    m4 m = m4LoadIdentity();
+    m.e[0][0] = t * x * x + c;
+    m.e[0][1] = t * x * y - z * s;
+    m.e[0][2] = t * x * z + y * s;
+    m.e[1][0] = t * x * y + z * s;
+    m.e[1][1] = t * y * y + c;
+    m.e[1][2] = t * y * z - x * s;
+    m.e[2][0] = t * x * z - y * s;
+    m.e[2][1] = t * y * z + x * s;
+    m.e[2][2] = t * z * z + c;
+    return m;
+}
+
+// the transforms below return m * transform, what the matrix stack functions do to the current matrix.
+// they only work on the values they get, no globals, so transform hierarchies can be evaluated on any thread
+constexpr m4 m4Translate(m4 m, f32 x, f32 y, f32 z)
+{
+    for (i32 i = 0; i < 4; i++)
+        m.e[i][3] += x * m.e[i][0] + y * m.e[i][1] + z * m.e[i][2];
+    return m;
+}
+
+constexpr m4 m4Scale(m4 m, f32 x, f32 y, f32 z)
+{
+    for (i32 i = 0; i < 4; i++) {
+        m.e[i][0] *= x;
+        m.e[i][1] *= y;
+        m.e[i][2] *= z;
+    }
+    return m;
+}
+
+// rotation in radians
+m4 m4Rotate(m4 m, f32 angle, v3 axis)
+{
+    return m4Multiply(m, m4Rotation(angle, axis));
+}
+
+// the perspective projection perspectiveFrustum() sets up, fov is the vertical field of view in degrees
+m4 m4Perspective(f32 fov, f32 aspect, f32 nearZ, f32 farZ)
+{
+    f32 f = 1.f / tanf(radians(fov) * 0.5f);
+    m4 m;
+    m.e[0][0] = f / aspect;
+    m.e[1][1] = f;
+    m.e[2][2] = (farZ + nearZ) / (nearZ - farZ);
+    m.e[2][3] = 2.f * farZ * nearZ / (nearZ - farZ);
+    m.e[3][2] = -1.f;
+    return m;
+}
+
+// OpenGL friendly contigous array matrix
+typedef f32 Matrix[16];      //column major 4x4 matrix
+
+// the matrix the old Matrix functions translateMatrix(), scale() and rotate(angle, axis) work on
+Matrix transformationMatrix;
+
+// m4 is row major, OpenGL wants the columns first
+void m4ToMatrix(const m4 *m, Matrix out)
+{
+    for (i32 row = 0; row < 4; row++) {
+        for (i32 col = 0; col < 4; col++)
+            out[col * 4 + row] = m->e[row][col];
+    }
+}
+
+// and back, for matrices read from OpenGL
+m4 matrixToM4(const Matrix in)
+{
+    m4 result;
+    for (i32 row = 0; row < 4; row++) {
+        for (i32 col = 0; col < 4; col++)
+            result.e[row][col] = in[col * 4 + row];
+    }
+    return result;
+}
+
+// Quaternions
+
+// a rotation stored as four numbers instead of a 3x3 matrix. quaternions multiply with 16 multiplies
+// instead of 27, interpolate smoothly with slerp and can be renormalized cheaply when errors pile up.
+// x, y and z are the axis scaled by sin(angle / 2) and w is cos(angle / 2)
+struct quat
+{
+    f32 x, y, z, w;
+};
+
+inline quat quatIdentity()
+{
+    quat result = { 0.f, 0.f, 0.f, 1.f };
+    return result;
+}
+
+// rotation of angle radians around axis, the axis doesn't have to be normalized
+quat quatFromAxisAngle(v3 axis, f32 angle)
+{
+    f32 l = axis.lengthSquared();
+    if (l == 0.f)
+        return quatIdentity();
+
+    f32 s, c;
+    fastSinCos(angle * 0.5f, &s, &c);
+    s *= inverseSquareRoot(l);
+    quat result = { axis.x * s, axis.y * s, axis.z * s, c };
+    return result;
+}
+
+// a * b rotates by b first and then by a, like multiplying rotation matrices
+inline quat quatMultiply(quat a, quat b)
+{
+    quat result;
+    result.x = a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y;
+    result.y = a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x;
+    result.z = a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w;
+    result.w = a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z;
+    return result;
+}
+
+inline quat operator*(quat a, quat b)
+{
+    return quatMultiply(a, b);
+}
+
+// rotations around the x, y and z-axis in radians, the same rotation as rotateX(), rotateY() and rotateZ()
+// called in that order
+quat quatFromEuler(f32 x, f32 y, f32 z)
+{
+    return quatFromAxisAngle(v3(1.f, 0.f, 0.f), x) * quatFromAxisAngle(v3(0.f, 1.f, 0.f), y) * quatFromAxisAngle(v3(0.f, 0.f, 1.f), z);
+}
+
+inline f32 quatDot(quat a, quat b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+// the inverse rotation of a unit quaternion
+inline quat quatConjugate(quat q)
+{
+    quat result = { -q.x, -q.y, -q.z, q.w };
+    return result;
+}
+
+inline quat quatNormalize(quat q)
+{
+    f32 l = quatDot(q, q);
+    if (l == 0.f)
+        return quatIdentity();
+    f32 s = inverseSquareRoot(l);
+    quat result = { q.x * s, q.y * s, q.z * s, q.w * s };
+    return result;
+}
+
+// rotates v by q, cheaper than building the matrix for a single vector
+inline v3 quatRotate(quat q, v3 v)
+{
+    v3 axis = v3(q.x, q.y, q.z);
+    v3 t = v3CrossProduct(axis, v) * 2.f;
+    return v + t * q.w + v3CrossProduct(axis, t);
+}
+
+// normalized linear interpolation, cheaper than slerp but the speed isn't constant over the arc
+quat quatNlerp(quat a, quat b, f32 t)
+{
+    // q and -q are the same rotation, flip b to take the shorter way around
+    f32 sign = quatDot(a, b) < 0.f ? -1.f : 1.f;
+    f32 wa = 1.f - t;
+    f32 wb = t * sign;
+    quat result = { a.x * wa + b.x * wb, a.y * wa + b.y * wb, a.z * wa + b.z * wb, a.w * wa + b.w * wb };
+    return quatNormalize(result);
+}
+
+// spherical linear interpolation, constant speed along the shortest arc from a to b.
+// uses the fast trigonometry like quatSlerpArray(), the two agree within 5e-7 per component but not to
+// the bit, the build uses -fp:fast and quatSlerpArray() normalizes with inverseSquareRoot4()
+quat quatSlerp(quat a, quat b, f32 t)
+{
+    f32 d = quatDot(a, b);
+    f32 sign = d < 0.f ? -1.f : 1.f;
+    d *= sign;
+
+    f32 wa = 1.f - t;
+    f32 wb = t;
+    f32 sinAngle = sqrtf(maximum(1.f - d * d, 0.f));
+    // nearly the same rotation, sin(angle) is too small to divide by and nlerp is exact enough
+    if (sinAngle > 1e-4f) {
+        f32 angle = fastAtan2(sinAngle, d);
+        f32 invSin = 1.f / sinAngle;
+        wa = fastSin(wa * angle) * invSin;
+        wb = fastSin(wb * angle) * invSin;
+    }
+    wb *= sign;
+    quat result = { a.x * wa + b.x * wb, a.y * wa + b.y * wb, a.z * wa + b.z * wb, a.w * wa + b.w * wb };
+    return quatNormalize(result);
+}
+
+// out[i] = quatSlerp(a[i], b[i], t), four quaternions at a time with SSE. out can be the same array as a or b
+void quatSlerpArray(const quat *a, const quat *b, f32 t, quat *out, i32 count)
+{
+    __m128 one = _mm_set1_ps(1.f);
+    __m128 signMask = _mm_set1_ps(-0.f);
+    __m128 weightA = _mm_set1_ps(1.f - t);
+    __m128 weightB = _mm_set1_ps(t);
+
+    i32 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        // four quaternions in, one component per register
+        __m128 ax = _mm_loadu_ps(&a[i].x), ay = _mm_loadu_ps(&a[i + 1].x);
+        __m128 az = _mm_loadu_ps(&a[i + 2].x), aw = _mm_loadu_ps(&a[i + 3].x);
+        __m128 bx = _mm_loadu_ps(&b[i].x), by = _mm_loadu_ps(&b[i + 1].x);
+        __m128 bz = _mm_loadu_ps(&b[i + 2].x), bw = _mm_loadu_ps(&b[i + 3].x);
+        _MM_TRANSPOSE4_PS(ax, ay, az, aw);
+        _MM_TRANSPOSE4_PS(bx, by, bz, bw);
+
+        __m128 d = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz)), _mm_mul_ps(aw, bw));
+        __m128 sign = _mm_and_ps(d, signMask);
+        d = _mm_xor_ps(d, sign);
+
+        __m128 sinAngle = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(one, _mm_mul_ps(d, d)), _mm_setzero_ps()));
+        __m128 angle = fastAtan2_4(sinAngle, d);
+        __m128 invSin = _mm_div_ps(one, sinAngle);
+        __m128 sinA, sinB, unused;
+        fastSinCos4(_mm_mul_ps(weightA, angle), &sinA, &unused);
+        fastSinCos4(_mm_mul_ps(weightB, angle), &sinB, &unused);
+        __m128 useSlerp = _mm_cmpgt_ps(sinAngle, _mm_set1_ps(1e-4f));
+        __m128 wa = _mm_or_ps(_mm_and_ps(useSlerp, _mm_mul_ps(sinA, invSin)), _mm_andnot_ps(useSlerp, weightA));
+        __m128 wb = _mm_or_ps(_mm_and_ps(useSlerp, _mm_mul_ps(sinB, invSin)), _mm_andnot_ps(useSlerp, weightB));
+        wb = _mm_xor_ps(wb, sign);
+
+        __m128 x = _mm_add_ps(_mm_mul_ps(ax, wa), _mm_mul_ps(bx, wb));
+        __m128 y = _mm_add_ps(_mm_mul_ps(ay, wa), _mm_mul_ps(by, wb));
+        __m128 z = _mm_add_ps(_mm_mul_ps(az, wa), _mm_mul_ps(bz, wb));
+        __m128 w = _mm_add_ps(_mm_mul_ps(aw, wa), _mm_mul_ps(bw, wb));
+        __m128 l = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)), _mm_mul_ps(w, w));
+        __m128 s = inverseSquareRoot4(l);
+        x = _mm_mul_ps(x, s);
+        y = _mm_mul_ps(y, s);
+        z = _mm_mul_ps(z, s);
+        w = _mm_mul_ps(w, s);
+
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        _mm_storeu_ps(&out[i].x, x);
+        _mm_storeu_ps(&out[i + 1].x, y);
+        _mm_storeu_ps(&out[i + 2].x, z);
+        _mm_storeu_ps(&out[i + 3].x, w);
+    }
+    for (; i < count; i++)
+        out[i] = quatSlerp(a[i], b[i], t);
+}
+
+// the rotation matrix of a unit quaternion
+m4 quatToM4(quat q)
+{
+    f32 x2 = q.x + q.x, y2 = q.y + q.y, z2 = q.z + q.z;
+    f32 xx = q.x * x2, yy = q.y * y2, zz = q.z * z2;
+    f32 xy = q.x * y2, xz = q.x * z2, yz = q.y * z2;
+    f32 wx = q.w * x2, wy = q.w * y2, wz = q.w * z2;
+
+    m4 m = m4LoadIdentity();
+    m.e[0][0] = 1.f - (yy + zz);
+    m.e[0][1] = xy - wz;
+    m.e[0][2] = xz + wy;
+    m.e[1][0] = xy + wz;
+    m.e[1][1] = 1.f - (xx + zz);
+    m.e[1][2] = yz - wx;
+    m.e[2][0] = xz - wy;
+    m.e[2][1] = yz + wx;
+    m.e[2][2] = 1.f - (xx + yy);
+    return m;
+}
+
+// the rotation and a translation in one matrix, for drawInstanced() transforms
+m4 quatToM4(quat q, v3 position)
+{
+    m4 m = quatToM4(q);
+    m.e[0][3] = position.x;
+    m.e[1][3] = position.y;
+    m.e[2][3] = position.z;
+    return m;
+}
+
+void quatToMatrix(quat q, Matrix out)
+{
+    m4 m = quatToM4(q);
+    m4ToMatrix(&m, out);
+}
+
+// m * the rotation of q, only the first three columns change
+m4 m4Rotate(m4 m, quat q)
+{
+    m4 r = quatToM4(q);
+    for (i32 i = 0; i < 4; i++) {
+        f32 c0 = m.e[i][0], c1 = m.e[i][1], c2 = m.e[i][2];
+        for (i32 j = 0; j < 3; j++)
+            m.e[i][j] = c0 * r.e[0][j] + c1 * r.e[1][j] + c2 * r.e[2][j];
+    }
+    return m;
+}
+
+// translation * rotation * scaling, the local transform of a node in a hierarchy built without
+// any matrix products
+m4 m4Transform(v3 position, quat rotation, v3 scaling)
+{
+    m4 m = quatToM4(rotation, position);
+    for (i32 i = 0; i < 3; i++) {
+        m.e[i][0] *= scaling.x;
+        m.e[i][1] *= scaling.y;
+        m.e[i][2] *= scaling.z;
+    }
+    return m;
+}
+
+// Matrix stack
+
+// the modelview matrix is kept on the CPU, so the framework can read it for culling, level of detail and
+// batching. GL only gets a copy when something is drawn and the matrix has changed since the last draw,
+// so raw GL drawing (glBegin(), glVertex() and the like) after translate() or rotate() needs a
+// flushMatrix() first or it is drawn with the matrix of the last framework draw.
+#define MATRIX_STACK_DEPTH 32
+
+struct MatrixStack
+{
+    m4 matrices[MATRIX_STACK_DEPTH];
+    i32 top;
+    b32 dirty;      // the top matrix has changed since it was loaded into GL
+    m4 *overflow;   // matrices pushed past the depth, popMatrix() takes these off first. realloc keeps the alignment
+    i32 overflowCount;
+    i32 overflowCapacity;
+};
+
+global MatrixStack matrixStack = { { m4LoadIdentity() }, 0, true, 0, 0, 0 };
+
+inline m4 *topMatrix()
+{
+    return matrixStack.matrices + matrixStack.top;
+}
+
+// loads the current matrix into GL if it has changed, the drawing functions call this before they draw,
+// raw GL calls that depend on the modelview matrix need it too
+inline void flushMatrix()
+{
+    if (matrixStack.dirty) {
+        Matrix m;
+        m4ToMatrix(topMatrix(), m);
+        glLoadMatrixf(m);
+        matrixStack.dirty = false;
+    }
+}
+
+void loadIdentity()
+{
+    *topMatrix() = m4LoadIdentity();
+    matrixStack.dirty = true;
+}
+
+// past MATRIX_STACK_DEPTH the top matrix is saved to a heap array that grows as needed, deep recursion
+// still works, it just copies a matrix more per push and pop
+void pushMatrix()
+{
+    MatrixStack *stack = &matrixStack;
+    if (stack->top < MATRIX_STACK_DEPTH - 1) {
+        stack->matrices[stack->top + 1] = stack->matrices[stack->top];
+        stack->top++;
+    } else {
+        if (stack->overflowCount == stack->overflowCapacity) {
+            stack->overflowCapacity = stack->overflowCapacity ? stack->overflowCapacity * 2 : MATRIX_STACK_DEPTH;
+            stack->overflow = (m4 *)realloc(stack->overflow, sizeof(m4) * stack->overflowCapacity);
+        }
+        stack->overflow[stack->overflowCount++] = *topMatrix();
+    }
+}
+
+void popMatrix()
+{
+    if (matrixStack.overflowCount > 0) {
+        *topMatrix() = matrixStack.overflow[--matrixStack.overflowCount];
+        matrixStack.dirty = true;
+    } else if (matrixStack.top > 0) {
+        matrixStack.top--;
+        matrixStack.dirty = true;
+    }
+}
+
+// returns the current modelview matrix
+m4 getMatrix()
+{
+    return *topMatrix();
+}
+
+// multiplies the current matrix with m
+void applyMatrix(m4 m)
+{
+    m4MultiplySSE(topMatrix(), &m, topMatrix());
+    matrixStack.dirty = true;
+}
+
+// the basic transforms only touch the columns they change instead of multiplying full matrices
+void translate(f32 x, f32 y, f32 z = 0.f)
+{
+    *topMatrix() = m4Translate(*topMatrix(), x, y, z);
+    matrixStack.dirty = true;
+}
+
+// rotates the columns a and b of the current matrix, takes radians
+internal void
+rotateColumns(i32 a, i32 b, f32 angle)
+{
+    f32 c = cosinus(angle);
+    f32 s = sinus(angle);
+    m4 *m = topMatrix();
+    for (i32 i = 0; i < 4; i++) {
+        f32 ca = m->e[i][a];
+        f32 cb = m->e[i][b];
+        m->e[i][a] = c * ca + s * cb;
+        m->e[i][b] = c * cb - s * ca;
+    }
+    matrixStack.dirty = true;
+}
+
+// rotation around the x, y and z-axis in degrees
+void rotateX(f32 angle)
+{
+    rotateColumns(1, 2, radians(angle));
+}
+
+void rotateY(f32 angle)
+{
+    rotateColumns(2, 0, radians(angle));
+}
+
+void rotateZ(f32 angle)
+{
+    rotateColumns(0, 1, radians(angle));
+}
+
+// rotation in radians
+void rotate(f32 angle)
+{
+    rotateColumns(0, 1, angle);
+}
+
+// rotation by a quaternion
+void rotate(quat q)
+{
+    *topMatrix() = m4Rotate(*topMatrix(), q);
+    matrixStack.dirty = true;
+}
+
+
+// rotates a vector using a 4x4 matrix, translation column is ignored
+void rotateVector(v3 vSrc, Matrix mMatrix, v3 *vOut)
+{
+	vOut->x = mMatrix[0] * vSrc.x + mMatrix[4] * vSrc.y + mMatrix[8] * vSrc.z;
+	vOut->y = mMatrix[1] * vSrc.x + mMatrix[5] * vSrc.y + mMatrix[9] * vSrc.z;
+	vOut->z = mMatrix[2] * vSrc.x + mMatrix[6] * vSrc.y + mMatrix[10] * vSrc.z;
+}
+
+// load a matrix with the identity matrix
+void loadIdentityMatrix(Matrix m)
+{
+	static Matrix identity = {
+		1.0f, 0.0f, 0.0f, 0.0f, // x column
+		0.0f, 1.0f, 0.0f, 0.0f, // y column
+		0.0f, 0.0f, 1.0f, 0.0f, // z column
+		0.0f, 0.0f, 0.0f, 1.0f  // translation
+	};
+    
+	memcpy(m, identity, sizeof(Matrix));
+	//glMatrixMode(GL_MODELVIEW);
+	//glLoadMatrixf(identity);
+}
+
+// reset the transformation matrix
+void loadIdentityMatrix()
+{
+	static Matrix identity = {
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f
+	};
+    
+	memcpy(transformationMatrix, identity, sizeof(Matrix));
+}
+
+// multiply two 4x4 matricies, mProduct can be the same matrix as m1 or m2
+void multiplyMatrix(const Matrix m1, const Matrix m2, Matrix mProduct)
+{
+	// the product is built in a local matrix, writing straight into mProduct would change m1 or m2
+	// while they are still being read when they are the same matrix
+	Matrix product;
+	product[0] = m1[0] * m2[0] + m1[4] * m2[1] + m1[8] * m2[2] + m1[12] * m2[3];
+	product[4] = m1[0] * m2[4] + m1[4] * m2[5] + m1[8] * m2[6] + m1[12] * m2[7];
+	product[8] = m1[0] * m2[8] + m1[4] * m2[9] + m1[8] * m2[10] + m1[12] * m2[11];
+	product[12] = m1[0] * m2[12] + m1[4] * m2[13] + m1[8] * m2[14] + m1[12] * m2[15];
+    
+	product[1] = m1[1] * m2[0] + m1[5] * m2[1] + m1[9] * m2[2] + m1[13] * m2[3];
+	product[5] = m1[1] * m2[4] + m1[5] * m2[5] + m1[9] * m2[6] + m1[13] * m2[7];
+	product[9] = m1[1] * m2[8] + m1[5] * m2[9] + m1[9] * m2[10] + m1[13] * m2[11];
+	product[13] = m1[1] * m2[12] + m1[5] * m2[13] + m1[9] * m2[14] + m1[13] * m2[15];
+    
+	product[2] = m1[2] * m2[0] + m1[6] * m2[1] + m1[10] * m2[2] + m1[14] * m2[3];
+	product[6] = m1[2] * m2[4] + m1[6] * m2[5] + m1[10] * m2[6] + m1[14] * m2[7];
+	product[10] = m1[2] * m2[8] + m1[6] * m2[9] + m1[10] * m2[10] + m1[14] * m2[11];
+	product[14] = m1[2] * m2[12] + m1[6] * m2[13] + m1[10] * m2[14] + m1[14] * m2[15];
+    
+	product[3] = m1[3] * m2[0] + m1[7] * m2[1] + m1[11] * m2[2] + m1[15] * m2[3];
+	product[7] = m1[3] * m2[4] + m1[7] * m2[5] + m1[11] * m2[6] + m1[15] * m2[7];
+	product[11] = m1[3] * m2[8] + m1[7] * m2[9] + m1[11] * m2[10] + m1[15] * m2[11];
+	product[15] = m1[3] * m2[12] + m1[7] * m2[13] + m1[11] * m2[14] + m1[15] * m2[15];
+    
+	memcpy(mProduct, product, sizeof(Matrix));
+}
+
+// create a translation matrix
+void translateMatrix(f32 x, f32 y, f32 z)
+{
+	Matrix translation;
+	loadIdentityMatrix(translation);
+	translation[12] = x;
+	translation[13] = y;
+	translation[14] = z;
+	multiplyMatrix(translation, transformationMatrix, transformationMatrix);
+}
+
+void translateMatrix(Matrix m, v3 pos)
+{
+	Matrix translation;
+	loadIdentityMatrix(translation);
+	translation[12] = pos.x;
+	translation[13] = pos.y;
+	translation[14] = pos.z;
+	multiplyMatrix(translation, transformationMatrix, m);
+}
+
+
+// create a scaling matrix
+void scale(f32 x, f32 y, f32 z)
+{
+	Matrix scaling;
+	loadIdentityMatrix(scaling);
+	scaling[0] = x;
+	scaling[5] = y;
+	scaling[10] = z;
+	multiplyMatrix(transformationMatrix, scaling, transformationMatrix);
+}
+
+//creates a 4x4 rotation matrix, takes radians
+void rotate(f32 angle, v3 pos)
+{
+	Matrix rotation;
+	m4 m = m4Rotation(angle, pos);
+	m4ToMatrix(&m, rotation);
+	multiplyMatrix(transformationMatrix, rotation, transformationMatrix);
+}
+
+// create a translation matrix
+void createTranslationMatrix(f32 x, f32 y, f32 z, Matrix mTranslate)
+{
+    loadIdentityMatrix(mTranslate);
+    mTranslate[12] = x;
+    mTranslate[13] = y;
+    mTranslate[14] = z;
+}
+
+// create a scaling matrix
+void createScalingMatrix(f32 x, f32 y, f32 z, Matrix mScale)
+{
+    loadIdentityMatrix(mScale);
+    mScale[0] = x;
+    mScale[5] = y;
+    mScale[10] = z;
+}
+
+// creates a 4x4 rotation matrix, takes radians
+void createRotationMatrix(f32 angle, v3 pos, Matrix mMatrix)
+{
+    m4 m = m4Rotation(angle, pos);
+    m4ToMatrix(&m, mMatrix);
+}
+
+// creates a shadow matrix out of the plane equation coefficients and the position of the light
+void createShadowMatrix(v3 vPoints[3], f32 vLightPos[4], Matrix destMat)
+{
+    f32 vPlaneEquation[4];
+    f32 dot;
+    //Matrix destMat;
+    
+    v3GetPlaneEquation(vPoints[0], vPoints[1], vPoints[2], vPlaneEquation);
+    
+    // dot product of plane and light position
+    dot = vPlaneEquation[0] * vLightPos[0] +
+        vPlaneEquation[1] * vLightPos[1] +
+        vPlaneEquation[2] * vLightPos[2] +
+        vPlaneEquation[3] * vLightPos[3];
+    
+    // calculate shadow projection
+    // 1st column
+    destMat[0] = dot - vLightPos[0] * vPlaneEquation[0];
+    destMat[4] = 0.0f - vLightPos[0] * vPlaneEquation[1];
+    destMat[8] = 0.0f - vLightPos[0] * vPlaneEquation[2];
+    destMat[12] = 0.0f - vLightPos[0] * vPlaneEquation[3];
+    
+    // 2nd column
+    destMat[1] = 0.0f - vLightPos[1] * vPlaneEquation[0];
+    destMat[5] = dot - vLightPos[1] * vPlaneEquation[1];
+    destMat[9] = 0.0f - vLightPos[1] * vPlaneEquation[2];
+    destMat[13] = 0.0f - vLightPos[1] * vPlaneEquation[3];
+    
+    // 3rd Column
+    destMat[2] = 0.0f - vLightPos[2] * vPlaneEquation[0];
+    destMat[6] = 0.0f - vLightPos[2] * vPlaneEquation[1];
+    destMat[10] = dot - vLightPos[2] * vPlaneEquation[2];
+    destMat[14] = 0.0f - vLightPos[2] * vPlaneEquation[3];
+    
+    // 4th Column
+    destMat[3] = 0.0f - vLightPos[3] * vPlaneEquation[0];
+    destMat[7] = 0.0f - vLightPos[3] * vPlaneEquation[1];
+    destMat[11] = 0.0f - vLightPos[3] * vPlaneEquation[2];
+    destMat[15] = dot - vLightPos[3] * vPlaneEquation[3];
+}
+
+//
+// Colors
+//
+
+union Color
+{
+    struct {
+        i32 r, g, b, a;
+    };
+    struct {
+        i32 h, s, b, a;
+    };
+    struct {
+        i32 h, s, l, a;
+    };
+    struct {
+        f32 fR, fG, fB, fA;
+    };
+};
+
+typedef struct {
+    f32 r, g, b, a;
+} Colorf;
+
+enum ColorModes {
+    RGB,
+    HSB,
+    HSL
+};
+
+Color black = { 0,0,0, 255 };
+Color white = { 255,255,255, 255 };
+Color c64red = { 104, 55, 43, 255 };
+Color c64cyan = { 112, 164, 178, 255 };
+Color c64purple = { 111, 61, 134, 255 };
+Color c64green = { 88, 141, 67, 255 };;
+Color c64blue = { 53, 40, 121, 255 };
+Color c64yellow = { 184, 199, 111, 255 };
+Color c64orange = { 111, 79, 37, 255 };;
+Color c64brown = { 67, 57, 0, 255 };
+Color c64lightred = { 154, 103, 89, 255 };
+Color c64darkgrey = { 68, 68, 68, 255 };
+Color c64grey = { 108, 108, 108, 255 };
+Color c64lightgreen = { 154, 210, 132, 255 };
+Color c64lightblue = { 108, 94, 181, 255 };
+Color c64lightgrey = { 149, 149, 149, 255 };
+Color red = { 255,0,0, 255 };
+Color green = { 0,255,0, 255 };;
+Color blue = { 0,0,255, 255 };
+Color yellow = { 255,255,0, 255 };
+Color cyan = { 0,255,255, 255 };
+Color magenta = { 255,0,255, 255 };
+Color purple = { 128, 0, 128, 255 };
+Color gray = { 128, 128, 128, 255 };
+Color grey = { 192, 192, 192, 255 };
+Color maroon = { 128, 0, 0, 255 };
+Color darkgreen = { 0, 128, 0, 255 };
+Color navy = { 0, 0, 128, 255 };
+Color teal = { 0, 128, 128, 255 };
+Color olive = { 128, 128, 0, 255 };
+Color orange = { 255,127,50, 255 };
+Color cornflowerblue = { 101, 156, 239, 255 };
+Color azure = { 0, 127, 255, 255 };
+Color turquoise = { 48, 213, 200, 255 };
+Color gold = { 255, 215, 0, 255 };
+Color silver = { 192, 192, 192, 255 };
+Color pink = { 255, 192, 203, 255 };
+Color brown = { 0xa5,0x2a,0x2a, 0xff };
+
+// blends two colors channel by channel, amount 0 gives from and 1 gives to
+constexpr Color lerpColor(Color from, Color to, f32 amount)
+{
+    Color result = {
+        (i32)(lerp((f32)from.r, (f32)to.r, amount) + 0.5f),
+        (i32)(lerp((f32)from.g, (f32)to.g, amount) + 0.5f),
+        (i32)(lerp((f32)from.b, (f32)to.b, amount) + 0.5f),
+        (i32)(lerp((f32)from.a, (f32)to.a, amount) + 0.5f)
+    };
+    return result;
+}
+
+//
+// Lookup tables
+//
+
+// fixed size tables filled by constexpr functions, declared constexpr they are computed by the compiler
+// and nothing is built at startup:
+//   global constexpr LookupTable<f32, 256> sines = sineTable<256>();
+template <typename T, i32 count>
+struct LookupTable
+{
+    T e[count];
+
+    constexpr T &operator[](i32 i) { return e[i]; }
+    constexpr const T &operator[](i32 i) const { return e[i]; }
+    constexpr i32 size() const { return count; }
+};
+
+// one period of sine, entry i is sin(TWO_PI * i / count)
+template <i32 count>
+constexpr LookupTable<f32, count> sineTable()
+{
+    LookupTable<f32, count> result = {};
+    for (i32 i = 0; i < count; i++)
+        result[i] = fastSin(TWO_PI * (f32)i / (f32)count);
+    return result;
+}
+
+// count points evenly spaced on the unit circle, counterclockwise from (1, 0)
+template <i32 count>
+constexpr LookupTable<v2, count> circleTable()
+{
+    LookupTable<v2, count> result = {};
+    for (i32 i = 0; i < count; i++) {
+        f32 s = 0.f, c = 0.f;
+        fastSinCos(TWO_PI * (f32)i / (f32)count, &s, &c);
+        result[i] = v2(c, s);
+    }
+    return result;
+}
+
+// count colors blended from one color to another, both ends included
+template <i32 count>
+constexpr LookupTable<Color, count> colorRamp(Color from, Color to)
+{
+    LookupTable<Color, count> result = {};
+    for (i32 i = 0; i < count; i++)
+        result[i] = lerpColor(from, to, count > 1 ? (f32)i / (f32)(count - 1) : 0.f);
+    return result;
+}
+
+// the unit circles circle() and ellipse() are drawn with
+global constexpr LookupTable<v2, 64> circleFillPoints = circleTable<64>();
+global constexpr LookupTable<v2, 256> ellipseFillPoints = circleTable<256>();
+global constexpr LookupTable<v2, 100> outlinePoints = circleTable<100>();
+
+// compile-time checks of the constexpr math, a wrong value stops the build
+static_assert(square(-3.f) == 9.f, "square");
+static_assert(powerOf(2.f, 10.f) == 1024.f, "powerOf");
+static_assert(absoluteValue(-2.5f) == 2.5f, "absoluteValue");
+static_assert(signOf(-7) == -1 && signOf(0) == 1, "signOf");
+static_assert(constrain(12, 0, 10) == 10 && constrain(-1, 0, 10) == 0, "constrain");
+static_assert(constrainf(0.5f, 0.f, 1.f) == 0.5f, "constrainf");
+static_assert(map(5.f, 0.f, 10.f, 0.f, 100.f) == 50.f, "map");
+static_assert(map(20.f, 0.f, 10.f, 100.f, 0.f) == 0.f, "map clamps to the output range");
+static_assert(map(1.f, 2.f, 2.f, 3.f, 4.f) == 3.f, "map of an empty range");
+static_assert(lerp(10.f, 20.f, 0.25f) == 12.5f, "lerp");
+static_assert(radians(180.f) == PI && degrees(PI) == 180.f, "radians, degrees");
+static_assert(absoluteValue(fastSin(PI / 6.f) - 0.5f) < 1e-7f, "fastSin");
+static_assert(absoluteValue(fastCos(PI) + 1.f) < 1e-7f, "fastCos");
+static_assert(absoluteValue(fastSin(-100.f) - 0.50636564f) < 1e-6f, "fastSin far from 0");
+static_assert((v2(1.f, 2.f) + v2(3.f, 4.f) * 2.f).y == 10.f, "v2 operators");
+static_assert(v2(3.f, 4.f).lengthSquared() == 25.f, "v2 lengthSquared");
+static_assert(v3CrossProduct(v3(1.f, 0.f, 0.f), v3(0.f, 1.f, 0.f)).z == 1.f, "v3CrossProduct");
+static_assert(m4MultiplyScalar(m4Translation(1.f, 2.f, 3.f), m4Translation(4.f, 5.f, 6.f)).e[1][3] == 7.f, "m4 translations add");
+static_assert(m4Scale(m4Translation(1.f, 2.f, 3.f), 2.f, 2.f, 2.f).e[0][0] == 2.f, "m4Scale");
+static_assert(m4Translate(m4Scaling(2.f, 2.f, 2.f), 1.f, 0.f, 0.f).e[0][3] == 2.f, "m4Translate");
+static_assert(m4TransposeScalar(m4Translation(1.f, 2.f, 3.f)).e[3][2] == 3.f, "m4TransposeScalar");
+static_assert(sineTable<8>()[2] == 1.f && sineTable<8>()[6] == -1.f, "sineTable");
+static_assert(absoluteValue(circleFillPoints[16].x) < 1e-7f && circleFillPoints[16].y == 1.f, "circleTable");
+static_assert(colorRamp<3>(Color{ 0, 0, 0, 255 }, Color{ 255, 100, 10, 255 })[1].r == 128, "colorRamp");
+
+//
+// Input
+//
+
+typedef struct {
+    b32 isDown;
+    b32 changed;
+} ButtonState;
+
+enum {
+    KEY_0 = 0x30,
+    KEY_1 = 0x31,
+    KEY_2 = 0x32,
+    KEY_3 = 0x33,
+    KEY_4 = 0x34,
+    KEY_5 = 0x35,
+    KEY_6 = 0x36,
+    KEY_7 = 0x37,
+    KEY_8 = 0x38,
+    KEY_9 = 0x39,
+    KEY_A = 0x41,
+    KEY_B = 0x42,
+    KEY_C = 0x43,
+    KEY_D = 0x44,
+    KEY_E = 0x45,
+    KEY_F = 0x46,
+    KEY_G = 0x47,
+    KEY_H = 0x48,
+    KEY_I = 0x49,
+    KEY_J = 0x4a,
+    KEY_K = 0x4b,
+    KEY_L = 0x4c,
+    KEY_M = 0x4d,
+    KEY_N = 0x4e,
+    KEY_O = 0x4f,
+    KEY_P = 0x50,
+    KEY_Q = 0x51,
+    KEY_R = 0x52,
+    KEY_S = 0x53,
+    KEY_T = 0x54,
+    KEY_U = 0x55,
+    KEY_V = 0x56,
+    KEY_W = 0x57,
+    KEY_X = 0x58,
+    KEY_Y = 0x59,
+    KEY_Z = 0x5a,
+    KEY_CTRL = VK_CONTROL,
+    KEY_ALT = VK_MENU,
+    KEY_SHIFT = VK_SHIFT,
+    KEY_ENTER = VK_RETURN,
+    KEY_ESCAPE = VK_ESCAPE,
+    KEY_SPACE = VK_SPACE,
+    KEY_BACK = VK_BACK,
+    KEY_TAB = VK_TAB,
+    KEY_PAUSE = VK_PAUSE,
+    KEY_SCROLL = VK_SCROLL,
+    KEY_INSERT = VK_INSERT,
+    KEY_HOME = VK_HOME,
+    KEY_END = VK_END,
+    KEY_DELETE = VK_DELETE,
+    KEY_PGUP = VK_PRIOR,
+    KEY_PGDOWN = VK_NEXT,
+    KEY_UP = VK_UP,
+    KEY_DOWN = VK_DOWN,
+    KEY_LEFT = VK_LEFT,
+    KEY_RIGHT = VK_RIGHT,
+    KEY_F1 = VK_F1,
+    KEY_F2 = VK_F2,
+    KEY_F3 = VK_F3,
+    KEY_F4 = VK_F4,
+    KEY_F5 = VK_F5,
+    KEY_F6 = VK_F6,
+    KEY_F7 = VK_F7,
+    KEY_F8 = VK_F8,
+    KEY_F9 = VK_F9,
+    KEY_F10 = VK_F10,
+    KEY_F11 = VK_F11,
+    KEY_F12 = VK_F12,
+
+    KEY_COUNT
+};
+
+enum {
+    MOUSE_LEFT,
+    MOUSE_MIDDLE,
+    MOUSE_RIGHT,
+
+    MOUSE_BUTTONS_COUNT
+};
+
+enum {
+    GAMEPAD_UP,
+    GAMEPAD_DOWN,
+    GAMEPAD_LEFT,
+    GAMEPAD_RIGHT,
+    GAMEPAD_START,
+    GAMEPAD_BACK,
+    GAMEPAD_LEFT_THUMB,
+    GAMEPAD_RIGHT_THUMB,
+    GAMEPAD_LEFT_SHOULDER,
+    GAMEPAD_RIGHT_SHOULDER,
+    GAMEPAD_A,
+    GAMEPAD_B,
+    GAMEPAD_X,
+    GAMEPAD_Y,
+
+    GAMEPAD_BUTTONS_COUNT
+};
+
+typedef struct {
+    f32 leftStickX;
+    f32 leftStickY;
+    f32 rightStickX;
+    f32 rightStickY;
+
+    u8 leftTrigger;
+    u8 rightTrigger;
+
+    union {
+        ButtonState gamepadButtons[GAMEPAD_BUTTONS_COUNT];
+
+        struct {
+            ButtonState up;
+            ButtonState down;
+            ButtonState left;
+            ButtonState right;
+            ButtonState start;
+            ButtonState back;
+            ButtonState leftThumb;
+            ButtonState rightThumb;
+            ButtonState leftShoulder;
+            ButtonState rightShoulder;
+            ButtonState aButton;
+            ButtonState bButton;
+            ButtonState xButton;
+            ButtonState yButton;
+        };
+    };
+
+    b32 keys[KEY_COUNT];
+    b32 prevKeys[KEY_COUNT];
+
+    i32 mouseX;
+    i32 mouseY;
+    i32 prevMouseX;
+    i32 prevMouseY;
+    b32 mouseDragged;
+    b32 mouseMoved;
+    i32 mouseWheelDelta;
+    ButtonState mouseButtons[MOUSE_BUTTONS_COUNT];
+} Input;
+
+internal void
+updateGamepadButton(DWORD gamepadState, DWORD buttonBitTest, ButtonState *button)
+{
+    b32 isDown = (gamepadState & buttonBitTest);
+    button->changed = isDown != button->isDown;
+    button->isDown = isDown;
+}
+
+internal f32
+processStickValue(f32 value, f32 deadZoneThreshold)
+{
+    // return 0 if we got a value that are in the dead zone 
+    f32 result = 0;
+
+    if (value < -deadZoneThreshold) {
+        // NOTE:if we say that the deadszone ends at 0.2, 
+        // this will map the value to 0 - 1 instead of 0.2 - 1
+        result = (value + deadZoneThreshold) / (32768.0f - deadZoneThreshold);
+    }
+    else if (value > deadZoneThreshold) {
+        result = (value - deadZoneThreshold) / (32767.0f - deadZoneThreshold);
+    }
+
+    return result;
+}
+
+internal void
+updateMouse(ButtonState *button, b32 isDown)
+{
+    button->changed = isDown != button->isDown;
+    button->isDown = isDown;
+}
+
+
+//
+// File I/O
+//
+
+//remember to free the memory after you called this function!
+char *loadTextFile(char *filename)
+{
+    char *contents = 0;
+    FILE *file = fopen(filename, "rb");
+
+    if (file)
+    {
+        fseek(file, 0, SEEK_END);				    // go to end of file
+        size_t fileSize = ftell(file);			    // get file size
+        fseek(file, 0, SEEK_SET);				    // go to beginning of file
+        contents = (char *)malloc(fileSize + 1);	// allocate memory for file + 1 byte for null terminator
+
+        fread(contents, fileSize, 1, file);		    // read in the file
+        contents[fileSize] = 0;					    // insert the null terminator
+
+        fclose(file);
+    }
+    return contents;
+}
+
+void *loadFile(char *filename)
+{
+    FILE *fp = fopen(filename, "r");
+    //move pointer to the end of the file to get length
+    fseek(fp, 0, SEEK_END);
+    long fileSize = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    void *contents = (void *)malloc((fileSize) * sizeof(char));
+
+    //read file
+    fread(contents, 1, fileSize, fp);
+    fclose(fp);
+    return contents;
+}
+
+//
+// Windows
+//
+
+typedef struct {
+    BITMAPINFO bitmapInfo; // win32 bitmap info structer
+    void *pixels; // pixel memory
+    i32 width, height;
+} BackBuffer;
+
+struct PlatformState {
+    b32 running;
+    b32 lockFPS;
+    i64 frequencyCounter;
+
+    HWND window;
+    i32 windowWidth;
+    i32 windowHeight;
+    b32 fullscreen;
+    
+    i32 canvasWidth;
+    i32 canvasHeight;
+
+    // API
+    b32 projection3DFlag; // 2D projection if false
+    i32 colorModeFlag;
+    b32 doubleBufferDisabledFlag; // double buffering on/off
+    b32 fillFlag; // fill flag for shapes
+    i32 lineWidth; // strokeweight	
+    i32 rectModeFlag;
+    Colorf clearColor;
+    Colorf strokeColor;
+    Colorf fillColor;
+    f32 milliseconds;
+    i32 lodModeFlag; // level of detail for sphere(), torus() and model()
+    f32 lodPixelsPerSegment; // target edge length on screen in LOD_AUTO mode
+    f32 lodHysteresis; // relative band around the thresholds before switching level
+    i32 lodSlot; // LOD draw calls so far this frame
+    i32 *lodLevels; // level picked last frame for every LOD draw call, stretchy buffer
+    i32 transparencyModeFlag; // queue translucent 3D meshes and draw them back to front
+
+    // UI state
+    i32 hotWidget; // widget is below the mouse cursor
+    i32 activeWidget; // user is interacting with the widget
+    i32 keyboardFocus;
+    i32 keyentered;
+    i32 keymod;
+    i32 keychar;
+    i32 lastwidget;
+};
+
+global PlatformState platformState;
+global Input input;
+
+// processing, p5.js global variables
+global i32 width;
+global i32 height;
+global f32 deltaTime; //target seconds per frame
+global u64 frameCount = 0;	// number of frames drawn since program start
+global i32 mouseX;
+global i32 mouseY;
+global b32 mouseDragged;
+global v2 center;
+
+void draw();
+void setup();
+void cleanup();
+void initOpenGL();
+void buildFont(const char *fontName, int fontSize);
+void set3dProjection(i32 width, i32 height, f32 fov, f32 nearZ, f32 farZ);
+void set2dProjection(i32 width, i32 height);
+void drawTransparent();
+
+internal void
+toggleFullscreen()
+{
+    local WINDOWPLACEMENT windowPosition = { sizeof(windowPosition) };
+    DWORD windowStyleFlags = GetWindowLong(platformState.window, GWL_STYLE);
+    if (windowStyleFlags & WS_OVERLAPPEDWINDOW) {
+        MONITORINFO monitorInfo = { sizeof(monitorInfo) };
+        if (GetWindowPlacement(platformState.window, &windowPosition) &&
+            GetMonitorInfo(MonitorFromWindow(platformState.window, MONITOR_DEFAULTTOPRIMARY), &monitorInfo)) {
+            SetWindowLong(platformState.window, GWL_STYLE, windowStyleFlags & ~WS_OVERLAPPEDWINDOW);
+            SetWindowPos(platformState.window, HWND_TOP,
+                monitorInfo.rcMonitor.left, monitorInfo.rcMonitor.top,
+                monitorInfo.rcMonitor.right - monitorInfo.rcMonitor.left,
+                monitorInfo.rcMonitor.bottom - monitorInfo.rcMonitor.top,
+                SWP_NOOWNERZORDER | SWP_FRAMECHANGED);
+        }
+    }
+    else {
+        SetWindowLong(platformState.window, GWL_STYLE, windowStyleFlags | WS_OVERLAPPEDWINDOW);
+        SetWindowPlacement(platformState.window, &windowPosition);
+        SetWindowPos(platformState.window, 0, 0, 0, 0, 0,
+            SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER |
+            SWP_NOOWNERZORDER | SWP_FRAMECHANGED);
+    }
+}
+
+void setWindowTitle(const char *title)
+{
+    SetWindowTextA(platformState.window, title);
+}
+
+inline f32
+getSecondsElapsed(LARGE_INTEGER start, LARGE_INTEGER end)
+{
+    f32 result = ((f32)(end.QuadPart - start.QuadPart) / (f32)platformState.frequencyCounter);
+    //f64 result = ((end.QuadPart - start.QuadPart) / (f64)platformState.frequencyCounter);
+    return result;
+}
+
+
+internal LRESULT CALLBACK
+windowProc(HWND window, UINT message, WPARAM wParam, LPARAM lParam)
+{
+    LRESULT result = 0;
+
+    switch (message) {
+    case WM_QUIT:
+    case WM_CLOSE:
+    case WM_DESTROY: {
+        platformState.running = false;
+    } break;
+
+    case WM_SIZE: {
+        platformState.windowWidth = LOWORD(lParam);
+        platformState.windowHeight = HIWORD(lParam);
+
+        if (platformState.projection3DFlag) {
+            set3dProjection(platformState.windowWidth, platformState.windowHeight, 60.f, 1.0f, 500.0f);
+        }
+        else {
+            set2dProjection(platformState.windowWidth, platformState.windowHeight);
+        }
+        glClearColor(platformState.clearColor.r, platformState.clearColor.g, platformState.clearColor.b, platformState.clearColor.a);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    } break;
+
+
+    case WM_MOUSEWHEEL: {
+        i16 wheelDelta = HIWORD(wParam);
+        // wheel rotation is a multiple of WHEEL_DELTA, which is set to 120
+        input.mouseWheelDelta = (i32)wheelDelta / WHEEL_DELTA;
+    } break;
+
+    default: {
+        result = DefWindowProc(window, message, wParam, lParam);
+    } break;
+    }
+
+    return result;
+}
+
+enum { OGL2D, OGL3D };
+void createCanvas(i32 winWidth = 100, i32 winHeight = 100, const char *caption = "Creative Framework", i32 renderContext = OGL2D, b32 fullscreen = false)
+{
+    RECT windowRect;
+    windowRect.left = 0;
+    windowRect.right = winWidth;
+    windowRect.top = 0;
+    windowRect.bottom = winHeight;
+
+    platformState.canvasWidth = platformState.windowWidth = width = winWidth;
+    platformState.canvasHeight = platformState.windowHeight = height = winHeight;
+
+    center = v2(f32(width / 2), f32(height / 2));
+
+    // calculates the required size of the window rectangle, based on the desired client-rectangle size
+    if (AdjustWindowRect(&windowRect, WS_OVERLAPPEDWINDOW, 0)) {
+        winWidth = windowRect.right - windowRect.left;
+        winHeight = windowRect.bottom - windowRect.top;
+    }
+
+    WNDCLASSA windowClass = { 0 };
+    windowClass.style = CS_OWNDC | CS_HREDRAW | CS_VREDRAW;
+    windowClass.lpfnWndProc = windowProc;
+    windowClass.hCursor = LoadCursor(0, IDC_ARROW);
+    windowClass.hbrBackground = (HBRUSH)GetStockObject(BLACK_BRUSH);
+    windowClass.hIcon = (HICON)LoadImage(NULL, "data/icon.ico", IMAGE_ICON, 0, 0, LR_LOADFROMFILE);
+    windowClass.lpszClassName = "creativeFrameworkClass";
+
+    if (RegisterClassA(&windowClass) == 0) {
+        quitError("Failed to initialize window class.");
+    }
+
+    platformState.window = CreateWindowExA(0, windowClass.lpszClassName, caption,
+        WS_OVERLAPPED | WS_MINIMIZEBOX | WS_SYSMENU | WS_VISIBLE, //WS_OVERLAPPEDWINDOW |
+        CW_USEDEFAULT, CW_USEDEFAULT,
+        winWidth, winHeight, 0, 0, 0, 0);
+
+    if (!(platformState.window)) {
+        quitError("Failed to create window.");
+    }
+
+    initOpenGL();
+    if (renderContext == OGL2D)
+        set2dProjection(platformState.windowWidth, platformState.windowHeight);
+    else
+        set3dProjection(platformState.windowWidth, platformState.windowHeight, 60.f, 1.0f, 500.0f);
+
+    buildFont("Verdana", 18);
+
+    if (fullscreen) {
+        toggleFullscreen();
+    }
+
+    // set global variables
+    width = platformState.canvasWidth;
+    height = platformState.canvasHeight;
+
+    platformState.fullscreen = false;
+    platformState.colorModeFlag = RGB;
+    platformState.fillFlag = true;
+    platformState.doubleBufferDisabledFlag = false;
+    platformState.clearColor = { 0, 0, 0, 0 };
+    platformState.strokeColor = { 255, 255, 255, 255 };
+    platformState.fillColor = { 255, 255, 255, 255 };
+    platformState.lineWidth = 1;
+    platformState.rectModeFlag = 0;
+    platformState.milliseconds = 0;
+    platformState.lodModeFlag = 0;
+    platformState.lodPixelsPerSegment = 6.f;
+    platformState.lodHysteresis = 0.2f;
+    platformState.transparencyModeFlag = 0;
+    input.mouseDragged = false;
+    input.mouseMoved = false;
+    randomSeed(GetTickCount());
+
+}
+
+#define WinMainNOCRT void __stdcall WinMainCRTStartup() {
+#ifdef NOCRT
+WinMainNOCRT
+#else
+int WINAPI WinMain(HINSTANCE instance, HINSTANCE prevInstance, LPSTR commandLine, int commandShow)
+{
+#endif
+    setup();
+
+    HDC deviceContext = GetDC(platformState.window);
+    i32 monitorRefreshHz = GetDeviceCaps(deviceContext, VREFRESH);
+
+    // 60hz = 0.0166666675 deltaSecondsPerFrame
+    // 30hz = 0.0333333351 deltaSecondsPerFrame
+    // the time it takes to draw a frame
+    i32 framesPerSecond = 60;
+    if (framesPerSecond)
+        deltaTime = 1.f / (f32)framesPerSecond;
+    else
+        deltaTime = 1.f / (f32)monitorRefreshHz;
+
+    f32 deltaSecondsPerFrame = deltaTime;
+
+    // get the frequency of the performance counter in counts per seconds
+    LARGE_INTEGER frequencyCounterResult;
+    QueryPerformanceFrequency(&frequencyCounterResult);
+    platformState.frequencyCounter = frequencyCounterResult.QuadPart;
+
+    LARGE_INTEGER lastCounter;
+    QueryPerformanceCounter(&lastCounter);
+    i64 initialCounter = lastCounter.QuadPart;
+
+    platformState.lockFPS = true;
+    platformState.running = true;
+
+    // Main loop
+    while (platformState.running) {
+        /* Input */
+        for (int i = 0; i < MOUSE_BUTTONS_COUNT; i++) input.mouseButtons[i].changed = false;
+        input.mouseWheelDelta = 0;
+
+        MSG message;
+        while (PeekMessageA(&message, platformState.window, 0, 0, PM_REMOVE)) {
+            switch (message.message) {
+            case WM_LBUTTONDOWN: {
+                updateMouse(&input.mouseButtons[MOUSE_LEFT], true);
+            } break;
+
+            case WM_LBUTTONUP: {
+                updateMouse(&input.mouseButtons[MOUSE_LEFT], false);
+            } break;
+
+            case WM_MBUTTONDOWN: {
+                updateMouse(&input.mouseButtons[MOUSE_MIDDLE], true);
+            } break;
+
+            case WM_MBUTTONUP: {
+                updateMouse(&input.mouseButtons[MOUSE_MIDDLE], false);
+
+            } break;
+
+            case WM_RBUTTONDOWN: {
+                updateMouse(&input.mouseButtons[MOUSE_RIGHT], true);
+            } break;
+
+            case WM_RBUTTONUP: {
+                updateMouse(&input.mouseButtons[MOUSE_RIGHT], false);
+            } break;
+
+            case WM_SYSKEYDOWN:
+            case WM_SYSKEYUP:
+            case WM_KEYDOWN:
+            case WM_KEYUP: {
+                u32 keyCode = (u32)message.wParam;
+                b32 wasDown = ((message.lParam & (1 << 30)) != 0);
+                b32 isDown = ((message.lParam & (1 << 31)) == 0);
+                b32 altDown = message.lParam & (1 << 29);
+
+                if (keyCode == VK_F4 && altDown) {
+                    platformState.running = false;
+                    break;
+                }
+
+                if (keyCode == VK_RETURN && altDown && isDown && isDown != wasDown) {
+                    if (platformState.fullscreen)
+                        platformState.fullscreen = false;
+                    else
+                        platformState.fullscreen = true;
+                    toggleFullscreen();
+                    break;
+                }
+
+                if (keyCode == VK_ESCAPE) {
+                    platformState.running = false;
+                    break;
+                }
+            } break;
+
+            default: {
+                TranslateMessage(&message);
+                DispatchMessage(&message);
+            }
+            }
+        }
+
+        BYTE keyboard[256];
+        GetKeyboardState(keyboard);
+
+        for (int i = 0; i < KEY_COUNT; i++) {
+            input.prevKeys[i] = input.keys[i];
+            input.keys[i] = keyboard[i] >> 7;
+        }
+
+        // save the mouse coordinates for the previous frame, this is used for mousedrag
+        input.prevMouseX = input.mouseX;
+        input.prevMouseY = input.mouseY;
 
-    KEY_COUNT
-};
+        POINT mouseP;
+        GetCursorPos(&mouseP);
+        ScreenToClient(platformState.window, &mouseP);
 
-enum {
-    MOUSE_LEFT,
-    MOUSE_MIDDLE,
-    MOUSE_RIGHT,
+        // TODO: Fix this so it works when resizing the window
+        i32 aspectX = platformState.windowWidth / platformState.canvasWidth;
+        i32 aspectY = platformState.windowHeight / platformState.canvasHeight;
+        if (aspectX <= 0 || aspectY <= 0) {
+            aspectX = 1;
+            aspectY = 1;
+        }
 
-    MOUSE_BUTTONS_COUNT
-};
+        input.mouseX = mouseX = mouseP.x / aspectX;
+        input.mouseY = mouseY = mouseP.y / aspectX; // NOTE: if BOTTOM up DIB: backBuffer.height-mouseP.y;
 
-enum {
-    GAMEPAD_UP,
-    GAMEPAD_DOWN,
-    GAMEPAD_LEFT,
-    GAMEPAD_RIGHT,
-    GAMEPAD_START,
-    GAMEPAD_BACK,
-    GAMEPAD_LEFT_THUMB,
-    GAMEPAD_RIGHT_THUMB,
-    GAMEPAD_LEFT_SHOULDER,
-    GAMEPAD_RIGHT_SHOULDER,
-    GAMEPAD_A,
-    GAMEPAD_B,
-    GAMEPAD_X,
-    GAMEPAD_Y,
+        if (input.mouseX != input.prevMouseX || input.mouseY != input.prevMouseY)
+            input.mouseMoved = true;
+        else
+            input.mouseMoved = false;
 
-    GAMEPAD_BUTTONS_COUNT
-};
+        if ((input.mouseButtons[0].isDown) && (input.mouseX != input.prevMouseX || input.mouseY != input.prevMouseY))
+            input.mouseDragged = mouseDragged = true;
+        else
+            input.mouseDragged = mouseDragged = false;
 
-typedef struct {
-    f32 leftStickX;
-    f32 leftStickY;
-    f32 rightStickX;
-    f32 rightStickY;
+        XINPUT_STATE controllerState;
+        if (XInputGetState(0, &controllerState) == ERROR_SUCCESS) {
+            XINPUT_GAMEPAD *pad = &controllerState.Gamepad;
+            f32 stickDeadZone = XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE;
 
-    u8 leftTrigger;
-    u8 rightTrigger;
+            input.leftStickX = pad->sThumbLX;
+            input.leftStickX = processStickValue(input.leftStickX, stickDeadZone);
+            input.leftStickY = pad->sThumbLY;
+            input.leftStickY = processStickValue(input.leftStickY, stickDeadZone);
+            input.rightStickX = pad->sThumbRX;
+            input.rightStickX = processStickValue(input.rightStickX, stickDeadZone);
+            input.rightStickY = pad->sThumbRY;
+            input.rightStickY = processStickValue(input.rightStickY, stickDeadZone);
 
-    union {
-        ButtonState gamepadButtons[GAMEPAD_BUTTONS_COUNT];
+            // value between 0 and 255 for the left/right trigger analog control
+            input.leftTrigger = pad->bLeftTrigger;
+            input.rightTrigger = pad->bRightTrigger;
 
-        struct {
-            ButtonState up;
-            ButtonState down;
-            ButtonState left;
-            ButtonState right;
-            ButtonState start;
-            ButtonState back;
-            ButtonState leftThumb;
-            ButtonState rightThumb;
-            ButtonState leftShoulder;
-            ButtonState rightShoulder;
-            ButtonState aButton;
-            ButtonState bButton;
-            ButtonState xButton;
-            ButtonState yButton;
-        };
-    };
+            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_DPAD_UP, &input.up);
+            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_DPAD_DOWN, &input.down);
+            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_DPAD_LEFT, &input.left);
+            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_DPAD_RIGHT, &input.right);
+            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_START, &input.start);
+            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_BACK, &input.back);
+            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_LEFT_THUMB, &input.leftThumb);
+            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_RIGHT_THUMB, &input.rightThumb);
+            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_LEFT_SHOULDER, &input.leftShoulder);
+            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_RIGHT_SHOULDER, &input.rightShoulder);
+            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_A, &input.aButton);
+            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_B, &input.bButton);
+            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_X, &input.xButton);
+            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_Y, &input.yButton);
 
-    b32 keys[KEY_COUNT];
-    b32 prevKeys[KEY_COUNT];
+        }
+        else {
+            // gamepad is not available
+        }
 
-    i32 mouseX;
-    i32 mouseY;
-    i32 prevMouseX;
-    i32 prevMouseY;
-    b32 mouseDragged;
-    b32 mouseMoved;
-    i32 mouseWheelDelta;
-    ButtonState mouseButtons[MOUSE_BUTTONS_COUNT];
-} Input;
+        //
+        // Render
+        //
 
-internal void
-updateGamepadButton(DWORD gamepadState, DWORD buttonBitTest, ButtonState *button)
+        draw();
+        drawTransparent();
+
+        loadIdentity();
+        if (platformState.doubleBufferDisabledFlag)
+            glFlush();
+        else
+            SwapBuffers(deviceContext);
+
+        //
+        // Timing
+        //
+        LARGE_INTEGER endCounter;
+        QueryPerformanceCounter(&endCounter);
+        i64 counterElapsed = endCounter.QuadPart - lastCounter.QuadPart;
+        if (platformState.doubleBufferDisabledFlag) {
+            f32 secondsElapsedForFrame = getSecondsElapsed(lastCounter, endCounter);
+            if (platformState.lockFPS) {
+                if (secondsElapsedForFrame < deltaTime) {
+                    i32 msToSleep = (i32)((deltaTime - secondsElapsedForFrame) * 1000.f);
+                    if (msToSleep > 0)
+                        Sleep(msToSleep);
+
+                    // if there is some time left
+                    while (secondsElapsedForFrame < deltaTime) {
+                        QueryPerformanceCounter(&endCounter);
+                        secondsElapsedForFrame = getSecondsElapsed(lastCounter, endCounter);
+                    }
+                }
+            }
+        }
+    
+        QueryPerformanceCounter(&endCounter);
+        deltaSecondsPerFrame = getSecondsElapsed(lastCounter, endCounter);
+        
+        platformState.milliseconds = (1000.f * (lastCounter.QuadPart - initialCounter) /
+            platformState.frequencyCounter);
+#if 0
+        i64 secondsElapsedSinceStart = (lastCounter.QuadPart - initialCounter) /
+            platformState.frequencyCounter;
+
+        f64 msPerFrame = 1000. * getSecondsElapsed(lastCounter, endCounter);
+        counterElapsed = endCounter.QuadPart - lastCounter.QuadPart;
+        f64 fps = (f64)platformState.frequencyCounter / (f64)counterElapsed;
+
+        static i64 lastTime = 0;
+        if (secondsElapsedSinceStart - lastTime > 1) {
+            debugPrint("seconds=%d, ms=%.05f, dt=%.05f, %.03fms, %.03fFPS\n", secondsElapsedSinceStart, platformState.milliseconds,
+                deltaSecondsPerFrame, msPerFrame, fps);
+            debugPrint("Wheel delta: %d\n", input.mouseWheelDelta);
+            debugPrint("MouseX: %d  MouseY: %d\n", mouseX, mouseY);
+            lastTime = secondsElapsedSinceStart;
+        }
+#else
+        // just to remove warning about unreferenced variable
+        counterElapsed = 0;
+#endif
+
+        QueryPerformanceCounter(&lastCounter);
+        platformState.lodSlot = 0;
+        frameCount++;
+    }
+
+    cleanup();
+
+#ifdef NOCRT
+    ExitProcess(0);
+#else
+    return 0;
+#endif
+}
+
+//
+// Color Functions
+//
+
+void colorMode(i32 mode)
 {
-    b32 isDown = (gamepadState & buttonBitTest);
-    button->changed = isDown != button->isDown;
-    button->isDown = isDown;
+    switch (mode) {
+    case RGB:
+        platformState.colorModeFlag = RGB;
+        break;
+    case HSB:
+        platformState.colorModeFlag = HSB;
+        break;
+    case HSL:
+        platformState.colorModeFlag = HSL;
+        break;
+    }
 }
 
-internal f32
-processStickValue(f32 value, f32 deadZoneThreshold)
+// converts HSB(=HSV) color to RGB color
+Colorf colorHSB(Colorf colorHSB)
 {
-    // return 0 if we got a value that are in the dead zone 
-    f32 result = 0;
+    if (colorHSB.r < 0 || colorHSB.r > 255)
+        colorHSB.r = 0;
+    if (colorHSB.g < 0 || colorHSB.g > 255)
+        colorHSB.g = 0;
+    if (colorHSB.b < 0 || colorHSB.b > 255)
+        colorHSB.b = 0;
 
-    if (value < -deadZoneThreshold) {
-        // NOTE:if we say that the deadszone ends at 0.2, 
-        // this will map the value to 0 - 1 instead of 0.2 - 1
-        result = (value + deadZoneThreshold) / (32768.0f - deadZoneThreshold);
-    }
-    else if (value > deadZoneThreshold) {
-        result = (value - deadZoneThreshold) / (32767.0f - deadZoneThreshold);
+    f32 r = 0, g = 0, b = 0, h, s, v;
+    h = colorHSB.r / 256.0f;
+    s = colorHSB.g / 256.0f;
+    v = colorHSB.b / 256.0f;
+
+    if (s == 0.0)
+        r = g = b = v;
+    else {
+        f32 f, p, q, t;
+        i32 i;
+        h *= 6.0;
+        i = (i32)h;
+        f = h - i;
+        p = v * (1.0f - s);
+        q = v * (1.0f - (s * f));
+        t = v * (1.0f - (s * (1.0f - f)));
+
+        switch (i) {
+        case 0:
+            r = v; g = t; b = p;
+            break;
+        case 1:
+            r = q; g = v; b = p;
+            break;
+        case 2:
+            r = p; g = v; b = t;
+            break;
+        case 3:
+            r = p; g = q; b = v;
+            break;
+        case 4:
+            r = t; g = p; b = v;
+            break;
+        case 5:
+            r = v; g = p; b = q;
+            break;
+        }
     }
 
-    return result;
-}
-
-internal void
-updateMouse(ButtonState *button, b32 isDown)
-{
-    button->changed = isDown != button->isDown;
-    button->isDown = isDown;
+    Colorf col;
+    col.r = r * 255.0f;
+    col.g = g * 255.0f;
+    col.b = b * 255.0f;
+    col.a = 255;
+    return col;
 }
 
-
-//
-// File I/O
-//
-
-//remember to free the memory after you called this function!
-char *loadTextFile(char *filename)
+// converts HSL color to RGB color
+Colorf colorHSL(Colorf colorHSL)
 {
-    char *contents = 0;
-    FILE *file = fopen(filename, "rb");
-
-    if (file)
-    {
-        fseek(file, 0, SEEK_END);				    // go to end of file
-        size_t fileSize = ftell(file);			    // get file size
-        fseek(file, 0, SEEK_SET);				    // go to beginning of file
-        contents = (char *)malloc(fileSize + 1);	// allocate memory for file + 1 byte for null terminator
+    f32 r, g, b, h, s, l;
+    f32 tempCol1, tempCol2, tempRed, tempGreen, tempBlue;
+    h = colorHSL.r / 256.0f;
+    s = colorHSL.g / 256.0f;
+    l = colorHSL.b / 256.0f;
 
-        fread(contents, fileSize, 1, file);		    // read in the file
-        contents[fileSize] = 0;					    // insert the null terminator
+    if (s == 0)
+        r = g = b = l;
+    else {
+        if (l < 0.5)
+            tempCol2 = l * (1 + s);
+        else
+            tempCol2 = (l + s) - (l * s);
 
-        fclose(file);
-    }
-    return contents;
-}
+        tempCol1 = 2 * l - tempCol2;
+        tempRed = h + 1.0f / 3.0f;
 
-void *loadFile(char *filename)
-{
-    FILE *fp = fopen(filename, "r");
-    //move pointer to the end of the file to get length
-    fseek(fp, 0, SEEK_END);
-    long fileSize = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
-    void *contents = (void *)malloc((fileSize) * sizeof(char));
+        if (tempRed > 1)
+            tempRed--;
 
-    //read file
-    fread(contents, 1, fileSize, fp);
-    fclose(fp);
-    return contents;
-}
+        tempGreen = h;
+        tempBlue = h - 1.0f / 3.0f;
 
-//
-// Windows
-//
+        if (tempBlue < 0)
+            tempBlue++;
 
-typedef struct {
-    BITMAPINFO bitmapInfo; // win32 bitmap info structer
-    void *pixels; // pixel memory
-    i32 width, height;
-} BackBuffer;
+        // red
+        if (tempRed < 1.f / 6.f)
+            r = tempCol1 + (tempCol2 - tempCol1) * 6.f * tempRed;
+        else if (tempRed < 0.5f)
+            r = tempCol2;
+        else if (tempRed < 2.f / 3.f)
+            r = tempCol1 + (tempCol2 - tempCol1) * ((2.f / 3.f) - tempRed) * 6.f;
+        else
+            r = tempCol1;
 
-struct PlatformState {
-    b32 running;
-    b32 lockFPS;
-    i64 frequencyCounter;
+        // green
+        if (tempGreen < 1.f / 6.f)
+            g = tempCol1 + (tempCol2 - tempCol1) * 6.f * tempGreen;
+        else if (tempGreen < 0.5)
+            g = tempCol2;
+        else if (tempGreen < 2.f / 3.f)
+            g = tempCol1 + (tempCol2 - tempCol1) * ((2.f / 3.f) - tempGreen) * 6.f;
+        else
+            g = tempCol1;
 
-    HWND window;
-    i32 windowWidth;
-    i32 windowHeight;
-    b32 fullscreen;
-    
-    i32 canvasWidth;
-    i32 canvasHeight;
+        // blue
+        if (tempBlue < 1.0 / 6.0)
+            b = tempCol1 + (tempCol2 - tempCol1) * 6.f * tempBlue;
+        else if (tempBlue < 0.5)
+            b = tempCol2;
+        else if (tempBlue < 2.f / 3.f)
+            b = tempCol1 + (tempCol2 - tempCol1) * ((2.f / 3.f) - tempBlue) * 6.f;
+        else
+            b = tempCol1;
+    }
 
-    // API
-    b32 projection3DFlag; // 2D projection if false
-    i32 colorModeFlag;
-    b32 doubleBufferDisabledFlag; // double buffering on/off
-    b32 fillFlag; // fill flag for shapes
-    i32 lineWidth; // strokeweight	
-    i32 rectModeFlag;
-    Colorf clearColor;
-    Colorf strokeColor;
-    Colorf fillColor;
-    f32 milliseconds;
+    Colorf col;
+    col.r = r * 255.f;
+    col.g = g * 255.f;
+    col.b = b * 255.f;
+    col.a = 255;
+    return col;
+}
 
-    // UI state
-    i32 hotWidget; // widget is below the mouse cursor
-    i32 activeWidget; // user is interacting with the widget
-    i32 keyboardFocus;
-    i32 keyentered;
-    i32 keymod;
-    i32 keychar;
-    i32 lastwidget;
-};
+Colorf checkColorMode(Color inColor)
+{
+    Colorf col = { (f32)inColor.r, (f32)inColor.g, (f32)inColor.b, 255.f };
+    Colorf outColor;
 
-global PlatformState platformState;
-global Input input;
+    if (platformState.colorModeFlag == HSB)
+        outColor = colorHSB(col);
+    else if (platformState.colorModeFlag == HSL)
+        outColor = colorHSL(col);
+    else // RGB
+        outColor = col;
 
-// processing, p5.js global variables
-global i32 width;
-global i32 height;
-global f32 deltaTime; //target seconds per frame
-global u64 frameCount = 0;	// number of frames drawn since program start
-global i32 mouseX;
-global i32 mouseY;
-global b32 mouseDragged;
-global v2 center;
+    return outColor;
+}
 
-void draw();
-void setup();
-void cleanup();
-void initOpenGL();
-void buildFont(const char *fontName, int fontSize);
-void set3dProjection(i32 width, i32 height, f32 fov, f32 nearZ, f32 farZ);
-void set2dProjection(i32 width, i32 height);
 
-internal void
-toggleFullscreen()
+// packs a color into 32 bits with red in the lowest byte, the layout used by drawInstanced()
+u32 packColor(Color col)
 {
-    local WINDOWPLACEMENT windowPosition = { sizeof(windowPosition) };
-    DWORD windowStyleFlags = GetWindowLong(platformState.window, GWL_STYLE);
-    if (windowStyleFlags & WS_OVERLAPPEDWINDOW) {
-        MONITORINFO monitorInfo = { sizeof(monitorInfo) };
-        if (GetWindowPlacement(platformState.window, &windowPosition) &&
-            GetMonitorInfo(MonitorFromWindow(platformState.window, MONITOR_DEFAULTTOPRIMARY), &monitorInfo)) {
-            SetWindowLong(platformState.window, GWL_STYLE, windowStyleFlags & ~WS_OVERLAPPEDWINDOW);
-            SetWindowPos(platformState.window, HWND_TOP,
-                monitorInfo.rcMonitor.left, monitorInfo.rcMonitor.top,
-                monitorInfo.rcMonitor.right - monitorInfo.rcMonitor.left,
-                monitorInfo.rcMonitor.bottom - monitorInfo.rcMonitor.top,
-                SWP_NOOWNERZORDER | SWP_FRAMECHANGED);
-        }
-    }
-    else {
-        SetWindowLong(platformState.window, GWL_STYLE, windowStyleFlags | WS_OVERLAPPEDWINDOW);
-        SetWindowPlacement(platformState.window, &windowPosition);
-        SetWindowPos(platformState.window, 0, 0, 0, 0, 0,
-            SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER |
-            SWP_NOOWNERZORDER | SWP_FRAMECHANGED);
-    }
+    Colorf c = checkColorMode(col);
+    u32 result = ((u32)constrain(col.a, 0, 255) << 24) | ((u32)constrain((i32)c.b, 0, 255) << 16) |
+        ((u32)constrain((i32)c.g, 0, 255) << 8) | (u32)constrain((i32)c.r, 0, 255);
+    return result;
 }
 
-void setWindowTitle(const char *title)
+u32 packColor(i32 r, i32 g, i32 b, i32 a = 255)
 {
-    SetWindowTextA(platformState.window, title);
+    Color col = { r, g, b, a };
+    return packColor(col);
 }
 
-inline f32
-getSecondsElapsed(LARGE_INTEGER start, LARGE_INTEGER end)
+// the fill color packed the same way as packColor()
+internal u32
+fillColorPacked()
 {
-    f32 result = ((f32)(end.QuadPart - start.QuadPart) / (f32)platformState.frequencyCounter);
-    //f64 result = ((end.QuadPart - start.QuadPart) / (f64)platformState.frequencyCounter);
-    return result;
+    Colorf *f = &platformState.fillColor;
+    return ((u32)(constrainf(f->a, 0.f, 1.f) * 255.f) << 24) | ((u32)(constrainf(f->b, 0.f, 1.f) * 255.f) << 16) |
+        ((u32)(constrainf(f->g, 0.f, 1.f) * 255.f) << 8) | (u32)(constrainf(f->r, 0.f, 1.f) * 255.f);
 }
 
+//
+// OpenGL API
+//
 
-internal LRESULT CALLBACK
-windowProc(HWND window, UINT message, WPARAM wParam, LPARAM lParam)
+void initOpenGL()
 {
-    LRESULT result = 0;
+    HDC deviceContext = GetDC(platformState.window);
 
-    switch (message) {
-    case WM_QUIT:
-    case WM_CLOSE:
-    case WM_DESTROY: {
-        platformState.running = false;
-    } break;
+    // define the pixelformat for OpenGL, double buffering and RGBA
+    PIXELFORMATDESCRIPTOR pfd = { 0 };
+    pfd.nSize = sizeof(pfd);
+    pfd.nVersion = 1;
+    pfd.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER;
+    pfd.iPixelType = PFD_TYPE_RGBA;
+    pfd.cColorBits = 32; // bits per pixel
+    //pfd.cStencilBits = 8
+    //pfd.cAlphaBits = 8;  // NOTE: is this needed?
+    //pfd.cDepthBits = 16; // depth of the z-buffer Needed for 3d?
+    pfd.dwLayerMask = PFD_MAIN_PLANE; // sets the pfd to be the main drawing plane
 
-    case WM_SIZE: {
-        platformState.windowWidth = LOWORD(lParam);
-        platformState.windowHeight = HIWORD(lParam);
+    // get the best matching pixel format
+    i32 pixelFormatIndex = ChoosePixelFormat(deviceContext, &pfd);
 
-        if (platformState.projection3DFlag) {
-            set3dProjection(platformState.windowWidth, platformState.windowHeight, 60.f, 1.0f, 500.0f);
-        }
-        else {
-            set2dProjection(platformState.windowWidth, platformState.windowHeight);
-        }
-        glClearColor(platformState.clearColor.r, platformState.clearColor.g, platformState.clearColor.b, platformState.clearColor.a);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    } break;
+    // NOTE: is this needed?
+    PIXELFORMATDESCRIPTOR pixelFormat;
+    DescribePixelFormat(deviceContext, pixelFormatIndex,
+        sizeof(pixelFormat), &pixelFormat);
 
+    // try to set the pixel format on the window
+    SetPixelFormat(deviceContext, pixelFormatIndex, &pixelFormat);
+    //SetPixelFormat(deviceContext, pixelFormatIndex, &pfd);
 
-    case WM_MOUSEWHEEL: {
-        i16 wheelDelta = HIWORD(wParam);
-        // wheel rotation is a multiple of WHEEL_DELTA, which is set to 120
-        input.mouseWheelDelta = (i32)wheelDelta / WHEEL_DELTA;
-    } break;
+    // create a opengl rendering context
+    HGLRC openGLRC = wglCreateContext(deviceContext);
 
-    default: {
-        result = DefWindowProc(window, message, wParam, lParam);
-    } break;
+    // makes the specified OpenGL rendering context the calling thread's current rendering context
+    if (wglMakeCurrent(deviceContext, openGLRC) == 0) {
+        // NOTE: the program won't crash if the other OpenGL calls would fail so we can
+        // safely catch the error here
+        quitError("Failed to create OpenGL rendering context.");
     }
-
-    return result;
 }
 
-enum { OGL2D, OGL3D };
-void createCanvas(i32 winWidth = 100, i32 winHeight = 100, const char *caption = "Creative Framework", i32 renderContext = OGL2D, b32 fullscreen = false)
+
+u32	base;								// font base display list
+void buildFont(const char *fontName, int fontSize)
 {
-    RECT windowRect;
-    windowRect.left = 0;
-    windowRect.right = winWidth;
-    windowRect.top = 0;
-    windowRect.bottom = winHeight;
+    HFONT font;
+    base = glGenLists(96);
 
-    platformState.canvasWidth = platformState.windowWidth = width = winWidth;
-    platformState.canvasHeight = platformState.windowHeight = height = winHeight;
+    font = CreateFont(-fontSize,		// font height, negative number = get a font based on the character height
+        0,								// font width
+        0,								// angle of escapement
+        0,								// orientation angle
+        FW_BOLD,						// font weight
+        FALSE,							// italic
+        FALSE,							// underline
+        FALSE,							// strikeout
+        ANSI_CHARSET,					// character set identifier
+        OUT_TT_PRECIS,					// output precision, true type
+        CLIP_DEFAULT_PRECIS,			// clipping precision
+        ANTIALIASED_QUALITY,			// output quality
+        FF_DONTCARE | DEFAULT_PITCH,	// family and pitch
+        fontName);						// font name
 
-    center = v2(f32(width / 2), f32(height / 2));
+    HDC dc = GetDC(platformState.window);
+    SelectObject(dc, font);
+    // create 96 characters, starting at character 32
+    wglUseFontBitmaps(dc, 32, 96, base);
+    ReleaseDC(platformState.window, dc);
+}
 
-    // calculates the required size of the window rectangle, based on the desired client-rectangle size
-    if (AdjustWindowRect(&windowRect, WS_OVERLAPPEDWINDOW, 0)) {
-        winWidth = windowRect.right - windowRect.left;
-        winHeight = windowRect.bottom - windowRect.top;
-    }
+void freeFont()
+{
+    if (base != 0)
+        glDeleteLists(base, 96);
+}
 
-    WNDCLASSA windowClass = { 0 };
-    windowClass.style = CS_OWNDC | CS_HREDRAW | CS_VREDRAW;
-    windowClass.lpfnWndProc = windowProc;
-    windowClass.hCursor = LoadCursor(0, IDC_ARROW);
-    windowClass.hbrBackground = (HBRUSH)GetStockObject(BLACK_BRUSH);
-    windowClass.hIcon = (HICON)LoadImage(NULL, "data/icon.ico", IMAGE_ICON, 0, 0, LR_LOADFROMFILE);
-    windowClass.lpszClassName = "creativeFrameworkClass";
+void text(int xPos, int yPos, const char *str, ...)
+{
+    flushMatrix();
+    if ((base == 0) || (!str))
+        return;
 
-    if (RegisterClassA(&windowClass) == 0) {
-        quitError("Failed to initialize window class.");
-    }
+    va_list	args;
+    char buffer[256];
 
-    platformState.window = CreateWindowExA(0, windowClass.lpszClassName, caption,
-        WS_OVERLAPPED | WS_MINIMIZEBOX | WS_SYSMENU | WS_VISIBLE, //WS_OVERLAPPEDWINDOW |
-        CW_USEDEFAULT, CW_USEDEFAULT,
-        winWidth, winHeight, 0, 0, 0, 0);
+    va_start(args, str);
+    vsprintf(buffer, str, args);
+    va_end(args);
 
-    if (!(platformState.window)) {
-        quitError("Failed to create window.");
-    }
+    glRasterPos2i(xPos, yPos);
 
-    initOpenGL();
-    if (renderContext == OGL2D)
-        set2dProjection(platformState.windowWidth, platformState.windowHeight);
-    else
-        set3dProjection(platformState.windowWidth, platformState.windowHeight, 60.f, 1.0f, 500.0f);
+    glPushAttrib(GL_LIST_BIT);
 
-    buildFont("Verdana", 18);
+    // starting at character 32
+    glListBase(base - 32);
+    glCallLists((int)strlen(buffer), GL_UNSIGNED_BYTE, buffer);
+    glPopAttrib();
+}
 
-    if (fullscreen) {
-        toggleFullscreen();
-    }
 
-    // set global variables
-    width = platformState.canvasWidth;
-    height = platformState.canvasHeight;
+void disableDoubleBuffer()
+{
+    platformState.doubleBufferDisabledFlag = true;
+    glDrawBuffer(GL_FRONT);
+}
 
-    platformState.fullscreen = false;
-    platformState.colorModeFlag = RGB;
-    platformState.fillFlag = true;
+void enableDoubleBuffer()
+{
     platformState.doubleBufferDisabledFlag = false;
-    platformState.clearColor = { 0, 0, 0, 0 };
-    platformState.strokeColor = { 255, 255, 255, 255 };
-    platformState.fillColor = { 255, 255, 255, 255 };
-    platformState.lineWidth = 1;
-    platformState.rectModeFlag = 0;
-    platformState.milliseconds = 0;
-    input.mouseDragged = false;
-    input.mouseMoved = false;
-    randomSeed(GetTickCount());
-    randomGenerator.seed(GetTickCount());
-
+    glDrawBuffer(GL_FRONT_AND_BACK);
 }
 
-#define WinMainNOCRT void __stdcall WinMainCRTStartup() {
-#ifdef NOCRT
-WinMainNOCRT
-#else
-int WINAPI WinMain(HINSTANCE instance, HINSTANCE prevInstance, LPSTR commandLine, int commandShow)
+void set2dProjection(i32 windowWidth = platformState.windowWidth, i32 windowHeight = platformState.windowHeight)
 {
-#endif
-    setup();
-
-    HDC deviceContext = GetDC(platformState.window);
-    i32 monitorRefreshHz = GetDeviceCaps(deviceContext, VREFRESH);
-
-    // 60hz = 0.0166666675 deltaSecondsPerFrame
-    // 30hz = 0.0333333351 deltaSecondsPerFrame
-    // the time it takes to draw a frame
-    i32 framesPerSecond = 60;
-    if (framesPerSecond)
-        deltaTime = 1.f / (f32)framesPerSecond;
-    else
-        deltaTime = 1.f / (f32)monitorRefreshHz;
-
-    f32 deltaSecondsPerFrame = deltaTime;
-
-    // get the frequency of the performance counter in counts per seconds
-    LARGE_INTEGER frequencyCounterResult;
-    QueryPerformanceFrequency(&frequencyCounterResult);
-    platformState.frequencyCounter = frequencyCounterResult.QuadPart;
-
-    LARGE_INTEGER lastCounter;
-    QueryPerformanceCounter(&lastCounter);
-    i64 initialCounter = lastCounter.QuadPart;
+    drawTransparent();
+    glViewport(0, 0, windowWidth, windowHeight);
 
-    platformState.lockFPS = true;
-    platformState.running = true;
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
 
-    // Main loop
-    while (platformState.running) {
-        /* Input */
-        for (int i = 0; i < MOUSE_BUTTONS_COUNT; i++) input.mouseButtons[i].changed = false;
-        input.mouseWheelDelta = 0;
+    glOrtho(0, platformState.canvasWidth, platformState.canvasHeight, 0, -1, 1);
 
-        MSG message;
-        while (PeekMessageA(&message, platformState.window, 0, 0, PM_REMOVE)) {
-            switch (message.message) {
-            case WM_LBUTTONDOWN: {
-                updateMouse(&input.mouseButtons[MOUSE_LEFT], true);
-            } break;
+    glMatrixMode(GL_MODELVIEW);
+    loadIdentity();
 
-            case WM_LBUTTONUP: {
-                updateMouse(&input.mouseButtons[MOUSE_LEFT], false);
-            } break;
+    glDisable(GL_DEPTH_TEST);
+    platformState.projection3DFlag = false;
 
-            case WM_MBUTTONDOWN: {
-                updateMouse(&input.mouseButtons[MOUSE_MIDDLE], true);
-            } break;
+    // blending
+    glEnable(GL_BLEND);
+    // color = (a*source)+(b*dest)
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
 
-            case WM_MBUTTONUP: {
-                updateMouse(&input.mouseButtons[MOUSE_MIDDLE], false);
+// set orthographic projection
+// objects with the same dimension appear the same size, regardless of 
+// whether they are near or far from the camera
+void ortho(f32 left = 0.f, f32 right = platformState.canvasWidth, f32 bottom = platformState.canvasHeight, f32 top = 0.f, f32 nearZ = 0.0f, f32 farZ = 500.f)
+{
+    drawTransparent();
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
 
-            } break;
+    glOrtho(left, right, bottom, top, nearZ, farZ);
 
-            case WM_RBUTTONDOWN: {
-                updateMouse(&input.mouseButtons[MOUSE_RIGHT], true);
-            } break;
+    glMatrixMode(GL_MODELVIEW);
+    loadIdentity();
 
-            case WM_RBUTTONUP: {
-                updateMouse(&input.mouseButtons[MOUSE_RIGHT], false);
-            } break;
+    glDisable(GL_DEPTH_TEST);
+    platformState.projection3DFlag = false;
+}
 
-            case WM_SYSKEYDOWN:
-            case WM_SYSKEYUP:
-            case WM_KEYDOWN:
-            case WM_KEYUP: {
-                u32 keyCode = (u32)message.wParam;
-                b32 wasDown = ((message.lParam & (1 << 30)) != 0);
-                b32 isDown = ((message.lParam & (1 << 31)) == 0);
-                b32 altDown = message.lParam & (1 << 29);
+// multiplies the current matrix with a perspective projection, fov is the vertical field of view in degrees.
+// not frustum(), Processing's frustum() takes the left, right, bottom and top planes
+void perspectiveFrustum(f32 fov, f32 aspect, f32 nearZ, f32 farZ)
+{
+    f32 top = nearZ * tanf(radians(fov) * 0.5f);
+    f32 right = top * aspect;
+    glFrustum(-right, right, -top, top, nearZ, farZ);
+}
 
-                if (keyCode == VK_F4 && altDown) {
-                    platformState.running = false;
-                    break;
-                }
+// set perspective projection
+void set3dProjection(i32 windowWidth = platformState.windowWidth, i32 windowHeight = platformState.windowHeight, f32 fov = 60.f, f32 nearZ = 1.0f, f32 farZ = 500.0f)
+{
+    // prevent divide by zero
+    if (!windowHeight) return;
+    drawTransparent();
 
-                if (keyCode == VK_RETURN && altDown && isDown && isDown != wasDown) {
-                    if (platformState.fullscreen)
-                        platformState.fullscreen = false;
-                    else
-                        platformState.fullscreen = true;
-                    toggleFullscreen();
-                    break;
-                }
+    f32 aspect = (f32)platformState.canvasWidth / (f32)platformState.canvasHeight;
 
-                if (keyCode == VK_ESCAPE) {
-                    platformState.running = false;
-                    break;
-                }
-            } break;
+    glViewport(0, 0, windowWidth, windowHeight);
 
-            default: {
-                TranslateMessage(&message);
-                DispatchMessage(&message);
-            }
-            }
-        }
+    // center
+    //glViewport(windowWidth / 4.f, windowHeight / 4.f, windowWidth / 2.f, windowHeight / 2.f);
 
-        BYTE keyboard[256];
-        GetKeyboardState(keyboard);
+    // switch to the projection matrix and reset it
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
 
-        for (int i = 0; i < KEY_COUNT; i++) {
-            input.prevKeys[i] = input.keys[i];
-            input.keys[i] = keyboard[i] >> 7;
-        }
+    // set camera perspective
+    perspectiveFrustum(fov,		// camera angle, field of view in degrees, set to 45 degrees viewing angle
+        aspect,			// aspect ratio
+        nearZ,			// near z clipping coordinate
+        farZ);			// far z clipping coordinate, start and end point for how deep we can draw into the screen
 
-        // save the mouse coordinates for the previous frame, this is used for mousedrag
-        input.prevMouseX = input.mouseX;
-        input.prevMouseY = input.mouseY;
+    // switch to GL_MODELVIEW, tells OGL that all future transformations will affect what we draw
+    // reset the modelview matrix, wich is where the object information is stored, sets x,y,z to zero
+    glMatrixMode(GL_MODELVIEW);
+    loadIdentity();
 
-        POINT mouseP;
-        GetCursorPos(&mouseP);
-        ScreenToClient(platformState.window, &mouseP);
+    // enable depth buffer
+    glEnable(GL_DEPTH_TEST);
 
-        // TODO: Fix this so it works when resizing the window
-        i32 aspectX = platformState.windowWidth / platformState.canvasWidth;
-        i32 aspectY = platformState.windowHeight / platformState.canvasHeight;
-        if (aspectX <= 0 || aspectY <= 0) {
-            aspectX = 1;
-            aspectY = 1;
-        }
+    glShadeModel(GL_SMOOTH);
+    // meshes are drawn scaled, keep the normals unit length for lighting
+    glEnable(GL_NORMALIZE);
+    glHint(GL_PERSPECTIVE_CORRECTION_HINT, GL_NICEST);
 
-        input.mouseX = mouseX = mouseP.x / aspectX;
-        input.mouseY = mouseY = mouseP.y / aspectX; // NOTE: if BOTTOM up DIB: backBuffer.height-mouseP.y;
+    //NOTE: this has been turned on by set2dProjection
+    glDisable(GL_BLEND);
+    platformState.projection3DFlag = true;
+}
 
-        if (input.mouseX != input.prevMouseX || input.mouseY != input.prevMouseY)
-            input.mouseMoved = true;
-        else
-            input.mouseMoved = false;
+// set perspective projection
+void perspective(f32 fov, f32 aspect, f32 nearZ, f32 farZ)
+{
+    drawTransparent();
+    // switch to the projection matrix and reset it
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
 
-        if ((input.mouseButtons[0].isDown) && (input.mouseX != input.prevMouseX || input.mouseY != input.prevMouseY))
-            input.mouseDragged = mouseDragged = true;
-        else
-            input.mouseDragged = mouseDragged = false;
+    // set camera perspective
+    perspectiveFrustum(fov,		// camera angle, field of view in degrees, set to 45 degrees viewing angle
+        aspect,			// aspect ratio
+        nearZ,			// near z clipping coordinate
+        farZ);			// far z clipping coordinate, start and end point for how deep we can draw into the screen
 
-        XINPUT_STATE controllerState;
-        if (XInputGetState(0, &controllerState) == ERROR_SUCCESS) {
-            XINPUT_GAMEPAD *pad = &controllerState.Gamepad;
-            f32 stickDeadZone = XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE;
+    // switch to GL_MODELVIEW, tells OGL that all future transformations will affect what we draw
+    // reset the modelview matrix, wich is where the object information is stored, sets x,y,z to zero
+    glMatrixMode(GL_MODELVIEW);
+    loadIdentity();
 
-            input.leftStickX = pad->sThumbLX;
-            input.leftStickX = processStickValue(input.leftStickX, stickDeadZone);
-            input.leftStickY = pad->sThumbLY;
-            input.leftStickY = processStickValue(input.leftStickY, stickDeadZone);
-            input.rightStickX = pad->sThumbRX;
-            input.rightStickX = processStickValue(input.rightStickX, stickDeadZone);
-            input.rightStickY = pad->sThumbRY;
-            input.rightStickY = processStickValue(input.rightStickY, stickDeadZone);
+    // enable depth buffer
+    //glEnable(GL_DEPTH_TEST);
+    // don't calculate inside of objects
+    //glEnable(GL_CULL_FACE);		
+    // counter clock-wise polygons face out
+    //glFrontFace(GL_CCW);
+    platformState.projection3DFlag = true;
+}
 
-            // value between 0 and 255 for the left/right trigger analog control
-            input.leftTrigger = pad->bLeftTrigger;
-            input.rightTrigger = pad->bRightTrigger;
+// Color
 
-            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_DPAD_UP, &input.up);
-            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_DPAD_DOWN, &input.down);
-            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_DPAD_LEFT, &input.left);
-            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_DPAD_RIGHT, &input.right);
-            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_START, &input.start);
-            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_BACK, &input.back);
-            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_LEFT_THUMB, &input.leftThumb);
-            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_RIGHT_THUMB, &input.rightThumb);
-            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_LEFT_SHOULDER, &input.leftShoulder);
-            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_RIGHT_SHOULDER, &input.rightShoulder);
-            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_A, &input.aButton);
-            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_B, &input.bButton);
-            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_X, &input.xButton);
-            updateGamepadButton(pad->wButtons, XINPUT_GAMEPAD_Y, &input.yButton);
+// clear screen and depth buffers
+inline void background(Color col, i32 alpha = 255)
+{
+    Colorf newColor = checkColorMode(col);
+    f32 r = newColor.r / 255.f;
+    f32 g = newColor.g / 255.f;
+    f32 b = newColor.b / 255.f;
+    f32 a = (f32)alpha / 255.f;
+    platformState.clearColor = { r, g, b, a };
 
-        }
-        else {
-            // gamepad is not available
-        }
+    glClearColor(r, g, b, a);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
 
-        //
-        // Render
-        //
+inline void background(i32 inColor, i32 alpha = 255)
+{
+    Color col = { inColor, inColor, inColor, alpha };
+    background(col);
+}
 
-        draw();
+inline void background(i32 r, i32 g, i32 b, i32 a = 255)
+{
+    Color col = { r, g, b, a };
+    background(col);
+}
 
-        glLoadIdentity();
-        if (platformState.doubleBufferDisabledFlag)
-            glFlush();
-        else
-            SwapBuffers(deviceContext);
+inline void clear(Color col, i32 alpha = 255)
+{
+    background(col, alpha);
+}
 
-        //
-        // Timing
-        //
-        LARGE_INTEGER endCounter;
-        QueryPerformanceCounter(&endCounter);
-        i64 counterElapsed = endCounter.QuadPart - lastCounter.QuadPart;
-        if (platformState.doubleBufferDisabledFlag) {
-            f32 secondsElapsedForFrame = getSecondsElapsed(lastCounter, endCounter);
-            if (platformState.lockFPS) {
-                if (secondsElapsedForFrame < deltaTime) {
-                    i32 msToSleep = (i32)((deltaTime - secondsElapsedForFrame) * 1000.f);
-                    if (msToSleep > 0)
-                        Sleep(msToSleep);
+inline void clear(i32 inColor, i32 alpha = 255)
+{
+    background(inColor, alpha);
+}
 
-                    // if there is some time left
-                    while (secondsElapsedForFrame < deltaTime) {
-                        QueryPerformanceCounter(&endCounter);
-                        secondsElapsedForFrame = getSecondsElapsed(lastCounter, endCounter);
-                    }
-                }
-            }
-        }
-    
-        QueryPerformanceCounter(&endCounter);
-        deltaSecondsPerFrame = getSecondsElapsed(lastCounter, endCounter);
-        
-        platformState.milliseconds = (1000.f * (lastCounter.QuadPart - initialCounter) /
-            platformState.frequencyCounter);
-#if 0
-        i64 secondsElapsedSinceStart = (lastCounter.QuadPart - initialCounter) /
-            platformState.frequencyCounter;
+inline void clear(i32 r, i32 g, i32 b, i32 a = 255)
+{
+    background(r, g, b, a);
+}
 
-        f64 msPerFrame = 1000. * getSecondsElapsed(lastCounter, endCounter);
-        counterElapsed = endCounter.QuadPart - lastCounter.QuadPart;
-        f64 fps = (f64)platformState.frequencyCounter / (f64)counterElapsed;
+inline void pointSize(f32 value)
+{
+    glPointSize(value);
+}
 
-        static i64 lastTime = 0;
-        if (secondsElapsedSinceStart - lastTime > 1) {
-            debugPrint("seconds=%d, ms=%.05f, dt=%.05f, %.03fms, %.03fFPS\n", secondsElapsedSinceStart, platformState.milliseconds,
-                deltaSecondsPerFrame, msPerFrame, fps);
-            debugPrint("Wheel delta: %d\n", input.mouseWheelDelta);
-            debugPrint("MouseX: %d  MouseY: %d\n", mouseX, mouseY);
-            lastTime = secondsElapsedSinceStart;
-        }
-#else
-        // just to remove warning about unreferenced variable
-        counterElapsed = 0;
-#endif
+inline void noStroke()
+{
+    platformState.lineWidth = 0;
+    glLineWidth(1);
+}
 
-        QueryPerformanceCounter(&lastCounter);
-        frameCount++;
-    }
+inline void strokeWeight(i32 value)
+{
+    platformState.lineWidth = value;
+    glLineWidth((f32)value);
+    glPointSize((f32)value);
+}
 
-    cleanup();
+inline void stroke(Color col, i32 alpha = 255)
+{
+    Colorf newColor = checkColorMode(col);
+    f32 r = newColor.r / 255.f;
+    f32 g = newColor.g / 255.f;
+    f32 b = newColor.b / 255.f;
+    f32 a = (f32)alpha / 255.f;
 
-#ifdef NOCRT
-    ExitProcess(0);
-#else
-    return 0;
-#endif
+    platformState.strokeColor = { r, g, b, a };
+    glColor4f(platformState.strokeColor.r, platformState.strokeColor.g, platformState.strokeColor.b, platformState.strokeColor.a);
 }
 
-//
-// Color Functions
-//
+inline void stroke(i32 inColor, i32 alpha = 255)
+{
+    Color col = { inColor, inColor, inColor, alpha };
+    stroke(col);
+}
 
-void colorMode(i32 mode)
+inline void stroke(i32 r, i32 g, i32 b, i32 a = 255)
 {
-    switch (mode) {
-    case RGB:
-        platformState.colorModeFlag = RGB;
-        break;
-    case HSB:
-        platformState.colorModeFlag = HSB;
-        break;
-    case HSL:
-        platformState.colorModeFlag = HSL;
-        break;
-    }
+    Color col = { r, g, b, a };
+    stroke(col);
 }
 
-// converts HSB(=HSV) color to RGB color
-Colorf colorHSB(Colorf colorHSB)
+inline void noFill()
 {
-    if (colorHSB.r < 0 || colorHSB.r > 255)
-        colorHSB.r = 0;
-    if (colorHSB.g < 0 || colorHSB.g > 255)
-        colorHSB.g = 0;
-    if (colorHSB.b < 0 || colorHSB.b > 255)
-        colorHSB.b = 0;
+    platformState.fillFlag = false;
+    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+}
 
-    f32 r = 0, g = 0, b = 0, h, s, v;
-    h = colorHSB.r / 256.0f;
-    s = colorHSB.g / 256.0f;
-    v = colorHSB.b / 256.0f;
+inline void fill(Color col)
+{
+    platformState.fillFlag = true;
+    //if (platformState.colorModeFlag == HSB)
+    Colorf newColor = checkColorMode(col);
+    f32 r = newColor.r / 255.0f;
+    f32 g = newColor.g / 255.0f;
+    f32 b = newColor.b / 255.0f;
+    f32 a = (f32)col.a / 255.0f;
 
-    if (s == 0.0)
-        r = g = b = v;
-    else {
-        f32 f, p, q, t;
-        i32 i;
-        h *= 6.0;
-        i = (i32)h;
-        f = h - i;
-        p = v * (1.0f - s);
-        q = v * (1.0f - (s * f));
-        t = v * (1.0f - (s * (1.0f - f)));
+    platformState.fillColor = { r, g, b, a };
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+}
 
-        switch (i) {
-        case 0:
-            r = v; g = t; b = p;
-            break;
-        case 1:
-            r = q; g = v; b = p;
-            break;
-        case 2:
-            r = p; g = v; b = t;
-            break;
-        case 3:
-            r = p; g = q; b = v;
-            break;
-        case 4:
-            r = t; g = p; b = v;
-            break;
-        case 5:
-            r = v; g = p; b = q;
-            break;
-        }
-    }
+inline void fill(i32 r, i32 g, i32 b, i32 a = 255)
+{
+    Color col = { r, g, b, a };
+    fill(col);
+}
 
-    Colorf col;
-    col.r = r * 255.0f;
-    col.g = g * 255.0f;
-    col.b = b * 255.0f;
-    col.a = 255;
-    return col;
+inline void fill(Color col, i32 alpha)
+{
+    col.a = alpha;
+    fill(col);
 }
 
-// converts HSL color to RGB color
-Colorf colorHSL(Colorf colorHSL)
+inline void fill(i32 col, i32 alpha = 255)
 {
-    f32 r, g, b, h, s, l;
-    f32 tempCol1, tempCol2, tempRed, tempGreen, tempBlue;
-    h = colorHSL.r / 256.0f;
-    s = colorHSL.g / 256.0f;
-    l = colorHSL.b / 256.0f;
+    Color color = { col, col, col, alpha };
+    fill(color);
+}
 
-    if (s == 0)
-        r = g = b = l;
-    else {
-        if (l < 0.5)
-            tempCol2 = l * (1 + s);
-        else
-            tempCol2 = (l + s) - (l * s);
 
-        tempCol1 = 2 * l - tempCol2;
-        tempRed = h + 1.0f / 3.0f;
+// 2D drawing
 
-        if (tempRed > 1)
-            tempRed--;
+enum { CENTER = 1 };
+inline void rectMode(const i32 mode)
+{
+    platformState.rectModeFlag = mode;
+}
 
-        tempGreen = h;
-        tempBlue = h - 1.0f / 3.0f;
+inline void line(i32 x0, i32 y0, i32 x1, i32 y1)
+{
+    flushMatrix();
+    glColor4f(platformState.strokeColor.r, platformState.strokeColor.g, platformState.strokeColor.b, platformState.strokeColor.a);
+    glBegin(GL_LINES);
+    glVertex2i(x0, y0);
+    glVertex2i(x1, y1);
+    glEnd();
+}
 
-        if (tempBlue < 0)
-            tempBlue++;
+inline void line(f32 x0, f32 y0, f32 x1, f32 y1)
+{
+    line((i32)x0, (i32)y0, (i32)x1, (i32)y1);
+}
 
-        // red
-        if (tempRed < 1.f / 6.f)
-            r = tempCol1 + (tempCol2 - tempCol1) * 6.f * tempRed;
-        else if (tempRed < 0.5f)
-            r = tempCol2;
-        else if (tempRed < 2.f / 3.f)
-            r = tempCol1 + (tempCol2 - tempCol1) * ((2.f / 3.f) - tempRed) * 6.f;
-        else
-            r = tempCol1;
+inline void point(i32 x, i32 y)
+{
+    flushMatrix();
+    glColor4f(platformState.strokeColor.r, platformState.strokeColor.g, platformState.strokeColor.b, platformState.strokeColor.a);
+    glBegin(GL_POINTS);
+    glVertex2i(x, y);
+    glEnd();
+}
 
-        // green
-        if (tempGreen < 1.f / 6.f)
-            g = tempCol1 + (tempCol2 - tempCol1) * 6.f * tempGreen;
-        else if (tempGreen < 0.5)
-            g = tempCol2;
-        else if (tempGreen < 2.f / 3.f)
-            g = tempCol1 + (tempCol2 - tempCol1) * ((2.f / 3.f) - tempGreen) * 6.f;
-        else
-            g = tempCol1;
+inline void point(f32 x, f32 y, f32 z)
+{
+    flushMatrix();
+    glColor4f(platformState.strokeColor.r, platformState.strokeColor.g, platformState.strokeColor.b, platformState.strokeColor.a);
+    glBegin(GL_POINTS);
+    glVertex3f(x, y, z);
+    glEnd();
+}
 
-        // blue
-        if (tempBlue < 1.0 / 6.0)
-            b = tempCol1 + (tempCol2 - tempCol1) * 6.f * tempBlue;
-        else if (tempBlue < 0.5)
-            b = tempCol2;
-        else if (tempBlue < 2.f / 3.f)
-            b = tempCol1 + (tempCol2 - tempCol1) * ((2.f / 3.f) - tempBlue) * 6.f;
-        else
-            b = tempCol1;
+// draws the points projectPoints() marked visible, in 2d. runs of visible points go to OpenGL as one draw
+void points(const v2 *positions, const u32 *visible, i32 count)
+{
+    flushMatrix();
+    glColor4f(platformState.strokeColor.r, platformState.strokeColor.g, platformState.strokeColor.b, platformState.strokeColor.a);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(2, GL_FLOAT, sizeof(v2), positions);
+    i32 first = -1;
+    for (i32 i = 0; i <= count; i++) {
+        b32 on = i < count && pointVisible(visible, i);
+        if (on && first < 0) {
+            first = i;
+        } else if (!on && first >= 0) {
+            glDrawArrays(GL_POINTS, first, i - first);
+            first = -1;
+        }
     }
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
 
-    Colorf col;
-    col.r = r * 255.f;
-    col.g = g * 255.f;
-    col.b = b * 255.f;
-    col.a = 255;
-    return col;
+// draws every vector in the array as a point
+inline void points(const v2Array *a)
+{
+    flushMatrix();
+    glColor4f(platformState.strokeColor.r, platformState.strokeColor.g, platformState.strokeColor.b, platformState.strokeColor.a);
+    glBegin(GL_POINTS);
+    for (i32 i = 0; i < a->count; i++)
+        glVertex2f(a->x[i], a->y[i]);
+    glEnd();
 }
 
-Colorf checkColorMode(Color inColor)
+inline void points(const v3Array *a)
 {
-    Colorf col = { (f32)inColor.r, (f32)inColor.g, (f32)inColor.b, 255.f };
-    Colorf outColor;
+    flushMatrix();
+    glColor4f(platformState.strokeColor.r, platformState.strokeColor.g, platformState.strokeColor.b, platformState.strokeColor.a);
+    glBegin(GL_POINTS);
+    for (i32 i = 0; i < a->count; i++)
+        glVertex3f(a->x[i], a->y[i], a->z[i]);
+    glEnd();
+}
 
-    if (platformState.colorModeFlag == HSB)
-        outColor = colorHSB(col);
-    else if (platformState.colorModeFlag == HSL)
-        outColor = colorHSL(col);
-    else // RGB
-        outColor = col;
+inline void rect(i32 x, i32 y, i32 w, i32 h)
+{
+    flushMatrix();
+    //glRectf(50.0f, 50.0f, 25.0f, 25.0f);
+    i32 dx = 0, dy = 0;
+    if (platformState.fillFlag) {
+        glColor4f(platformState.fillColor.r, platformState.fillColor.g, platformState.fillColor.b, platformState.fillColor.a);
 
-    return outColor;
-}
+        glBegin(GL_QUADS);
+        if (platformState.rectModeFlag == CENTER) {
+            dx = x - w / 2;
+            dy = y - h / 2;
+            glVertex2i(dx, dy);
+            glVertex2i(dx + w, dy);
+            glVertex2i(dx + w, dy + h);
+            glVertex2i(dx, dy + h);
+        }
+        else {
+            glVertex2i(x, y);
+            glVertex2i(x + w, y);
+            glVertex2i(x + w, y + h);
+            glVertex2i(x, y + h);
+        }
+        glEnd();
 
+        glColor4f(platformState.strokeColor.r, platformState.strokeColor.g, platformState.strokeColor.b, platformState.strokeColor.a);
+    }
 
-//
-// OpenGL API
-//
+    if (platformState.lineWidth > 0) {
+        glBegin(GL_LINE_LOOP);
+        if (platformState.rectModeFlag == CENTER) {
+            dx = x - w / 2;
+            dy = y - h / 2;
+            glVertex2i(dx, dy);
+            glVertex2i(dx + w, dy);
+            glVertex2i(dx + w, dy + h);
+            glVertex2i(dx, dy + h);
+        }
+        else {
+            glVertex2i(x, y);
+            glVertex2i(x + w, y);
+            glVertex2i(x + w, y + h);
+            glVertex2i(x, y + h);
+        }
+        glEnd();
+    }
+}
 
-void initOpenGL()
+inline void rect(f32 x, f32 y, f32 w, f32 h)
 {
-    HDC deviceContext = GetDC(platformState.window);
+    rect((i32)x, (i32)y, (i32)w, (i32)h);
 
-    // define the pixelformat for OpenGL, double buffering and RGBA
-    PIXELFORMATDESCRIPTOR pfd = { 0 };
-    pfd.nSize = sizeof(pfd);
-    pfd.nVersion = 1;
-    pfd.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER;
-    pfd.iPixelType = PFD_TYPE_RGBA;
-    pfd.cColorBits = 32; // bits per pixel
-    //pfd.cStencilBits = 8
-    //pfd.cAlphaBits = 8;  // NOTE: is this needed?
-    //pfd.cDepthBits = 16; // depth of the z-buffer Needed for 3d?
-    pfd.dwLayerMask = PFD_MAIN_PLANE; // sets the pfd to be the main drawing plane
+}
 
-    // get the best matching pixel format
-    i32 pixelFormatIndex = ChoosePixelFormat(deviceContext, &pfd);
+void quad(i32 x1, i32 y1, i32 x2, i32 y2, i32 x3, i32 y3, i32 x4, i32 y4)
+{
+    flushMatrix();
+    if (platformState.fillFlag) {
+        glColor4f(platformState.fillColor.r, platformState.fillColor.g, platformState.fillColor.b, platformState.fillColor.a);
+        glBegin(GL_QUADS);
+        glVertex2i(x1, y1);
+        glVertex2i(x2, y2);
+        glVertex2i(x3, y3);
+        glVertex2i(x4, y4);
+        glEnd();
+        glColor4f(platformState.strokeColor.r, platformState.strokeColor.g, platformState.strokeColor.b, platformState.strokeColor.a);
+    }
 
-    // NOTE: is this needed?
-    PIXELFORMATDESCRIPTOR pixelFormat;
-    DescribePixelFormat(deviceContext, pixelFormatIndex,
-        sizeof(pixelFormat), &pixelFormat);
+    if (platformState.lineWidth > 0) {
+        glBegin(GL_LINE_LOOP);
+        glVertex2i(x1, y1);
+        glVertex2i(x2, y2);
+        glVertex2i(x3, y3);
+        glVertex2i(x4, y4);
+        glEnd();
+    }
+}
 
-    // try to set the pixel format on the window
-    SetPixelFormat(deviceContext, pixelFormatIndex, &pixelFormat);
-    //SetPixelFormat(deviceContext, pixelFormatIndex, &pfd);
+void circle(i32 x, i32 y, i32 radius)
+{
+    flushMatrix();
+    if (platformState.fillFlag) {
+        glColor4f(platformState.fillColor.r, platformState.fillColor.g, platformState.fillColor.b, platformState.fillColor.a);
+        glBegin(GL_TRIANGLE_FAN);
+        glVertex2i(x, y);
+        for (i32 i = 0; i < circleFillPoints.size(); i++) {
+            v2 p = circleFillPoints[i];
+            glVertex2f((f32)x + p.x * (f32)radius, (f32)y + p.y * (f32)radius);
+        }
 
-    // create a opengl rendering context
-    HGLRC openGLRC = wglCreateContext(deviceContext);
+        // close the circle
+        glVertex2f((f32)x + (f32)radius, (f32)y);
+        glEnd();
+        glColor4f(platformState.strokeColor.r, platformState.strokeColor.g, platformState.strokeColor.b, platformState.strokeColor.a);
+    }
 
-    // makes the specified OpenGL rendering context the calling thread's current rendering context
-    if (wglMakeCurrent(deviceContext, openGLRC) == 0) {
-        // NOTE: the program won't crash if the other OpenGL calls would fail so we can
-        // safely catch the error here
-        quitError("Failed to create OpenGL rendering context.");
+    if (platformState.lineWidth > 0) {
+        glBegin(GL_LINE_STRIP);
+        for (i32 i = 0; i <= outlinePoints.size(); i++) {
+            v2 p = outlinePoints[i % outlinePoints.size()];
+            glVertex2f((f32)x + p.y * (f32)radius, (f32)y + p.x * (f32)radius);
+        }
+        glEnd();
     }
 }
 
-
-u32	base;								// font base display list
-void buildFont(const char *fontName, int fontSize)
+void circle(f32 x, f32 y, f32 radius)
 {
-    HFONT font;
-    base = glGenLists(96);
+    circle((i32)x, (i32)y, (i32)radius);
+}
 
-    font = CreateFont(-fontSize,		// font height, negative number = get a font based on the character height
-        0,								// font width
-        0,								// angle of escapement
-        0,								// orientation angle
-        FW_BOLD,						// font weight
-        FALSE,							// italic
-        FALSE,							// underline
-        FALSE,							// strikeout
-        ANSI_CHARSET,					// character set identifier
-        OUT_TT_PRECIS,					// output precision, true type
-        CLIP_DEFAULT_PRECIS,			// clipping precision
-        ANTIALIASED_QUALITY,			// output quality
-        FF_DONTCARE | DEFAULT_PITCH,	// family and pitch
-        fontName);						// font name
+void ellipse(i32 x, i32 y, i32 r1, i32 r2 = 0)
+{
+    flushMatrix();
+    if (r2 == 0)
+        r2 = r1;
+    if (platformState.fillFlag) {
+        glColor4f(platformState.fillColor.r, platformState.fillColor.g, platformState.fillColor.b, platformState.fillColor.a);
+        glBegin(GL_TRIANGLE_FAN);
+        glVertex2i(x, y);
+        for (i32 i = 0; i <= ellipseFillPoints.size(); i++) {
+            v2 p = ellipseFillPoints[i % ellipseFillPoints.size()];
+            glVertex2f((f32)x + p.x * (f32)r1, (f32)y + p.y * (f32)r2);
+        }
+        glEnd();
+        glColor4f(platformState.strokeColor.r, platformState.strokeColor.g, platformState.strokeColor.b, platformState.strokeColor.a);
+    }
 
-    HDC dc = GetDC(platformState.window);
-    SelectObject(dc, font);
-    // create 96 characters, starting at character 32
-    wglUseFontBitmaps(dc, 32, 96, base);
-    ReleaseDC(platformState.window, dc);
+    if (platformState.lineWidth > 0) {
+        glBegin(GL_LINE_STRIP);
+        for (i32 i = 0; i <= outlinePoints.size(); i++) {
+            v2 p = outlinePoints[i % outlinePoints.size()];
+            glVertex2f((f32)x + p.y * (f32)r1, (f32)y + p.x * (f32)r2);
+        }
+        glEnd();
+    }
 }
 
-void freeFont()
+void ellipse(f32 x, f32 y, f32 r1, f32 r2 = 0.f)
 {
-    if (base != 0)
-        glDeleteLists(base, 96);
+    ellipse((i32)x, (i32)y, (i32)r1, (i32)r2);
 }
 
-void text(int xPos, int yPos, const char *str, ...)
+void arc(i32 x, i32 y, i32 r1, i32 r2, f32 start, f32 end)
 {
-    if ((base == 0) || (!str))
-        return;
+    flushMatrix();
+    if (r2 == 0)
+        r2 = r1;
 
-    va_list	args;
-    char buffer[256];
+    if (platformState.lineWidth > 0) {
+        glBegin(GL_LINE_STRIP);
+        for (f32 angle = start; angle <= end; angle += 0.02f)
+            glVertex2f((f32)x + cosinus(angle) * (f32)r1, (f32)y + sinus(angle) * (f32)r2);
 
-    va_start(args, str);
-    vsprintf(buffer, str, args);
-    va_end(args);
+        glEnd();
+    }
+}
 
-    glRasterPos2i(xPos, yPos);
+void triangle(i32 x1, i32 y1, i32 x2, i32 y2, i32 x3, i32 y3)
+{
+    flushMatrix();
+    glColor4f(platformState.fillColor.r, platformState.fillColor.g, platformState.fillColor.b, platformState.fillColor.a);
 
-    glPushAttrib(GL_LIST_BIT);
+    glBegin(GL_TRIANGLE_FAN);
+    glVertex2i(x1, y1);
+    glVertex2i(x2, y2);
+    glVertex2i(x3, y3);
+    glEnd();
+}
 
-    // starting at character 32
-    glListBase(base - 32);
-    glCallLists((int)strlen(buffer), GL_UNSIGNED_BYTE, buffer);
-    glPopAttrib();
+enum { CLOSE = 1 };
+void beginShape(i32 close = 0)
+{
+    flushMatrix();
+    if (platformState.fillFlag) {
+        glColor4f(platformState.fillColor.r, platformState.fillColor.g, platformState.fillColor.b, platformState.fillColor.a);
+        glBegin(GL_TRIANGLE_FAN);
+        //glBegin(GL_POLYGON);
+    }
+    else {
+        glColor4f(platformState.strokeColor.r, platformState.strokeColor.g, platformState.strokeColor.b, platformState.strokeColor.a);
+
+        if (close == CLOSE)
+            glBegin(GL_LINE_LOOP);
+        else
+            glBegin(GL_LINE_STRIP);
+    }
+}
+
+void endShape()
+{
+    glEnd();
 }
 
 
-void disableDoubleBuffer()
+// Light
+
+void noLights()
 {
-    platformState.doubleBufferDisabledFlag = true;
-    glDrawBuffer(GL_FRONT);
+    drawTransparent();
+    glDisable(GL_LIGHTING);
 }
 
-void enableDoubleBuffer()
+// set default light
+void lights()
 {
-    platformState.doubleBufferDisabledFlag = false;
-    glDrawBuffer(GL_FRONT_AND_BACK);
+    drawTransparent();
+    flushMatrix();
+    // light values and coordinates
+    f32 ambientLight[] = { 0.5f, 0.5f, 0.5f, 1.0f };
+    f32 diffuseLight[] = { 0.5f, 0.5f, 0.5f, 1.0f };
+    f32 lightPos[] = { 0.f, 50.0f, 100.0f, 0.0f };
+
+    glEnable(GL_LIGHTING);
+
+    // setup and enable light 0
+    glLightfv(GL_LIGHT0, GL_AMBIENT, ambientLight);
+    glLightfv(GL_LIGHT0, GL_DIFFUSE, diffuseLight);
+    glLightfv(GL_LIGHT0, GL_POSITION, lightPos);
+    glEnable(GL_LIGHT0);
+
+    // enable color tracking
+    glEnable(GL_COLOR_MATERIAL);
+    // set material properties to follow glColor values
+    glColorMaterial(GL_FRONT, GL_AMBIENT_AND_DIFFUSE);
 }
 
-void set2dProjection(i32 windowWidth = platformState.windowWidth, i32 windowHeight = platformState.windowHeight)
+void ambientLight(f32 r, f32 g, f32 b, f32 a = 1.0f)
 {
-    glViewport(0, 0, windowWidth, windowHeight);
+    glEnable(GL_LIGHTING);
 
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
+    // ambient light, directionless light, dark white light
+    float ambientLight[] = { r, g, b,a };
 
-    gluOrtho2D(0, platformState.canvasWidth, platformState.canvasHeight, 0);
+    // set light model to use ambient light
+    glLightModelfv(GL_LIGHT_MODEL_AMBIENT, ambientLight);
+    // enable material color tracking
+    glEnable(GL_COLOR_MATERIAL);
+    // front material ambient and diffuse colors track glColor
+    glColorMaterial(GL_FRONT, GL_AMBIENT_AND_DIFFUSE);
+}
 
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
+// diffuse light, light from a direction
+void directionalLight(f32 r, f32 g, f32 b, f32 x, f32 y, f32 z)
+{
+    flushMatrix();
+    // position/direction of light
+    f32 lightPos[] = { x, y, z, 1.0 };
+    f32 ambientLight[] = { 0.3f, 0.3f, 0.3f, 1.0f };
+    f32 diffuseLight[] = { r, g, b, 1.0f };
+    glEnable(GL_LIGHTING);
 
-    glDisable(GL_DEPTH_TEST);
-    platformState.projection3DFlag = false;
+    // setup and enable light 0
+    glLightfv(GL_LIGHT0, GL_POSITION, lightPos);
+    glLightfv(GL_LIGHT0, GL_AMBIENT, ambientLight);
+    glLightfv(GL_LIGHT0, GL_DIFFUSE, diffuseLight);
+    glEnable(GL_LIGHT0);
 
-    // blending
-    glEnable(GL_BLEND);
-    // color = (a*source)+(b*dest)
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    // enable color tracking
+    glEnable(GL_COLOR_MATERIAL);
+    // set Material properties to follow glColor values
+    glColorMaterial(GL_FRONT, GL_AMBIENT_AND_DIFFUSE);
 }
 
-// set orthographic projection
-// objects with the same dimension appear the same size, regardless of 
-// whether they are near or far from the camera
-void ortho(f32 left = 0.f, f32 right = platformState.canvasWidth, f32 bottom = platformState.canvasHeight, f32 top = 0.f, f32 nearZ = 0.0f, f32 farZ = 500.f)
+void specularLight(f32 r, f32 g, f32 b, f32 x, f32 y, f32 z)
 {
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
+    flushMatrix();
+    //position/direction of light
+    f32 lightPos[] = { x, y, z, 1.f };
+    f32 ambientLight[] = { r * 0.3f, g * 0.3f, b * 0.3f, 1.0f };
+    f32 diffuseLight[] = { r * 0.7f, g * 0.7f, b * 0.7f, 1.f };
+    f32 specularLight[] = { r, g, b, 1.0f };
+    f32 specularReflectance[] = { r, g, b, 1.0f };
 
-    glOrtho(left, right, bottom, top, nearZ, farZ);
+    glEnable(GL_LIGHTING);
 
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
+    // setup and enable light 0
+    glLightfv(GL_LIGHT0, GL_POSITION, lightPos);
+    glLightfv(GL_LIGHT0, GL_AMBIENT, ambientLight);
+    glLightfv(GL_LIGHT0, GL_DIFFUSE, diffuseLight);
+    glLightfv(GL_LIGHT0, GL_SPECULAR, specularLight);
+    glEnable(GL_LIGHT0);
 
-    glDisable(GL_DEPTH_TEST);
-    platformState.projection3DFlag = false;
+    // enable color tracking
+    glEnable(GL_COLOR_MATERIAL);
+    // set material properties to follow glColor values
+    glColorMaterial(GL_FRONT, GL_AMBIENT_AND_DIFFUSE);
+
+    // set materials specular reflectivity and shininess
+    glMaterialfv(GL_FRONT, GL_SPECULAR, specularReflectance);
+    /*	The GL_SHININESS property sets the specular exponent of the material, which specifies how small and focused the specular highlight is.
+        The larger the value, the more shiny and pronounced the surface. The range of this parameter is 1-128 */
+    glMateriali(GL_FRONT, GL_SHININESS, 40);
 }
 
-// set perspective projection
-void set3dProjection(i32 windowWidth = platformState.windowWidth, i32 windowHeight = platformState.windowHeight, f32 fov = 60.f, f32 nearZ = 1.0f, f32 farZ = 500.0f)
+void spotLight(f32 r, f32 g, f32 b, f32 x, f32 y, f32 z, f32 dirX, f32 dirY, f32 dirZ, f32 angle)
 {
-    // prevent divide by zero
-    if (!windowHeight) return;
+    flushMatrix();
+    f32 lightPos[] = { x, y, z, 1.0f };
+    f32 specular[] = { r, g, b, 1.0f };
+    f32 specularRef[] = { r, g, b, 1.0f };
+    f32 ambient[] = { r * 0.5f, g * 0.5f, b * 0.5f, 1.0f };
+    f32 spotDir[] = { dirX, dirY, dirZ };
 
-    f32 aspect = (f32)platformState.canvasWidth / (f32)platformState.canvasHeight;
+    glEnable(GL_LIGHTING);
 
-    glViewport(0, 0, windowWidth, windowHeight);
+    // setup and enable light 0
+    glLightModelfv(GL_LIGHT_MODEL_AMBIENT, ambient);
+
+    glLightfv(GL_LIGHT0, GL_DIFFUSE, ambient);
+    glLightfv(GL_LIGHT0, GL_SPECULAR, specular);
+    glLightfv(GL_LIGHT0, GL_POSITION, lightPos);
+    glLightfv(GL_LIGHT0, GL_SPOT_DIRECTION, spotDir);
 
-    // center
-    //glViewport(windowWidth / 4.f, windowHeight / 4.f, windowWidth / 2.f, windowHeight / 2.f);
+    // set cut off angle to 60 degrees to create spot effect
+    glLightf(GL_LIGHT0, GL_SPOT_CUTOFF, angle);
 
-    // switch to the projection matrix and reset it
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
+    glEnable(GL_LIGHT0);
 
-    // set camera perspective
-    gluPerspective(fov,		// camera angle, field of view in degrees, set to 45 degrees viewing angle
-        aspect,				// aspect ratio
-        nearZ,				// near z clipping coordinate
-        farZ);				// far z clipping coordinate, start and end point for how deep we can draw into the screen
+    // enable color tracking
+    glEnable(GL_COLOR_MATERIAL);
 
-    // switch to GL_MODELVIEW, tells OGL that all future transformations will affect what we draw
-    // reset the modelview matrix, wich is where the object information is stored, sets x,y,z to zero
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
+    // set material properties to follow glColor values
+    glColorMaterial(GL_FRONT, GL_AMBIENT_AND_DIFFUSE);
+    // set materials specular reflectivity and shininess
+    glMaterialfv(GL_FRONT, GL_SPECULAR, specularRef);
+    glMateriali(GL_FRONT, GL_SHININESS, 128);
+}
 
-    // enable depth buffer
-    glEnable(GL_DEPTH_TEST);
 
-    glShadeModel(GL_SMOOTH);
-    glHint(GL_PERSPECTIVE_CORRECTION_HINT, GL_NICEST);
+// Blending
 
-    //NOTE: this has been turned on by set2dProjection
-    glDisable(GL_BLEND);
-    platformState.projection3DFlag = true;
-}
+enum { ALPHA_BLEND, ADDITIVE_BLEND, MULTIPLIED_BLEND };
 
-// set perspective projection
-void perspective(f32 fov, f32 aspect, f32 nearZ, f32 farZ)
+void blendMode(i32 mode)
 {
-    // switch to the projection matrix and reset it
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
+    switch (mode) {
+    case ALPHA_BLEND:
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        break;
+    case ADDITIVE_BLEND:
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+        break;
+    case MULTIPLIED_BLEND:
+        glBlendFunc(GL_DST_COLOR, GL_ONE_MINUS_SRC_ALPHA);
+        break;
+    }
+}
 
-    // set camera perspective
-    gluPerspective(fov,		// camera angle, field of view in degrees, set to 45 degrees viewing angle
-        aspect,				// aspect ratio
-        nearZ,				// near z clipping coordinate
-        farZ);				// far z clipping coordinate, start and end point for how deep we can draw into the screen
 
-    // switch to GL_MODELVIEW, tells OGL that all future transformations will affect what we draw
-    // reset the modelview matrix, wich is where the object information is stored, sets x,y,z to zero
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
+// Fog
 
-    // enable depth buffer
-    //glEnable(GL_DEPTH_TEST);
-    // don't calculate inside of objects
-    //glEnable(GL_CULL_FACE);		
-    // counter clock-wise polygons face out
-    //glFrontFace(GL_CCW);
-    platformState.projection3DFlag = true;
+void enableFog(f32 start, f32 end, f32 r, f32 g, f32 b, f32 a)
+{
+    // fog setup
+    glEnable(GL_FOG);
+    glFogi(GL_FOG_MODE, /*GL_EXP2*/GL_LINEAR);		// fog equation
+    //glFogf(GL_FOG_DENSITY, 0.6f); //only works if GL_FOG_MODE == GL_EXP eller GL_EXP2
+    // Note that GL_FOG_START and GL_FOG_END only have an effect on GL_LINEAR fog
+    // where the fog starts and ends
+    glFogf(GL_FOG_START, start);
+    glFogf(GL_FOG_END, end);
+    f32 col[] = { r, g, b, a };
+    glFogfv(GL_FOG_COLOR, col);
 }
 
-void loadIdentity()
+void disableFog()
 {
-    glLoadIdentity();
+    glDisable(GL_FOG);
 }
 
-void pushMatrix()
+
+// Meshes
+
+// indexed triangle mesh, the arrays are stretchy buffers
+struct Mesh
 {
-    glPushMatrix();
-}
+    v3 *positions = 0;
+    v3 *normals = 0;
+    v2 *texCoords = 0;  // optional
+    u32 *indices = 0;   // three indices per triangle
+    u32 list = 0;       // display list compiled from the arrays
+    f32 radius = 0.f;   // bounding sphere radius around the local origin
+    u32 serial = 0;     // new for every buildMesh(), 0 when freed. things that keep a mesh pointer keep this too
+};
 
-void popMatrix()
+global u32 meshSerials;
+
+inline u32 meshVertex(Mesh *mesh, v3 position, v3 normal)
 {
-    glPopMatrix();
+    pushArray(mesh->positions, position);
+    pushArray(mesh->normals, normal);
+    return countArray(mesh->positions) - 1;
 }
 
-void translate(f32 x, f32 y, f32 z = 0.f)
+inline u32 meshVertex(Mesh *mesh, v3 position, v3 normal, v2 texCoord)
 {
-    glTranslatef(x, y, z);
+    pushArray(mesh->texCoords, texCoord);
+    return meshVertex(mesh, position, normal);
 }
 
-void rotateX(f32 angle)
+inline void meshTriangle(Mesh *mesh, u32 a, u32 b, u32 c)
 {
-    glRotatef(angle, 1.0f, 0.0f, 0.0f);
+    pushArray(mesh->indices, a);
+    pushArray(mesh->indices, b);
+    pushArray(mesh->indices, c);
 }
 
-void rotateY(f32 angle)
+// maps 64-bit keys to vertex indices, used to weld and cluster vertices
+struct VertexMap
+{
+    u64 *keys;
+    u32 *values;
+    u32 mask;
+};
+
+internal VertexMap
+createVertexMap(i32 maxCount)
 {
-    glRotatef(angle, 0.0f, 1.0f, 0.0f);
+    VertexMap map;
+    u32 size = 16;
+    while (size < (u32)maxCount * 2)
+        size *= 2;
+
+    map.mask = size - 1;
+    map.keys = (u64 *)malloc(sizeof(u64) * size);
+    map.values = (u32 *)malloc(sizeof(u32) * size);
+    for (u32 i = 0; i < size; i++)
+        map.values[i] = 0xffffffff;
+    return map;
 }
 
-void rotateZ(f32 angle)
+// returns the value slot for the key, an empty slot holds 0xffffffff
+internal u32 *
+findVertex(VertexMap *map, u64 key)
 {
-    glRotatef(angle, 0.0f, 0.0f, 1.0f);
+    u64 hash = key;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+
+    u32 index = (u32)hash & map->mask;
+    while (map->values[index] != 0xffffffff && map->keys[index] != key)
+        index = (index + 1) & map->mask;
+
+    map->keys[index] = key;
+    return map->values + index;
 }
 
-// rotation in radians
-void rotate(f32 angle)
+internal void
+freeVertexMap(VertexMap *map)
 {
-    f32 deg = degrees(angle);
-    glRotatef(deg, 0.0f, 0.0f, 1.0f);
+    free(map->keys);
+    free(map->values);
 }
 
+// Transparency
 
-// Color
+enum { TRANSPARENCY_OFF, TRANSPARENCY_SORTED };
 
-// clear screen and depth buffers
-inline void background(Color col, i32 alpha = 255)
+// a translucent mesh draw recorded by drawMesh() in TRANSPARENCY_SORTED mode
+struct TransparentDraw
 {
-    Colorf newColor = checkColorMode(col);
-    f32 r = newColor.r / 255.f;
-    f32 g = newColor.g / 255.f;
-    f32 b = newColor.b / 255.f;
-    f32 a = (f32)alpha / 255.f;
-    platformState.clearColor = { r, g, b, a };
+    Mesh *mesh;
+    u32 serial; // serial of the mesh when it was queued, a mesh rebuilt since then is skipped
+    m4 transform;
+    u32 color;
+    u32 key;    // view depth as a sortable integer, smaller is further away
+};
 
-    glClearColor(r, g, b, a);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-}
+struct TransparencyQueue
+{
+    TransparentDraw *draws;
+    u32 *order;         // back to front order of the last frame, reused when it still sorts the new depths
+    u32 *scratch;
+    i32 orderCount;
+    i32 capacity;
+};
 
-inline void background(i32 inColor, i32 alpha = 255)
+global TransparencyQueue transparencyQueue;
+
+// with TRANSPARENCY_SORTED, meshes drawn in 3D with a fill alpha below 255 are queued and drawn back to front
+// when draw() returns. this covers drawMesh(), model() and the mesh based shapes (sphere, torus, cylinder,
+// cone and capsule), the sort is per object so objects that intersect can still blend in the wrong order.
+// every draw keeps its matrix and fill color. the projection and the lights aren't kept, changing them
+// (set2dProjection(), set3dProjection(), ortho(), perspective(), lights(), noLights()) draws the queue
+// first, so the sort only works between those calls. other raw GL state changes in draw() aren't seen
+// and the queue is drawn with the state at the end of the frame. noFill() meshes are drawn right away.
+void transparencyMode(i32 mode)
 {
-    Color col = { inColor, inColor, inColor, alpha };
-    background(col);
+    platformState.transparencyModeFlag = mode;
 }
 
-inline void background(i32 r, i32 g, i32 b, i32 a = 255)
-{
-    Color col = { r, g, b, a };
-    background(col);
+internal void
+queueTransparent(Mesh *mesh)
+{
+    TransparentDraw draw;
+    draw.mesh = mesh;
+    draw.serial = mesh->serial;
+    draw.transform = *topMatrix();
+    draw.color = fillColorPacked();
+
+    // the camera looks down -z, flip the float bits so the integers sort like the floats
+    f32 depth = draw.transform.e[2][3];
+    u32 bits;
+    memcpy(&bits, &depth, sizeof(bits));
+    draw.key = (bits & 0x80000000) ? ~bits : (bits | 0x80000000);
+    pushArray(transparencyQueue.draws, draw);
+}
+
+// compiles the vertex arrays into a display list so the mesh can be drawn with a single call
+void buildMesh(Mesh *mesh)
+{
+    f32 radiusSquared = 0.f;
+    for (i32 i = 0; i < countArray(mesh->positions); i++) {
+        f32 d = v3DotProduct(mesh->positions[i], mesh->positions[i]);
+        if (d > radiusSquared)
+            radiusSquared = d;
+    }
+    mesh->radius = squareRoot(radiusSquared);
+    mesh->serial = ++meshSerials;
+
+    if (mesh->list == 0)
+        mesh->list = glGenLists(1);
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(v3), mesh->positions);
+    glNormalPointer(GL_FLOAT, sizeof(v3), mesh->normals);
+    if (mesh->texCoords) {
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(2, GL_FLOAT, sizeof(v2), mesh->texCoords);
+    }
+
+    // the arrays are copied into the display list when it is compiled
+    glNewList(mesh->list, GL_COMPILE);
+    glDrawElements(GL_TRIANGLES, countArray(mesh->indices), GL_UNSIGNED_INT, mesh->indices);
+    glEndList();
+
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
 }
 
-inline void clear(Color col, i32 alpha = 255)
+void drawMesh(Mesh *mesh)
 {
-    background(col, alpha);
+    if (mesh && mesh->list) {
+        if (platformState.transparencyModeFlag == TRANSPARENCY_SORTED && platformState.projection3DFlag &&
+            platformState.fillFlag && platformState.fillColor.a < 1.f) {
+            queueTransparent(mesh);
+            return;
+        }
+        flushMatrix();
+        glCallList(mesh->list);
+    }
 }
 
-inline void clear(i32 inColor, i32 alpha = 255)
+// scratch arrays for drawInstanced(), kept between calls
+struct InstanceBatch
 {
-    background(inColor, alpha);
-}
+    v3 *positions;
+    v3 *normals;
+    u32 *colors;
+    u32 *indices;
+    i32 vertexCapacity;
+    i32 indexCapacity;
+    u32 indexSerial; // the indices are built for the mesh with this serial, its index count and number of instances
+    i32 indexCount;
+    i32 indexInstances;
+};
 
-inline void clear(i32 r, i32 g, i32 b, i32 a = 255)
+global InstanceBatch instanceBatch;
+
+void freeMesh(Mesh *mesh)
 {
-    background(r, g, b, a);
+    if (mesh->serial != 0 && instanceBatch.indexSerial == mesh->serial)
+        instanceBatch.indexSerial = 0;
+
+    if (mesh->list != 0)
+        glDeleteLists(mesh->list, 1);
+
+    freeArray(mesh->positions);
+    freeArray(mesh->normals);
+    freeArray(mesh->texCoords);
+    freeArray(mesh->indices);
+    *mesh = Mesh();
 }
 
-inline void pointSize(f32 value)
+// generated meshes are cached by their parameters, so every tessellation is only built once. the float
+// parameters (torus ratio, capsule length) are rounded to steps of 1 / MESH_PARAM_STEPS so values that
+// only differ by rounding share a mesh. the cache holds MESH_CACHE_SIZE meshes, when it is full the least
+// recently used one is rebuilt in place and gets a new serial. meshes used in the current frame are never
+// rebuilt, a frame that uses more shapes than that grows the cache instead. an animated ratio or length
+// doesn't grow it
+#define MESH_CACHE_SIZE 64
+#define MESH_PARAM_STEPS 1024.f
+
+enum { MESH_SPHERE, MESH_TORUS, MESH_BOX, MESH_CYLINDER, MESH_CONE, MESH_CAPSULE };
+
+struct MeshCacheEntry
 {
-    glPointSize(value);
-}
+    i32 type;
+    f32 params[3];
+    Mesh *mesh;
+    u32 lastUse;
+    u64 lastFrame;
+};
 
-inline void noStroke()
+global MeshCacheEntry *meshCache;
+global u32 meshCacheUses;
+
+inline f32 meshParam(f32 value)
 {
-    platformState.lineWidth = 0;
-    glLineWidth(1);
+    return roundf(value * MESH_PARAM_STEPS) / MESH_PARAM_STEPS;
 }
 
-inline void strokeWeight(i32 value)
+internal Mesh *
+findCachedMesh(i32 type, f32 p0, f32 p1, f32 p2)
 {
-    platformState.lineWidth = value;
-    glLineWidth((f32)value);
-    glPointSize((f32)value);
+    for (i32 i = 0; i < countArray(meshCache); i++) {
+        MeshCacheEntry *entry = meshCache + i;
+        if (entry->type == type && entry->params[0] == p0 && entry->params[1] == p1 && entry->params[2] == p2) {
+            entry->lastUse = ++meshCacheUses;
+            entry->lastFrame = frameCount;
+            return entry->mesh;
+        }
+    }
+    return 0;
 }
 
-inline void stroke(Color col, i32 alpha = 255)
+internal Mesh *
+addCachedMesh(i32 type, f32 p0, f32 p1, f32 p2)
 {
-    Colorf newColor = checkColorMode(col);
-    f32 r = newColor.r / 255.f;
-    f32 g = newColor.g / 255.f;
-    f32 b = newColor.b / 255.f;
-    f32 a = (f32)alpha / 255.f;
+    MeshCacheEntry entry = { type, { p0, p1, p2 }, 0, ++meshCacheUses, frameCount };
+    i32 oldest = -1;
+    if (countArray(meshCache) >= MESH_CACHE_SIZE) {
+        for (i32 i = 0; i < countArray(meshCache); i++)
+            if (meshCache[i].lastFrame != frameCount && (oldest < 0 || meshCache[i].lastUse < meshCache[oldest].lastUse))
+                oldest = i;
+    }
+    if (oldest < 0) {
+        // the entries move when the cache grows, so the meshes are allocated separately
+        entry.mesh = (Mesh *)malloc(sizeof(Mesh));
+        *entry.mesh = Mesh();
+        pushArray(meshCache, entry);
+        return entry.mesh;
+    }
 
-    platformState.strokeColor = { r, g, b, a };
-    glColor4f(platformState.strokeColor.r, platformState.strokeColor.g, platformState.strokeColor.b, platformState.strokeColor.a);
+    entry.mesh = meshCache[oldest].mesh;
+    freeMesh(entry.mesh);
+    meshCache[oldest] = entry;
+    return entry.mesh;
 }
 
-inline void stroke(i32 inColor, i32 alpha = 255)
+void freeMeshCache()
 {
-    Color col = { inColor, inColor, inColor, alpha };
-    stroke(col);
+    for (i32 i = 0; i < countArray(meshCache); i++) {
+        freeMesh(meshCache[i].mesh);
+        free(meshCache[i].mesh);
+    }
+    freeArray(meshCache);
+    meshCache = 0;
 }
 
-inline void stroke(i32 r, i32 g, i32 b, i32 a = 255)
+// unit sphere around the z-axis
+Mesh *sphereMesh(i32 slices = 24, i32 stacks = 16)
 {
-    Color col = { r, g, b, a };
-    stroke(col);
-}
+    Mesh *mesh = findCachedMesh(MESH_SPHERE, (f32)slices, (f32)stacks, 0.f);
+    if (mesh)
+        return mesh;
 
-inline void noFill()
-{
-    platformState.fillFlag = false;
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-}
+    mesh = addCachedMesh(MESH_SPHERE, (f32)slices, (f32)stacks, 0.f);
 
-inline void fill(Color col)
-{
-    platformState.fillFlag = true;
-    //if (platformState.colorModeFlag == HSB)
-    Colorf newColor = checkColorMode(col);
-    f32 r = newColor.r / 255.0f;
-    f32 g = newColor.g / 255.0f;
-    f32 b = newColor.b / 255.0f;
-    f32 a = (f32)col.a / 255.0f;
+    f32 drho = PI / (f32)stacks;
+    f32 dtheta = 2.0f * PI / (f32)slices;
 
-    platformState.fillColor = { r, g, b, a };
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-}
+    for (i32 i = 0; i <= stacks; i++) {
+        f32 rho = (f32)i * drho;
+        f32 srho = sinus(rho);
+        f32 crho = cosinus(rho);
 
-inline void fill(i32 r, i32 g, i32 b, i32 a = 255)
-{
-    Color col = { r, g, b, a };
-    fill(col);
+        for (i32 j = 0; j <= slices; j++) {
+            f32 theta = (j == slices) ? 0.0f : j * dtheta;
+            v3 normal = v3(-sinus(theta) * srho, cosinus(theta) * srho, crho);
+            meshVertex(mesh, normal, normal, v2((f32)j / (f32)slices, 1.0f - (f32)i / (f32)stacks));
+        }
+    }
+
+    u32 row = slices + 1;
+    for (i32 i = 0; i < stacks; i++) {
+        for (i32 j = 0; j < slices; j++) {
+            u32 v00 = i * row + j;
+            u32 v10 = v00 + row;
+            meshTriangle(mesh, v00, v10, v00 + 1);
+            meshTriangle(mesh, v10, v10 + 1, v00 + 1);
+        }
+    }
+
+    buildMesh(mesh);
+    return mesh;
 }
 
-inline void fill(Color col, i32 alpha)
+// torus with a major radius of 1, ratio is minorRadius / majorRadius
+Mesh *torusMesh(f32 ratio, i32 numMajor = 61, i32 numMinor = 37)
 {
-    col.a = alpha;
-    fill(col);
+    ratio = meshParam(ratio);
+    Mesh *mesh = findCachedMesh(MESH_TORUS, ratio, (f32)numMajor, (f32)numMinor);
+    if (mesh)
+        return mesh;
+
+    mesh = addCachedMesh(MESH_TORUS, ratio, (f32)numMajor, (f32)numMinor);
+
+    f32 majorStep = 2.0f * PI / numMajor;
+    f32 minorStep = 2.0f * PI / numMinor;
+
+    for (i32 i = 0; i <= numMajor; i++) {
+        f32 a = (i == numMajor) ? 0.0f : i * majorStep;
+        f32 x = cosinus(a);
+        f32 y = sinus(a);
+
+        for (i32 j = 0; j <= numMinor; j++) {
+            f32 b = (j == numMinor) ? 0.0f : j * minorStep;
+            f32 c = cosinus(b);
+            f32 s = sinus(b);
+            f32 r = ratio * c + 1.0f;
+            meshVertex(mesh, v3(x * r, y * r, ratio * s), v3(x * c, y * c, s),
+                v2((f32)i / (f32)numMajor, (f32)j / (f32)numMinor));
+        }
+    }
+
+    u32 row = numMinor + 1;
+    for (i32 i = 0; i < numMajor; i++) {
+        for (i32 j = 0; j < numMinor; j++) {
+            u32 v00 = i * row + j;
+            u32 v10 = v00 + row;
+            meshTriangle(mesh, v00, v10, v00 + 1);
+            meshTriangle(mesh, v10, v10 + 1, v00 + 1);
+        }
+    }
+
+    buildMesh(mesh);
+    return mesh;
 }
 
-inline void fill(i32 col, i32 alpha = 255)
+
+// unit cube from -1 to 1, the same size as cube(1)
+Mesh *boxMesh()
 {
-    Color color = { col, col, col, alpha };
-    fill(color);
+    Mesh *mesh = findCachedMesh(MESH_BOX, 0.f, 0.f, 0.f);
+    if (mesh)
+        return mesh;
+
+    mesh = addCachedMesh(MESH_BOX, 0.f, 0.f, 0.f);
+
+    // face normal and two axes along the face, u x v = normal so the corners are counter-clockwise
+    v3 faces[6][3] = {
+        { v3(1.f, 0.f, 0.f),  v3(0.f, 1.f, 0.f), v3(0.f, 0.f, 1.f) },
+        { v3(-1.f, 0.f, 0.f), v3(0.f, 0.f, 1.f), v3(0.f, 1.f, 0.f) },
+        { v3(0.f, 1.f, 0.f),  v3(0.f, 0.f, 1.f), v3(1.f, 0.f, 0.f) },
+        { v3(0.f, -1.f, 0.f), v3(1.f, 0.f, 0.f), v3(0.f, 0.f, 1.f) },
+        { v3(0.f, 0.f, 1.f),  v3(1.f, 0.f, 0.f), v3(0.f, 1.f, 0.f) },
+        { v3(0.f, 0.f, -1.f), v3(0.f, 1.f, 0.f), v3(1.f, 0.f, 0.f) },
+    };
+
+    for (i32 i = 0; i < 6; i++) {
+        v3 n = faces[i][0];
+        v3 u = faces[i][1];
+        v3 v = faces[i][2];
+        u32 first = meshVertex(mesh, n - u - v, n, v2(0.f, 0.f));
+        meshVertex(mesh, n + u - v, n, v2(1.f, 0.f));
+        meshVertex(mesh, n + u + v, n, v2(1.f, 1.f));
+        meshVertex(mesh, n - u + v, n, v2(0.f, 1.f));
+        meshTriangle(mesh, first, first + 1, first + 2);
+        meshTriangle(mesh, first, first + 2, first + 3);
+    }
+
+    buildMesh(mesh);
+    return mesh;
 }
 
 
-// 2D drawing
+// adds rings of vertices around the z-axis and connects every ring with the next one,
+// rings[i] holds the height, radius and the z and radial parts of the normal
+internal void
+meshRings(Mesh *mesh, v4 *rings, i32 ringCount, i32 slices)
+{
+    u32 first = countArray(mesh->positions);
+    f32 step = TWO_PI / (f32)slices;
+
+    for (i32 i = 0; i < ringCount; i++) {
+        v4 ring = rings[i];
+        for (i32 j = 0; j <= slices; j++) {
+            f32 a = (j == slices) ? 0.f : j * step;
+            f32 c = cosinus(a);
+            f32 s = sinus(a);
+            meshVertex(mesh, v3(c * ring.y, s * ring.y, ring.x), v3(c * ring.w, s * ring.w, ring.z),
+                v2((f32)j / (f32)slices, (f32)i / (f32)(ringCount - 1)));
+        }
+    }
 
-enum { CENTER = 1 };
-inline void rectMode(const i32 mode)
-{
-    platformState.rectModeFlag = mode;
+    // counter-clockwise seen from the outside
+    u32 row = slices + 1;
+    for (i32 i = 0; i < ringCount - 1; i++) {
+        for (i32 j = 0; j < slices; j++) {
+            u32 v00 = first + i * row + j;
+            u32 v10 = v00 + row;
+            meshTriangle(mesh, v00, v00 + 1, v10 + 1);
+            meshTriangle(mesh, v00, v10 + 1, v10);
+        }
+    }
 }
 
-inline void line(i32 x0, i32 y0, i32 x1, i32 y1)
+// flat disc at height z facing up or down
+internal void
+meshCap(Mesh *mesh, f32 z, i32 slices, b32 up)
 {
-    glColor4f(platformState.strokeColor.r, platformState.strokeColor.g, platformState.strokeColor.b, platformState.strokeColor.a);
-    glBegin(GL_LINES);
-    glVertex2i(x0, y0);
-    glVertex2i(x1, y1);
-    glEnd();
+    f32 nz = up ? 1.f : -1.f;
+    f32 step = TWO_PI / (f32)slices;
+    u32 center = meshVertex(mesh, v3(0.f, 0.f, z), v3(0.f, 0.f, nz), v2(0.5f, 0.5f));
+
+    for (i32 j = 0; j <= slices; j++) {
+        f32 a = (j == slices) ? 0.f : j * step;
+        f32 c = cosinus(a);
+        f32 s = sinus(a);
+        meshVertex(mesh, v3(c, s, z), v3(0.f, 0.f, nz), v2(0.5f + c * 0.5f, 0.5f + s * 0.5f));
+    }
+
+    for (i32 j = 0; j < slices; j++) {
+        if (up)
+            meshTriangle(mesh, center, center + 1 + j, center + 2 + j);
+        else
+            meshTriangle(mesh, center, center + 2 + j, center + 1 + j);
+    }
 }
 
-inline void line(f32 x0, f32 y0, f32 x1, f32 y1)
+// cylinder with radius 1 from z = 0 to 1, with end caps
+Mesh *cylinderMesh(i32 slices = 32, i32 stacks = 7)
 {
-    line((i32)x0, (i32)y0, (i32)x1, (i32)y1);
-}
+    Mesh *mesh = findCachedMesh(MESH_CYLINDER, (f32)slices, (f32)stacks, 0.f);
+    if (mesh)
+        return mesh;
 
-inline void point(i32 x, i32 y)
-{
-    glColor4f(platformState.strokeColor.r, platformState.strokeColor.g, platformState.strokeColor.b, platformState.strokeColor.a);
-    glBegin(GL_POINTS);
-    glVertex2i(x, y);
-    glEnd();
+    mesh = addCachedMesh(MESH_CYLINDER, (f32)slices, (f32)stacks, 0.f);
+
+    v4 *rings = 0;
+    for (i32 i = 0; i <= stacks; i++)
+        pushArray(rings, v4((f32)i / (f32)stacks, 1.f, 0.f, 1.f));
+    meshRings(mesh, rings, countArray(rings), slices);
+    meshCap(mesh, 0.f, slices, false);
+    meshCap(mesh, 1.f, slices, true);
+    freeArray(rings);
+
+    buildMesh(mesh);
+    return mesh;
 }
 
-inline void point(f32 x, f32 y, f32 z)
+// cone with a base radius of 1 at z = 0 and the tip at z = 1, with a base cap
+Mesh *coneMesh(i32 slices = 32, i32 stacks = 7)
 {
-    glColor4f(platformState.strokeColor.r, platformState.strokeColor.g, platformState.strokeColor.b, platformState.strokeColor.a);
-    glBegin(GL_POINTS);
-    glVertex3f(x, y, z);
-    glEnd();
+    Mesh *mesh = findCachedMesh(MESH_CONE, (f32)slices, (f32)stacks, 0.f);
+    if (mesh)
+        return mesh;
+
+    mesh = addCachedMesh(MESH_CONE, (f32)slices, (f32)stacks, 0.f);
+
+    // the side leans 45 degrees, the normal points half up and half out
+    f32 n = 0.70710678f;
+    v4 *rings = 0;
+    for (i32 i = 0; i <= stacks; i++) {
+        f32 t = (f32)i / (f32)stacks;
+        pushArray(rings, v4(t, 1.f - t, n, n));
+    }
+    meshRings(mesh, rings, countArray(rings), slices);
+    meshCap(mesh, 0.f, slices, false);
+    freeArray(rings);
+
+    buildMesh(mesh);
+    return mesh;
 }
 
-inline void rect(i32 x, i32 y, i32 w, i32 h)
+// capsule with radius 1, the cylinder part goes from z = 0 to length and the ends are half spheres
+Mesh *capsuleMesh(f32 length, i32 slices = 24, i32 stacks = 16)
 {
-    //glRectf(50.0f, 50.0f, 25.0f, 25.0f);
-    i32 dx = 0, dy = 0;
-    if (platformState.fillFlag) {
-        glColor4f(platformState.fillColor.r, platformState.fillColor.g, platformState.fillColor.b, platformState.fillColor.a);
+    length = meshParam(length);
+    Mesh *mesh = findCachedMesh(MESH_CAPSULE, length, (f32)slices, (f32)stacks);
+    if (mesh)
+        return mesh;
 
-        glBegin(GL_QUADS);
-        if (platformState.rectModeFlag == CENTER) {
-            dx = x - w / 2;
-            dy = y - h / 2;
-            glVertex2i(dx, dy);
-            glVertex2i(dx + w, dy);
-            glVertex2i(dx + w, dy + h);
-            glVertex2i(dx, dy + h);
-        }
-        else {
-            glVertex2i(x, y);
-            glVertex2i(x + w, y);
-            glVertex2i(x + w, y + h);
-            glVertex2i(x, y + h);
-        }
-        glEnd();
+    mesh = addCachedMesh(MESH_CAPSULE, length, (f32)slices, (f32)stacks);
 
-        glColor4f(platformState.strokeColor.r, platformState.strokeColor.g, platformState.strokeColor.b, platformState.strokeColor.a);
+    i32 halfStacks = maximum(stacks / 2, 2);
+    f32 step = HALF_PI / (f32)halfStacks;
+    v4 *rings = 0;
+
+    // bottom half sphere from the pole up to the equator, then the top half sphere from
+    // the equator to the pole, the quads between the two equators make the cylinder
+    for (i32 i = 0; i <= halfStacks; i++) {
+        f32 phi = -HALF_PI + i * step;
+        pushArray(rings, v4(sinus(phi), cosinus(phi), sinus(phi), cosinus(phi)));
     }
+    for (i32 i = 0; i <= halfStacks; i++) {
+        f32 phi = i * step;
+        pushArray(rings, v4(length + sinus(phi), cosinus(phi), sinus(phi), cosinus(phi)));
+    }
+    meshRings(mesh, rings, countArray(rings), slices);
+    freeArray(rings);
 
-    if (platformState.lineWidth > 0) {
-        glBegin(GL_LINE_LOOP);
-        if (platformState.rectModeFlag == CENTER) {
-            dx = x - w / 2;
-            dy = y - h / 2;
-            glVertex2i(dx, dy);
-            glVertex2i(dx + w, dy);
-            glVertex2i(dx + w, dy + h);
-            glVertex2i(dx, dy + h);
-        }
-        else {
-            glVertex2i(x, y);
-            glVertex2i(x + w, y);
-            glVertex2i(x + w, y + h);
-            glVertex2i(x, y + h);
+    buildMesh(mesh);
+    return mesh;
+}
+
+
+// Mesh optimization
+
+// post-transform vertex cache statistics, acmr is the average number of vertices transformed per triangle
+// (0.5 is the best possible, 3 the worst) and atvr the number of transformed vertices per vertex (1 is the best)
+struct MeshCacheStats
+{
+    f32 acmr;
+    f32 atvr;
+};
+
+enum { MESH_OPTIMIZE_CACHE = 1, MESH_OPTIMIZE_FETCH = 2, MESH_OPTIMIZE_OVERDRAW = 4 };
+
+// size of the fifo cache used to measure the meshes, most hardware has somewhere between 16 and 32 entries
+#define MESH_ANALYZE_CACHE_SIZE 16
+// size of the lru cache the reordering optimizes for
+#define MESH_OPTIMIZE_CACHE_SIZE 32
+#define MESH_OPTIMIZE_MAX_VALENCE 32
+
+// runs the triangles through a fifo vertex cache, returns the number of misses and optionally the misses per triangle
+internal i32
+simulateVertexCache(u32 *indices, i32 indexCount, i32 vertexCount, u8 *triangleMisses)
+{
+    u32 *timestamps = (u32 *)malloc(sizeof(u32) * vertexCount);
+    for (i32 i = 0; i < vertexCount; i++)
+        timestamps[i] = 0;
+
+    // a vertex is in the cache if it was added less than the cache size misses ago
+    u32 time = MESH_ANALYZE_CACHE_SIZE + 1;
+    i32 misses = 0;
+    for (i32 i = 0; i < indexCount; i += 3) {
+        i32 missCount = 0;
+        for (i32 j = 0; j < 3; j++) {
+            u32 v = indices[i + j];
+            if (time - timestamps[v] > MESH_ANALYZE_CACHE_SIZE) {
+                timestamps[v] = time++;
+                missCount++;
+            }
         }
-        glEnd();
+        if (triangleMisses)
+            triangleMisses[i / 3] = (u8)missCount;
+        misses += missCount;
     }
+
+    free(timestamps);
+    return misses;
 }
 
-inline void rect(f32 x, f32 y, f32 w, f32 h)
+MeshCacheStats analyzeVertexCache(Mesh *mesh)
 {
-    rect((i32)x, (i32)y, (i32)w, (i32)h);
+    MeshCacheStats result = { 0.f, 0.f };
+    i32 indexCount = countArray(mesh->indices);
+    i32 vertexCount = countArray(mesh->positions);
+    if (indexCount == 0 || vertexCount == 0)
+        return result;
 
+    i32 misses = simulateVertexCache(mesh->indices, indexCount, vertexCount, 0);
+    result.acmr = (f32)misses / (f32)(indexCount / 3);
+    result.atvr = (f32)misses / (f32)vertexCount;
+    return result;
 }
 
-void quad(i32 x1, i32 y1, i32 x2, i32 y2, i32 x3, i32 y3, i32 x4, i32 y4)
-{
-    if (platformState.fillFlag) {
-        glColor4f(platformState.fillColor.r, platformState.fillColor.g, platformState.fillColor.b, platformState.fillColor.a);
-        glBegin(GL_QUADS);
-        glVertex2i(x1, y1);
-        glVertex2i(x2, y2);
-        glVertex2i(x3, y3);
-        glVertex2i(x4, y4);
-        glEnd();
-        glColor4f(platformState.strokeColor.r, platformState.strokeColor.g, platformState.strokeColor.b, platformState.strokeColor.a);
+// score of a vertex for the reordering, vertices that were used recently and vertices with few
+// triangles left score high so the triangles around them are finished first
+internal f32
+forsythVertexScore(i32 cachePosition, i32 remainingValence)
+{
+    local f32 cacheScores[MESH_OPTIMIZE_CACHE_SIZE];
+    local f32 valenceScores[MESH_OPTIMIZE_MAX_VALENCE];
+    local b32 initialized;
+    if (!initialized) {
+        for (i32 i = 0; i < MESH_OPTIMIZE_CACHE_SIZE; i++) {
+            // the last triangle gets a fixed score so it is not reused right away
+            if (i < 3)
+                cacheScores[i] = 0.75f;
+            else
+                cacheScores[i] = powf(1.f - (f32)(i - 3) / (f32)(MESH_OPTIMIZE_CACHE_SIZE - 3), 1.5f);
+        }
+        for (i32 i = 0; i < MESH_OPTIMIZE_MAX_VALENCE; i++)
+            valenceScores[i] = (i == 0) ? 0.f : 2.f / squareRoot((f32)i);
+        initialized = true;
     }
 
-    if (platformState.lineWidth > 0) {
-        glBegin(GL_LINE_LOOP);
-        glVertex2i(x1, y1);
-        glVertex2i(x2, y2);
-        glVertex2i(x3, y3);
-        glVertex2i(x4, y4);
-        glEnd();
-    }
+    if (remainingValence == 0)
+        return -1.f;
+
+    f32 score = (cachePosition >= 0) ? cacheScores[cachePosition] : 0.f;
+    return score + valenceScores[minimum(remainingValence, MESH_OPTIMIZE_MAX_VALENCE - 1)];
 }
 
-void circle(i32 x, i32 y, i32 radius)
+// reorders the triangles for the post-transform vertex cache, Tom Forsyth's linear-speed algorithm
+void optimizeVertexCache(Mesh *mesh)
 {
-    if (platformState.fillFlag) {
-        glColor4f(platformState.fillColor.r, platformState.fillColor.g, platformState.fillColor.b, platformState.fillColor.a);
-        glBegin(GL_TRIANGLE_FAN);
-        glVertex2i(x, y);
-        for (f32 angle = 0.f; angle < TWO_PI; angle += 0.1f) {
-            glVertex2f((f32)(x + cosinus(angle) * radius), (f32)(y + sinus(angle) * radius));
-        }
+    i32 indexCount = countArray(mesh->indices);
+    i32 vertexCount = countArray(mesh->positions);
+    i32 triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return;
 
-        // close the circle
-        glVertex2f((f32)x + (f32)cosinus(TWO_PI) * (f32)radius, (f32)y + (f32)sinus(TWO_PI) * (f32)radius);
-        glEnd();
-        glColor4f(platformState.strokeColor.r, platformState.strokeColor.g, platformState.strokeColor.b, platformState.strokeColor.a);
+    // triangles around every vertex, the live ones are kept at the front of each list
+    i32 *valence = (i32 *)calloc(vertexCount, sizeof(i32));
+    i32 *firstTriangle = (i32 *)malloc(sizeof(i32) * (vertexCount + 1));
+    i32 *vertexTriangles = (i32 *)malloc(sizeof(i32) * indexCount);
+    for (i32 i = 0; i < indexCount; i++)
+        valence[mesh->indices[i]]++;
+
+    firstTriangle[0] = 0;
+    for (i32 i = 0; i < vertexCount; i++)
+        firstTriangle[i + 1] = firstTriangle[i] + valence[i];
+    for (i32 i = 0; i < vertexCount; i++)
+        valence[i] = 0;
+    for (i32 i = 0; i < indexCount; i++) {
+        u32 v = mesh->indices[i];
+        vertexTriangles[firstTriangle[v] + valence[v]++] = i / 3;
     }
 
-    if (platformState.lineWidth > 0) {
-        glBegin(GL_LINE_STRIP);
-        for (f32 angle = 0; angle < PI * 4; angle += (PI / 50.0f)) {
-            glVertex2f((f32)(x + sinus(angle) * radius), (f32)(y + cosinus(angle) * radius));
+    i32 *cachePosition = (i32 *)malloc(sizeof(i32) * vertexCount);
+    f32 *vertexScore = (f32 *)malloc(sizeof(f32) * vertexCount);
+    for (i32 i = 0; i < vertexCount; i++) {
+        cachePosition[i] = -1;
+        vertexScore[i] = forsythVertexScore(-1, valence[i]);
+    }
+
+    f32 *triangleScore = (f32 *)malloc(sizeof(f32) * triangleCount);
+    u8 *emitted = (u8 *)calloc(triangleCount, 1);
+    for (i32 i = 0; i < triangleCount; i++) {
+        u32 *t = mesh->indices + i * 3;
+        triangleScore[i] = vertexScore[t[0]] + vertexScore[t[1]] + vertexScore[t[2]];
+    }
+
+    u32 *result = (u32 *)malloc(sizeof(u32) * indexCount);
+    u32 cache[MESH_OPTIMIZE_CACHE_SIZE + 3];
+    u32 newCache[MESH_OPTIMIZE_CACHE_SIZE + 3];
+    i32 cacheCount = 0;
+    i32 scanPosition = 0;
+
+    // start with the best triangle overall
+    i32 best = 0;
+    for (i32 i = 1; i < triangleCount; i++) {
+        if (triangleScore[i] > triangleScore[best])
+            best = i;
+    }
+
+    for (i32 emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+        if (best < 0) {
+            // nothing in the cache has triangles left, continue with the next unused triangle
+            while (emitted[scanPosition])
+                scanPosition++;
+            best = scanPosition;
         }
-        glEnd();
+
+        u32 *t = mesh->indices + best * 3;
+        result[emittedCount * 3] = t[0];
+        result[emittedCount * 3 + 1] = t[1];
+        result[emittedCount * 3 + 2] = t[2];
+        emitted[best] = true;
+
+        // remove the triangle from the lists of its vertices
+        for (i32 j = 0; j < 3; j++) {
+            u32 v = t[j];
+            i32 *list = vertexTriangles + firstTriangle[v];
+            for (i32 k = 0; k < valence[v]; k++) {
+                if (list[k] == best) {
+                    list[k] = list[--valence[v]];
+                    break;
+                }
+            }
+        }
+
+        // move the triangle's vertices to the front of the cache
+        i32 newCount = 0;
+        newCache[newCount++] = t[0];
+        newCache[newCount++] = t[1];
+        newCache[newCount++] = t[2];
+        for (i32 j = 0; j < cacheCount; j++) {
+            u32 v = cache[j];
+            if (v != t[0] && v != t[1] && v != t[2])
+                newCache[newCount++] = v;
+        }
+
+        // rescore the vertices and the triangles around them, the ones that fell out of the cache too
+        best = -1;
+        f32 bestScore = -1.f;
+        for (i32 j = 0; j < newCount; j++) {
+            u32 v = newCache[j];
+            cachePosition[v] = (j < MESH_OPTIMIZE_CACHE_SIZE) ? j : -1;
+            f32 score = forsythVertexScore(cachePosition[v], valence[v]);
+            f32 change = score - vertexScore[v];
+            vertexScore[v] = score;
+
+            i32 *list = vertexTriangles + firstTriangle[v];
+            for (i32 k = 0; k < valence[v]; k++) {
+                i32 triangle = list[k];
+                triangleScore[triangle] += change;
+                if (cachePosition[v] >= 0 && triangleScore[triangle] > bestScore) {
+                    bestScore = triangleScore[triangle];
+                    best = triangle;
+                }
+            }
+        }
+
+        cacheCount = minimum(newCount, MESH_OPTIMIZE_CACHE_SIZE);
+        for (i32 j = 0; j < cacheCount; j++)
+            cache[j] = newCache[j];
     }
-}
 
-void circle(f32 x, f32 y, f32 radius)
-{
-    circle((i32)x, (i32)y, (i32)radius);
+    for (i32 i = 0; i < indexCount; i++)
+        mesh->indices[i] = result[i];
+
+    free(result);
+    free(emitted);
+    free(triangleScore);
+    free(vertexScore);
+    free(cachePosition);
+    free(vertexTriangles);
+    free(firstTriangle);
+    free(valence);
 }
 
-void ellipse(i32 x, i32 y, i32 r1, i32 r2 = 0)
+// reorders the vertices in the order the triangles use them, so the vertex fetches read memory
+// front to back, vertices no triangle uses are dropped
+void optimizeVertexFetch(Mesh *mesh)
 {
-    if (r2 == 0)
-        r2 = r1;
-    if (platformState.fillFlag) {
-        glColor4f(platformState.fillColor.r, platformState.fillColor.g, platformState.fillColor.b, platformState.fillColor.a);
-        glBegin(GL_TRIANGLE_FAN);
-        glVertex2i(x, y);
-        for (f32 angle = 0.f; angle < TWO_PI; angle += 0.02f) {
-            glVertex2f(f32(x + cos(angle) * r1), f32(y + sin(angle) * r2));
-        }
-        glEnd();
-        glColor4f(platformState.strokeColor.r, platformState.strokeColor.g, platformState.strokeColor.b, platformState.strokeColor.a);
-    }
+    i32 indexCount = countArray(mesh->indices);
+    i32 vertexCount = countArray(mesh->positions);
+    if (indexCount == 0)
+        return;
 
-    if (platformState.lineWidth > 0) {
-        glBegin(GL_LINE_STRIP);
-        for (f32 angle = 0; angle < PI * 4; angle += (PI / 50.0f)) {
-            glVertex2f((f32)(x + sin(angle) * r1), (f32)(y + cos(angle) * r2));
+    u32 *remap = (u32 *)malloc(sizeof(u32) * vertexCount);
+    for (i32 i = 0; i < vertexCount; i++)
+        remap[i] = 0xffffffff;
+
+    Mesh result = Mesh();
+    for (i32 i = 0; i < indexCount; i++) {
+        u32 v = mesh->indices[i];
+        if (remap[v] == 0xffffffff) {
+            if (mesh->texCoords)
+                remap[v] = meshVertex(&result, mesh->positions[v], mesh->normals[v], mesh->texCoords[v]);
+            else
+                remap[v] = meshVertex(&result, mesh->positions[v], mesh->normals[v]);
         }
-        glEnd();
+        mesh->indices[i] = remap[v];
     }
+
+    freeArray(mesh->positions);
+    freeArray(mesh->normals);
+    freeArray(mesh->texCoords);
+    mesh->positions = result.positions;
+    mesh->normals = result.normals;
+    mesh->texCoords = result.texCoords;
+    free(remap);
 }
 
-void ellipse(f32 x, f32 y, f32 r1, f32 r2 = 0.f)
+struct TriangleCluster
 {
-    ellipse((i32)x, (i32)y, (i32)r1, (i32)r2);
+    i32 first;
+    i32 count;
+    f32 sortKey;
+};
+
+internal int
+compareClusters(const void *a, const void *b)
+{
+    f32 ka = ((TriangleCluster *)a)->sortKey;
+    f32 kb = ((TriangleCluster *)b)->sortKey;
+    return (ka > kb) ? -1 : ((ka < kb) ? 1 : 0);
 }
 
-void arc(i32 x, i32 y, i32 r1, i32 r2, f32 start, f32 end)
+// sorts runs of cache optimized triangles so the ones facing away from the center are drawn first and
+// occlude the rest, run after optimizeVertexCache(). the runs are split where the cache restarts, and again
+// where their acmr gets within the threshold of the whole run, a higher threshold gives smaller runs.
+void optimizeOverdraw(Mesh *mesh, f32 threshold = 1.05f)
 {
-    if (r2 == 0)
-        r2 = r1;
+    i32 indexCount = countArray(mesh->indices);
+    i32 vertexCount = countArray(mesh->positions);
+    i32 triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return;
 
-    if (platformState.lineWidth > 0) {
-        glBegin(GL_LINE_STRIP);
-        for (f32 angle = start; angle <= end; angle += 0.02f)
-            glVertex2f((f32)x + cosinus(angle) * (f32)r1, (f32)y + sinus(angle) * (f32)r2);
+    // a triangle where all three vertices miss starts a new run
+    u8 *triangleMisses = (u8 *)malloc(triangleCount);
+    simulateVertexCache(mesh->indices, indexCount, vertexCount, triangleMisses);
+
+    u32 *timestamps = (u32 *)calloc(vertexCount, sizeof(u32));
+    u32 time = MESH_ANALYZE_CACHE_SIZE + 1;
+
+    TriangleCluster *clusters = 0;
+    i32 start = 0;
+    for (i32 i = 1; i <= triangleCount; i++) {
+        if (i < triangleCount && triangleMisses[i] != 3)
+            continue;
+
+        i32 runMisses = 0;
+        for (i32 j = start; j < i; j++)
+            runMisses += triangleMisses[j];
+        f32 limit = threshold * (f32)runMisses / (f32)(i - start);
+
+        // split the run where the acmr of the cluster so far drops to the limit, every cluster starts cold
+        TriangleCluster cluster = { start, 0, 0.f };
+        i32 misses = 0;
+        time += MESH_ANALYZE_CACHE_SIZE + 1;
+        for (i32 j = start; j < i; j++) {
+            for (i32 k = 0; k < 3; k++) {
+                u32 v = mesh->indices[j * 3 + k];
+                if (time - timestamps[v] > MESH_ANALYZE_CACHE_SIZE) {
+                    timestamps[v] = time++;
+                    misses++;
+                }
+            }
+            cluster.count++;
+            if ((cluster.count > 1 && (f32)misses / (f32)cluster.count <= limit) || j == i - 1) {
+                pushArray(clusters, cluster);
+                cluster.first = j + 1;
+                cluster.count = 0;
+                misses = 0;
+                time += MESH_ANALYZE_CACHE_SIZE + 1;
+            }
+        }
+        start = i;
+    }
+    free(timestamps);
+    free(triangleMisses);
+
+    v3 meshCenter = v3(0.f, 0.f, 0.f);
+    for (i32 i = 0; i < vertexCount; i++)
+        meshCenter += mesh->positions[i];
+    meshCenter *= 1.f / (f32)vertexCount;
+
+    for (i32 i = 0; i < countArray(clusters); i++) {
+        TriangleCluster *cluster = clusters + i;
+        v3 center = v3(0.f, 0.f, 0.f);
+        v3 normal = v3(0.f, 0.f, 0.f);
+        f32 area = 0.f;
+        for (i32 j = cluster->first; j < cluster->first + cluster->count; j++) {
+            v3 a = mesh->positions[mesh->indices[j * 3]];
+            v3 b = mesh->positions[mesh->indices[j * 3 + 1]];
+            v3 c = mesh->positions[mesh->indices[j * 3 + 2]];
+            v3 n = v3CrossProduct(b - a, c - a);
+            f32 weight = n.length();
+            center += (a + b + c) * (weight / 3.f);
+            normal += n;
+            area += weight;
+        }
+        if (area > 0.f)
+            center *= 1.f / area;
+        normal.normalize();
+        cluster->sortKey = v3DotProduct(center - meshCenter, normal);
+    }
 
-        glEnd();
+    qsort(clusters, countArray(clusters), sizeof(TriangleCluster), compareClusters);
+
+    u32 *result = (u32 *)malloc(sizeof(u32) * indexCount);
+    i32 count = 0;
+    for (i32 i = 0; i < countArray(clusters); i++) {
+        for (i32 j = clusters[i].first * 3; j < (clusters[i].first + clusters[i].count) * 3; j++)
+            result[count++] = mesh->indices[j];
     }
+    for (i32 i = 0; i < indexCount; i++)
+        mesh->indices[i] = result[i];
+
+    free(result);
+    freeArray(clusters);
 }
 
-void triangle(i32 x1, i32 y1, i32 x2, i32 y2, i32 x3, i32 y3)
+// runs the optimizations selected by flags before the mesh is built, returns the cache stats before and after
+void optimizeMesh(Mesh *mesh, i32 flags, MeshCacheStats *before = 0, MeshCacheStats *after = 0)
 {
-    glColor4f(platformState.fillColor.r, platformState.fillColor.g, platformState.fillColor.b, platformState.fillColor.a);
+    if (before)
+        *before = analyzeVertexCache(mesh);
 
-    glBegin(GL_TRIANGLE_FAN);
-    glVertex2i(x1, y1);
-    glVertex2i(x2, y2);
-    glVertex2i(x3, y3);
-    glEnd();
+    if (flags & MESH_OPTIMIZE_CACHE)
+        optimizeVertexCache(mesh);
+    if (flags & MESH_OPTIMIZE_OVERDRAW)
+        optimizeOverdraw(mesh);
+    if (flags & MESH_OPTIMIZE_FETCH)
+        optimizeVertexFetch(mesh);
+
+    if (after)
+        *after = analyzeVertexCache(mesh);
 }
 
-enum { CLOSE = 1 };
-void beginShape(i32 close = 0)
-{
-    if (platformState.fillFlag) {
-        glColor4f(platformState.fillColor.r, platformState.fillColor.g, platformState.fillColor.b, platformState.fillColor.a);
-        glBegin(GL_TRIANGLE_FAN);
-        //glBegin(GL_POLYGON);
+
+// Instancing
+
+// meshes up to this many vertices are transformed on the CPU and drawn in batches
+#define INSTANCE_BATCH_MAX_MESH_VERTICES 512
+#define INSTANCE_BATCH_VERTICES 65536
+
+internal void
+reserveInstanceBatch(i32 vertexCount, i32 indexCount)
+{
+    InstanceBatch *batch = &instanceBatch;
+    if (vertexCount > batch->vertexCapacity) {
+        batch->positions = (v3 *)realloc(batch->positions, sizeof(v3) * vertexCount);
+        batch->normals = (v3 *)realloc(batch->normals, sizeof(v3) * vertexCount);
+        batch->colors = (u32 *)realloc(batch->colors, sizeof(u32) * vertexCount);
+        batch->vertexCapacity = vertexCount;
     }
-    else {
-        glColor4f(platformState.strokeColor.r, platformState.strokeColor.g, platformState.strokeColor.b, platformState.strokeColor.a);
+    if (indexCount > batch->indexCapacity) {
+        batch->indices = (u32 *)realloc(batch->indices, sizeof(u32) * indexCount);
+        batch->indexCapacity = indexCount;
+        batch->indexSerial = 0;
+    }
+}
 
-        if (close == CLOSE)
-            glBegin(GL_LINE_LOOP);
-        else
-            glBegin(GL_LINE_STRIP);
+// transforms the vertices of one instance into the batch arrays, the normals use the
+// cofactor matrix (inverse transpose times the determinant) so non-uniform scaling works
+internal void
+transformInstance(Mesh *mesh, const m4 *m, u32 color, v3 *positions, v3 *normals, u32 *colors)
+{
+    f32 m00 = m->e[0][0], m01 = m->e[0][1], m02 = m->e[0][2], m03 = m->e[0][3];
+    f32 m10 = m->e[1][0], m11 = m->e[1][1], m12 = m->e[1][2], m13 = m->e[1][3];
+    f32 m20 = m->e[2][0], m21 = m->e[2][1], m22 = m->e[2][2], m23 = m->e[2][3];
+
+    f32 n00 = m11 * m22 - m12 * m21, n01 = m12 * m20 - m10 * m22, n02 = m10 * m21 - m11 * m20;
+    f32 n10 = m02 * m21 - m01 * m22, n11 = m00 * m22 - m02 * m20, n12 = m01 * m20 - m00 * m21;
+    f32 n20 = m01 * m12 - m02 * m11, n21 = m02 * m10 - m00 * m12, n22 = m00 * m11 - m01 * m10;
+    if (m00 * n00 + m01 * n01 + m02 * n02 < 0.f) {
+        // mirrored, flip the normals back out
+        n00 = -n00; n01 = -n01; n02 = -n02;
+        n10 = -n10; n11 = -n11; n12 = -n12;
+        n20 = -n20; n21 = -n21; n22 = -n22;
+    }
+
+    i32 vertexCount = countArray(mesh->positions);
+    for (i32 i = 0; i < vertexCount; i++) {
+        v3 p = mesh->positions[i];
+        v3 n = mesh->normals[i];
+        positions[i].x = m00 * p.x + m01 * p.y + m02 * p.z + m03;
+        positions[i].y = m10 * p.x + m11 * p.y + m12 * p.z + m13;
+        positions[i].z = m20 * p.x + m21 * p.y + m22 * p.z + m23;
+        normals[i].x = n00 * n.x + n01 * n.y + n02 * n.z;
+        normals[i].y = n10 * n.x + n11 * n.y + n12 * n.z;
+        normals[i].z = n20 * n.x + n21 * n.y + n22 * n.z;
+        colors[i] = color;
     }
 }
 
-void endShape()
+// draws a mesh once for every transform, colors are packed with packColor() or 0 to use the fill color.
+// the fixed function pipeline has no hardware instancing, so small meshes are transformed on the CPU into
+// one vertex array and drawn with a single call per batch, larger meshes load the matrix and call the
+// display list once per instance.
+void drawInstanced(Mesh *mesh, const m4 *transforms, const u32 *colors, i32 count)
 {
-    glEnd();
-}
+    if (!mesh || mesh->list == 0 || count <= 0)
+        return;
 
+    flushMatrix();
+    u32 fill = fillColorPacked();
 
-// Light
+    i32 vertexCount = countArray(mesh->positions);
+    i32 indexCount = countArray(mesh->indices);
 
-void noLights()
-{
-    glDisable(GL_LIGHTING);
-}
+    if (vertexCount > INSTANCE_BATCH_MAX_MESH_VERTICES) {
+        Matrix matrix;
+        glColor4ubv((u8 *)&fill);
+        for (i32 i = 0; i < count; i++) {
+            if (colors)
+                glColor4ubv((u8 *)(colors + i));
+            m4ToMatrix(transforms + i, matrix);
+            glPushMatrix();
+            glMultMatrixf(matrix);
+            glCallList(mesh->list);
+            glPopMatrix();
+        }
+        return;
+    }
 
-// set default light
-void lights()
-{
-    // light values and coordinates
-    f32 ambientLight[] = { 0.5f, 0.5f, 0.5f, 1.0f };
-    f32 diffuseLight[] = { 0.5f, 0.5f, 0.5f, 1.0f };
-    f32 lightPos[] = { 0.f, 50.0f, 100.0f, 0.0f };
+    InstanceBatch *batch = &instanceBatch;
+    i32 batchInstances = minimum(count, INSTANCE_BATCH_VERTICES / vertexCount);
+    reserveInstanceBatch(batchInstances * vertexCount, batchInstances * indexCount);
 
-    glEnable(GL_LIGHTING);
+    // the indices only change with the mesh, every instance offsets them by its first vertex
+    if (mesh->serial == 0 || batch->indexSerial != mesh->serial || batch->indexCount != indexCount ||
+        batch->indexInstances < batchInstances) {
+        for (i32 i = 0; i < batchInstances; i++) {
+            for (i32 j = 0; j < indexCount; j++)
+                batch->indices[i * indexCount + j] = mesh->indices[j] + i * vertexCount;
+        }
+        batch->indexSerial = mesh->serial;
+        batch->indexCount = indexCount;
+        batch->indexInstances = batchInstances;
+    }
 
-    // setup and enable light 0
-    glLightfv(GL_LIGHT0, GL_AMBIENT, ambientLight);
-    glLightfv(GL_LIGHT0, GL_DIFFUSE, diffuseLight);
-    glLightfv(GL_LIGHT0, GL_POSITION, lightPos);
-    glEnable(GL_LIGHT0);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(v3), batch->positions);
+    glNormalPointer(GL_FLOAT, sizeof(v3), batch->normals);
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(u32), batch->colors);
+
+    for (i32 first = 0; first < count; first += batchInstances) {
+        i32 instances = minimum(batchInstances, count - first);
+        for (i32 i = 0; i < instances; i++) {
+            i32 offset = i * vertexCount;
+            transformInstance(mesh, transforms + first + i, colors ? colors[first + i] : fill,
+                batch->positions + offset, batch->normals + offset, batch->colors + offset);
+        }
+        glDrawElements(GL_TRIANGLES, instances * indexCount, GL_UNSIGNED_INT, batch->indices);
+    }
 
-    // enable color tracking
-    glEnable(GL_COLOR_MATERIAL);
-    // set material properties to follow glColor values
-    glColorMaterial(GL_FRONT, GL_AMBIENT_AND_DIFFUSE);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+
+    // the color array leaves the current color undefined
+    glColor4ubv((u8 *)&fill);
 }
 
-void ambientLight(f32 r, f32 g, f32 b, f32 a = 1.0f)
+
+// meshes added between beginBatch() and endBatch() are transformed with the current matrix on the CPU
+// and drawn with one call, so thousands of small shapes with their own transforms cost a single draw
+struct MeshBatch
 {
-    glEnable(GL_LIGHTING);
+    v3 *positions;
+    v3 *normals;
+    u32 *colors;
+    u32 *indices;
+};
 
-    // ambient light, directionless light, dark white light
-    float ambientLight[] = { r, g, b,a };
+global MeshBatch meshBatch;
 
-    // set light model to use ambient light
-    glLightModelfv(GL_LIGHT_MODEL_AMBIENT, ambientLight);
-    // enable material color tracking
-    glEnable(GL_COLOR_MATERIAL);
-    // front material ambient and diffuse colors track glColor
-    glColorMaterial(GL_FRONT, GL_AMBIENT_AND_DIFFUSE);
+void beginBatch()
+{
+    MeshBatch *batch = &meshBatch;
+    if (batch->positions) {
+        stb__sbn(batch->positions) = 0;
+        stb__sbn(batch->normals) = 0;
+        stb__sbn(batch->colors) = 0;
+    }
+    if (batch->indices)
+        stb__sbn(batch->indices) = 0;
+}
+
+internal void
+batchMeshTransform(Mesh *mesh, const m4 *transform, u32 color)
+{
+    MeshBatch *batch = &meshBatch;
+    i32 vertexCount = countArray(mesh->positions);
+    i32 indexCount = countArray(mesh->indices);
+    u32 first = countArray(batch->positions);
+
+    v3 *positions = stb_sb_add(batch->positions, vertexCount);
+    v3 *normals = stb_sb_add(batch->normals, vertexCount);
+    u32 *colors = stb_sb_add(batch->colors, vertexCount);
+    transformInstance(mesh, transform, color, positions, normals, colors);
+
+    u32 *indices = stb_sb_add(batch->indices, indexCount);
+    for (i32 i = 0; i < indexCount; i++)
+        indices[i] = mesh->indices[i] + first;
 }
 
-// diffuse light, light from a direction
-void directionalLight(f32 r, f32 g, f32 b, f32 x, f32 y, f32 z)
+// adds the mesh with the current matrix and the fill color, or color if it is not 0
+void batchMesh(Mesh *mesh, u32 color = 0)
 {
-    // position/direction of light
-    f32 lightPos[] = { x, y, z, 1.0 };
-    f32 ambientLight[] = { 0.3f, 0.3f, 0.3f, 1.0f };
-    f32 diffuseLight[] = { r, g, b, 1.0f };
-    glEnable(GL_LIGHTING);
+    if (mesh)
+        batchMeshTransform(mesh, topMatrix(), color ? color : fillColorPacked());
+}
 
-    // setup and enable light 0
-    glLightfv(GL_LIGHT0, GL_POSITION, lightPos);
-    glLightfv(GL_LIGHT0, GL_AMBIENT, ambientLight);
-    glLightfv(GL_LIGHT0, GL_DIFFUSE, diffuseLight);
-    glEnable(GL_LIGHT0);
+// draws everything added since beginBatch(), the vertices are already in eye space
+void endBatch()
+{
+    MeshBatch *batch = &meshBatch;
+    if (countArray(batch->indices) == 0)
+        return;
 
-    // enable color tracking
-    glEnable(GL_COLOR_MATERIAL);
-    // set Material properties to follow glColor values
-    glColorMaterial(GL_FRONT, GL_AMBIENT_AND_DIFFUSE);
+    glPushMatrix();
+    glLoadIdentity();
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(v3), batch->positions);
+    glNormalPointer(GL_FLOAT, sizeof(v3), batch->normals);
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(u32), batch->colors);
+    glDrawElements(GL_TRIANGLES, countArray(batch->indices), GL_UNSIGNED_INT, batch->indices);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+
+    glPopMatrix();
+
+    u32 fill = fillColorPacked();
+    glColor4ubv((u8 *)&fill);
 }
 
-void specularLight(f32 r, f32 g, f32 b, f32 x, f32 y, f32 z)
+// sorts the queued draws back to front into transparencyQueue.order
+internal void
+sortTransparent()
 {
-    //position/direction of light
-    f32 lightPos[] = { x, y, z, 1.f };
-    f32 ambientLight[] = { r * 0.3f, g * 0.3f, b * 0.3f, 1.0f };
-    f32 diffuseLight[] = { r * 0.7f, g * 0.7f, b * 0.7f, 1.f };
-    f32 specularLight[] = { r, g, b, 1.0f };
-    f32 specularReflectance[] = { r, g, b, 1.0f };
+    TransparencyQueue *queue = &transparencyQueue;
+    i32 count = countArray(queue->draws);
+    TransparentDraw *draws = queue->draws;
 
-    glEnable(GL_LIGHTING);
+    if (count > queue->capacity) {
+        queue->order = (u32 *)realloc(queue->order, sizeof(u32) * count);
+        queue->scratch = (u32 *)realloc(queue->scratch, sizeof(u32) * count);
+        queue->capacity = count;
+    }
 
-    // setup and enable light 0
-    glLightfv(GL_LIGHT0, GL_POSITION, lightPos);
-    glLightfv(GL_LIGHT0, GL_AMBIENT, ambientLight);
-    glLightfv(GL_LIGHT0, GL_DIFFUSE, diffuseLight);
-    glLightfv(GL_LIGHT0, GL_SPECULAR, specularLight);
-    glEnable(GL_LIGHT0);
+    // mostly static scenes queue the same draws every frame, then last frame's order only needs
+    // a few insertion sort moves. if it takes more than a move per draw, fall back to the radix sort
+    if (count == queue->orderCount) {
+        u32 *order = queue->order;
+        i32 moves = 0;
+        for (i32 i = 1; i < count && moves <= count; i++) {
+            u32 current = order[i];
+            i32 j = i;
+            while (j > 0 && draws[order[j - 1]].key > draws[current].key && moves <= count) {
+                order[j] = order[j - 1];
+                j--;
+                moves++;
+            }
+            order[j] = current;
+        }
+        if (moves <= count)
+            return;
+    }
 
-    // enable color tracking
-    glEnable(GL_COLOR_MATERIAL);
-    // set material properties to follow glColor values
-    glColorMaterial(GL_FRONT, GL_AMBIENT_AND_DIFFUSE);
+    // least significant byte first, the passes where all the keys share the byte are skipped
+    u32 *order = queue->order;
+    u32 *scratch = queue->scratch;
+    for (i32 i = 0; i < count; i++)
+        order[i] = i;
+
+    for (i32 shift = 0; shift < 32; shift += 8) {
+        i32 offsets[256] = { 0 };
+        for (i32 i = 0; i < count; i++)
+            offsets[(draws[i].key >> shift) & 0xff]++;
+        if (offsets[(draws[0].key >> shift) & 0xff] == count)
+            continue;
+
+        i32 sum = 0;
+        for (i32 i = 0; i < 256; i++) {
+            i32 bucket = offsets[i];
+            offsets[i] = sum;
+            sum += bucket;
+        }
+        for (i32 i = 0; i < count; i++) {
+            u32 index = order[i];
+            scratch[offsets[(draws[index].key >> shift) & 0xff]++] = index;
+        }
 
-    // set materials specular reflectivity and shininess
-    glMaterialfv(GL_FRONT, GL_SPECULAR, specularReflectance);
-    /*	The GL_SHININESS property sets the specular exponent of the material, which specifies how small and focused the specular highlight is.
-        The larger the value, the more shiny and pronounced the surface. The range of this parameter is 1-128 */
-    glMateriali(GL_FRONT, GL_SHININESS, 40);
+        u32 *swap = order;
+        order = scratch;
+        scratch = swap;
+    }
+
+    queue->order = order;
+    queue->scratch = scratch;
+    queue->orderCount = count;
 }
 
-void spotLight(f32 r, f32 g, f32 b, f32 x, f32 y, f32 z, f32 dirX, f32 dirY, f32 dirZ, f32 angle)
+// draws the queued translucent meshes back to front, called when draw() returns
+void drawTransparent()
 {
-    f32 lightPos[] = { x, y, z, 1.0f };
-    f32 specular[] = { r, g, b, 1.0f };
-    f32 specularRef[] = { r, g, b, 1.0f };
-    f32 ambient[] = { r * 0.5f, g * 0.5f, b * 0.5f, 1.0f };
-    f32 spotDir[] = { dirX, dirY, dirZ };
+    TransparencyQueue *queue = &transparencyQueue;
+    i32 count = countArray(queue->draws);
+    if (count == 0) {
+        queue->orderCount = 0;
+        return;
+    }
 
-    glEnable(GL_LIGHTING);
+    sortTransparent();
 
-    // setup and enable light 0
-    glLightModelfv(GL_LIGHT_MODEL_AMBIENT, ambient);
+    b32 blend = glIsEnabled(GL_BLEND);
+    GLboolean depthMask;
+    glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+    glEnable(GL_BLEND);
+    glDepthMask(GL_FALSE);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
-    glLightfv(GL_LIGHT0, GL_DIFFUSE, ambient);
-    glLightfv(GL_LIGHT0, GL_SPECULAR, specular);
-    glLightfv(GL_LIGHT0, GL_POSITION, lightPos);
-    glLightfv(GL_LIGHT0, GL_SPOT_DIRECTION, spotDir);
+    // small meshes go into one CPU transformed batch, a large mesh ends the batch so the order is kept
+    beginBatch();
+    for (i32 i = 0; i < count; i++) {
+        TransparentDraw *draw = queue->draws + queue->order[i];
+        if (draw->mesh->serial != draw->serial)
+            continue;
+        if (countArray(draw->mesh->positions) <= INSTANCE_BATCH_MAX_MESH_VERTICES) {
+            batchMeshTransform(draw->mesh, &draw->transform, draw->color);
+        }
+        else {
+            endBatch();
+            beginBatch();
+
+            Matrix m;
+            m4ToMatrix(&draw->transform, m);
+            glLoadMatrixf(m);
+            glColor4ubv((u8 *)&draw->color);
+            glCallList(draw->mesh->list);
+            matrixStack.dirty = true;
+        }
+    }
+    endBatch();
 
-    // set cut off angle to 60 degrees to create spot effect
-    glLightf(GL_LIGHT0, GL_SPOT_CUTOFF, angle);
+    glDepthMask(depthMask);
+    if (!blend)
+        glDisable(GL_BLEND);
+    if (!platformState.fillFlag)
+        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
-    glEnable(GL_LIGHT0);
+    stb__sbn(queue->draws) = 0;
+}
 
-    // enable color tracking
-    glEnable(GL_COLOR_MATERIAL);
 
-    // set material properties to follow glColor values
-    glColorMaterial(GL_FRONT, GL_AMBIENT_AND_DIFFUSE);
-    // set materials specular reflectivity and shininess
-    glMaterialfv(GL_FRONT, GL_SPECULAR, specularRef);
-    glMateriali(GL_FRONT, GL_SHININESS, 128);
+// Level of detail
+
+enum { LOD_OFF, LOD_AUTO };
+
+// LOD_AUTO lets sphere(), torus() and model() pick their tessellation from the size on screen.
+// pixelsPerSegment is the target edge length in pixels, hysteresis is the relative band
+// around a threshold that has to be crossed before the level changes, this prevents popping.
+void lodMode(i32 mode, f32 pixelsPerSegment = 6.f, f32 hysteresis = 0.2f)
+{
+    platformState.lodModeFlag = mode;
+    platformState.lodPixelsPerSegment = pixelsPerSegment;
+    platformState.lodHysteresis = hysteresis;
 }
 
+// returns the radius in pixels of a sphere at the origin of the current modelview matrix
+f32 projectedRadius(f32 radius)
+{
+    f32 mv[16], proj[16];
+    m4ToMatrix(topMatrix(), mv);
+    glGetFloatv(GL_PROJECTION_MATRIX, proj);
+
+    // use the largest axis scale of the modelview matrix
+    f32 scaleSquared = maximum(mv[0] * mv[0] + mv[1] * mv[1] + mv[2] * mv[2],
+        maximum(mv[4] * mv[4] + mv[5] * mv[5] + mv[6] * mv[6], mv[8] * mv[8] + mv[9] * mv[9] + mv[10] * mv[10]));
 
-// Blending
+    // clip w of the origin, the view distance for a perspective projection and 1 for orthographic
+    f32 w = proj[3] * mv[12] + proj[7] * mv[13] + proj[11] * mv[14] + proj[15] * mv[15];
+    if (w <= 0.0001f)
+        return FLT_MAX;
 
-enum { ALPHA_BLEND, ADDITIVE_BLEND, MULTIPLIED_BLEND };
+    return radius * squareRoot(scaleSquared) * absoluteValue(proj[5]) * platformState.windowHeight * 0.5f / w;
+}
 
-void blendMode(i32 mode)
+// the projection matrix times the current matrix, what OpenGL transforms vertices with
+m4 getClipMatrix()
 {
-    switch (mode) {
-    case ALPHA_BLEND:
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        break;
-    case ADDITIVE_BLEND:
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-        break;
-    case MULTIPLIED_BLEND:
-        glBlendFunc(GL_DST_COLOR, GL_ONE_MINUS_SRC_ALPHA);
-        break;
-    }
+    Matrix proj;
+    glGetFloatv(GL_PROJECTION_MATRIX, proj);
+    return m4Multiply(matrixToM4(proj), *topMatrix());
 }
 
+// projects points with the current projection and matrix to canvas coordinates, see projectPoints() above
+i32 projectPoints(const v3 *in, v2 *out, u32 *visible, i32 count)
+{
+    m4 m = getClipMatrix();
+    return projectPoints(&m, in, out, visible, count, (f32)platformState.canvasWidth, (f32)platformState.canvasHeight);
+}
 
-// Fog
-
-void enableFog(f32 start, f32 end, f32 r, f32 g, f32 b, f32 a)
+// picks a level from the screen space error of every level, levels are ordered from the finest (0) to the coarsest.
+// every LOD draw call in a frame gets its own slot that remembers the last level, this works as long as the
+// sketch draws its objects in the same order every frame
+internal i32
+selectLodLevel(f32 *errorInPixels, i32 levelCount)
 {
-    // fog setup
-    glEnable(GL_FOG);
-    glFogi(GL_FOG_MODE, /*GL_EXP2*/GL_LINEAR);		// fog equation
-    //glFogf(GL_FOG_DENSITY, 0.6f); //only works if GL_FOG_MODE == GL_EXP eller GL_EXP2
-    // Note that GL_FOG_START and GL_FOG_END only have an effect on GL_LINEAR fog
-    // where the fog starts and ends
-    glFogf(GL_FOG_START, start);
-    glFogf(GL_FOG_END, end);
-    f32 col[] = { r, g, b, a };
-    glFogfv(GL_FOG_COLOR, col);
+    f32 target = platformState.lodPixelsPerSegment;
+    f32 band = platformState.lodHysteresis;
+
+    i32 slot = platformState.lodSlot++;
+    while (countArray(platformState.lodLevels) <= slot)
+        pushArray(platformState.lodLevels, -1);
+
+    i32 level = platformState.lodLevels[slot];
+    b32 keep = level >= 0 && level < levelCount &&
+        errorInPixels[level] <= target * (1.f + band) &&
+        (level == levelCount - 1 || errorInPixels[level + 1] > target * (1.f - band));
+
+    if (!keep) {
+        // coarsest level that is still below the target
+        level = 0;
+        while (level + 1 < levelCount && errorInPixels[level + 1] <= target)
+            level++;
+    }
+
+    platformState.lodLevels[slot] = level;
+    return level;
 }
 
-void disableFog()
+global i32 sphereLodLevels[][2] = { { 64, 43 }, { 48, 32 }, { 32, 22 }, { 24, 16 }, { 16, 11 }, { 12, 8 }, { 8, 6 }, { 6, 4 } };
+global i32 torusLodLevels[][2] = { { 96, 58 }, { 61, 37 }, { 48, 29 }, { 32, 19 }, { 24, 14 }, { 16, 10 }, { 12, 7 }, { 8, 5 } };
+
+// picks slices and stacks for a ring of the given radius from its size on screen
+internal void
+selectLodTessellation(f32 radius, i32 levels[][2], i32 levelCount, i32 *slices, i32 *stacks)
 {
-    glDisable(GL_FOG);
+    f32 circumference = TWO_PI * projectedRadius(radius);
+    f32 error[8];
+    for (i32 i = 0; i < levelCount; i++)
+        error[i] = circumference / (f32)levels[i][0];
+
+    i32 level = selectLodLevel(error, levelCount);
+    *slices = levels[level][0];
+    *stacks = levels[level][1];
 }
 
 
@@ -3194,6 +8157,7 @@ void vertex(f32 x, f32 y, f32 z = 0.f)
 
 void cube(f32 size = 1.f)
 {
+    flushMatrix();
     glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
     glColor4f(platformState.strokeColor.r, platformState.strokeColor.g, platformState.strokeColor.b, platformState.strokeColor.a);
@@ -3257,6 +8221,7 @@ void cube(f32 size = 1.f)
 
 void plane(f32 w, f32 h)
 {
+    flushMatrix();
     glColor4f(platformState.fillColor.r, platformState.fillColor.g, platformState.fillColor.b, platformState.fillColor.a);
     glBegin(GL_QUADS);
     //glNormal3f(0.0, 0.0, 1.0);
@@ -3269,144 +8234,79 @@ void plane(f32 w, f32 h)
     glEnd();
 }
 
-void sphere(f32 radius, i32 slices = 24, i32 stacks = 16)
+// slices and stacks of 0 uses 24x16, or the size on screen when lodMode(LOD_AUTO) is on
+void sphere(f32 radius, i32 slices = 0, i32 stacks = 0)
 {
     glColor4f(platformState.fillColor.r, platformState.fillColor.g, platformState.fillColor.b, platformState.fillColor.a);
-#if 1
-    f32 drho = PI / (f32)stacks;
-    f32 dtheta = 2.0f * PI / (f32)slices;
-    f32 ds = 1.0f / (f32)slices;
-    f32 dt = 1.0f / (f32)stacks;
-    f32 t = 1.0f;
-    f32 s = 0.0f;
-
-    for (i32 i = 0; i < stacks; i++)
-    {
-        f32 rho = (f32)i * drho;
-        f32 srho = sin(rho);
-        f32 crho = cos(rho);
-        f32 srhodrho = sin(rho + drho);
-        f32 crhodrho = cos(rho + drho);
-
-        glBegin(GL_TRIANGLE_STRIP);
-        s = 0.0f;
-        for (i32 j = 0; j <= slices; j++)
-        {
-            f32 theta = (j == slices) ? 0.0f : j * dtheta;
-            f32 stheta = -sin(theta);
-            f32 ctheta = cos(theta);
-
-            f32 x = stheta * srho;
-            f32 y = ctheta * srho;
-            f32 z = crho;
-
-            glTexCoord2f(s, t);
-            glNormal3f(x, y, z);
-            glVertex3f(x * radius, y * radius, z * radius);
-
-            x = stheta * srhodrho;
-            y = ctheta * srhodrho;
-            z = crhodrho;
-            glTexCoord2f(s, t - dt);
-            s += ds;
-            glNormal3f(x, y, z);
-            glVertex3f(x * radius, y * radius, z * radius);
-        }
-        glEnd();
 
-        t -= dt;
+    if (slices <= 0 || stacks <= 0) {
+        slices = 24;
+        stacks = 16;
+        if (platformState.lodModeFlag == LOD_AUTO)
+            selectLodTessellation(radius, sphereLodLevels, arrayCount(sphereLodLevels), &slices, &stacks);
     }
-#else
-    GLUquadric *q = gluNewQuadric();
-    gluSphere(q, radius, slices, stacks);
-    gluDeleteQuadric(q);
-#endif
+
+    pushMatrix();
+    applyMatrix(m4Scaling(radius, radius, radius));
+    drawMesh(sphereMesh(slices, stacks));
+    popMatrix();
 }
 
-void torus(f32 majorRadius, f32 minorRadius, i32 numMajor = 61, i32 numMinor = 37)
+// numMajor and numMinor of 0 uses 61x37, or the size on screen when lodMode(LOD_AUTO) is on
+void torus(f32 majorRadius, f32 minorRadius, i32 numMajor = 0, i32 numMinor = 0)
 {
     glColor4f(platformState.fillColor.r, platformState.fillColor.g, platformState.fillColor.b, platformState.fillColor.a);
-    v3 normal;
-    f32 vNormal[3];
-    f64 majorStep = 2.0f * PI / numMajor;
-    f64 minorStep = 2.0f * PI / numMinor;
-    int i, j;
-
-    for (i = 0; i < numMajor; ++i) {
-        f64 a0 = i * majorStep;
-        f64 a1 = a0 + majorStep;
-        f32 x0 = cosinus((f32)a0);
-        f32 y0 = sinus((f32)a0);
-        f32 x1 = cosinus((f32)a1);
-        f32 y1 = sinus((f32)a1);
-
-        glBegin(GL_TRIANGLE_STRIP);
-        for (j = 0; j <= numMinor; ++j) {
-            f64 b = j * minorStep;
-            f32 c = cosinus((f32)b);
-            f32 r = minorRadius * c + majorRadius;
-            f32 z = minorRadius * sinus((f32)b);
-
-            glTexCoord2f((f32)(i) / (f32)(numMajor), (f32)(j) / (f32)(numMinor));
-            normal.x = x0 * c;
-            normal.y = y0 * c;
-            normal.z = z / minorRadius;
-            normal = v3Normalize(normal);
-            vNormal[0] = normal.x;
-            vNormal[1] = normal.y;
-            vNormal[2] = normal.z;
-            glNormal3fv(vNormal);
-            glVertex3f(x0 * r, y0 * r, z);
-
-            glTexCoord2f((f32)(i + 1) / (f32)(numMajor), (f32)(j) / (f32)(numMinor));
-            vNormal[0] = x1 * c;
-            vNormal[1] = y1 * c;
-            vNormal[2] = z / minorRadius;
-            glNormal3fv(vNormal);
-            glVertex3f(x1 * r, y1 * r, z);
-        }
-        glEnd();
+
+    if (numMajor <= 0 || numMinor <= 0) {
+        numMajor = 61;
+        numMinor = 37;
+        if (platformState.lodModeFlag == LOD_AUTO)
+            selectLodTessellation(majorRadius + minorRadius, torusLodLevels, arrayCount(torusLodLevels), &numMajor, &numMinor);
     }
+
+    pushMatrix();
+    applyMatrix(m4Scaling(majorRadius, majorRadius, majorRadius));
+    drawMesh(torusMesh(minorRadius / majorRadius, numMajor, numMinor));
+    popMatrix();
 }
 
+// cylinder along the z-axis from 0 to h
 void cylinder(f32 w, f32 h, i32 slices = 32, i32 stacks = 7)
 {
     glColor4f(platformState.fillColor.r, platformState.fillColor.g, platformState.fillColor.b, platformState.fillColor.a);
-    GLUquadricObj *q = gluNewQuadric();
-    gluCylinder(q, w, w, h, slices, stacks);
-    /*glBegin(GL_TRIANGLE_FAN);
-    for (f32 angle = 0; angle < 360; angle++)
-    {
-    glVertex2f(sin(angle) * width, cos(angle) * width);
-    }
-    glEnd();
-    translate(0.0f, height*2, 0.0f);
-    glBegin(GL_TRIANGLE_FAN);
-    for (f32 angle = 0; angle < 360; angle++)
-    {
-    glVertex2f(sin(angle) * width, cos(angle) * width);
-    }
-    glEnd();*/
-    gluDeleteQuadric(q);
+    pushMatrix();
+    applyMatrix(m4Scaling(w, w, h));
+    drawMesh(cylinderMesh(slices, stacks));
+    popMatrix();
 }
 
+// cone along the z-axis with the base at 0 and the tip at h
 void cone(f32 w, f32 h, i32 slices = 32, i32 stacks = 7)
 {
     glColor4f(platformState.fillColor.r, platformState.fillColor.g, platformState.fillColor.b, platformState.fillColor.a);
-    GLUquadricObj *q = gluNewQuadric();
-    gluCylinder(q, w, 0, h, slices, stacks);
-
-    glBegin(GL_TRIANGLE_FAN);
-    for (f32 angle = 0; angle < 360; angle++)
-        glVertex2f(sin(angle) * w, cos(angle) * w);
+    pushMatrix();
+    applyMatrix(m4Scaling(w, w, h));
+    drawMesh(coneMesh(slices, stacks));
+    popMatrix();
+}
 
-    glEnd();
+// cylinder along the z-axis from 0 to h with half spheres at the ends
+void capsule(f32 radius, f32 h, i32 slices = 24, i32 stacks = 16)
+{
+    // the mesh is built for radius 1, there is nothing to draw without one
+    if (radius <= 0.f)
+        return;
 
-    gluDeleteQuadric(q);
+    glColor4f(platformState.fillColor.r, platformState.fillColor.g, platformState.fillColor.b, platformState.fillColor.a);
+    pushMatrix();
+    applyMatrix(m4Scaling(radius, radius, radius));
+    drawMesh(capsuleMesh(h / radius, slices, stacks));
+    popMatrix();
 }
 
 void cone2(f32 w, f32 h)
 {
+    flushMatrix();
     //glColor4f(fillColor.r, fillColor.g, fillColor.b, fillColor.a);
     f32 x, y, angle;
     i32 pivot = 1;
@@ -3451,6 +8351,7 @@ void cone2(f32 w, f32 h)
 
 void box(f32 w, f32 h = 0, f32 depth = 0)
 {
+    flushMatrix();
     if (h == 0 && depth == 0)
         h = depth = w;
 
@@ -3515,6 +8416,7 @@ void box(f32 w, f32 h = 0, f32 depth = 0)
 
 void pyramid(f32 w, f32 h)
 {
+    flushMatrix();
     glColor4f(platformState.fillColor.r, platformState.fillColor.g, platformState.fillColor.b, platformState.fillColor.a);
     //draw pyramid
     glBegin(GL_TRIANGLES);
@@ -3631,8 +8533,10 @@ void image(Image texture, i32 x, i32 y, i32 w = 0, i32 h = 0)
     glEnable(GL_TEXTURE_2D);
     glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
 
+    // images ignore the current transform, the matrix stack is loaded again on the next draw
     glLoadIdentity();
     glTranslatef((f32)x, (f32)y, 0.0f);
+    matrixStack.dirty = true;
 
     glBindTexture(GL_TEXTURE_2D, texture.id);
 
@@ -3664,6 +8568,145 @@ void image(Image texture, i32 x, i32 y, i32 w = 0, i32 h = 0)
         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 }
 
+// noise images, noise mapped through a color ramp into RGBA pixels. the image is split in tiles that are
+// spread over the processors, every tile is filled by the grid kernels and colored through a lookup table
+// of NOISE_IMAGE_LUT packed colors
+#define NOISE_IMAGE_TILE 64
+#define NOISE_IMAGE_LUT 256
+
+// where the noise is sampled, pixel (px, py) is noise at (x + px * scale, y + py * scale), at depth z
+// when dimensions is 3
+struct NoiseImageParams
+{
+    const Noise *noise = 0; // 0 for the noise of noise()
+    f32 x = 0.f;
+    f32 y = 0.f;
+    f32 z = 0.f;
+    f32 scale = 0.01f;
+    i32 dimensions = 2;
+    i32 fractal = NOISE_FBM;
+};
+
+struct NoiseImageJob
+{
+    NoiseImageParams params;
+    const Noise *noise;
+    u32 *pixels;
+    i32 width, height;
+    i32 tilesX;
+    u32 lut[NOISE_IMAGE_LUT];
+};
+
+// the ramp resampled to the lookup table, the colors in between are blended
+internal void
+noiseImageLut(u32 *lut, const Color *ramp, i32 count)
+{
+    for (i32 i = 0; i < NOISE_IMAGE_LUT; i++) {
+        if (count < 2) {
+            lut[i] = packColor(ramp[0]);
+            continue;
+        }
+        f32 position = (f32)i / (f32)(NOISE_IMAGE_LUT - 1) * (f32)(count - 1);
+        i32 index = minimum((i32)position, count - 2);
+        lut[i] = packColor(lerpColor(ramp[index], ramp[index + 1], position - (f32)index));
+    }
+}
+
+internal void
+noiseImageTiles(void *data, i32 first, i32 last)
+{
+    NoiseImageJob *job = (NoiseImageJob *)data;
+    const NoiseImageParams *p = &job->params;
+    f32 values[NOISE_IMAGE_TILE * NOISE_IMAGE_TILE];
+    for (i32 t = first; t < last; t++) {
+        i32 x0 = (t % job->tilesX) * NOISE_IMAGE_TILE;
+        i32 y0 = (t / job->tilesX) * NOISE_IMAGE_TILE;
+        i32 w = minimum(NOISE_IMAGE_TILE, job->width - x0);
+        i32 h = minimum(NOISE_IMAGE_TILE, job->height - y0);
+        NoiseGrid grid = { job->noise->perm, values, w, p->dimensions == 3 ? 3 : 2, job->noise->octaves, job->noise->falloff,
+            p->fractal, { p->x + (f32)x0 * p->scale, p->y + (f32)y0 * p->scale, p->z }, { p->scale, 0.f, 0.f },
+            { 0.f, p->scale, 0.f } };
+        noiseGridRows(&grid, 0, h);
+
+        for (i32 y = 0; y < h; y++) {
+            u32 *row = job->pixels + (i64)(y0 + y) * job->width + x0;
+            const f32 *v = values + y * w;
+            for (i32 x = 0; x < w; x++)
+                row[x] = job->lut[(i32)(constrainf(v[x], 0.f, 1.f) * (f32)(NOISE_IMAGE_LUT - 1) + 0.5f)];
+        }
+    }
+}
+
+// fills w * h pixels with red in the lowest byte, the layout of GL_RGBA textures and of
+// stbi_write_png(filename, w, h, 4, pixels, w * 4). the ramp goes from noise 0 to noise 1 and is packed
+// in the current colorMode
+void noisePixels(u32 *pixels, i32 w, i32 h, NoiseImageParams params, const Color *ramp, i32 rampCount)
+{
+    Assert(rampCount > 0);
+    if (w <= 0 || h <= 0)
+        return;
+    NoiseImageJob job;
+    job.params = params;
+    job.noise = params.noise ? params.noise : &noiseDefault;
+    job.pixels = pixels;
+    job.width = w;
+    job.height = h;
+    job.tilesX = (w + NOISE_IMAGE_TILE - 1) / NOISE_IMAGE_TILE;
+    noiseImageLut(job.lut, ramp, rampCount);
+    i32 tilesY = (h + NOISE_IMAGE_TILE - 1) / NOISE_IMAGE_TILE;
+    parallelFor(job.tilesX * tilesY, 2, noiseImageTiles, &job);
+}
+
+// a noise texture ready for image()
+Image noiseImage(i32 w, i32 h, NoiseImageParams params, const Color *ramp, i32 rampCount)
+{
+    u32 *pixels = (u32 *)malloc(sizeof(u32) * w * h);
+    noisePixels(pixels, w, h, params, ramp, rampCount);
+
+    Image result;
+    glGenTextures(1, &result.id);
+    glBindTexture(GL_TEXTURE_2D, result.id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    result.width = w;
+    result.height = h;
+
+    free(pixels);
+    return result;
+}
+
+// new noise in an image made by noiseImage(), for noise that moves. the texture is updated in place
+void noiseImageUpdate(Image *img, NoiseImageParams params, const Color *ramp, i32 rampCount)
+{
+    u32 *pixels = (u32 *)malloc(sizeof(u32) * img->width * img->height);
+    noisePixels(pixels, img->width, img->height, params, ramp, rampCount);
+    glBindTexture(GL_TEXTURE_2D, img->id);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, img->width, img->height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    free(pixels);
+}
+
+// the same with a ramp from colorRamp<count>()
+template <i32 count>
+inline void noisePixels(u32 *pixels, i32 w, i32 h, NoiseImageParams params, const LookupTable<Color, count> &ramp)
+{
+    noisePixels(pixels, w, h, params, ramp.e, count);
+}
+
+template <i32 count>
+inline Image noiseImage(i32 w, i32 h, NoiseImageParams params, const LookupTable<Color, count> &ramp)
+{
+    return noiseImage(w, h, params, ramp.e, count);
+}
+
+template <i32 count>
+inline void noiseImageUpdate(Image *img, NoiseImageParams params, const LookupTable<Color, count> &ramp)
+{
+    noiseImageUpdate(img, params, ramp.e, count);
+}
+
 void sprite(u32 tex, i32 x, i32 y, i32 w, i32 h)
 {
     // check if wireframe rendering is turned on
@@ -3675,6 +8718,7 @@ void sprite(u32 tex, i32 x, i32 y, i32 w, i32 h)
 
     glLoadIdentity();
     glTranslatef((f32)x, (f32)y, 0.0f);
+    matrixStack.dirty = true;
 
     glBindTexture(GL_TEXTURE_2D, tex);
 
@@ -3711,7 +8755,8 @@ void sprite3d(u32 tex, v3 pos, i32 w, i32 h)
     glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
 
     pushMatrix();
-    glTranslatef(pos.x, pos.y, pos.z);
+    translate(pos.x, pos.y, pos.z);
+    flushMatrix();
     glBindTexture(GL_TEXTURE_2D, tex);
 
     // place texture on quad
@@ -3811,7 +8856,7 @@ struct Sprite
 
         u32 error = glGetError();
         if (error != GL_NO_ERROR) {
-            quitError("Failed to load pixels from texture: %s\n", gluErrorString(error));
+            quitError("Failed to load pixels from texture: error 0x%x\n", error);
             return false;
         }
 
@@ -3870,6 +8915,7 @@ struct Sprite
     // TODO: Fix all the drawing functions
     void draw()
     {
+        flushMatrix();
         // check if wireframe rendering is turned on
         if (platformState.fillFlag == false)
             glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
@@ -3916,6 +8962,7 @@ struct Sprite
             // reset identity matrix to remove previous transformations
             glLoadIdentity();
             glTranslatef(x, y, 0.f);
+            matrixStack.dirty = true;
             glBindTexture(GL_TEXTURE_2D, id);
 
             // place texture on quad
@@ -3941,6 +8988,7 @@ struct Sprite
     // NOTE: origin is relative to destination rectangle size
     void drawEx(Rect sourceRec, Rect destRec, v2 origin, f32 rotation, Color tint)
     {
+        flushMatrix();
         if (id != 0) {
             if (sourceRec.w < 0) sourceRec.x -= sourceRec.w;
             if (sourceRec.h < 0) sourceRec.y -= sourceRec.h;
@@ -4035,6 +9083,7 @@ struct Sprite
         if (id != 0) {
             glEnable(GL_TEXTURE_2D);
             glLoadIdentity();
+            matrixStack.dirty = true;
 
             // texture coordinates
             f32 texTop = 0.f;
@@ -4112,8 +9161,72 @@ char *moveToNextLine(char *cont)
     return cont;
 }
 
-// load blender obj file
-int loadModel(char *filename)
+#define MODEL_LOD_LEVELS 4
+
+struct Model
+{
+    Mesh lods[MODEL_LOD_LEVELS]; // lods[0] is the full model, the others are simplified
+    f32 cellSize[MODEL_LOD_LEVELS]; // clustering grid size of every level, the error in model units
+    i32 lodCount;
+};
+
+global Model *models;
+
+// simplifies a mesh by merging all vertices inside the same grid cell into one vertex
+internal void
+clusterMesh(Mesh *source, f32 cellSize, Mesh *result)
+{
+    i32 vertexCount = countArray(source->positions);
+    VertexMap map = createVertexMap(vertexCount);
+    u32 *remap = (u32 *)malloc(sizeof(u32) * vertexCount);
+    f32 *weights = 0;
+
+    for (i32 i = 0; i < vertexCount; i++) {
+        v3 p = source->positions[i];
+        u64 x = (u64)(floorFloatToInt(p.x / cellSize) + (1 << 20)) & 0x1fffff;
+        u64 y = (u64)(floorFloatToInt(p.y / cellSize) + (1 << 20)) & 0x1fffff;
+        u64 z = (u64)(floorFloatToInt(p.z / cellSize) + (1 << 20)) & 0x1fffff;
+
+        u32 *cluster = findVertex(&map, x | (y << 21) | (z << 42));
+        if (*cluster == 0xffffffff) {
+            *cluster = meshVertex(result, v3(0.f, 0.f, 0.f), v3(0.f, 0.f, 0.f));
+            pushArray(weights, 0.f);
+        }
+        result->positions[*cluster] += p;
+        weights[*cluster] += 1.f;
+        remap[i] = *cluster;
+    }
+
+    for (i32 i = 0; i < countArray(result->positions); i++)
+        result->positions[i] *= 1.f / weights[i];
+
+    // drop the triangles that collapsed and average the area weighted face normals
+    for (i32 i = 0; i < countArray(source->indices); i += 3) {
+        u32 a = remap[source->indices[i]];
+        u32 b = remap[source->indices[i + 1]];
+        u32 c = remap[source->indices[i + 2]];
+        if (a == b || b == c || c == a)
+            continue;
+
+        v3 n = v3CrossProduct(result->positions[b] - result->positions[a], result->positions[c] - result->positions[a]);
+        result->normals[a] += n;
+        result->normals[b] += n;
+        result->normals[c] += n;
+        meshTriangle(result, a, b, c);
+    }
+
+    for (i32 i = 0; i < countArray(result->normals); i++)
+        result->normals[i].normalize();
+
+    freeArray(weights);
+    free(remap);
+    freeVertexMap(&map);
+}
+
+// load blender obj file, returns the model id used by model()
+// optimizeFlags selects the MESH_OPTIMIZE_ passes run on every level, before and after get the vertex cache
+// stats of the full detail level, they are only written when there are passes to run
+int loadModel(char *filename, i32 optimizeFlags = 0, MeshCacheStats *before = 0, MeshCacheStats *after = 0)
 {
     v3 *vertex = 0;
     Face *faces = 0;
@@ -4162,31 +9275,51 @@ int loadModel(char *filename)
         contents = moveToNextLine(contents);
     }
 
-    // generate a display list
-    i32 num = glGenLists(1);
+    Model result = Model();
+    Mesh *mesh = &result.lods[0];
 
-    glNewList(num, GL_COMPILE);
+    // faces with the same normal share their vertices, quads are split into two triangles
+    VertexMap map = createVertexMap(countArray(faces) * 4);
     for (i32 i = 0; i < countArray(faces); i++) {
-        //quads?
-        if (faces[i].quad) {
-            glBegin(GL_QUADS);
-            glNormal3f(normals[faces[i].facenum - 1].x, normals[faces[i].facenum - 1].y, normals[faces[i].facenum - 1].z); //-1 because C index from 0
-            glVertex3f(vertex[faces[i].faces[0] - 1].x, vertex[faces[i].faces[0] - 1].y, vertex[faces[i].faces[0] - 1].z);
-            glVertex3f(vertex[faces[i].faces[1] - 1].x, vertex[faces[i].faces[1] - 1].y, vertex[faces[i].faces[1] - 1].z);
-            glVertex3f(vertex[faces[i].faces[2] - 1].x, vertex[faces[i].faces[2] - 1].y, vertex[faces[i].faces[2] - 1].z);
-            glVertex3f(vertex[faces[i].faces[3] - 1].x, vertex[faces[i].faces[3] - 1].y, vertex[faces[i].faces[3] - 1].z);
-            glEnd();
+        u32 corners[4];
+        i32 cornerCount = faces[i].quad ? 4 : 3;
+        for (i32 j = 0; j < cornerCount; j++) {
+            //-1 because C index from 0
+            u32 *index = findVertex(&map, ((u64)faces[i].faces[j] << 32) | (u32)faces[i].facenum);
+            if (*index == 0xffffffff)
+                *index = meshVertex(mesh, vertex[faces[i].faces[j] - 1], normals[faces[i].facenum - 1]);
+            corners[j] = *index;
         }
-        else {
-            glBegin(GL_TRIANGLES);
-            glNormal3f(normals[faces[i].facenum - 1].x, normals[faces[i].facenum - 1].y, normals[faces[i].facenum - 1].z); //-1 because C index from 0
-            glVertex3f(vertex[faces[i].faces[0] - 1].x, vertex[faces[i].faces[0] - 1].y, vertex[faces[i].faces[0] - 1].z);
-            glVertex3f(vertex[faces[i].faces[1] - 1].x, vertex[faces[i].faces[1] - 1].y, vertex[faces[i].faces[1] - 1].z);
-            glVertex3f(vertex[faces[i].faces[2] - 1].x, vertex[faces[i].faces[2] - 1].y, vertex[faces[i].faces[2] - 1].z);
-            glEnd();
+
+        meshTriangle(mesh, corners[0], corners[1], corners[2]);
+        if (faces[i].quad)
+            meshTriangle(mesh, corners[0], corners[2], corners[3]);
+    }
+    freeVertexMap(&map);
+
+    if (optimizeFlags)
+        optimizeMesh(mesh, optimizeFlags, before, after);
+    buildMesh(mesh);
+    result.lodCount = 1;
+
+    // simplified levels for lodMode(LOD_AUTO), each level merges vertices on a grid twice as coarse
+    f32 cellSize = mesh->radius / 16.f;
+    while (result.lodCount < MODEL_LOD_LEVELS) {
+        Mesh *lod = &result.lods[result.lodCount];
+        clusterMesh(mesh, cellSize, lod);
+        if (countArray(lod->indices) < 3 * 16) {
+            freeMesh(lod);
+            break;
         }
+
+        if (optimizeFlags)
+            optimizeMesh(lod, optimizeFlags);
+        buildMesh(lod);
+        result.cellSize[result.lodCount++] = cellSize;
+        cellSize *= 2.f;
     }
-    glEndList();
+
+    pushArray(models, result);
 
     // cleanup
     freeArray(faces);
@@ -4195,12 +9328,45 @@ int loadModel(char *filename)
 
     contents = contentsAddress;
     free(contents);
-    return num;
+    return countArray(models) - 1;
 }
 
 void model(i32 object)
 {
-    glCallList(object);
+    if (object < 0 || object >= countArray(models))
+        return;
+
+    Model *m = models + object;
+    i32 level = 0;
+    if (platformState.lodModeFlag == LOD_AUTO && m->lodCount > 1) {
+        f32 pixelsPerUnit = projectedRadius(1.f);
+        f32 error[MODEL_LOD_LEVELS];
+        for (i32 i = 0; i < m->lodCount; i++)
+            error[i] = m->cellSize[i] * pixelsPerUnit;
+        level = selectLodLevel(error, m->lodCount);
+    }
+
+    drawMesh(&m->lods[level]);
+}
+
+// returns the mesh of a loaded model for drawInstanced(), level 0 is the full model
+Mesh *modelMesh(i32 object, i32 level = 0)
+{
+    if (object < 0 || object >= countArray(models))
+        return 0;
+
+    Model *m = models + object;
+    return &m->lods[constrain(level, 0, m->lodCount - 1)];
+}
+
+void freeModels()
+{
+    for (i32 i = 0; i < countArray(models); i++) {
+        for (i32 j = 0; j < models[i].lodCount; j++)
+            freeMesh(&models[i].lods[j]);
+    }
+    freeArray(models);
+    models = 0;
 }
 
 //
@@ -4319,6 +9485,24 @@ u32 getTicks()
     return result;
 }
 
+internal f64
+performanceCounterPeriod()
+{
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    return 1.0 / (f64)frequency.QuadPart;
+}
+
+global f64 secondsPerCount = performanceCounterPeriod();
+
+// returns a high resolution time in seconds from an arbitrary start, for timing code. subtract two calls
+f64 seconds()
+{
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return (f64)counter.QuadPart * secondsPerCount;
+}
+
 /*
 ------------------------------------------------------------------------------
 This software is available under 2 licenses - you may choose the one you like.
@@ -84,7 +84,8 @@ void draw()
 	translate(0.0f, 0.0f, zPos);
 	rotateX(angle);
 
-	// draw pyramid
+	// draw pyramid, raw GL needs the matrix loaded first
+	flushMatrix();
 	glBegin(GL_TRIANGLES);
 	glColor3f(1.0f, 0.0f, 0.0f);
 	glVertex3f(0.0f, 1.0f, 0.0f);		//top - front
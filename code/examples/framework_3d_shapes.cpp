@@ -21,13 +21,14 @@ void draw()
 	clear(c64blue);
 	translate(10.f, -15.f, -80.f);
 
+	// the same rotation for every shape, built once per frame
+	quat spin = quatFromEuler(radians(angle), radians(angle), radians(angle));
+
 	// draw cube
 	pushMatrix();
 		fill(magenta);
 		translate(-55.f, 0.f, 0.f);
-		rotateX(angle);
-		rotateY(angle);
-		rotateZ(angle);
+		rotate(spin);
 		cube(8);
 	popMatrix();
 
@@ -35,9 +36,7 @@ void draw()
 	pushMatrix();
 		fill(blue);
 		translate(-30.f, 0.f, 0.f);
-		rotateX(angle);
-		rotateY(angle);
-		rotateZ(angle);
+		rotate(spin);
 		plane(20, 20);
 	popMatrix();
 
@@ -45,9 +44,7 @@ void draw()
 	pushMatrix();
 		fill(pink);
 		translate(0.f, 0.0f, 0.f);
-		rotateX(angle);
-		rotateY(angle);
-		rotateZ(angle);
+		rotate(spin);
 		noFill();
 		sphere(10);
 	popMatrix();
@@ -56,9 +53,7 @@ void draw()
 	pushMatrix();
 		fill(green);
 		translate(40.f, 0.0f, 0.f);
-		rotateX(angle);
-		rotateY(angle);
-		rotateZ(angle);
+		rotate(spin);
 		noFill();
 		torus(12, 6);
 	popMatrix();
@@ -67,9 +62,7 @@ void draw()
 	pushMatrix();
 		fill(c64cyan);
 		translate(-55.f, 35.f, 0.f);
-		rotateX(angle);
-		rotateY(angle);
-		rotateZ(angle);
+		rotate(spin);
 		box(5, 10, 15);
 	popMatrix();
 
@@ -87,9 +80,7 @@ void draw()
 	pushMatrix();
 		fill(yellow);
 		translate(0.f, 35.f, 0.f);
-		rotateX(angle);
-		rotateY(angle);
-		rotateZ(angle);
+		rotate(spin);
 		cylinder(10, 20);
 	popMatrix();
 
@@ -98,9 +89,7 @@ void draw()
 		fill(red);
 		noFill();
 		translate(40.f, 35.f, 0.f);
-		rotateX(angle);
-		rotateY(angle);
-		rotateZ(angle);
+		rotate(spin);
 		pyramid(10,15);
 	popMatrix();
 
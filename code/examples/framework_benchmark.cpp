@@ -0,0 +1,1057 @@
+﻿/*	Benchmark
+	Times the SIMD kernels, fast approximations and vector operations of the framework against the
+	scalar, libm and older code they replace. Shows the nanoseconds per operation and the max error of
+	the approximations, for the random distributions the error is the Kolmogorov-Smirnov distance of
+	65536 samples to the exact distribution. The benchmarks run once in setup(), build with optimizations on.
+	Click the mouse to show the next page.
+
+	Copyright (c) 2020 Martin Fairbanks
+	This example has been created using the cpp5 framework.
+	Licensing information can be found in the cpp5_framework.h file.
+*/
+
+#include "../cpp5_framework.h"
+#include <random> // std::normal_distribution, what randomGaussian() used before
+
+#define MAX_RESULTS 80
+#define BENCHMARK_COUNT 4096
+#define BENCHMARK_REPEATS 200
+#define ROWS_PER_PAGE 17
+#define DISTRIBUTION_SAMPLES 65536
+#define NOISE_GRID 64
+
+// times the statement over the benchmark arrays, i is the index of the current element
+#define TIME_LOOP(result, ...) \
+{ \
+	f64 loopStart = seconds(); \
+	for (i32 r = 0; r < BENCHMARK_REPEATS; r++) \
+		for (i32 i = 0; i < BENCHMARK_COUNT; i++) { __VA_ARGS__; } \
+	result = nanoseconds(loopStart, (i64)BENCHMARK_REPEATS * BENCHMARK_COUNT); \
+}
+
+struct BenchmarkResult
+{
+	const char *name;
+	f64 before;		// ns per operation
+	f64 after;
+	f64 maxError;	// against the double precision result, 0 for exact kernels
+};
+
+global BenchmarkResult results[MAX_RESULTS];
+global i32 resultCount;
+
+// the results are summed in here so the compiler can't remove the loops
+global volatile f32 sink;
+
+// globals keep the 16 byte alignment of m4
+global m4 a[BENCHMARK_COUNT];
+global m4 b[BENCHMARK_COUNT];
+global m4 out[BENCHMARK_COUNT];
+global v4 vectors[BENCHMARK_COUNT];
+global v4 transformed[BENCHMARK_COUNT];
+global v2 particles[BENCHMARK_COUNT];
+global v2 velocities[BENCHMARK_COUNT];
+global f32 angles[BENCHMARK_COUNT];
+global f32 sines[BENCHMARK_COUNT];
+global f32 cosines[BENCHMARK_COUNT];
+global v2 v2Results[BENCHMARK_COUNT];
+global v3 positions[BENCHMARK_COUNT];
+global v3 directions[BENCHMARK_COUNT];
+global v3 v3Results[BENCHMARK_COUNT];
+global quat fromOrientations[BENCHMARK_COUNT];
+global quat toOrientations[BENCHMARK_COUNT];
+global quat orientations[BENCHMARK_COUNT];
+global u32 visibleMask[BENCHMARK_COUNT / 32];
+global i32 page;
+
+internal f64
+nanoseconds(f64 start, i64 operations)
+{
+	return (seconds() - start) * 1e9 / (f64)operations;
+}
+
+internal void
+addResult(const char *name, f64 before, f64 after, f64 maxError = 0.0)
+{
+	if (resultCount < MAX_RESULTS)
+		results[resultCount++] = { name, before, after, maxError };
+}
+
+internal f32
+randomUnit()
+{
+	return (f32)rand() / (f32)RAND_MAX * 2.f - 1.f;
+}
+
+// largest difference of out to a * b computed in double precision
+internal f64
+m4MultiplyError(const m4 *a, const m4 *b, const m4 *out)
+{
+	f64 maxError = 0.0;
+	for (i32 i = 0; i < 4; i++) {
+		for (i32 j = 0; j < 4; j++) {
+			f64 exact = 0.0;
+			for (i32 k = 0; k < 4; k++)
+				exact += (f64)a->e[i][k] * (f64)b->e[k][j];
+			maxError = maximum(maxError, absoluteValue(exact - (f64)out->e[i][j]));
+		}
+	}
+	return maxError;
+}
+
+internal f64
+m4TransformError(const m4 *m, v4 in, v4 out)
+{
+	f64 maxError = 0.0;
+	for (i32 i = 0; i < 4; i++) {
+		f64 exact = 0.0;
+		for (i32 k = 0; k < 4; k++)
+			exact += (f64)m->e[i][k] * (f64)in.e[k];
+		maxError = maximum(maxError, absoluteValue(exact - (f64)out.e[i]));
+	}
+	return maxError;
+}
+
+// largest difference of m * inverse to the identity, in double precision
+internal f64
+m4InverseError(const m4 *m, const m4 *inverse)
+{
+	m4 identity = m4LoadIdentity();
+	f64 maxError = 0.0;
+	for (i32 i = 0; i < 4; i++) {
+		for (i32 j = 0; j < 4; j++) {
+			f64 product = 0.0;
+			for (i32 k = 0; k < 4; k++)
+				product += (f64)m->e[i][k] * (f64)inverse->e[k][j];
+			maxError = maximum(maxError, absoluteValue(product - (f64)identity.e[i][j]));
+		}
+	}
+	return maxError;
+}
+
+// every dispatch path is timed and checked, the max error column is against double precision
+internal void
+benchmarkMatrices()
+{
+	const i32 count = BENCHMARK_COUNT;
+	const i32 repeats = BENCHMARK_REPEATS;
+
+	for (i32 i = 0; i < count; i++) {
+		a[i] = m4Multiply(m4Translation(randomUnit(), randomUnit(), randomUnit()), m4RotationY(randomUnit()));
+		b[i] = m4Multiply(m4RotationX(randomUnit()), m4Scaling(2.f + randomUnit(), 2.f, 2.f));
+		vectors[i] = v4(randomUnit(), randomUnit(), randomUnit(), 1.f);
+	}
+
+	f64 start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		for (i32 i = 0; i < count; i++)
+			out[i] = m4MultiplyScalar(a[i], b[i]);
+	f64 scalar = nanoseconds(start, (i64)repeats * count);
+	sink += out[count - 1].e[0][0];
+
+	f64 maxError = 0.0;
+	start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		for (i32 i = 0; i < count; i++)
+			m4MultiplySSE(a + i, b + i, out + i);
+	f64 simd = nanoseconds(start, (i64)repeats * count);
+	maxError = 0.0;
+	for (i32 i = 0; i < count; i++)
+		maxError = maximum(maxError, m4MultiplyError(a + i, b + i, out + i));
+	addResult("m4Multiply SSE", scalar, simd, maxError);
+	sink += out[count - 1].e[0][0];
+
+	if (cpuFeatures.avx && cpuFeatures.fma) {
+		start = seconds();
+		for (i32 r = 0; r < repeats; r++)
+			for (i32 i = 0; i < count; i++)
+				m4MultiplyAVX(a + i, b + i, out + i);
+		simd = nanoseconds(start, (i64)repeats * count);
+		maxError = 0.0;
+		for (i32 i = 0; i < count; i++)
+			maxError = maximum(maxError, m4MultiplyError(a + i, b + i, out + i));
+		addResult("m4Multiply AVX/FMA", scalar, simd, maxError);
+		sink += out[count - 1].e[0][0];
+	}
+
+	start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		for (i32 i = 0; i < count; i++)
+			transformed[i] = m4MultiplyV4Scalar(a[r & 7], vectors[i]);
+	scalar = nanoseconds(start, (i64)repeats * count);
+	sink += transformed[count - 1].x;
+
+	// the last repeat used a[(repeats - 1) & 7]
+	const m4 *last = a + ((repeats - 1) & 7);
+	start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		m4TransformSSE(a + (r & 7), vectors, transformed, count);
+	simd = nanoseconds(start, (i64)repeats * count);
+	maxError = 0.0;
+	for (i32 i = 0; i < count; i++)
+		maxError = maximum(maxError, m4TransformError(last, vectors[i], transformed[i]));
+	addResult("m4MultiplyV4 SSE (per vector)", scalar, simd, maxError);
+	sink += transformed[count - 1].x;
+
+	if (cpuFeatures.avx && cpuFeatures.fma) {
+		start = seconds();
+		for (i32 r = 0; r < repeats; r++)
+			m4TransformAVX(a + (r & 7), vectors, transformed, count);
+		simd = nanoseconds(start, (i64)repeats * count);
+		maxError = 0.0;
+		for (i32 i = 0; i < count; i++)
+			maxError = maximum(maxError, m4TransformError(last, vectors[i], transformed[i]));
+		addResult("m4MultiplyV4 AVX/FMA (per vector)", scalar, simd, maxError);
+		sink += transformed[count - 1].x;
+	}
+
+	start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		for (i32 i = 0; i < count; i++)
+			out[i] = m4TransposeScalar(a[i]);
+	scalar = nanoseconds(start, (i64)repeats * count);
+	sink += out[count - 1].e[0][1];
+
+	start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		for (i32 i = 0; i < count; i++)
+			out[i] = m4Transpose(a[i]);
+	addResult("m4Transpose", scalar, nanoseconds(start, (i64)repeats * count));
+	sink += out[count - 1].e[0][1];
+
+	start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		for (i32 i = 0; i < count; i++)
+			m4InverseScalar(a + i, out + i);
+	scalar = nanoseconds(start, (i64)repeats * count);
+	sink += out[count - 1].e[0][3];
+
+	start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		for (i32 i = 0; i < count; i++)
+			m4InverseSSE(a + i, out + i);
+	simd = nanoseconds(start, (i64)repeats * count);
+	maxError = 0.0;
+	for (i32 i = 0; i < count; i++)
+		maxError = maximum(maxError, m4InverseError(a + i, out + i));
+	addResult("m4Inverse SSE", scalar, simd, maxError);
+	sink += out[count - 1].e[0][3];
+
+	// a point cloud in front of a perspective camera, about half of it inside the view
+	m4 clip = m4Multiply(m4Perspective(60.f, 16.f / 9.f, 0.1f, 10.f), m4Translation(0.f, 0.f, -1.5f));
+	for (i32 i = 0; i < count; i++)
+		positions[i] = v3(vectors[i].x, vectors[i].y, vectors[i].z);
+
+	start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		for (i32 i = 0; i < count; i++)
+			transformed[i] = m4MultiplyV4Scalar(clip, v4(positions[i].x, positions[i].y, positions[i].z, 1.f));
+	scalar = nanoseconds(start, (i64)repeats * count);
+	sink += transformed[count - 1].x;
+
+	start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		transformPoints(&clip, positions, transformed, count);
+	addResult("transformPoints (per point)", scalar, nanoseconds(start, (i64)repeats * count));
+	sink += transformed[count - 1].x;
+
+	i32 visibleCount = 0;
+	start = seconds();
+	for (i32 r = 0; r < repeats; r++) {
+		for (i32 i = 0; i < count; i++) {
+			v4 c = m4MultiplyV4Scalar(clip, v4(positions[i].x, positions[i].y, positions[i].z, 1.f));
+			v2Results[i] = v2((c.x / c.w) * 480.f + 480.f, 270.f - (c.y / c.w) * 270.f);
+			visibleCount += c.w > 0.f && fabsf(c.x) <= c.w && fabsf(c.y) <= c.w && fabsf(c.z) <= c.w;
+		}
+	}
+	scalar = nanoseconds(start, (i64)repeats * count);
+	sink += v2Results[count - 1].x + (f32)visibleCount;
+
+	start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		visibleCount += projectPoints(&clip, positions, v2Results, visibleMask, count, 960.f, 540.f);
+	addResult("projectPoints (per point)", scalar, nanoseconds(start, (i64)repeats * count));
+	sink += v2Results[count - 1].x + (f32)visibleCount;
+}
+
+internal void
+benchmarkVectorArrays()
+{
+	const i32 count = BENCHMARK_COUNT;
+	const i32 repeats = BENCHMARK_REPEATS;
+
+	v2Array position = v2ArrayCreate(count);
+	v2Array velocity = v2ArrayCreate(count);
+	for (i32 i = 0; i < count; i++) {
+		particles[i] = v2(randomUnit() * 100.f, randomUnit() * 100.f);
+		velocities[i] = v2(randomUnit() * 10.f, randomUnit() * 10.f);
+		v2ArraySet(&position, i, particles[i]);
+		v2ArraySet(&velocity, i, velocities[i]);
+	}
+
+	f64 start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		for (i32 i = 0; i < count; i++)
+			particles[i] += velocities[i] * 0.01f;
+	f64 scalar = nanoseconds(start, (i64)repeats * count);
+	sink += particles[count - 1].x;
+
+	start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		v2ArrayMultiplyAdd(&position, &position, &velocity, 0.01f);
+	addResult("v2ArrayMultiplyAdd (per vector)", scalar, nanoseconds(start, (i64)repeats * count));
+	sink += position.x[count - 1];
+
+	start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		for (i32 i = 0; i < count; i++)
+			velocities[i].normalize();
+	scalar = nanoseconds(start, (i64)repeats * count);
+	sink += velocities[count - 1].x;
+
+	start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		v2ArrayNormalize(&velocity, &velocity);
+	addResult("v2ArrayNormalize (per vector)", scalar, nanoseconds(start, (i64)repeats * count));
+	sink += velocity.x[count - 1];
+
+	start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		for (i32 i = 0; i < count; i++)
+			particles[i].limit(50.f);
+	scalar = nanoseconds(start, (i64)repeats * count);
+	sink += particles[count - 1].x;
+
+	start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		v2ArrayLimit(&position, &position, 50.f);
+	addResult("v2ArrayLimit (per vector)", scalar, nanoseconds(start, (i64)repeats * count));
+	sink += position.x[count - 1];
+
+	v2ArrayFree(&velocity);
+	v2ArrayFree(&position);
+}
+
+// 100000 particles stored the way the old Array did, a pointer to a heap allocation each, against
+// Array<v2>. the particles are created in a shuffled order like after a while of adding and removing
+internal void
+benchmarkArray()
+{
+	const i32 count = 100000, repeats = 20;
+	void **pointers = (void **)malloc(sizeof(void *) * count);
+	Array<v2> array;
+	array.reserve(count);
+	for (i32 i = 0; i < count; i++) {
+		v2 *p = (v2 *)malloc(sizeof(v2));
+		*p = v2(random(100.f), random(100.f));
+		pointers[i] = p;
+		array.push(*p);
+	}
+	for (i32 i = count - 1; i > 0; i--) {
+		i32 j = random(0, i);
+		void *swap = pointers[i];
+		pointers[i] = pointers[j];
+		pointers[j] = swap;
+	}
+
+	v2 sum = v2(0.f, 0.f);
+	f64 start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		for (i32 i = 0; i < count; i++)
+			sum += *(v2 *)pointers[i];
+	f64 before = nanoseconds(start, (i64)repeats * count);
+	start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		for (v2 &p : array)
+			sum += p;
+	addResult("void ** Array vs Array<v2> scan", before, nanoseconds(start, (i64)repeats * count));
+	sink += sum.x;
+
+	for (i32 i = 0; i < count; i++)
+		free(pointers[i]);
+	free(pointers);
+	array.freeMem();
+}
+
+internal void
+benchmarkTrigonometry()
+{
+	const i32 count = BENCHMARK_COUNT;
+	const i32 repeats = BENCHMARK_REPEATS;
+
+	// the accuracy is checked over a wide range of angles, the timing runs on angles a sketch would use
+	f64 sinCosError = 0.0;
+	for (i32 i = 0; i < 1000000; i++) {
+		f32 angle = -1000.f + 2000.f * (f32)i / 1000000.f;
+		f32 s, c;
+		fastSinCos(angle, &s, &c);
+		sinCosError = maximum(sinCosError, fabs(s - sin((f64)angle)));
+		sinCosError = maximum(sinCosError, fabs(c - cos((f64)angle)));
+	}
+
+	f64 atan2Error = 0.0;
+	for (i32 i = 0; i < 1000000; i++) {
+		f32 y = randomUnit() * 100.f;
+		f32 x = randomUnit() * 100.f;
+		atan2Error = maximum(atan2Error, fabs(fastAtan2(y, x) - atan2((f64)y, (f64)x)));
+	}
+
+	for (i32 i = 0; i < count; i++)
+		angles[i] = randomUnit() * TWO_PI;
+
+	f64 start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		for (i32 i = 0; i < count; i++) {
+			sines[i] = sinf(angles[i]);
+			cosines[i] = cosf(angles[i]);
+		}
+	f64 libm = nanoseconds(start, (i64)repeats * count);
+	sink += sines[count - 1] + cosines[count - 1];
+
+	start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		for (i32 i = 0; i < count; i++)
+			fastSinCos(angles[i], sines + i, cosines + i);
+	addResult("fastSinCos vs sinf + cosf", libm, nanoseconds(start, (i64)repeats * count), sinCosError);
+	sink += sines[count - 1] + cosines[count - 1];
+
+	start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		fastSinCosArray(angles, sines, cosines, count);
+	addResult("fastSinCosArray vs sinf + cosf", libm, nanoseconds(start, (i64)repeats * count), sinCosError);
+	sink += sines[count - 1] + cosines[count - 1];
+
+	start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		for (i32 i = 0; i < count; i++)
+			sines[i] = atan2f(angles[i], angles[(i + r) & (count - 1)]);
+	libm = nanoseconds(start, (i64)repeats * count);
+	sink += sines[count - 1];
+
+	start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		for (i32 i = 0; i < count; i++)
+			sines[i] = fastAtan2(angles[i], angles[(i + r) & (count - 1)]);
+	addResult("fastAtan2 vs atan2f", libm, nanoseconds(start, (i64)repeats * count), atan2Error);
+	sink += sines[count - 1];
+
+	start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		fastAtan2Array(angles, cosines, sines, count);
+	addResult("fastAtan2Array vs atan2f", libm, nanoseconds(start, (i64)repeats * count), atan2Error);
+	sink += sines[count - 1];
+}
+
+// the vector code before it was rewritten without trigonometry and with inverse square roots
+internal void
+setLengthBefore(v2 *v, f32 length)
+{
+	f32 a = v->heading();
+	v->x = cosf(a) * length;
+	v->y = sinf(a) * length;
+}
+
+internal void
+setAngleBefore(v2 *v, f32 angle)
+{
+	f32 l = v->length();
+	v->x = cosf(angle) * l;
+	v->y = sinf(angle) * l;
+}
+
+internal void
+limitBefore(v2 *v, f32 max)
+{
+	if (v->length() > max)
+		setLengthBefore(v, max);
+}
+
+internal void
+normalizeBefore(v2 *v)
+{
+	f32 l = v->length();
+	if (l > 0) {
+		v->x *= 1 / l;
+		v->y *= 1 / l;
+	}
+}
+
+internal f32
+angleBetweenBefore(v2 a, v2 b)
+{
+	return acosf(a.dotProduct(b) / (a.length() * b.length()));
+}
+
+internal v2
+divideBefore(v2 a, f32 scalar)
+{
+	return v2(a.x / scalar, a.y / scalar);
+}
+
+internal void
+v3NormalizeBefore(v3 *v)
+{
+	f32 l = v->length();
+	if (l > 0)
+		*v *= 1 / l;
+}
+
+internal v3
+v3DivideBefore(v3 a, f32 scalar)
+{
+	return v3(a.x / scalar, a.y / scalar, a.z / scalar);
+}
+
+// lengths of unit vectors that put lengthSquared() below FLT_MIN or near FLT_MAX, where the rsqrt estimate
+// alone breaks
+global f32 extremeScales[] = { 1e-20f, 1e-19f, 1.f, 1e18f, 1e19f };
+
+// largest distance of the normalized length to 1, v2 normalize and setLength, v3 normalize and quatNormalize
+internal f64
+extremeNormalizeError()
+{
+	f64 maxError = 0.0;
+	for (i32 i = 0; i < BENCHMARK_COUNT; i++)
+	{
+		f32 scale = extremeScales[i % arrayCount(extremeScales)];
+		v2 a = particles[i] * (scale / particles[i].length());
+		v2 b = a;
+		v3 c = directions[i];
+		a.normalize();
+		b.setLength(2.f);
+		c.normalize();
+		quat q = quatNormalize(quat{ directions[i].x, directions[i].y, directions[i].z, 0.f });
+		maxError = maximum(maxError, absoluteValue(sqrt((f64)a.x * a.x + (f64)a.y * a.y) - 1.0));
+		maxError = maximum(maxError, absoluteValue(sqrt((f64)b.x * b.x + (f64)b.y * b.y) - 2.0));
+		maxError = maximum(maxError, absoluteValue(sqrt((f64)c.x * c.x + (f64)c.y * c.y + (f64)c.z * c.z) - 1.0));
+		maxError = maximum(maxError, absoluteValue(sqrt((f64)q.x * q.x + (f64)q.y * q.y + (f64)q.z * q.z) - 1.0));
+	}
+	return maxError;
+}
+
+internal void
+benchmarkVectors()
+{
+	for (i32 i = 0; i < BENCHMARK_COUNT; i++) {
+		particles[i] = v2(randomUnit() * 100.f, randomUnit() * 100.f);
+		velocities[i] = v2(randomUnit() * 10.f, randomUnit() * 10.f);
+		angles[i] = randomUnit() * TWO_PI;
+		positions[i] = v3(randomUnit() * 100.f, randomUnit() * 100.f, randomUnit() * 100.f);
+		directions[i] = v3(randomUnit(), randomUnit(), randomUnit());
+	}
+
+	// operations that weren't changed are timed once and show up with the same time in both columns
+	f64 before, after;
+	TIME_LOOP(after, v2Results[i] = particles[i] + velocities[i]);
+	addResult("v2 +", after, after);
+	TIME_LOOP(after, v2Results[i] = particles[i] - velocities[i]);
+	addResult("v2 -", after, after);
+	TIME_LOOP(after, v2Results[i] = particles[i] * angles[i]);
+	addResult("v2 * scalar", after, after);
+	TIME_LOOP(before, v2Results[i] = divideBefore(particles[i], angles[i]));
+	TIME_LOOP(after, v2Results[i] = particles[i] / angles[i]);
+	addResult("v2 / scalar", before, after);
+	TIME_LOOP(after, v2Results[i] = -particles[i]);
+	addResult("v2 negate", after, after);
+	TIME_LOOP(after, v2Results[i] = v2Hadamard(particles[i], velocities[i]));
+	addResult("v2Hadamard", after, after);
+	TIME_LOOP(after, sines[i] = v2DotProduct(particles[i], velocities[i]));
+	addResult("v2DotProduct", after, after);
+	TIME_LOOP(after, sines[i] = particles[i].length());
+	addResult("v2 length", after, after);
+	TIME_LOOP(after, sines[i] = particles[i].heading());
+	addResult("v2 heading", after, after);
+	TIME_LOOP(after, sines[i] = dist(particles[i], velocities[i]));
+	addResult("dist", after, after);
+	TIME_LOOP(before, sines[i] = angleBetweenBefore(particles[i], velocities[i]));
+	TIME_LOOP(after, sines[i] = particles[i].angleBetween(velocities[i]));
+	addResult("v2 angleBetween", before, after);
+	TIME_LOOP(before, v2Results[i] = particles[i]; normalizeBefore(v2Results + i));
+	TIME_LOOP(after, v2Results[i] = particles[i]; v2Results[i].normalize());
+	addResult("v2 normalize", before, after);
+	TIME_LOOP(before, v2Results[i] = particles[i]; setLengthBefore(v2Results + i, 5.f));
+	TIME_LOOP(after, v2Results[i] = particles[i]; v2Results[i].setLength(5.f));
+	addResult("v2 setLength", before, after);
+	TIME_LOOP(before, v2Results[i] = particles[i]; setAngleBefore(v2Results + i, angles[i]));
+	TIME_LOOP(after, v2Results[i] = particles[i]; v2Results[i].setAngle(angles[i]));
+	addResult("v2 setAngle", before, after);
+	TIME_LOOP(before, v2Results[i] = particles[i]; limitBefore(v2Results + i, 50.f));
+	TIME_LOOP(after, v2Results[i] = particles[i]; v2Results[i].limit(50.f));
+	addResult("v2 limit", before, after);
+	sink += v2Results[BENCHMARK_COUNT - 1].x + sines[BENCHMARK_COUNT - 1];
+
+	TIME_LOOP(after, v3Results[i] = positions[i] + directions[i]);
+	addResult("v3 +", after, after);
+	TIME_LOOP(after, v3Results[i] = positions[i] - directions[i]);
+	addResult("v3 -", after, after);
+	TIME_LOOP(after, v3Results[i] = positions[i] * angles[i]);
+	addResult("v3 * scalar", after, after);
+	TIME_LOOP(before, v3Results[i] = v3DivideBefore(positions[i], angles[i]));
+	TIME_LOOP(after, v3Results[i] = positions[i] / angles[i]);
+	addResult("v3 / scalar", before, after);
+	TIME_LOOP(after, sines[i] = v3DotProduct(positions[i], directions[i]));
+	addResult("v3DotProduct", after, after);
+	TIME_LOOP(after, v3Results[i] = v3CrossProduct(positions[i], directions[i]));
+	addResult("v3CrossProduct", after, after);
+	TIME_LOOP(after, sines[i] = positions[i].length());
+	addResult("v3 length", after, after);
+	TIME_LOOP(before, v3Results[i] = positions[i]; v3NormalizeBefore(v3Results + i));
+	TIME_LOOP(after, v3Results[i] = positions[i]; v3Results[i].normalize());
+	addResult("v3 normalize", before, after);
+	for (i32 i = 0; i < BENCHMARK_COUNT; i++)
+		directions[i] = positions[i] * (extremeScales[i % arrayCount(extremeScales)] / positions[i].length());
+	TIME_LOOP(before, v3Results[i] = directions[i]; v3NormalizeBefore(v3Results + i));
+	TIME_LOOP(after, v3Results[i] = directions[i]; v3Results[i].normalize());
+	addResult("v3 normalize tiny and huge", before, after, extremeNormalizeError());
+	sink += v3Results[BENCHMARK_COUNT - 1].x + sines[BENCHMARK_COUNT - 1];
+}
+
+// building each transform from euler angles with matrix products against interpolating quaternions
+internal void
+benchmarkQuaternions()
+{
+	for (i32 i = 0; i < BENCHMARK_COUNT; i++) {
+		angles[i] = randomUnit() * TWO_PI;
+		fromOrientations[i] = quatFromEuler(randomUnit(), randomUnit(), randomUnit());
+		toOrientations[i] = quatFromEuler(randomUnit(), randomUnit(), randomUnit());
+	}
+
+	f64 before, after;
+	TIME_LOOP(before, out[i] = m4Multiply(m4Multiply(m4RotationX(angles[i]), m4RotationY(angles[i])), m4RotationZ(angles[i])));
+	sink += out[BENCHMARK_COUNT - 1].e[0][0];
+
+	f64 start = seconds();
+	for (i32 r = 0; r < BENCHMARK_REPEATS; r++) {
+		quatSlerpArray(fromOrientations, toOrientations, (f32)r / BENCHMARK_REPEATS, orientations, BENCHMARK_COUNT);
+		for (i32 i = 0; i < BENCHMARK_COUNT; i++)
+			out[i] = quatToM4(orientations[i]);
+	}
+	after = nanoseconds(start, (i64)BENCHMARK_REPEATS * BENCHMARK_COUNT);
+	addResult("euler m4 vs slerp + quatToM4", before, after);
+	sink += out[BENCHMARK_COUNT - 1].e[0][0];
+
+	TIME_LOOP(before, orientations[i] = quatSlerp(fromOrientations[i], toOrientations[i], 0.3f));
+	start = seconds();
+	for (i32 r = 0; r < BENCHMARK_REPEATS; r++)
+		quatSlerpArray(fromOrientations, toOrientations, 0.3f, orientations, BENCHMARK_COUNT);
+	addResult("quatSlerp vs quatSlerpArray", before, nanoseconds(start, (i64)BENCHMARK_REPEATS * BENCHMARK_COUNT));
+	sink += orientations[BENCHMARK_COUNT - 1].w;
+}
+
+internal int
+compareFloats(const void *a, const void *b)
+{
+	f32 x = *(const f32 *)a;
+	f32 y = *(const f32 *)b;
+	return (x > y) - (x < y);
+}
+
+// the largest distance between the sample distribution and the exact one, about 0.006 is expected
+// for 65536 samples, a value well above 0.01 means the sampler is off
+internal f64
+ksDistance(f32 *samples, i32 count, f64 (*cdf)(f64 x))
+{
+	qsort(samples, count, sizeof(f32), compareFloats);
+	f64 result = 0.0;
+	for (i32 i = 0; i < count; i++) {
+		f64 c = cdf(samples[i]);
+		result = maximum(result, maximum(fabs(c - (f64)i / count), fabs(c - (f64)(i + 1) / count)));
+	}
+	return result;
+}
+
+internal f64
+normalCdf(f64 x)
+{
+	return 0.5 * erfc(-x / sqrt(2.0));
+}
+
+internal f64
+exponentialCdf(f64 x)
+{
+	return x < 0.0 ? 0.0 : 1.0 - exp(-x);
+}
+
+// ksDistance() for randomPoisson(mean), the cumulative frequencies of the samples against the exact ones
+internal f64
+poissonDistance(f32 mean)
+{
+	// the tail past mean + 20 standard deviations is far below what the samples can show
+	i32 bins = (i32)(mean + 20.f * sqrtf(mean)) + 20;
+	i32 *counts = (i32 *)calloc(bins, sizeof(i32));
+	for (i32 i = 0; i < DISTRIBUTION_SAMPLES; i++)
+		counts[minimum(randomPoisson(mean), bins - 1)]++;
+
+	f64 p = exp(-(f64)mean);
+	f64 exact = 0.0, sampled = 0.0, result = 0.0;
+	for (i32 k = 0; k < bins; k++)
+	{
+		exact += p;
+		sampled += (f64)counts[k] / DISTRIBUTION_SAMPLES;
+		result = maximum(result, fabs(exact - sampled));
+		p *= (f64)mean / (k + 1);
+	}
+	free(counts);
+	return result;
+}
+
+// montecarlo() as it was, rejection sampling with an acceptance of (1 - r1)^8
+internal f32
+montecarloRejection()
+{
+	while (true) {
+		f32 r1 = random();
+		f32 probability = powerOf(1.f - r1, 8.f);
+		f32 r2 = random();
+		if (r2 < probability)
+			return r1;
+	}
+}
+
+internal f32
+powerLaw(f32 x)
+{
+	return 1.f / (x * x);
+}
+
+// the largest difference between the bin frequencies of the samples and the weights the distribution was
+// built from. with 65536 samples the noise of the most likely power law bin is about 0.001
+internal f64
+binFrequencyError(const Distribution *d, const f32 *samples, i32 count, f32 (*pdf)(f32 x))
+{
+	i32 *counts = (i32 *)calloc(d->count, sizeof(i32));
+	f32 binWidth = (d->max - d->min) / (f32)d->count;
+	for (i32 i = 0; i < count; i++)
+		counts[constrain((i32)((samples[i] - d->min) / binWidth), 0, d->count - 1)]++;
+
+	f64 total = 0.0;
+	for (i32 i = 0; i < d->count; i++)
+		total += pdf(d->min + ((f32)i + 0.5f) * binWidth);
+
+	f64 result = 0.0;
+	for (i32 i = 0; i < d->count; i++)
+	{
+		f64 weight = pdf(d->min + ((f32)i + 0.5f) * binWidth) / total;
+		result = maximum(result, fabs((f64)counts[i] / count - weight));
+	}
+	free(counts);
+	return result;
+}
+
+// the ziggurat samplers against the std distributions and the inverse transform they replace
+internal void
+benchmarkDistributions()
+{
+	f32 *samples = (f32 *)malloc(DISTRIBUTION_SAMPLES * sizeof(f32));
+	std::default_random_engine engine;
+
+	f64 before, after;
+	TIME_LOOP(before, std::normal_distribution<f32> distribution(0.f, 1.f); sines[i] = distribution(engine));
+	TIME_LOOP(after, sines[i] = randomGaussian());
+	for (i32 i = 0; i < DISTRIBUTION_SAMPLES; i++)
+		samples[i] = randomGaussian();
+	addResult("randomGaussian vs std::normal_distribution", before, after, ksDistance(samples, DISTRIBUTION_SAMPLES, normalCdf));
+	sink += sines[BENCHMARK_COUNT - 1];
+
+	f64 start = seconds();
+	for (i32 r = 0; r < BENCHMARK_REPEATS; r++)
+		randomGaussianFill(sines, BENCHMARK_COUNT);
+	f64 fill = nanoseconds(start, (i64)BENCHMARK_REPEATS * BENCHMARK_COUNT);
+	randomGaussianFill(samples, DISTRIBUTION_SAMPLES);
+	addResult("randomGaussian vs randomGaussianFill", after, fill, ksDistance(samples, DISTRIBUTION_SAMPLES, normalCdf));
+	sink += sines[BENCHMARK_COUNT - 1];
+
+	TIME_LOOP(before, sines[i] = -logf(1.f - random()));
+	TIME_LOOP(after, sines[i] = randomExponential());
+	for (i32 i = 0; i < DISTRIBUTION_SAMPLES; i++)
+		samples[i] = randomExponential();
+	addResult("randomExponential vs -log(1 - random())", before, after, ksDistance(samples, DISTRIBUTION_SAMPLES, exponentialCdf));
+	sink += sines[BENCHMARK_COUNT - 1];
+
+	start = seconds();
+	for (i32 r = 0; r < BENCHMARK_REPEATS; r++)
+		randomExponentialFill(sines, BENCHMARK_COUNT);
+	fill = nanoseconds(start, (i64)BENCHMARK_REPEATS * BENCHMARK_COUNT);
+	randomExponentialFill(samples, DISTRIBUTION_SAMPLES);
+	addResult("randomExponential vs randomExponentialFill", after, fill, ksDistance(samples, DISTRIBUTION_SAMPLES, exponentialCdf));
+	sink += sines[BENCHMARK_COUNT - 1];
+
+	// below and above the switch to the transformed rejection at a mean of 10
+	i32 total = 0;
+	TIME_LOOP(before, std::poisson_distribution<i32> distribution(3.0); total += distribution(engine));
+	TIME_LOOP(after, total += randomPoisson(3.f));
+	addResult("randomPoisson(3) vs std::poisson", before, after, poissonDistance(3.f));
+	TIME_LOOP(before, std::poisson_distribution<i32> distribution(40.0); total += distribution(engine));
+	TIME_LOOP(after, total += randomPoisson(40.f));
+	addResult("randomPoisson(40) vs std::poisson", before, after, poissonDistance(40.f));
+	sink += (f32)total;
+
+	TIME_LOOP(before, sines[i] = montecarloRejection());
+	TIME_LOOP(after, sines[i] = montecarlo());
+	addResult("montecarlo rejection vs inverse", before, after);
+	sink += sines[BENCHMARK_COUNT - 1];
+
+	// inverse transform of the power law on [1, 60] against the alias table
+	Distribution steps = distributionCreate(powerLaw, 1024, 1.f, 60.f);
+	TIME_LOOP(before, sines[i] = 1.f / (1.f - random() * (1.f - 1.f / 60.f)));
+	TIME_LOOP(after, sines[i] = distributionSample(&steps));
+	for (i32 i = 0; i < DISTRIBUTION_SAMPLES; i++)
+		samples[i] = distributionSample(&steps);
+	addResult("power law inverse vs distributionSample", before, after,
+		binFrequencyError(&steps, samples, DISTRIBUTION_SAMPLES, powerLaw));
+	sink += sines[BENCHMARK_COUNT - 1];
+
+	start = seconds();
+	for (i32 r = 0; r < BENCHMARK_REPEATS; r++)
+		distributionFill(&steps, sines, BENCHMARK_COUNT);
+	fill = nanoseconds(start, (i64)BENCHMARK_REPEATS * BENCHMARK_COUNT);
+	distributionFill(&steps, samples, DISTRIBUTION_SAMPLES);
+	addResult("distributionSample vs distributionFill", after, fill,
+		binFrequencyError(&steps, samples, DISTRIBUTION_SAMPLES, powerLaw));
+	sink += sines[BENCHMARK_COUNT - 1];
+	distributionFree(&steps);
+
+	free(samples);
+}
+
+// a Monte Carlo estimate of pi, the points inside the unit circle are counted per block of points
+#define PI_POINTS (1 << 20)
+#define PI_BLOCK 4096
+global i32 piInside[PI_POINTS / PI_BLOCK];
+global i32 piInsideOneThread[PI_POINTS / PI_BLOCK];
+
+internal void
+piBlock(void *data, RandomState *stream, i32 first, i32 last)
+{
+	i32 inside = 0;
+	for (i32 i = first; i < last; i++)
+	{
+		f32 x = random(stream, -1.f, 1.f);
+		f32 y = random(stream, -1.f, 1.f);
+		inside += x * x + y * y < 1.f;
+	}
+	((i32 *)data)[first / PI_BLOCK] = inside;
+}
+
+// the CRT rand() against the xoshiro generator behind random()
+internal void
+benchmarkRandom()
+{
+	i32 total = 0;
+	f64 before, after;
+	TIME_LOOP(before, total += rand() % 100);
+	TIME_LOOP(after, total += random(0, 99));
+	addResult("random(0, 99) vs rand() % 100", before, after);
+	sink += (f32)total;
+
+	f32 sum = 0.f;
+	TIME_LOOP(before, sum += (f32)rand() / RAND_MAX);
+	TIME_LOOP(after, sum += random());
+	addResult("random() vs rand() / RAND_MAX", before, after);
+	sink += sum;
+
+	TIME_LOOP(before, sines[i] = random(-1.f, 1.f));
+	f64 start = seconds();
+	for (i32 r = 0; r < BENCHMARK_REPEATS; r++)
+		randomFill(sines, BENCHMARK_COUNT, -1.f, 1.f);
+	addResult("random(min, max) vs randomFill", before, nanoseconds(start, (i64)BENCHMARK_REPEATS * BENCHMARK_COUNT));
+	sink += sines[BENCHMARK_COUNT - 1];
+
+	// the streams give the same counts on any number of threads, the parallel run is compared with one on
+	// a single thread and the max error is the largest difference of a block count, it should be 0
+	i32 inside = 0;
+	start = seconds();
+	for (i32 i = 0; i < PI_POINTS; i++)
+	{
+		f32 x = random(-1.f, 1.f);
+		f32 y = random(-1.f, 1.f);
+		inside += x * x + y * y < 1.f;
+	}
+	before = nanoseconds(start, PI_POINTS);
+	sink += (f32)inside;
+
+	start = seconds();
+	parallelForRandom(PI_POINTS, PI_BLOCK, 2020, piBlock, piInside);
+	after = nanoseconds(start, PI_POINTS);
+
+	parallelForRandom(PI_POINTS, PI_BLOCK, 2020, piBlock, piInsideOneThread, 1);
+
+	f64 mismatch = 0.0;
+	i32 parallelInside = 0;
+	for (i32 i = 0; i < PI_POINTS / PI_BLOCK; i++)
+	{
+		mismatch = maximum(mismatch, fabs((f64)(piInside[i] - piInsideOneThread[i])));
+		parallelInside += piInside[i];
+	}
+	Assert(mismatch == 0.0);
+	addResult("Monte Carlo pi vs parallelForRandom", before, after, mismatch);
+	sink += (f32)parallelInside;
+}
+
+// the usual way to make noise tile, a blend of four samples that are one period apart
+internal void
+tileableBlend(f32 *grid, i32 w, i32 h, f32 period)
+{
+	for (i32 y = 0; y < h; y++) {
+		for (i32 x = 0; x < w; x++) {
+			f32 fx = (f32)x / (f32)w;
+			f32 fy = (f32)y / (f32)h;
+			f32 px = fx * period;
+			f32 py = fy * period;
+			grid[y * w + x] =
+				noise(px, py) * (1.f - fx) * (1.f - fy) + noise(px - period, py) * fx * (1.f - fy) +
+				noise(px, py - period) * (1.f - fx) * fy + noise(px - period, py - period) * fx * fy;
+		}
+	}
+}
+
+// noise() per sample against the grid kernels, a 64x64 grid runs on one thread and shows the SIMD
+// speedup, the canvas sized grid is split over the processors
+internal void
+benchmarkNoise()
+{
+	const f32 step = 0.05f;
+	f64 before, after, maxError = 0.0;
+	TIME_LOOP(before, sines[i] = noise(0.3f + (f32)(i % NOISE_GRID) * step, 0.7f + (f32)(i / NOISE_GRID) * step));
+	f64 start = seconds();
+	for (i32 r = 0; r < BENCHMARK_REPEATS; r++)
+		noiseGrid2(cosines, NOISE_GRID, NOISE_GRID, 0.3f, 0.7f, step, step);
+	after = nanoseconds(start, (i64)BENCHMARK_REPEATS * BENCHMARK_COUNT);
+	for (i32 i = 0; i < BENCHMARK_COUNT; i++)
+		maxError = maximum(maxError, absoluteValue(sines[i] - cosines[i]));
+	addResult("noise(x, y) vs noiseGrid2", before, after, maxError);
+
+	maxError = 0.0;
+	TIME_LOOP(before, sines[i] = noise(0.3f + (f32)(i % NOISE_GRID) * step, 0.7f + (f32)(i / NOISE_GRID) * step, 5.f));
+	start = seconds();
+	for (i32 r = 0; r < BENCHMARK_REPEATS; r++)
+		noiseGrid3(cosines, NOISE_GRID, NOISE_GRID, 0.3f, 0.7f, 5.f, step, step);
+	after = nanoseconds(start, (i64)BENCHMARK_REPEATS * BENCHMARK_COUNT);
+	for (i32 i = 0; i < BENCHMARK_COUNT; i++)
+		maxError = maximum(maxError, absoluteValue(sines[i] - cosines[i]));
+	addResult("noise(x, y, z) vs noiseGrid3", before, after, maxError);
+	sink += cosines[BENCHMARK_COUNT - 1];
+
+	// a full canvas, like scene 4 of framework_perlin_noise
+	const i32 w = 960, h = 540, repeats = 8;
+	f32 *grid = (f32 *)malloc(sizeof(f32) * w * h);
+	start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		for (i32 y = 0; y < h; y++)
+			for (i32 x = 0; x < w; x++)
+				grid[y * w + x] = noise(0.3f + (f32)x * 0.02f, 0.7f + (f32)y * 0.02f, 5.f);
+	before = nanoseconds(start, (i64)repeats * w * h);
+	start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		noiseGrid3(grid, w, h, 0.3f, 0.7f, 5.f, 0.02f, 0.02f);
+	after = nanoseconds(start, (i64)repeats * w * h);
+	addResult("960x540 noise(x, y, z) vs threaded grid", before, after);
+	sink += grid[w * h - 1];
+	free(grid);
+
+	// the same canvas colored through a ramp, a blend and a pack per pixel against the tiled lookup table
+	Color ramp[] = { Color{ 10, 20, 90, 255 }, Color{ 230, 210, 140, 255 }, Color{ 30, 90, 30, 255 } };
+	u32 *pixels = (u32 *)malloc(sizeof(u32) * w * h);
+	start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		for (i32 y = 0; y < h; y++)
+			for (i32 x = 0; x < w; x++)
+			{
+				f32 n = noise(0.3f + (f32)x * 0.02f, 0.7f + (f32)y * 0.02f) * 2.f;
+				i32 index = minimum((i32)n, 1);
+				pixels[y * w + x] = packColor(lerpColor(ramp[index], ramp[index + 1], n - (f32)index));
+			}
+	before = nanoseconds(start, (i64)repeats * w * h);
+	NoiseImageParams params;
+	params.x = 0.3f;
+	params.y = 0.7f;
+	params.scale = 0.02f;
+	start = seconds();
+	for (i32 r = 0; r < repeats; r++)
+		noisePixels(pixels, w, h, params, ramp, 3);
+	after = nanoseconds(start, (i64)repeats * w * h);
+	addResult("960x540 noise + packColor vs noisePixels", before, after);
+	sink += (f32)pixels[w * h - 1];
+	free(pixels);
+
+	// 4 octaves evaluated every time against a noise field filled once
+	noiseDetail(4, 0.5f);
+	maxError = 0.0;
+	TIME_LOOP(before, sines[i] = noise(0.3f + (f32)(i % NOISE_GRID) * step, 0.7f + (f32)(i / NOISE_GRID) * step));
+	start = seconds();
+	for (i32 r = 0; r < BENCHMARK_REPEATS; r++)
+		noiseGrid2(cosines, NOISE_GRID, NOISE_GRID, 0.3f, 0.7f, step, step);
+	after = nanoseconds(start, (i64)BENCHMARK_REPEATS * BENCHMARK_COUNT);
+	for (i32 i = 0; i < BENCHMARK_COUNT; i++)
+		maxError = maximum(maxError, absoluteValue(sines[i] - cosines[i]));
+	addResult("4 octave noise vs noiseGrid2", before, after, maxError);
+
+	NoiseField field = noiseFieldCreate(0.3f, 0.7f, NOISE_GRID * step, NOISE_GRID * step, step / 4.f);
+	noiseFieldFill(&field);
+	TIME_LOOP(after, cosines[i] = noiseFieldSample(&field, 0.3f + (f32)(i % NOISE_GRID) * step, 0.7f + (f32)(i / NOISE_GRID) * step));
+	addResult("4 octave noise vs noiseFieldSample", before, after);
+	sink += cosines[BENCHMARK_COUNT - 1];
+	noiseFieldFree(&field);
+	noiseDetail(1);
+
+	// seamless loops and tiles, blends of samples one period apart against circles through 4D noise
+	const f32 loopLength = 4.f;
+	TIME_LOOP(before, f32 t = (f32)i / BENCHMARK_COUNT; sines[i] = noise(t * loopLength) * (1.f - t) + noise((t - 1.f) * loopLength) * t);
+	TIME_LOOP(after, sines[i] = loopNoise((f32)i / BENCHMARK_COUNT, loopLength / TWO_PI));
+	addResult("loop blend vs loopNoise(t)", before, after);
+	sink += sines[BENCHMARK_COUNT - 1];
+
+	start = seconds();
+	for (i32 r = 0; r < BENCHMARK_REPEATS; r++)
+		tileableBlend(sines, NOISE_GRID, NOISE_GRID, loopLength);
+	before = nanoseconds(start, (i64)BENCHMARK_REPEATS * BENCHMARK_COUNT);
+	start = seconds();
+	for (i32 r = 0; r < BENCHMARK_REPEATS; r++)
+		tileableNoise2(cosines, NOISE_GRID, NOISE_GRID, loopLength);
+	after = nanoseconds(start, (i64)BENCHMARK_REPEATS * BENCHMARK_COUNT);
+	addResult("tile blend vs tileableNoise2", before, after);
+	sink += sines[BENCHMARK_COUNT - 1] + cosines[BENCHMARK_COUNT - 1];
+}
+
+void setup()
+{
+	createCanvas(960, 540, "Benchmark");
+	benchmarkMatrices();
+	benchmarkVectorArrays();
+	benchmarkArray();
+	benchmarkTrigonometry();
+	benchmarkVectors();
+	benchmarkQuaternions();
+	benchmarkRandom();
+	benchmarkDistributions();
+	benchmarkNoise();
+}
+
+void draw()
+{
+	clear(c64blue);
+	text(20, 30, "%s", cpuFeatures.avx && cpuFeatures.fma ? "SSE2 + AVX/FMA" : "SSE2");
+	text(420, 30, "page %d / %d", page + 1, (resultCount + ROWS_PER_PAGE - 1) / ROWS_PER_PAGE);
+	text(20, 60, "operation");
+	text(420, 60, "before ns");
+	text(560, 60, "after ns");
+	text(700, 60, "speedup");
+	text(820, 60, "max error");
+
+	i32 first = page * ROWS_PER_PAGE;
+	for (i32 i = first; i < resultCount && i < first + ROWS_PER_PAGE; i++)
+	{
+		i32 y = 90 + (i - first) * 26;
+		text(20, y, "%s", results[i].name);
+		text(420, y, "%.2f", results[i].before);
+		text(560, y, "%.2f", results[i].after);
+		text(700, y, "%.2fx", results[i].before / results[i].after);
+		if (results[i].maxError > 0.0)
+			text(820, y, "%.1e", results[i].maxError);
+	}
+
+	if (mouseReleased())
+		page = (page + 1) % ((resultCount + ROWS_PER_PAGE - 1) / ROWS_PER_PAGE);
+}
+
+void cleanup() { }
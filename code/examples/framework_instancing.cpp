@@ -0,0 +1,87 @@
+﻿/* 	Instancing
+	Draws 10000 cubes with drawInstanced(), with beginBatch()/batchMesh()/endBatch() or
+	one pushMatrix/drawMesh/popMatrix per cube. Click the mouse to switch between them.
+
+	Copyright (c) 2020 Martin Fairbanks
+	This example has been created using the cpp5 framework.
+	Licensing information can be found in the cpp5_framework.h file.
+*/
+
+#include "../cpp5_framework.h"
+
+#define GRID_SIZE 100
+#define CUBE_COUNT (GRID_SIZE * GRID_SIZE)
+
+global m4 transforms[CUBE_COUNT];
+global u32 colors[CUBE_COUNT];
+global f32 angle;
+global i32 mode;
+
+void setup()
+{
+	createCanvas(960, 540, "Instancing");
+	set3dProjection();
+	lights();
+
+	colorMode(HSB);
+	for (i32 i = 0; i < CUBE_COUNT; i++)
+		colors[i] = packColor(i * 255 / CUBE_COUNT, 200, 255);
+}
+
+void draw()
+{
+	clear(c64blue);
+	translate(0.f, 0.f, -250.f);
+	rotateX(30.f);
+
+	for (i32 y = 0; y < GRID_SIZE; y++)
+	{
+		for (i32 x = 0; x < GRID_SIZE; x++)
+		{
+			i32 i = y * GRID_SIZE + x;
+			f32 wave = sinus(angle + (x + y) * 0.15f) * 6.f;
+			transforms[i] = m4Multiply(m4Translation((x - GRID_SIZE / 2) * 3.f, wave, (y - GRID_SIZE / 2) * 3.f),
+				m4RotationY(angle + i * 0.01f));
+		}
+	}
+
+	if (mode == 0)
+	{
+		drawInstanced(boxMesh(), transforms, colors, CUBE_COUNT);
+		setWindowTitle("drawInstanced()");
+	}
+	else if (mode == 1)
+	{
+		// the matrix stack transforms the cubes on the CPU, they are drawn with one call in endBatch()
+		beginBatch();
+		for (i32 i = 0; i < CUBE_COUNT; i++)
+		{
+			pushMatrix();
+			applyMatrix(transforms[i]);
+			batchMesh(boxMesh(), colors[i]);
+			popMatrix();
+		}
+		endBatch();
+		setWindowTitle("beginBatch() / batchMesh() / endBatch()");
+	}
+	else
+	{
+		// the same thing, one object at a time
+		for (i32 i = 0; i < CUBE_COUNT; i++)
+		{
+			pushMatrix();
+			applyMatrix(transforms[i]);
+			glColor4ubv((u8 *)&colors[i]);
+			drawMesh(boxMesh());
+			popMatrix();
+		}
+		setWindowTitle("pushMatrix() / drawMesh() / popMatrix()");
+	}
+
+	if (mouseReleased())
+		mode = (mode + 1) % 3;
+
+	angle += deltaTime;
+}
+
+void cleanup() { }
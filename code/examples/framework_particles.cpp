@@ -0,0 +1,71 @@
+﻿/* 	Particles
+	100000 particles stored in v2Arrays and updated with the batch kernels. The particles are pulled
+	towards the mouse and respawn when they get too close, the update time is shown in microseconds.
+
+	Copyright (c) 2020 Martin Fairbanks
+	This example has been created using the cpp5 framework.
+	Licensing information can be found in the cpp5_framework.h file.
+*/
+
+#include "../cpp5_framework.h"
+
+#define PARTICLE_COUNT 100000
+#define MAX_SPEED 400.f
+
+global v2Array position;
+global v2Array velocity;
+global v2Array toMouse;
+global f32 distance[PARTICLE_COUNT];
+global f64 updateTime;
+
+internal void
+spawn(i32 i)
+{
+	v2ArraySet(&position, i, v2(random((f32)width), random((f32)height)));
+	v2ArraySet(&velocity, i, random2d() * random(MAX_SPEED));
+}
+
+void setup()
+{
+	createCanvas(960, 540, "Particles");
+	position = v2ArrayCreate(PARTICLE_COUNT);
+	velocity = v2ArrayCreate(PARTICLE_COUNT);
+	toMouse = v2ArrayCreate(PARTICLE_COUNT);
+	for (i32 i = 0; i < PARTICLE_COUNT; i++)
+		spawn(i);
+}
+
+void draw()
+{
+	clear(black);
+
+	f64 start = seconds();
+	v2 mouse = v2((f32)mouseX, (f32)mouseY);
+
+	// accelerate towards the mouse
+	v2ArrayScale(&toMouse, &position, -1.f);
+	v2ArrayAdd(&toMouse, &toMouse, mouse);
+	v2ArrayNormalize(&toMouse, &toMouse);
+	v2ArrayMultiplyAdd(&velocity, &velocity, &toMouse, 600.f * deltaTime);
+	v2ArrayLimit(&velocity, &velocity, MAX_SPEED);
+	v2ArrayMultiplyAdd(&position, &position, &velocity, deltaTime);
+	v2ArrayDistance(distance, &position, mouse);
+	updateTime = (seconds() - start) * 1e6;
+
+	for (i32 i = 0; i < PARTICLE_COUNT; i++)
+		if (distance[i] < 4.f)
+			spawn(i);
+
+	stroke(255, 200, 100, 100);
+	points(&position);
+
+	stroke(white);
+	text(20, 30, "%d particles, update: %.0f microseconds", PARTICLE_COUNT, updateTime);
+}
+
+void cleanup()
+{
+	v2ArrayFree(&toMouse);
+	v2ArrayFree(&velocity);
+	v2ArrayFree(&position);
+}
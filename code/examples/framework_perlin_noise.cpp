@@ -66,6 +66,17 @@ struct Walker
 
 } walker;
 
+// noise for every pixel of the canvas colored through a ramp from deep water to snow, made once in setup
+global Image terrain;
+
+// flow field, the particles move in the direction of 4 octave noise from a noise instance of its own, so
+// the other scenes keep the default noise. the noise doesn't change so it is computed once into a noise
+// field and every step is a bilinear lookup
+#define FLOW_PARTICLES 2000
+#define FLOW_SCALE 0.004f
+global NoiseField flow;
+global v2 flowParticles[FLOW_PARTICLES];
+
 void setup()
 {
 	createCanvas(960, 540, "Perlin noise");
@@ -73,6 +84,22 @@ void setup()
 	fill(green);
 	walker.x = (f32)width / 2.f; //center.x;
 	walker.y = (f32)height / 2.f; //enter.y;
+
+	Noise flowNoise = noiseCreate(2020);
+	noiseDetail(&flowNoise, 4, 0.5f);
+	flow = noiseFieldCreate(&flowNoise, 0.f, 0.f, width * FLOW_SCALE, height * FLOW_SCALE, 4.f * FLOW_SCALE);
+	noiseFieldFill(&flow);
+	for (int i = 0; i < FLOW_PARTICLES; i++)
+		flowParticles[i] = v2(random((f32)width), random((f32)height));
+
+	Color ramp[] = { Color{ 10, 20, 90, 255 }, Color{ 40, 90, 200, 255 }, Color{ 230, 210, 140, 255 },
+		Color{ 60, 150, 50, 255 }, Color{ 30, 90, 30, 255 }, Color{ 120, 110, 100, 255 }, white };
+	Noise terrainNoise = noiseCreate(7);
+	noiseDetail(&terrainNoise, 6, 0.5f);
+	NoiseImageParams params;
+	params.noise = &terrainNoise;
+	params.scale = 0.004f;
+	terrain = noiseImage(width, height, params, ramp, 7);
 	disableDoubleBuffer();
 }
 
@@ -81,7 +108,6 @@ void draw()
 	static i32 scene = 0;
 	f32 x, y, n, xoff;
 	static f32 time = 0.f;
-	static f32 increment = 0.02f;
 
 	switch (scene)
 	{
@@ -131,37 +157,56 @@ void draw()
 		break;
 
 	case 4:
-		colorMode(HSB);
-		xoff = 0.f; // Start xoff at 0
+		// 6 octaves of 2D noise for every pixel, looked up in the color ramp
+		image(terrain, 0, 0);
+		setWindowTitle("2D Perlin noise");
+		break;
 
-		//calculate a noise values for every x,y coordinate in a 2D space
-		for (int xP = 0; xP < width; xP++)
+	case 5:
+		// flow field
+		stroke(white, 20);
+		for (int i = 0; i < FLOW_PARTICLES; i++)
 		{
-			xoff += increment;   
-			float yoff = 0.0;
-			for (int yP = 0; yP < height; yP++)
-			{
-				yoff += increment;
-
-				//calculate noise and scale by 255
-				f32 hue = noise(xoff, yoff) * 255;
-				f32 bright = noise(xoff + 1000, yoff + 500, xoff) * 255;
-
-				stroke((i32)hue, 255, (i32)bright);
-				//pixelBuffer[x + y*windowWidth] = getColor(Color{ (i32)hue, 255,  (i32)bright });
-				point(xP, yP);
-			}
+			v2 *p = &flowParticles[i];
+			f32 angle = noiseFieldSample(&flow, p->x * FLOW_SCALE, p->y * FLOW_SCALE) * TWO_PI * 2.f;
+			p->x += cosf(angle);
+			p->y += sinf(angle);
+			if (p->x < 0 || p->x >= width || p->y < 0 || p->y >= height)
+				*p = v2(random((f32)width), random((f32)height));
+			point((i32)p->x, (i32)p->y);
 		}
-		setWindowTitle("2D Perlin noise");
-		colorMode(RGB);
+		setWindowTitle("Perlin noise flow field");
+		break;
+
+	case 6:
+	{
+		// a blob that loops, the radius along the outline is 4D noise that comes back to the start
+		// every 240 frames
+		background(c64blue);
+		stroke(green);
+		f32 loop = (f32)(frameCount % 240) / 240.f;
+		f32 prevX = 0, prevY = 0;
+		for (int i = 0; i <= 200; i++)
+		{
+			f32 angle = (f32)i / 200.f * TWO_PI;
+			f32 radius = 100.f + 150.f * loopNoise(cosf(angle), sinf(angle), loop, 0.5f);
+			x = width / 2.f + radius * cosf(angle);
+			y = height / 2.f + radius * sinf(angle);
+			if (i > 0)
+				line(prevX, prevY, x, y);
+			prevX = x;
+			prevY = y;
+		}
+		setWindowTitle("Looping Perlin noise");
 		break;
 	}
+	}
 
 	if (mouseReleased())
 	{
 		background(c64blue);
 		scene++;
-		if (scene == 5)
+		if (scene == 7)
 		{
 			fill(green);
 			scene = 0;
@@ -169,4 +214,7 @@ void draw()
 	}
 }
 
-void cleanup() {}
+void cleanup()
+{
+	noiseFieldFree(&flow);
+}
@@ -0,0 +1,78 @@
+﻿/* 	Quaternions
+	10000 cubes turn smoothly between random orientations. The orientations are interpolated with
+	quatSlerpArray() and turned into transforms with quatToM4() for drawInstanced().
+
+	Copyright (c) 2020 Martin Fairbanks
+	This example has been created using the cpp5 framework.
+	Licensing information can be found in the cpp5_framework.h file.
+*/
+
+#include "../cpp5_framework.h"
+
+#define GRID_SIZE 100
+#define CUBE_COUNT (GRID_SIZE * GRID_SIZE)
+
+global quat from[CUBE_COUNT];
+global quat to[CUBE_COUNT];
+global quat orientations[CUBE_COUNT];
+global m4 transforms[CUBE_COUNT];
+global u32 colors[CUBE_COUNT];
+global f32 t;
+
+internal quat
+randomOrientation()
+{
+	v3 axis = v3(random(-1.f, 1.f), random(-1.f, 1.f), random(-1.f, 1.f));
+	return quatFromAxisAngle(axis, random(TWO_PI));
+}
+
+void setup()
+{
+	createCanvas(960, 540, "Quaternions");
+	set3dProjection();
+	lights();
+
+	colorMode(HSB);
+	for (i32 i = 0; i < CUBE_COUNT; i++)
+	{
+		from[i] = randomOrientation();
+		to[i] = randomOrientation();
+		colors[i] = packColor(i * 255 / CUBE_COUNT, 200, 255);
+	}
+}
+
+void draw()
+{
+	clear(c64blue);
+	translate(0.f, 0.f, -250.f);
+	rotateX(30.f);
+
+	// ease in and out between the two orientations
+	f32 s = t * t * (3.f - 2.f * t);
+	quatSlerpArray(from, to, s, orientations, CUBE_COUNT);
+
+	for (i32 y = 0; y < GRID_SIZE; y++)
+	{
+		for (i32 x = 0; x < GRID_SIZE; x++)
+		{
+			i32 i = y * GRID_SIZE + x;
+			v3 position = v3((x - GRID_SIZE / 2) * 3.f, 0.f, (y - GRID_SIZE / 2) * 3.f);
+			transforms[i] = quatToM4(orientations[i], position);
+		}
+	}
+	drawInstanced(boxMesh(), transforms, colors, CUBE_COUNT);
+
+	// pick new orientations when the cubes get there
+	t += deltaTime * 0.5f;
+	if (t >= 1.f)
+	{
+		t = 0.f;
+		for (i32 i = 0; i < CUBE_COUNT; i++)
+		{
+			from[i] = to[i];
+			to[i] = randomOrientation();
+		}
+	}
+}
+
+void cleanup() { }
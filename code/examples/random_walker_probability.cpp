@@ -9,9 +9,20 @@
 
 #include "../cpp5_framework.h"
 
+// step lengths for the last Levy flight, a power law where long jumps are rare but far more likely
+// than with a normal distribution
+global Distribution stepLengths;
+
+internal f32
+powerLaw(f32 x)
+{
+	return 1.f / (x * x);
+}
+
 void setup()
 {
 	createCanvas(960, 540, "random walkers");
+	stepLengths = distributionCreate(powerLaw, 1024, 1.f, 60.f);
 	disableDoubleBuffer();
 	background(c64blue);
 	fill(magenta);
@@ -182,6 +193,27 @@ void draw()
 
 		setWindowTitle("random walker: Levy flight with Monte Carlo algorithm");
 		break;
+
+	case 6:
+	{
+		// Random walker: Levy flight with step lengths from a Distribution, sampled in constant time
+		prevX = x;
+		prevY = y;
+
+		v2 direction = random2d();
+		stepsize = distributionSample(&stepLengths);
+
+		x += (i32)(direction.x * stepsize);
+		y += (i32)(direction.y * stepsize);
+
+		x = constrain(x, 0, width - 1);
+		y = constrain(y, 0, height - 1);
+
+		line(prevX, prevY, x, y);
+
+		setWindowTitle("random walker: Levy flight with a power law Distribution");
+		break;
+	}
 	}
 	
 	if (mouseReleased())
@@ -190,10 +222,13 @@ void draw()
 		scene++;
 		x = width / 2;
 		y = height / 2;
-		if (scene == 6)
+		if (scene == 7)
 			scene = 0;
 	}
 
 }
 
-void cleanup() {}
+void cleanup()
+{
+	distributionFree(&stepLengths);
+}
@@ -16,6 +16,9 @@ struct SnowFlake
 	i32 layer;
 } snow[2000];
 
+// the sideways shake of every flake, generated for all of them at once
+global i32 shake[MAX_FLAKES];
+
 void setup()
 {
 	createCanvas(960, 540, "Snowflakes");
@@ -33,6 +36,7 @@ void setup()
 void draw()
 {
 	clear(c64blue);
+	randomFillInt(shake, MAX_FLAKES, -2, 2);
 
 	for (int i = 0; i < MAX_FLAKES; i++)
 	{
@@ -48,7 +52,7 @@ void draw()
 		}
 
 		//shake and draw
-		snow[i].x = (snow[i].x + (rand() % 5) - 2);
+		snow[i].x = snow[i].x + shake[i];
 		point((int)snow[i].x, (int)snow[i].y);
 	}
 }
@@ -1,4 +1,6 @@
 ﻿/* 	3D starfield
+	The stars are projected all at once with projectPoints(), the projection is the x / z + centerX
+	of a pinhole camera written as a matrix.
 
 	Copyright (c) 2020 Martin Fairbanks
 	This example has been created using the cpp5 framework.
@@ -6,39 +8,29 @@
 */
 #include "../cpp5_framework.h"
 
-struct Star
-{
-	f32 xpos, ypos;
-	i32 zpos, speed;
-	u8 color;
-} stars[2000];
+#define STAR_COUNT 2000
+
+// x, y and the depth of every star
+global v3 stars[STAR_COUNT];
+global u8 colors[STAR_COUNT];
+global v2 previous[STAR_COUNT];
+global v2 current[STAR_COUNT];
+global u32 visible[(STAR_COUNT + 31) / 32];
+global m4 projection;
 
 global i32 centerX;
 global i32 centerY;
-global f32 prevPosX;
-global f32 prevPosY;
 
-void initStar(Star* star, int i)
+void initStar(i32 i)
 {
 	// randomly init stars, put them around the center of the screen
-	star->xpos = float(((rand() % width) * -1) + centerX);
-	star->ypos = float(((rand() % height) * -1) + centerY);
+	f32 xpos = float(((rand() % width) * -1) + centerX);
+	f32 ypos = float(((rand() % height) * -1) + centerY);
 
 	// change viewpoint
-	if (mouseX > width / 2)
-	{
-		star->xpos *= 800.0;
-		star->ypos *= 800.0;
-	}
-	else
-	{
-		star->xpos *= 40.0;
-		star->ypos *= 40.0;
-	}
-		
-	star->zpos = i;
-	star->speed = (rand() % 10) + 4;
-	star->color = u8(i << 1);
+	f32 spread = mouseX > width / 2 ? 800.f : 40.f;
+	stars[i] = v3(xpos * spread, ypos * spread, (f32)(i + 1));
+	colors[i] = u8((i + 1) << 1);
 }
 
 void setup()
@@ -46,52 +38,53 @@ void setup()
 	createCanvas(960, 540, "stars3d");
 	centerX = width / 2;
 	centerY = height / 2;
-	
-	for (int i = 0; i < arrayCount(stars); i++)
-		initStar(stars + i, i + 1);
+
+	// w = z, and the viewport maps x / w and y / w back to pixels with x / z + centerX, y / z + centerY.
+	// z stays 0 so only the screen edges and the stars behind the camera are clipped
+	projection.e[0][0] = 1.f / (f32)centerX;
+	projection.e[1][1] = -1.f / (f32)centerY;
+	projection.e[3][2] = 1.f;
+
+	for (i32 i = 0; i < STAR_COUNT; i++)
+		initStar(i);
 }
 
 void draw()
 {
 	clear(black);
 
-	// move and draw stars
-	for (int i = 0; i < arrayCount(stars); i++)
-	{
-		prevPosX = (stars[i].xpos / stars[i].zpos) + centerX;
-		prevPosY = (stars[i].ypos / stars[i].zpos) + centerY;
-
-		// change speed depending on mouse pos
-		stars[i].speed = mouseY / 20;
-		
-		// move star closer
-		stars[i].zpos -= stars[i].speed;
-		
-		// compute 3D position
-		f32 tempX = (stars[i].xpos / stars[i].zpos) + centerX;
-		f32 tempY = (stars[i].ypos / stars[i].zpos) + centerY;
+	projectPoints(&projection, stars, previous, visible, STAR_COUNT, (f32)width, (f32)height);
 
+	// move the stars closer, the speed depends on the mouse position
+	f32 speed = (f32)(mouseY / 20);
+	for (i32 i = 0; i < STAR_COUNT; i++)
+		stars[i].z -= speed;
+
+	projectPoints(&projection, stars, current, visible, STAR_COUNT, (f32)width, (f32)height);
+
+	for (i32 i = 0; i < STAR_COUNT; i++)
+	{
 		// check if star has moved outside of screen
-		if (tempX < 0 || tempX > width - 1 || tempX < 0 || tempY > height - 1 || stars[i].zpos <= 0)
+		if (!pointVisible(visible, i))
 		{
-			initStar(stars + i, i + 1);
+			initStar(i);
 			continue;
 		}
 
 		if (mouseX > width / 2)
 		{
 			stroke(white);
-			if (tempX == prevPosX || tempY ==prevPosY)
-				point((int)tempX, (int)tempY);
+			if (current[i].x == previous[i].x || current[i].y == previous[i].y)
+				point((i32)current[i].x, (i32)current[i].y);
 			else
-				line((int)tempX, (int)tempY, (int)prevPosX, (int)prevPosY);
+				line((i32)current[i].x, (i32)current[i].y, (i32)previous[i].x, (i32)previous[i].y);
 		}
 		else
 		{
-			stars[i].color = u8(stars[i].zpos >> 1);
+			colors[i] = u8((i32)stars[i].z >> 1);
 			noStroke();
-			fill(0, 0, 255, stars[i].color);
-			circle((int)tempX, (int)tempY, 4);
+			fill(0, 0, 255, colors[i]);
+			circle((i32)current[i].x, (i32)current[i].y, 4);
 		}
 	}
 }
@@ -164,7 +164,7 @@ namespace{
     {2,1,0,3},{0,0,0,0},{0,0,0,0},{0,0,0,0},{3,1,0,2},{0,0,0,0},{3,2,0,1},{3,2,1,0}};
 }
 /* 1D simplex noise */
-inline float _slang_library_noise1 (float x)
+inline float _slang_library_noise1 (float x, const unsigned char *perm = ::perm)
 {
   int i0 = FASTFLOOR(x);
   int i1 = i0 + 1;
@@ -188,7 +188,7 @@ inline float _slang_library_noise1 (float x)
 }
 
 /* 2D simplex noise */
-inline float _slang_library_noise2 (float x, float y)
+inline float _slang_library_noise2 (float x, float y, const unsigned char *perm = ::perm)
 {
 #define F2 0.366025403f /* F2 = 0.5*(sqrt(3.0)-1.0) */
 #define G2 0.211324865f /* G2 = (3.0-Math.sqrt(3.0))/6.0 */
@@ -227,9 +227,9 @@ inline float _slang_library_noise2 (float x, float y)
     x2 = x0 - 1.0f + 2.0f * G2; /* Offsets for last corner in (x,y) unskewed coords */
     y2 = y0 - 1.0f + 2.0f * G2;
 
-    /* Wrap the integer indices at 256, to avoid indexing perm[] out of bounds */
-    ii = i % 256;
-    jj = j % 256;
+    /* Wrap the integer indices at 256, & 255 keeps negative indices inside perm[] too */
+    ii = i & 255;
+    jj = j & 255;
 
     /* Calculate the contribution from the three corners */
     t0 = 0.5f - x0*x0-y0*y0;
@@ -259,7 +259,7 @@ inline float _slang_library_noise2 (float x, float y)
 }
 
 /* 3D simplex noise */
-inline float _slang_library_noise3 (float x, float y, float z)
+inline float _slang_library_noise3 (float x, float y, float z, const unsigned char *perm = ::perm)
 {
 /* Simple skewing factors for the 3D case */
 #define F3 0.333333333f
@@ -321,10 +321,10 @@ inline float _slang_library_noise3 (float x, float y, float z)
     y3 = y0 - 1.0f + 3.0f*G3;
     z3 = z0 - 1.0f + 3.0f*G3;
 
-    /* Wrap the integer indices at 256, to avoid indexing perm[] out of bounds */
-    ii = i % 256;
-    jj = j % 256;
-    kk = k % 256;
+    /* Wrap the integer indices at 256, & 255 keeps negative indices inside perm[] too */
+    ii = i & 255;
+    jj = j & 255;
+    kk = k & 255;
 
     /* Calculate the contribution from the four corners */
     t0 = 0.6f - x0*x0 - y0*y0 - z0*z0;
@@ -361,7 +361,7 @@ inline float _slang_library_noise3 (float x, float y, float z)
 }
 
 /* 4D simplex noise */
-inline float _slang_library_noise4 (float x, float y, float z, float w)
+inline float _slang_library_noise4 (float x, float y, float z, float w, const unsigned char *perm = ::perm)
 {
   /* The skewing and unskewing factors are hairy again for the 4D case */
 #define F4 0.309016994f /* F4 = (Math.sqrt(5.0)-1.0)/4.0 */
@@ -453,11 +453,11 @@ inline float _slang_library_noise4 (float x, float y, float z, float w)
     z4 = z0 - 1.0f + 4.0f*G4;
     w4 = w0 - 1.0f + 4.0f*G4;
 
-    /* Wrap the integer indices at 256, to avoid indexing perm[] out of bounds */
-    ii = i % 256;
-    jj = j % 256;
-    kk = k % 256;
-    ll = l % 256;
+    /* Wrap the integer indices at 256, & 255 keeps negative indices inside perm[] too */
+    ii = i & 255;
+    jj = j & 255;
+    kk = k & 255;
+    ll = l & 255;
 
     /* Calculate the contribution from the five corners */
     t0 = 0.6f - x0*x0 - y0*y0 - z0*z0 - w0*w0;